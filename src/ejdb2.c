@@ -1,11 +1,14 @@
 #include "ejdb2_internal.h"
 #include <iowow/wyhash32.h>
+#include <ctype.h>
+#include <sched.h>
 
 #ifdef IW_BLOCKS
 #include <Block.h>
 #endif
 
 static iwrc _jb_put_new_lw(struct jbcoll *jbc, struct jbl *jbl, int64_t *id);
+static void _jb_async_release(struct ejdb *db);
 
 static const struct iwkv_val EMPTY_VAL = { 0 };
 
@@ -56,12 +59,28 @@ static void _jb_coll_release(struct jbcoll *jbc) {
   if (jbc->meta) {
     jbl_destroy(&jbc->meta);
   }
+  free(jbc->zdict);
+  free(jbc->zdict_ht);
+  if (jbc->kmap) {
+    iwhmap_destroy(jbc->kmap);
+  }
+  free(jbc->keys);
+  for (int i = 0; i < jbc->colsnum; ++i) {
+    free(jbc->cols[i]);
+  }
   struct jbidx *nidx;
   for (struct jbidx *idx = jbc->idx; idx; idx = nidx) {
     nidx = idx->next;
     _jb_idx_release(idx);
   }
   jbc->idx = 0;
+  for (int i = 0; i < JB_COLL_WRITE_STRIPES; ++i) {
+    pthread_mutex_destroy(&jbc->stripes[i]);
+  }
+  pthread_cond_destroy(&jbc->wcond);
+  pthread_mutex_destroy(&jbc->wmtx);
+  pthread_mutex_destroy(&jbc->colmtx);
+  pthread_rwlock_destroy(&jbc->krwl);
   pthread_rwlock_destroy(&jbc->rwl);
   free(jbc);
 }
@@ -143,6 +162,195 @@ finish:
   return rc;
 }
 
+static void _jb_keys_entry_free(void *key, void *val) {
+  free(key);
+}
+
+static iwrc _jb_coll_load_keys_lr(struct jbcoll *jbc) {
+  iwrc rc = 0;
+  struct iwkv_cursor *cur;
+  struct iwkv_val kval;
+  char buf[sizeof(KEY_PREFIX_KEYDICT) + IWNUMBUF_SIZE];
+  // Full key format: k.<coldbid>.<keyid>
+  int sz = snprintf(buf, sizeof(buf), KEY_PREFIX_KEYDICT "%u.", jbc->dbid);
+  if (sz >= sizeof(buf)) {
+    return IW_ERROR_OVERFLOW;
+  }
+  kval.data = buf;
+  kval.size = sz;
+  rc = iwkv_cursor_open(jbc->db->metadb, &cur, IWKV_CURSOR_GE, &kval);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+    goto finish;
+  }
+  RCRET(rc);
+
+  do {
+    struct iwkv_val key, val;
+    RCC(rc, finish, iwkv_cursor_key(cur, &key));
+    if ((key.size > sz) && (key.size - sz < IWNUMBUF_SIZE) && !strncmp(buf, key.data, sz)) {
+      char nbuf[IWNUMBUF_SIZE];
+      memcpy(nbuf, (char*) key.data + sz, key.size - sz);
+      nbuf[key.size - sz] = '\0';
+      iwkv_val_dispose(&key);
+      uint32_t id = (uint32_t) strtoul(nbuf, 0, 10);
+      if (!id || id > INT32_MAX) {
+        rc = EJDB_ERROR_INVALID_COLLECTION_META;
+        break;
+      }
+      if (id > jbc->keysasz) {
+        char **nkeys = realloc(jbc->keys, id * 2 * sizeof(nkeys[0]));
+        RCA(nkeys, finish);
+        memset(nkeys + jbc->keysasz, 0, (id * 2 - jbc->keysasz) * sizeof(nkeys[0]));
+        jbc->keys = nkeys;
+        jbc->keysasz = id * 2;
+      }
+      RCC(rc, finish, iwkv_cursor_val(cur, &val));
+      char *k = strndup(val.data, val.size);
+      iwkv_val_dispose(&val);
+      RCA(k, finish);
+      rc = iwhmap_put(jbc->kmap, k, (void*) (uintptr_t) id);
+      if (rc) {
+        free(k);
+        break;
+      }
+      jbc->keys[id - 1] = k;
+      jbc->keysnum = MAX(jbc->keysnum, id);
+    } else {
+      iwkv_val_dispose(&key);
+    }
+  } while (!(rc = iwkv_cursor_to(cur, IWKV_CURSOR_PREV)));
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+
+finish:
+  iwkv_cursor_close(&cur);
+  return rc;
+}
+
+/**
+ * Sets compression dictionary of collection, `dict` content is copied.
+ */
+static iwrc _jb_coll_zdict_set(struct jbcoll *jbc, const void *dict, uint32_t dictsz) {
+  uint8_t *zdict = malloc(dictsz);
+  uint32_t *ht = malloc(sizeof(ht[0]) * (1U << JB_ZDOC_HASH_LOG));
+  if (!zdict || !ht) {
+    free(zdict);
+    free(ht);
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  memcpy(zdict, dict, dictsz);
+  jbi_zdict_hash(zdict, dictsz, ht);
+  free(jbc->zdict);
+  free(jbc->zdict_ht);
+  jbc->zdict = zdict;
+  jbc->zdictsz = dictsz;
+  jbc->zdict_ht = ht;
+  return 0;
+}
+
+/**
+ * Creates list of JSON pointers of collection columns.
+ */
+static iwrc _jb_coll_columns_list(struct jbcoll *jbc, binn **listp) {
+  iwrc rc = 0;
+  binn *list = binn_list();
+  struct iwxstr *xstr = iwxstr_new();
+  *listp = 0;
+  if (!list || !xstr) {
+    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    goto finish;
+  }
+  for (int i = 0; i < jbc->colsnum; ++i) {
+    iwxstr_clear(xstr);
+    RCC(rc, finish, jbl_ptr_serialize(jbc->cols[i], xstr));
+    if (!binn_list_add_str(list, iwxstr_ptr(xstr))) {
+      rc = JBL_ERROR_CREATION;
+      goto finish;
+    }
+  }
+  *listp = list;
+  list = 0;
+
+finish:
+  if (list) {
+    binn_free(list);
+  }
+  iwxstr_destroy(xstr);
+  return rc;
+}
+
+/**
+ * Stores meta object of collection `jbc` named `name` into meta database.
+ */
+static iwrc _jb_coll_meta_save(struct jbcoll *jbc, const char *name, struct jbl **metap) {
+  struct jbl *meta = 0;
+  binn *clist = 0;
+  struct iwkv_val key, val;
+  char keybuf[IWNUMBUF_SIZE + sizeof(KEY_PREFIX_COLLMETA)];
+
+  iwrc rc = jbl_create_empty_object(&meta);
+  RCRET(rc);
+  if (  !binn_object_set_str(&meta->bn, "name", name)
+     || !binn_object_set_uint32(&meta->bn, "id", jbc->dbid)
+     || (jbc->zmode && !binn_object_set_uint32(&meta->bn, "compression", jbc->zmode))
+     || (jbc->zdict && !binn_object_set_blob(&meta->bn, "zdict", jbc->zdict, (int) jbc->zdictsz))) {
+    rc = JBL_ERROR_CREATION;
+    goto finish;
+  }
+  if (jbc->coldb) {
+    RCC(rc, finish, _jb_coll_columns_list(jbc, &clist));
+    if (  !binn_object_set_list(&meta->bn, "columns", clist)
+       || !binn_object_set_uint32(&meta->bn, "coldbid", jbc->coldbid)) {
+      rc = JBL_ERROR_CREATION;
+      goto finish;
+    }
+  }
+  RCC(rc, finish, jbl_as_buf(meta, &val.data, &val.size));
+  key.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_COLLMETA "%u", jbc->dbid);
+  if (key.size >= sizeof(keybuf)) {
+    rc = IW_ERROR_OVERFLOW;
+    goto finish;
+  }
+  key.data = keybuf;
+  RCC(rc, finish, iwkv_put(jbc->db->metadb, &key, &val, IWKV_SYNC));
+
+finish:
+  if (clist) {
+    binn_free(clist);
+  }
+  if (rc || !metap) {
+    jbl_destroy(&meta);
+  } else {
+    *metap = meta;
+  }
+  return rc;
+}
+
+static iwrc _jb_coll_load_columns_lr(struct jbcoll *jbc) {
+  binn bv;
+  binn_iter iter;
+  uint32_t coldbid;
+  struct jbl *jbm = jbc->meta;
+  if (!binn_object_get_uint32(&jbm->bn, "coldbid", &coldbid)) {
+    return 0;
+  }
+  if (  !binn_object_get_value(&jbm->bn, "columns", &bv)
+     || !binn_iter_init(&iter, &bv, BINN_LIST)) {
+    return EJDB_ERROR_INVALID_COLLECTION_META;
+  }
+  while (binn_list_next(&iter, &bv)) {
+    if ((bv.type != BINN_STRING) || (jbc->colsnum >= JB_COL_MAX)) {
+      return EJDB_ERROR_INVALID_COLLECTION_META;
+    }
+    RCR(jbl_ptr_alloc(bv.ptr, &jbc->cols[jbc->colsnum]));
+    ++jbc->colsnum;
+  }
+  jbc->coldbid = coldbid;
+  return iwkv_db(jbc->db->iwkv, coldbid, IWDB_VNUM64_KEYS, &jbc->coldb);
+}
+
 static iwrc _jb_coll_load_meta_lr(struct jbcoll *jbc) {
   struct jbl *jbv;
   struct iwkv_cursor *cur;
@@ -162,14 +370,30 @@ static iwrc _jb_coll_load_meta_lr(struct jbcoll *jbc) {
   if (!jbc->dbid) {
     return EJDB_ERROR_INVALID_COLLECTION_META;
   }
+  uint32_t zmode;
+  if (binn_object_get_uint32(&jbm->bn, "compression", &zmode)) {
+    jbc->zmode = zmode;
+  }
+  void *zdict;
+  int zdictsz;
+  if (binn_object_get_blob(&jbm->bn, "zdict", &zdict, &zdictsz) && zdictsz > 0) {
+    rc = _jb_coll_zdict_set(jbc, zdict, (uint32_t) zdictsz);
+    RCRET(rc);
+  }
   rc = iwkv_db(jbc->db->iwkv, jbc->dbid, IWDB_VNUM64_KEYS, &jbc->cdb);
   RCRET(rc);
 
+  rc = _jb_coll_load_columns_lr(jbc);
+  RCRET(rc);
+
   jbc->rnum = _jb_meta_nrecs_get(jbc->db, jbc->dbid);
 
   rc = _jb_coll_load_indexes_lr(jbc);
   RCRET(rc);
 
+  rc = _jb_coll_load_keys_lr(jbc);
+  RCRET(rc);
+
   rc = iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0);
   RCRET(rc);
   rc = iwkv_cursor_to(cur, IWKV_CURSOR_NEXT);
@@ -195,6 +419,17 @@ static iwrc _jb_coll_init(struct jbcoll *jbc, struct iwkv_val *meta) {
   pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_READER_NP);
 #endif
   pthread_rwlock_init(&jbc->rwl, &attr);
+  pthread_mutex_init(&jbc->wmtx, 0);
+  pthread_cond_init(&jbc->wcond, 0);
+  for (int i = 0; i < JB_COLL_WRITE_STRIPES; ++i) {
+    pthread_mutex_init(&jbc->stripes[i], 0);
+  }
+  pthread_rwlock_init(&jbc->krwl, 0);
+  pthread_mutex_init(&jbc->colmtx, 0);
+  jbc->kmap = iwhmap_create_str(_jb_keys_entry_free);
+  if (!jbc->kmap) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
   if (meta) {
     rc = jbl_from_buf_keep(&jbc->meta, meta->data, meta->size, false);
     RCRET(rc);
@@ -205,6 +440,7 @@ static iwrc _jb_coll_init(struct jbcoll *jbc, struct iwkv_val *meta) {
   }
   rc = _jb_coll_load_meta_lr(jbc);
   RCRET(rc);
+  jbc->wepoch = __sync_add_and_fetch(&jbc->db->wepoch, 1);
 
   rc = iwhmap_put(jbc->db->mcolls, (void*) jbc->name, jbc);
   RCRET(rc);
@@ -254,7 +490,8 @@ static iwrc _jb_coll_add_meta_lr(struct jbcoll *jbc, binn *list) {
   }
   if (  !binn_object_set_str(meta, "name", jbc->name)
      || !binn_object_set_uint32(meta, "dbid", jbc->dbid)
-     || !binn_object_set_int64(meta, "rnum", jbc->rnum)) {
+     || !binn_object_set_int64(meta, "rnum", jbc->rnum)
+     || (jbc->zmode && !binn_object_set_uint32(meta, "compression", jbc->zmode))) {
     rc = JBL_ERROR_CREATION;
     goto finish;
   }
@@ -270,6 +507,16 @@ static iwrc _jb_coll_add_meta_lr(struct jbcoll *jbc, binn *list) {
     rc = JBL_ERROR_CREATION;
     goto finish;
   }
+  if (jbc->coldb) {
+    binn *clist;
+    RCC(rc, finish, _jb_coll_columns_list(jbc, &clist));
+    bool ok = binn_object_set_list(meta, "columns", clist);
+    binn_free(clist);
+    if (!ok) {
+      rc = JBL_ERROR_CREATION;
+      goto finish;
+    }
+  }
   if (!binn_list_add_value(list, meta)) {
     rc = JBL_ERROR_CREATION;
     goto finish;
@@ -283,6 +530,36 @@ finish:
   return rc;
 }
 
+/**
+ * Opens database of large documents bodies.
+ * Database is created on demand if `EJDB_OPTS.large_document_sz` is set.
+ */
+static iwrc _jb_db_xdb_open(struct ejdb *db) {
+  uint32_t dbid;
+  size_t vsz;
+  struct iwkv_val val, key = {
+    .data = (void*) KEY_XDBID,
+    .size = sizeof(KEY_XDBID) - 1
+  };
+  iwrc rc = iwkv_get_copy(db->metadb, &key, &dbid, sizeof(dbid), &vsz);
+  if (!rc) {
+    if (vsz != sizeof(dbid)) {
+      return EJDB_ERROR_INVALID_COLLECTION_META;
+    }
+    return iwkv_db(db->iwkv, IW_ITOHL(dbid), 0, &db->xdb);
+  } else if (rc != IWKV_ERROR_NOTFOUND) {
+    return rc;
+  }
+  if (!db->opts.large_document_sz || (db->oflags & IWKV_RDONLY)) {
+    return 0;
+  }
+  RCRET(iwkv_new_db(db->iwkv, 0, &dbid, &db->xdb));
+  dbid = IW_HTOIL(dbid);
+  val.data = &dbid;
+  val.size = sizeof(dbid);
+  return iwkv_put(db->metadb, &key, &val, IWKV_SYNC);
+}
+
 static iwrc _jb_db_meta_load(struct ejdb *db) {
   iwrc rc = 0;
   if (!db->metadb) {
@@ -293,6 +570,10 @@ static iwrc _jb_db_meta_load(struct ejdb *db) {
     rc = iwkv_db(db->iwkv, NUMRECSDB_ID, IWDB_VNUM64_KEYS, &db->nrecdb);
     RCRET(rc);
   }
+  if (!db->xdb) {
+    rc = _jb_db_xdb_open(db);
+    RCRET(rc);
+  }
 
   struct iwkv_cursor *cur;
   rc = iwkv_cursor_open(db->metadb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0);
@@ -335,10 +616,32 @@ static iwrc _jb_db_release(struct ejdb **dbp) {
 #ifdef JB_HTTP
   jbr_shutdown_wait(db->jbr);
 #endif
+  _jb_async_release(db);
   if (db->mcolls) {
     iwhmap_destroy(db->mcolls);
     db->mcolls = 0;
   }
+  if (db->qcache) {
+    iwhmap_destroy(db->qcache);
+    db->qcache = 0;
+  }
+  pthread_mutex_destroy(&db->qcache_mtx);
+  if (db->jcache) {
+    iwhmap_destroy(db->jcache);
+    db->jcache = 0;
+  }
+  pthread_mutex_destroy(&db->jcache_mtx);
+  if (db->qprof) {
+    iwhmap_destroy(db->qprof);
+    db->qprof = 0;
+  }
+  pthread_mutex_destroy(&db->qprof_mtx);
+  if (db->rcache) {
+    iwhmap_destroy(db->rcache->map);
+    pthread_mutex_destroy(&db->rcache->mtx);
+    free(db->rcache);
+    db->rcache = 0;
+  }
   if (db->iwkv) {
     IWRC(iwkv_close(&db->iwkv), rc);
   }
@@ -355,6 +658,163 @@ static iwrc _jb_db_release(struct ejdb **dbp) {
   return rc;
 }
 
+static uint32_t _jb_rslot_seq;
+static __thread int _jb_rslot_idx = -1;
+
+/**
+ * Returns readers counter of database lock used by calling thread.
+ */
+IW_INLINE struct jbrslot* _jb_rslot(struct ejdb *db) {
+  if (_jb_rslot_idx < 0) {
+    _jb_rslot_idx = (int) (__sync_fetch_and_add(&_jb_rslot_seq, 1) % JB_DB_RSLOTS);
+  }
+  return &db->rslots[_jb_rslot_idx];
+}
+
+int jb_db_rlock(struct ejdb *db) {
+  struct jbrslot *slot = _jb_rslot(db);
+  while (1) {
+    __atomic_add_fetch(&slot->readers, 1, __ATOMIC_SEQ_CST);
+    uint32_t wstate = __atomic_load_n(&db->wstate, __ATOMIC_SEQ_CST);
+    if (!wstate) {
+      return 0;
+    }
+    __atomic_sub_fetch(&slot->readers, 1, __ATOMIC_SEQ_CST);
+    if (wstate == JB_DB_WSTATE_HELD) {
+      // Wait for writer
+      int rci = pthread_rwlock_rdlock(&db->rwl);
+      if (rci) {
+        return rci;
+      }
+      pthread_rwlock_unlock(&db->rwl);
+    } else {
+      sched_yield();
+    }
+  }
+}
+
+int jb_db_wlock(struct ejdb *db) {
+  int rci = pthread_rwlock_wrlock(&db->rwl);
+  if (rci) {
+    return rci;
+  }
+  for (int attempt = 0; ; ++attempt) {
+    __atomic_store_n(&db->wstate, JB_DB_WSTATE_ACQUIRE, __ATOMIC_SEQ_CST);
+    int i = 0;
+    for ( ; i < JB_DB_RSLOTS && !__atomic_load_n(&db->rslots[i].readers, __ATOMIC_SEQ_CST); ++i);
+    if (i == JB_DB_RSLOTS) {
+      __atomic_store_n(&db->wstate, JB_DB_WSTATE_HELD, __ATOMIC_SEQ_CST);
+      return 0;
+    }
+    // Let running readers proceed, they may acquire nested read locks
+    __atomic_store_n(&db->wstate, 0, __ATOMIC_SEQ_CST);
+    if (attempt < 64) {
+      sched_yield();
+    } else {
+      usleep(100);
+    }
+  }
+}
+
+int jb_db_unlock(struct ejdb *db) {
+  // Database lock cannot be held by writer while any reader is running
+  if (__atomic_load_n(&db->wstate, __ATOMIC_SEQ_CST) == JB_DB_WSTATE_HELD) {
+    __atomic_store_n(&db->wstate, 0, __ATOMIC_SEQ_CST);
+    return pthread_rwlock_unlock(&db->rwl);
+  }
+  __atomic_sub_fetch(&_jb_rslot(db)->readers, 1, __ATOMIC_SEQ_CST);
+  return 0;
+}
+
+/**
+ * Acquires collection write lock. Number of waiting writers is tracked
+ * so long read-only scans may release collection lock for them.
+ */
+int jb_coll_wrlock(struct jbcoll *jbc) {
+  __sync_add_and_fetch(&jbc->wwait, 1);
+  int rci = pthread_rwlock_wrlock(&jbc->rwl);
+  __sync_sub_and_fetch(&jbc->wwait, 1);
+  return rci;
+}
+
+/**
+ * Enters group of read-only queries of collection.
+ * Waits until running document writers are finished. Called under collection read lock.
+ */
+void jb_coll_scan_lock(struct jbcoll *jbc) {
+  pthread_mutex_lock(&jbc->wmtx);
+  while (jbc->writers > 0) {
+    pthread_cond_wait(&jbc->wcond, &jbc->wmtx);
+  }
+  ++jbc->scanners;
+  pthread_mutex_unlock(&jbc->wmtx);
+}
+
+void jb_coll_scan_unlock(struct jbcoll *jbc) {
+  pthread_mutex_lock(&jbc->wmtx);
+  if (--jbc->scanners == 0) {
+    pthread_cond_broadcast(&jbc->wcond);
+  }
+  pthread_mutex_unlock(&jbc->wmtx);
+}
+
+/**
+ * Enters group of document writers of collection.
+ * Waits until running read-only queries are finished, waiting writer
+ * is counted in `wwait` so long queries may yield collection to it.
+ * Called under collection read lock.
+ */
+static void _jb_coll_writers_enter(struct jbcoll *jbc) {
+  pthread_mutex_lock(&jbc->wmtx);
+  if (jbc->scanners > 0) {
+    __sync_add_and_fetch(&jbc->wwait, 1);
+    do {
+      pthread_cond_wait(&jbc->wcond, &jbc->wmtx);
+    } while (jbc->scanners > 0);
+    __sync_sub_and_fetch(&jbc->wwait, 1);
+  }
+  ++jbc->writers;
+  pthread_mutex_unlock(&jbc->wmtx);
+}
+
+static void _jb_coll_writers_leave(struct jbcoll *jbc) {
+  pthread_mutex_lock(&jbc->wmtx);
+  if (--jbc->writers == 0) {
+    pthread_cond_broadcast(&jbc->wcond);
+  }
+  pthread_mutex_unlock(&jbc->wmtx);
+}
+
+IW_INLINE pthread_mutex_t* _jb_coll_stripe(struct jbcoll *jbc, int64_t id) {
+  return &jbc->stripes[(uint64_t) id % JB_COLL_WRITE_STRIPES];
+}
+
+/**
+ * Acquires write lock of document `id`: writers of distinct documents
+ * are run in parallel except ones sharing the same lock stripe.
+ */
+static void _jb_coll_doc_lock(struct jbcoll *jbc, int64_t id) {
+  _jb_coll_writers_enter(jbc);
+  pthread_mutex_lock(_jb_coll_stripe(jbc, id));
+}
+
+static void _jb_coll_doc_unlock(struct jbcoll *jbc, int64_t id) {
+  pthread_mutex_unlock(_jb_coll_stripe(jbc, id));
+  _jb_coll_writers_leave(jbc);
+}
+
+/**
+ * Advances documents identifiers sequence of collection up to `id`.
+ */
+static void _jb_coll_id_seq_update(struct jbcoll *jbc, int64_t id) {
+  for (int64_t seq = jbc->id_seq, prev; seq < id; seq = prev) {
+    prev = __sync_val_compare_and_swap(&jbc->id_seq, seq, id);
+    if (prev == seq) {
+      break;
+    }
+  }
+}
+
 static iwrc _jb_coll_acquire_keeplock2(
   struct ejdb *db, const char *coll, jb_coll_acquire_t acm,
   struct jbcoll **jbcp) {
@@ -370,10 +830,10 @@ static iwrc _jb_coll_acquire_keeplock2(
 
   jbc = iwhmap_get(db->mcolls, coll);
   if (jbc) {
-    wl ? pthread_rwlock_wrlock(&jbc->rwl) : pthread_rwlock_rdlock(&jbc->rwl);
+    wl ? jb_coll_wrlock(jbc) : pthread_rwlock_rdlock(&jbc->rwl);
     *jbcp = jbc;
   } else {
-    pthread_rwlock_unlock(&db->rwl); // relock
+    jb_db_unlock(db); // relock
     if ((db->oflags & IWKV_RDONLY) || (acm & JB_COLL_ACQUIRE_EXISTING)) {
       return IW_ERROR_NOT_EXISTS;
     }
@@ -435,7 +895,7 @@ create_finish:
           _jb_coll_release(jbc);
         }
       } else {
-        rci = wl ? pthread_rwlock_wrlock(&jbc->rwl) : pthread_rwlock_rdlock(&jbc->rwl); // -V522
+        rci = wl ? jb_coll_wrlock(jbc) : pthread_rwlock_rdlock(&jbc->rwl); // -V522
         if (rci) {
           rc = iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci);
           goto finish;
@@ -447,7 +907,7 @@ create_finish:
 
 finish:
   if (rc) {
-    pthread_rwlock_unlock(&db->rwl);
+    jb_db_unlock(db);
   }
   return rc;
 }
@@ -605,7 +1065,7 @@ finish:
     iwpool_destroy(pool);
   }
   if (delta && !_jb_meta_nrecs_update(idx->jbc->db, idx->dbid, delta)) {
-    idx->rnum += delta;
+    __sync_add_and_fetch(&idx->rnum, delta);
   }
   return rc;
 }
@@ -630,6 +1090,11 @@ static iwrc _jb_idx_fill(struct jbidx *idx) {
     }
     rc = iwkv_cursor_get(cur, &key, &val);
     RCBREAK(rc);
+    rc = jbi_doc_unpack(idx->jbc, &val);
+    if (rc) {
+      iwkv_kv_dispose(&key, &val);
+      break;
+    }
     if (!binn_load(val.data, &jbs.bn)) {
       rc = JBL_ERROR_CREATION;
       break;
@@ -642,6 +1107,44 @@ static iwrc _jb_idx_fill(struct jbidx *idx) {
   return rc;
 }
 
+/**
+ * Removes document `id` of collection `jbc` from joined documents cache.
+ * Called under collection write lock or document write lock.
+ */
+static void _jb_jcache_invalidate(struct jbcoll *jbc, int64_t id) {
+  struct ejdb *db = jbc->db;
+  struct jbdocref ref = {
+    .id = id,
+    .coll = jbc->name
+  };
+  if (!db->jcache) {
+    return;
+  }
+  pthread_mutex_lock(&db->jcache_mtx);
+  iwhmap_remove(db->jcache, &ref);
+  pthread_mutex_unlock(&db->jcache_mtx);
+}
+
+static void _jb_jcache_clear(struct ejdb *db) {
+  if (!db->jcache) {
+    return;
+  }
+  pthread_mutex_lock(&db->jcache_mtx);
+  iwhmap_clear(db->jcache);
+  pthread_mutex_unlock(&db->jcache_mtx);
+}
+
+/**
+ * Marks document `id` of collection `jbc` as modified:
+ * document is removed from joined documents cache and collection write epoch is advanced
+ * so query results cached before modification are not used anymore.
+ * Called under collection write lock or document write lock.
+ */
+static void _jb_coll_modified(struct jbcoll *jbc, int64_t id) {
+  jbc->wepoch = __sync_add_and_fetch(&jbc->db->wepoch, 1);
+  _jb_jcache_invalidate(jbc, id);
+}
+
 // Used to avoid deadlocks within a `iwkv_put` context
 static iwrc _jb_put_handler_after(iwrc rc, struct _jb_put_handler_ctx *ctx) {
   struct iwkv_val *oldval = &ctx->oldval;
@@ -654,9 +1157,16 @@ static iwrc _jb_put_handler_after(iwrc rc, struct _jb_put_handler_ctx *ctx) {
   struct jbl *prev;
   struct jbl jblprev;
   struct jbcoll *jbc = ctx->jbc;
+  bool olarge = jbi_doc_is_large(oldval->data, oldval->size);
   if (oldval->size) {
-    rc = jbl_from_buf_keep_onstack(&jblprev, oldval->data, oldval->size);
-    RCRET(rc);
+    rc = jbi_doc_unpack(jbc, oldval);
+    if (!rc) {
+      rc = jbl_from_buf_keep_onstack(&jblprev, oldval->data, oldval->size);
+    }
+    if (rc) {
+      iwkv_val_dispose(oldval);
+      return rc;
+    }
     prev = &jblprev;
   } else {
     prev = 0;
@@ -671,10 +1181,22 @@ static iwrc _jb_put_handler_after(iwrc rc, struct _jb_put_handler_ctx *ctx) {
   }
   if (!prev) {
     _jb_meta_nrecs_update(jbc->db, jbc->dbid, 1);
-    jbc->rnum += 1;
+    __sync_add_and_fetch(&jbc->rnum, 1);
   }
 
 finish:
+  // Body of large document is stored when previous document body is not needed anymore
+  if (!rc) {
+    if (ctx->xval) {
+      rc = jbi_xdoc_put(jbc, ctx->id, ctx->xval);
+    } else if (olarge) {
+      rc = jbi_xdoc_del(jbc, ctx->id);
+    }
+  }
+  if (!rc) {
+    rc = jbi_columns_put(jbc, ctx->id, ctx->jbl);
+  }
+  _jb_coll_modified(jbc, ctx->id);
   if (oldval->size) {
     iwkv_val_dispose(oldval);
   }
@@ -721,10 +1243,23 @@ static iwrc _jb_exec_scan_init(struct jbexec *ctx) {
     } else {
       ctx->scanner = jbi_uniq_scanner;
     }
-  } else {
-    ctx->scanner = jbi_full_scanner;
+  } else if (jbi_columns_covered(ctx)) {
+    ctx->scanner = jbi_columns_scanner;
     if (ctx->ux->log) {
-      iwxstr_cat2(ctx->ux->log, "[INDEX] NO");
+      iwxstr_cat2(ctx->ux->log, "[INDEX] NO [SCANNER] COLUMNS");
+    }
+  } else {
+    int nthreads = jbi_parallel_scan_threads(ctx);
+    if (nthreads > 1) {
+      ctx->scanner = jbi_parallel_scanner;
+      if (ctx->ux->log) {
+        iwxstr_printf(ctx->ux->log, "[INDEX] NO [SCANNER] PARALLEL %d", nthreads);
+      }
+    } else {
+      ctx->scanner = jbi_full_scanner;
+      if (ctx->ux->log) {
+        iwxstr_cat2(ctx->ux->log, "[INDEX] NO");
+      }
     }
   }
   return 0;
@@ -739,58 +1274,713 @@ static void _jb_exec_scan_release(struct jbexec *ctx) {
   if (ctx->proj_joined_nodes_pool) {
     iwpool_destroy(ctx->proj_joined_nodes_pool);
   }
+  jbi_page_release(ctx);
+  free(ctx->yield.buf);
+  ctx->yield.buf = 0;
   free(ctx->jblbuf);
+  free(ctx->zbuf);
+  iwxstr_destroy(ctx->rcbuf);
+  ctx->rcbuf = 0;
+  free(ctx->rckey);
+  ctx->rckey = 0;
+  if (ctx->plan) {
+    if (ctx->ux->log == ctx->plan) {
+      ctx->ux->log = 0;
+    }
+    iwxstr_destroy(ctx->plan);
+    ctx->plan = 0;
+  }
+}
+
+/**
+ * Logs query collector and keeps execution plan for slow queries log.
+ * Internal plan buffer is detached from `ux->log` before visiting of result documents.
+ */
+static iwrc _jb_exec_log_collector(struct jbexec *ctx, size_t log_pos) {
+  struct ejdb_exec *ux = ctx->ux;
+  if (!ux->log) {
+    return 0;
+  }
+  iwrc rc = iwxstr_printf(ux->log, " [COLLECTOR] %s\n", ctx->stats.collector);
+  RCRET(rc);
+  if (ux->log == ctx->plan) {
+    ux->log = 0;
+  } else if (ux->db->opts.slow_query_ms) {
+    RCB(finish, ctx->plan = iwxstr_new());
+    rc = iwxstr_cat(ctx->plan, iwxstr_ptr(ux->log) + log_pos, iwxstr_size(ux->log) - log_pos);
+  }
+
+finish:
+  return rc;
 }
 
 static iwrc _jb_noop_visitor(struct ejdb_exec *ctx, struct ejdb_doc *doc, int64_t *step) {
   return 0;
 }
 
-IW_INLINE iwrc _jb_put_impl(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
-  struct iwkv_val val, key = {
-    .data = &id,
-    .size = sizeof(id)
-  };
-  struct _jb_put_handler_ctx pctx = {
-    .id = id,
-    .jbc = jbc,
-    .jbl = jbl
-  };
-  iwrc rc = jbl_as_buf(jbl, &val.data, &val.size);
-  RCRET(rc);
-  return _jb_put_handler_after(iwkv_puth(jbc->cdb, &key, &val, 0, _jb_put_handler, &pctx), &pctx);
+static const char* _jb_exec_scanner_name(struct jbexec *ctx) {
+  if (ctx->scanner == jbi_pk_scanner) {
+    return "pk";
+  } else if (ctx->scanner == jbi_uniq_scanner) {
+    return "uniq";
+  } else if (ctx->scanner == jbi_dup_scanner) {
+    return "dup";
+  } else if (ctx->scanner == jbi_parallel_scanner) {
+    return "parallel";
+  } else if (ctx->scanner == jbi_columns_scanner) {
+    return "columns";
+  } else {
+    return "full";
+  }
 }
 
-iwrc jb_put(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
-  return _jb_put_impl(jbc, jbl, id);
+/**
+ * Stores query execution statistics into `ux->stats` as JSON object.
+ */
+static char* _jb_qcache_key(const char *coll, const char *query);
+
+static uint64_t _jb_time_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
 }
 
-iwrc jb_cursor_set(struct jbcoll *jbc, struct iwkv_cursor *cur, int64_t id, struct jbl *jbl) {
-  struct iwkv_val val;
-  struct _jb_put_handler_ctx pctx = {
-    .id = id,
-    .jbc = jbc,
-    .jbl = jbl
-  };
-  iwrc rc = jbl_as_buf(jbl, &val.data, &val.size);
-  RCRET(rc);
-  return _jb_put_handler_after(iwkv_cursor_seth(cur, &val, 0, _jb_put_handler, &pctx), &pctx);
+/**
+ * Returns latency histogram bucket of the given execution time.
+ * Values less than 4us have their own buckets, every next power of two range is split into 4 buckets.
+ */
+static int _jb_qprof_bucket(uint64_t us) {
+  if (us < 4) {
+    return (int) us;
+  }
+  int e = 63 - __builtin_clzll(us);
+  int idx = (e - 1) * 4 + (int) ((us >> (e - 2)) & 3);
+  return MIN(idx, JB_QPROF_BUCKETS - 1);
 }
 
-static iwrc _jb_exec_upsert_lw(struct jbexec *ctx) {
-  struct jbl_node *n;
-  int64_t id;
-  iwrc rc = 0;
-  struct jbl *jbl = 0;
-  struct ejdb_exec *ux = ctx->ux;
-  struct jql *q = ux->q;
-  if (q->aux->apply_placeholder) {
-    struct jqval *pv = jql_find_placeholder(q, q->aux->apply_placeholder);
-    if (!pv || (pv->type != JQVAL_JBLNODE) || !pv->vnode) {
-      rc = JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
-      goto finish;
-    }
-    n = pv->vnode;
+/**
+ * Returns inclusive upper bound of latency histogram bucket.
+ */
+static uint64_t _jb_qprof_bucket_bound(int idx) {
+  if (idx < 4) {
+    return (uint64_t) idx;
+  }
+  int e = idx / 4 + 1;
+  return ((uint64_t) (4 + idx % 4 + 1) << (e - 2)) - 1;
+}
+
+static uint64_t _jb_qprof_percentile(const struct jbqprof *p, uint64_t pct) {
+  uint64_t cnt = 0, rank = (p->calls * pct + 99) / 100;
+  for (int i = 0; i < JB_QPROF_BUCKETS; ++i) {
+    cnt += p->hist[i];
+    if (cnt && (cnt >= rank)) {
+      return MIN(_jb_qprof_bucket_bound(i), p->max_us);
+    }
+  }
+  return p->max_us;
+}
+
+static void _jb_qprof_entry_free(void *key, void *val) {
+  free(key);
+  if (val) {
+    struct jbqprof *p = val;
+    free(p->idx);
+    free(p);
+  }
+}
+
+/**
+ * Records query execution into query profiler
+ * and logs the query if its execution time exceeds slow queries threshold.
+ */
+static iwrc _jb_exec_profile(struct jbexec *ctx) {
+  iwrc rc = 0;
+  struct ejdb_exec *ux = ctx->ux;
+  struct ejdb *db = ux->db;
+  struct jbqprof *p;
+  struct jbidx *idx = ctx->midx.idx;
+  uint64_t us = _jb_time_us() - ctx->stats.start_us;
+
+  if (db->opts.slow_query_ms && (us / 1000 >= db->opts.slow_query_ms)) {
+    iwlog_warn("Slow query %" PRIu64 " ms, scanned: %" PRIu64 " returned: %" PRId64 " @%s %s\n%s",
+               us / 1000, ctx->stats.scanned, ux->cnt, ux->q->coll, ux->q->aux->buf,
+               ctx->plan ? iwxstr_ptr(ctx->plan) : "");
+  }
+  if (!db->qprof) {
+    return 0;
+  }
+  char *key = _jb_qcache_key(ux->q->coll, ux->q->aux->buf);
+  if (!key) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+
+  pthread_mutex_lock(&db->qprof_mtx);
+  p = iwhmap_get(db->qprof, key);
+  if (p) {
+    free(key);
+  } else {
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+      rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      free(key);
+      goto finish;
+    }
+    rc = iwhmap_put(db->qprof, key, p);
+    if (rc) {
+      free(key);
+      free(p);
+      goto finish;
+    }
+  }
+  ++p->calls;
+  p->scanned += ctx->stats.scanned;
+  p->fetched += ctx->stats.fetched;
+  p->returned += ux->cnt;
+  p->total_us += us;
+  p->max_us = MAX(p->max_us, us);
+  ++p->hist[_jb_qprof_bucket(us)];
+  if (ctx->stats.spilled) {
+    ++p->spills;
+  }
+  if (!idx) {
+    free(p->idx);
+    p->idx = 0;
+    p->idx_dbid = 0;
+  } else if (!p->idx || (p->idx_dbid != idx->dbid)) {
+    struct iwxstr *xstr = iwxstr_new();
+    if (!xstr) {
+      rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      goto finish;
+    }
+    rc = jbl_ptr_serialize(idx->ptr, xstr);
+    if (!rc) {
+      free(p->idx);
+      p->idx = iwxstr_destroy_keep_ptr(xstr);
+      p->idx_dbid = idx->dbid;
+    } else {
+      iwxstr_destroy(xstr);
+    }
+  }
+
+finish:
+  pthread_mutex_unlock(&db->qprof_mtx);
+  return rc;
+}
+
+static iwrc _jb_qprof_entry_add_meta(const char *key, const struct jbqprof *p, binn *list) {
+  iwrc rc = 0;
+  binn *hist = 0, *bucket = 0;
+  const char *query = strchr(key, '\n');
+  size_t clen = query ? query - key : 0;
+  char coll[clen + 1];
+  memcpy(coll, key, clen);
+  coll[clen] = '\0';
+  query = query ? query + 1 : key;
+
+  binn *meta = binn_object();
+  if (!meta) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  if (  !binn_object_set_str(meta, "collection", coll)
+     || !binn_object_set_str(meta, "query", query)
+     || !binn_object_set_int64(meta, "calls", (int64_t) p->calls)
+     || !binn_object_set_int64(meta, "scanned", (int64_t) p->scanned)
+     || !binn_object_set_int64(meta, "fetched", (int64_t) p->fetched)
+     || !binn_object_set_int64(meta, "returned", (int64_t) p->returned)
+     || !binn_object_set_int64(meta, "spills", (int64_t) p->spills)
+     || (p->idx && !binn_object_set_str(meta, "index", p->idx))
+     || !binn_object_set_int64(meta, "total_us", (int64_t) p->total_us)
+     || !binn_object_set_int64(meta, "max_us", (int64_t) p->max_us)
+     || !binn_object_set_int64(meta, "p50_us", (int64_t) _jb_qprof_percentile(p, 50))
+     || !binn_object_set_int64(meta, "p90_us", (int64_t) _jb_qprof_percentile(p, 90))
+     || !binn_object_set_int64(meta, "p99_us", (int64_t) _jb_qprof_percentile(p, 99))) {
+    rc = JBL_ERROR_CREATION;
+    goto finish;
+  }
+  hist = binn_list();
+  if (!hist) {
+    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    goto finish;
+  }
+  for (int i = 0; i < JB_QPROF_BUCKETS; ++i) {
+    if (!p->hist[i]) {
+      continue;
+    }
+    bucket = binn_list();
+    if (!bucket) {
+      rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      goto finish;
+    }
+    if (  !binn_list_add_int64(bucket, (int64_t) MIN(_jb_qprof_bucket_bound(i), p->max_us))
+       || !binn_list_add_int64(bucket, (int64_t) p->hist[i])
+       || !binn_list_add_list(hist, bucket)) {
+      rc = JBL_ERROR_CREATION;
+      goto finish;
+    }
+    binn_free(bucket);
+    bucket = 0;
+  }
+  if (  !binn_object_set_list(meta, "histogram", hist)
+     || !binn_list_add_value(list, meta)) {
+    rc = JBL_ERROR_CREATION;
+  }
+
+finish:
+  binn_free(meta);
+  if (hist) {
+    binn_free(hist);
+  }
+  if (bucket) {
+    binn_free(bucket);
+  }
+  return rc;
+}
+
+static iwrc _jb_qprof_add_meta(struct ejdb *db, binn *obj) {
+  iwrc rc = 0;
+  struct iwhmap_iter iter;
+  binn *qlist = binn_list();
+  if (!qlist) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  if (db->qprof) {
+    pthread_mutex_lock(&db->qprof_mtx);
+    iwhmap_iter_init(db->qprof, &iter);
+    while (!rc && iwhmap_iter_next(&iter)) {
+      rc = _jb_qprof_entry_add_meta(iter.key, iter.val, qlist);
+    }
+    pthread_mutex_unlock(&db->qprof_mtx);
+    RCGO(rc, finish);
+  }
+  if (!binn_object_set_list(obj, "queries", qlist)) {
+    rc = JBL_ERROR_CREATION;
+  }
+
+finish:
+  binn_free(qlist);
+  return rc;
+}
+
+static void _jb_rcache_entry_free(void *key, void *val) {
+  free(key);
+  if (val) {
+    struct jbrcentry *e = val;
+    e->cache->size -= e->size;
+    if (--e->refs == 0) {
+      free(e);
+    }
+  }
+}
+
+static bool _jb_rcache_eviction_needed(struct iwhmap *hm, void *op) {
+  struct jbrcache *cache = op;
+  return cache->size > cache->max_size;
+}
+
+static void _jb_rcache_entry_release(struct jbrcentry *e) {
+  struct jbrcache *cache = e->cache;
+  pthread_mutex_lock(&cache->mtx);
+  if (--e->refs == 0) {
+    free(e);
+  }
+  pthread_mutex_unlock(&cache->mtx);
+}
+
+/**
+ * Visits result set documents of query results cache entry.
+ */
+static iwrc _jb_rcache_visit(struct jbexec *ctx, struct jbrcentry *e) {
+  iwrc rc = 0;
+  int64_t step, skip = 0;
+  uint32_t sz, pos = 0;
+  struct ejdb_exec *ux = ctx->ux;
+  struct iwpool *pool = ux->pool;
+
+  if ((ux->q->aux->qmode & JQP_QRY_AGGREGATE) || (ux->visitor == _jb_noop_visitor)) {
+    // Only number of documents is kept for counting queries
+    ux->cnt = e->cnt;
+    return 0;
+  }
+  while (pos < e->dsz) {
+    struct jbl jbl, njbl;
+    struct ejdb_doc doc = { 0 };
+    memcpy(&doc.id, e->data + pos, sizeof(doc.id));
+    pos += sizeof(doc.id);
+    memcpy(&sz, e->data + pos, sizeof(sz));
+    pos += sizeof(sz);
+    RCC(rc, finish, jbl_from_buf_keep_onstack(&jbl, e->data + pos, sz));
+    doc.raw = &jbl;
+    pos += sz;
+    memcpy(&sz, e->data + pos, sizeof(sz));
+    pos += sizeof(sz);
+    if (sz && !skip) {
+      if (!pool) {
+        RCB(finish, pool = iwpool_create((size_t) sz * 2));
+      }
+      RCC(rc, finish, jbl_from_buf_keep_onstack(&njbl, e->data + pos, sz));
+      RCC(rc, finish, jbl_to_node(&njbl, &doc.node, true, pool));
+    }
+    pos += sz;
+    if (skip) {
+      --skip;
+      continue;
+    }
+    do {
+      step = 1;
+      RCC(rc, finish, jb_exec_visit(ctx, &doc, &step));
+    } while (step == -1);
+    ++ux->cnt;
+    if (step < 1) {
+      break;
+    }
+    skip = step - 1;
+    if (pool && (pool != ux->pool)) {
+      iwpool_destroy(pool);
+      pool = 0;
+    }
+  }
+
+finish:
+  if (pool && (pool != ux->pool)) {
+    iwpool_destroy(pool);
+  }
+  return rc;
+}
+
+/**
+ * Serves query from results cache if cached result set is up to date with collection.
+ * Otherwise starts recording of query result set.
+ * Called under collection read lock.
+ */
+static iwrc _jb_rcache_lookup(struct jbexec *ctx, bool *hit) {
+  iwrc rc = 0;
+  char *qkey = 0;
+  struct iwxstr *xstr = 0;
+  struct jbrcentry *e;
+  struct ejdb_exec *ux = ctx->ux;
+  struct jbrcache *cache = ux->db->rcache;
+
+  *hit = false;
+  if (  ux->log || ux->stats || ux->page_token || ux->next_page_token
+     || jql_has_apply(ux->q) || jql_has_projection_joins(ux->q)) {
+    return 0;
+  }
+  RCB(finish, qkey = _jb_qcache_key(ux->q->coll, ux->q->aux->buf));
+  RCB(finish, xstr = iwxstr_new());
+  char mode = ((ux->q->aux->qmode & JQP_QRY_AGGREGATE) || (ux->visitor == _jb_noop_visitor))
+              ? 'c' : ctx->projection ? 'p' : 'r';
+  RCC(rc, finish, iwxstr_printf(xstr, "%s\n%c %" PRId64 " %" PRId64, qkey, mode, ux->skip, ux->limit));
+  RCC(rc, finish, jql_placeholders_key(ux->q, xstr));
+
+  pthread_mutex_lock(&cache->mtx);
+  e = iwhmap_get(cache->map, iwxstr_ptr(xstr));
+  if (e && (e->epoch != ctx->jbc->wepoch)) {
+    iwhmap_remove(cache->map, iwxstr_ptr(xstr));
+    e = 0;
+  }
+  if (e) {
+    ++e->refs;
+    ++cache->hits;
+  } else {
+    ++cache->misses;
+  }
+  pthread_mutex_unlock(&cache->mtx);
+
+  if (e) {
+    *hit = true;
+    rc = _jb_rcache_visit(ctx, e);
+    _jb_rcache_entry_release(e);
+  } else {
+    RCB(finish, ctx->rcbuf = iwxstr_new());
+    ctx->rckey = iwxstr_destroy_keep_ptr(xstr);
+    xstr = 0;
+  }
+
+finish:
+  free(qkey);
+  iwxstr_destroy(xstr);
+  return rc;
+}
+
+/**
+ * Appends visited document to the recorded query result set.
+ */
+static iwrc _jb_rcache_record(struct jbexec *ctx, struct ejdb_doc *doc) {
+  iwrc rc = 0;
+  void *buf;
+  size_t sz;
+  uint32_t usz = 0;
+  struct jbl *njbl = 0;
+  struct iwxstr *xstr = ctx->rcbuf;
+
+  if (!doc->raw) {
+    goto abandon;
+  }
+  RCC(rc, finish, jbl_as_buf(doc->raw, &buf, &sz));
+  usz = (uint32_t) sz;
+  RCC(rc, finish, iwxstr_cat(xstr, &doc->id, sizeof(doc->id)));
+  RCC(rc, finish, iwxstr_cat(xstr, &usz, sizeof(usz)));
+  RCC(rc, finish, iwxstr_cat(xstr, buf, sz));
+  usz = 0;
+  if (doc->node) {
+    RCC(rc, finish, jbl_from_node(&njbl, doc->node));
+    RCC(rc, finish, jbl_as_buf(njbl, &buf, &sz));
+    usz = (uint32_t) sz;
+  }
+  RCC(rc, finish, iwxstr_cat(xstr, &usz, sizeof(usz)));
+  if (usz) {
+    RCC(rc, finish, iwxstr_cat(xstr, buf, usz));
+  }
+  if (iwxstr_size(xstr) <= ctx->ux->db->rcache->max_size / JB_RCACHE_MAX_ENTRY_RATIO) {
+    goto finish;
+  }
+
+abandon:
+  iwxstr_destroy(ctx->rcbuf);
+  ctx->rcbuf = 0;
+
+finish:
+  jbl_destroy(&njbl);
+  return rc;
+}
+
+/**
+ * Stores recorded query result set into query results cache.
+ */
+static iwrc _jb_rcache_put(struct jbexec *ctx) {
+  iwrc rc = 0;
+  struct jbrcache *cache = ctx->ux->db->rcache;
+  size_t dsz = iwxstr_size(ctx->rcbuf);
+  struct jbrcentry *e = malloc(sizeof(*e) + dsz);
+  if (!e) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  e->cache = cache;
+  e->epoch = ctx->jbc->wepoch;
+  e->cnt = ctx->ux->cnt;
+  e->refs = 1;
+  e->dsz = (uint32_t) dsz;
+  e->size = sizeof(*e) + dsz + strlen(ctx->rckey) + 1;
+  memcpy(e->data, iwxstr_ptr(ctx->rcbuf), dsz);
+
+  pthread_mutex_lock(&cache->mtx);
+  iwhmap_remove(cache->map, ctx->rckey);
+  cache->size += e->size;
+  rc = iwhmap_put(cache->map, ctx->rckey, e);
+  if (rc) {
+    cache->size -= e->size;
+    free(e);
+  } else {
+    ctx->rckey = 0; // Owned by cache
+  }
+  pthread_mutex_unlock(&cache->mtx);
+  return rc;
+}
+
+static iwrc _jb_rcache_add_meta(struct ejdb *db, binn *obj) {
+  iwrc rc = 0;
+  struct jbrcache *cache = db->rcache;
+  binn *meta = binn_object();
+  if (!meta) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  pthread_mutex_lock(&cache->mtx);
+  uint64_t total = cache->hits + cache->misses;
+  if (  !binn_object_set_int64(meta, "size", (int64_t) cache->size)
+     || !binn_object_set_int64(meta, "max_size", (int64_t) cache->max_size)
+     || !binn_object_set_int64(meta, "entries", iwhmap_count(cache->map))
+     || !binn_object_set_int64(meta, "hits", (int64_t) cache->hits)
+     || !binn_object_set_int64(meta, "misses", (int64_t) cache->misses)
+     || !binn_object_set_double(meta, "hit_rate", total ? (double) cache->hits / total : 0.0)) {
+    rc = JBL_ERROR_CREATION;
+  }
+  pthread_mutex_unlock(&cache->mtx);
+  if (!rc && !binn_object_set_object(obj, "result_cache", meta)) {
+    rc = JBL_ERROR_CREATION;
+  }
+  binn_free(meta);
+  return rc;
+}
+
+/**
+ * Checks query execution cancellation flag, scanned entries budget and deadline.
+ * Deadline is checked once per `JB_EXEC_GUARD_CLOCK_INTERVAL` of `scanned` entries.
+ * May be called from parallel scan workers.
+ */
+iwrc jb_exec_guard(struct jbexec *ctx, uint64_t scanned) {
+  struct ejdb_exec *ux = ctx->ux;
+  if (ux->cancel && *ux->cancel) {
+    return EJDB_ERROR_QUERY_CANCELLED;
+  }
+  if ((ux->max_scanned > 0) && (scanned > (uint64_t) ux->max_scanned)) {
+    return EJDB_ERROR_QUERY_BUDGET_EXCEEDED;
+  }
+  if (ctx->deadline_ms && !(scanned & (JB_EXEC_GUARD_CLOCK_INTERVAL - 1))) {
+    uint64_t ts;
+    iwrc rc = iwp_current_time_ms(&ts, true);
+    RCRET(rc);
+    if (ts >= ctx->deadline_ms) {
+      return EJDB_ERROR_QUERY_TIMEOUT;
+    }
+  }
+  return 0;
+}
+
+iwrc jb_exec_visit(struct jbexec *ctx, struct ejdb_doc *doc, int64_t *step) {
+  iwrc rc;
+  struct ejdb_exec *ux = ctx->ux;
+  if (ctx->guarded) {
+    if (ux->max_output_bytes > 0) {
+      ctx->obytes += doc->raw ? doc->raw->bn.size : 0;
+      if (ctx->obytes > (uint64_t) ux->max_output_bytes) {
+        return EJDB_ERROR_QUERY_BUDGET_EXCEEDED;
+      }
+    }
+    rc = jb_exec_guard(ctx, 0);
+    RCRET(rc);
+  }
+  if (ctx->rcbuf && (ux->visitor != _jb_noop_visitor)) {
+    rc = _jb_rcache_record(ctx, doc);
+    RCRET(rc);
+  }
+  rc = ux->visitor(ux, doc, step);
+  if (!rc && ctx->rcbuf && (*step != 1)) {
+    // Result set is not visited completely
+    iwxstr_destroy(ctx->rcbuf);
+    ctx->rcbuf = 0;
+  }
+  return rc;
+}
+
+static iwrc _jb_exec_stats(struct jbexec *ctx) {
+  iwrc rc;
+  uint64_t ts;
+  struct jbl_node *root;
+  struct ejdb_exec *ux = ctx->ux;
+  struct jbstats *st = &ctx->stats;
+  struct iwxstr *xstr = 0;
+  struct iwpool *pool = iwpool_create(256);
+  if (!pool) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  RCC(rc, finish, iwp_current_time_ms(&ts, true));
+  RCB(finish, root = iwpool_calloc(sizeof(*root), pool));
+  root->type = JBV_OBJECT;
+  RCC(rc, finish, jbn_add_item_str(root, "scanner", _jb_exec_scanner_name(ctx), -1, 0, pool));
+  if (ctx->midx.idx) {
+    RCB(finish, xstr = iwxstr_new());
+    RCC(rc, finish, jbl_ptr_serialize(ctx->midx.idx->ptr, xstr));
+    RCC(rc, finish, jbn_add_item_str(root, "index", iwxstr_ptr(xstr), (int) iwxstr_size(xstr), 0, pool));
+  } else {
+    RCC(rc, finish, jbn_add_item_null(root, "index", pool));
+  }
+  RCC(rc, finish, jbn_add_item_str(root, "collector", st->collector, -1, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "scanned", (int64_t) st->scanned, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "prefiltered", (int64_t) st->prefiltered, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "yields", (int64_t) st->yields, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "fetched", (int64_t) st->fetched, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "bytes", (int64_t) st->bytes, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "matched", (int64_t) st->matched, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "returned", ux->cnt, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "sort_ms", (int64_t) st->sort_ms, 0, pool));
+  RCC(rc, finish, jbn_add_item_bool(root, "spilled", st->spilled, 0, pool));
+  RCC(rc, finish, jbn_add_item_i64(root, "time_ms", (int64_t) (ts - st->start_ms), 0, pool));
+  iwxstr_clear(ux->stats);
+  rc = jbn_as_json(root, jbl_xstr_json_printer, ux->stats, 0);
+
+finish:
+  iwxstr_destroy(xstr);
+  iwpool_destroy(pool);
+  return rc;
+}
+
+/**
+ * Replaces packed value `val` of document `id` by stub of large document if value size exceeds
+ * `EJDB_OPTS.large_document_sz`. Document body is kept in `xval` to be stored by `_jb_put_handler_after()`.
+ */
+static iwrc _jb_doc_stub(
+  struct jbcoll *jbc, int64_t id, struct jbl *jbl, struct iwkv_val *val,
+  struct _jb_put_handler_ctx *pctx, struct iwkv_val *xval, void **xbufp) {
+  void *doc;
+  size_t docsz;
+  *xbufp = 0;
+  pctx->xval = 0;
+  if (!jbi_xdoc_needed(jbc, val->size)) {
+    return 0;
+  }
+  iwrc rc = jbl_as_buf(jbl, &doc, &docsz);
+  RCRET(rc);
+  *xval = *val;
+  rc = jbi_xdoc_stub(jbc, id, doc, docsz, val, xbufp);
+  if (!rc) {
+    pctx->xval = xval;
+  }
+  return rc;
+}
+
+IW_INLINE iwrc _jb_put_impl(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
+  void *zbuf, *xbuf;
+  struct iwkv_val val, xval, key = {
+    .data = &id,
+    .size = sizeof(id)
+  };
+  struct _jb_put_handler_ctx pctx = {
+    .id = id,
+    .jbc = jbc,
+    .jbl = jbl
+  };
+  iwrc rc = jbl_as_buf(jbl, &val.data, &val.size);
+  RCRET(rc);
+  rc = jbi_doc_pack(jbc, &val, &zbuf);
+  RCRET(rc);
+  rc = _jb_doc_stub(jbc, id, jbl, &val, &pctx, &xval, &xbuf);
+  if (!rc) {
+    rc = _jb_put_handler_after(iwkv_puth(jbc->cdb, &key, &val, 0, _jb_put_handler, &pctx), &pctx);
+  }
+  free(xbuf);
+  free(zbuf);
+  return rc;
+}
+
+iwrc jb_put(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
+  return _jb_put_impl(jbc, jbl, id);
+}
+
+iwrc jb_cursor_set(struct jbcoll *jbc, struct iwkv_cursor *cur, int64_t id, struct jbl *jbl) {
+  void *zbuf, *xbuf;
+  struct iwkv_val val, xval;
+  struct _jb_put_handler_ctx pctx = {
+    .id = id,
+    .jbc = jbc,
+    .jbl = jbl
+  };
+  iwrc rc = jbl_as_buf(jbl, &val.data, &val.size);
+  RCRET(rc);
+  rc = jbi_doc_pack(jbc, &val, &zbuf);
+  RCRET(rc);
+  rc = _jb_doc_stub(jbc, id, jbl, &val, &pctx, &xval, &xbuf);
+  if (!rc) {
+    rc = _jb_put_handler_after(iwkv_cursor_seth(cur, &val, 0, _jb_put_handler, &pctx), &pctx);
+  }
+  free(xbuf);
+  free(zbuf);
+  return rc;
+}
+
+static iwrc _jb_exec_upsert_lw(struct jbexec *ctx) {
+  struct jbl_node *n;
+  int64_t id;
+  iwrc rc = 0;
+  struct jbl *jbl = 0;
+  struct ejdb_exec *ux = ctx->ux;
+  struct jql *q = ux->q;
+  if (q->aux->apply_placeholder) {
+    struct jqval *pv = jql_find_placeholder(q, q->aux->apply_placeholder);
+    if (!pv || (pv->type != JQVAL_JBLNODE) || !pv->vnode) {
+      rc = JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
+      goto finish;
+    }
+    n = pv->vnode;
   } else {
     n = q->aux->apply;
   }
@@ -827,17 +2017,31 @@ iwrc ejdb_exec(struct ejdb_exec *ux) {
   }
   int rci;
   iwrc rc = 0;
+  struct jbexec ctx = {
+    .ux = ux,
+    .projection = jql_has_projection(ux->q)
+  };
   if (!ux->visitor) {
     ux->visitor = _jb_noop_visitor;
-    ux->q->aux->projection = 0; // Actually we don't need projection if exists
+    ctx.projection = false; // Actually we don't need projection if exists
   }
   if (ux->log) {
     // set terminating NULL to current pos of log
     iwxstr_cat(ux->log, 0, 0);
   }
-  struct jbexec ctx = {
-    .ux = ux
-  };
+  if (ux->stats) {
+    iwxstr_clear(ux->stats);
+    RCR(iwp_current_time_ms(&ctx.stats.start_ms, true));
+  }
+  if (ux->db->qprof || ux->db->opts.slow_query_ms) {
+    ctx.stats.start_us = _jb_time_us();
+  }
+  if (ux->timeout_ms) {
+    RCR(iwp_current_time_ms(&ctx.deadline_ms, true));
+    ctx.deadline_ms += ux->timeout_ms;
+  }
+  ctx.guarded = ux->cancel || ux->timeout_ms || ux->max_scanned > 0
+                || ux->max_sort_bytes > 0 || ux->max_output_bytes > 0;
   if (ux->limit < 1) {
     rc = jql_get_limit(ux->q, &ux->limit);
     RCRET(rc);
@@ -845,7 +2049,7 @@ iwrc ejdb_exec(struct ejdb_exec *ux) {
       ux->limit = INT64_MAX;
     }
   }
-  if (ux->skip < 1) {
+  if ((ux->skip < 1) && !(ux->page_token && *ux->page_token != '\0')) {
     rc = jql_get_skip(ux->q, &ux->skip);
     RCRET(rc);
   }
@@ -853,31 +2057,93 @@ iwrc ejdb_exec(struct ejdb_exec *ux) {
                                   jql_has_apply(ux->q) ? JB_COLL_ACQUIRE_WRITE : JB_COLL_ACQUIRE_EXISTING,
                                   &ctx.jbc);
   if (rc == IW_ERROR_NOT_EXISTS) {
+    if (ux->next_page_token) {
+      iwxstr_clear(ux->next_page_token);
+    }
     return 0;
   } else {
     RCRET(rc);
   }
+  if (!jql_has_apply(ux->q)) {
+    jb_coll_scan_lock(ctx.jbc);
+  }
 
-  RCC(rc, finish, _jb_exec_scan_init(&ctx));
-  if (ctx.sorting) {
-    if (ux->log) {
-      iwxstr_cat2(ux->log, " [COLLECTOR] SORTER\n");
+  if (ux->db->rcache) {
+    bool hit;
+    RCC(rc, finish, _jb_rcache_lookup(&ctx, &hit));
+    if (hit) {
+      if (ctx.stats.start_us) {
+        rc = _jb_exec_profile(&ctx);
+      }
+      goto finish;
     }
+  }
+  size_t log_pos = ux->log ? iwxstr_size(ux->log) : 0;
+  if (ux->db->opts.slow_query_ms && !ux->log) {
+    // Execution plan is logged into internal buffer for slow queries log
+    RCB(finish, ctx.plan = ux->log = iwxstr_new());
+  }
+  ctx.page.enabled = ux->page_token || ux->next_page_token;
+  RCC(rc, finish, _jb_exec_scan_init(&ctx));
+  if (  !ctx.sorting && !ctx.page.enabled && ctx.projection
+     && !jql_has_apply(ux->q) && jql_has_projection_joins(ux->q)) {
+    // Collect result documents by windows to fetch joined documents in batches
+    ctx.sorting = true;
+    ctx.windowed = true;
+  }
+  RCC(rc, finish, jbi_page_init(&ctx));
+  if (ux->db->opts.read_yield_ms && !jql_has_apply(ux->q) && (ctx.scanner == jbi_full_scanner)) {
+    // Document ids never move while collection lock is released, unlike entries of indexes
+    ctx.yield.enabled = true;
+    ctx.yield.idxgen = ctx.jbc->idxgen;
+    RCC(rc, finish, iwp_current_time_ms(&ctx.yield.deadline_ms, true));
+    ctx.yield.deadline_ms += ux->db->opts.read_yield_ms;
+  } else if (  ux->db->opts.apply_batch_size && jql_has_apply(ux->q)
+            && !ctx.sorting && (ctx.scanner == jbi_full_scanner)) {
+    // Documents are modified by consumer right after they are matched,
+    // so collection write lock may be released between batches of modified documents
+    ctx.yield.enabled = true;
+    ctx.yield.write = true;
+    ctx.yield.idxgen = ctx.jbc->idxgen;
+  }
+  if (jql_has_aggregates(ux->q)) {
+    // Implied ordering of aggregate query is used only to select index, groups are collected by consumer
+    struct jqp_aux *aux = ux->q->aux;
+    ctx.sorting = false;
+    ctx.agc.ordered = aux->aggregate_orderby && ctx.midx.idx && ctx.midx.orderby_support
+                      && (aux->groupby || ctx.midx.cursor_init != IWKV_CURSOR_EQ);
+    ctx.stats.collector = ctx.agc.ordered ? "AGGREGATE ORDERED" : "AGGREGATE";
+    RCC(rc, finish, _jb_exec_log_collector(&ctx, log_pos));
+    rc = ctx.scanner(&ctx, jbi_aggregate_consumer);
+  } else if (ctx.sorting) {
+    ctx.stats.collector = ctx.windowed ? "WINDOW" : "SORTER";
+    RCC(rc, finish, _jb_exec_log_collector(&ctx, log_pos));
     rc = ctx.scanner(&ctx, jbi_sorter_consumer);
   } else {
-    if (ux->log) {
-      iwxstr_cat2(ux->log, " [COLLECTOR] PLAIN\n");
-    }
+    ctx.stats.collector = "PLAIN";
+    RCC(rc, finish, _jb_exec_log_collector(&ctx, log_pos));
     rc = ctx.scanner(&ctx, jbi_consumer);
   }
   RCGO(rc, finish);
+  if (ctx.rcbuf) {
+    RCC(rc, finish, _jb_rcache_put(&ctx));
+  }
   if ((ux->cnt == 0) && jql_has_apply_upsert(ux->q)) {
     // No records found trying to upsert new record
-    rc = _jb_exec_upsert_lw(&ctx);
+    RCC(rc, finish, _jb_exec_upsert_lw(&ctx));
+  }
+  if (ux->stats) {
+    RCC(rc, finish, _jb_exec_stats(&ctx));
+  }
+  if (ctx.stats.start_us) {
+    rc = _jb_exec_profile(&ctx);
   }
 
 finish:
   _jb_exec_scan_release(&ctx);
+  if (!jql_has_apply(ux->q)) {
+    jb_coll_scan_unlock(ctx.jbc);
+  }
   API_COLL_UNLOCK(ctx.jbc, rci, rc);
   jql_reset(ux->q, true, false);
   return rc;
@@ -1007,9 +2273,120 @@ iwrc ejdb_count(struct ejdb *db, struct jql *q, int64_t *count, int64_t limit) {
   return _jb_count(db, q, count, limit, 0);
 }
 
+/**
+ * Builds prepared query cache key: `<coll>\n<query>` where runs of whitespaces
+ * outside of string literals are collapsed into a single space.
+ */
+static char* _jb_qcache_key(const char *coll, const char *query) {
+  size_t clen = coll ? strlen(coll) : 0;
+  char *key = malloc(clen + strlen(query) + 2);
+  if (!key) {
+    return 0;
+  }
+  char *wp = key;
+  if (clen) {
+    memcpy(wp, coll, clen);
+    wp += clen;
+  }
+  *wp++ = '\n';
+  bool instr = false, space = false;
+  for (const char *rp = query; *rp; ++rp) {
+    char c = *rp;
+    if (instr) {
+      *wp++ = c;
+      if (c == '\\' && rp[1]) {
+        *wp++ = *++rp;
+      } else if (c == '"') {
+        instr = false;
+      }
+      continue;
+    }
+    if (isspace((unsigned char) c)) {
+      space = true;
+      continue;
+    }
+    if (space && wp[-1] != '\n') {
+      *wp++ = ' ';
+    }
+    space = false;
+    if (c == '"') {
+      instr = true;
+    }
+    *wp++ = c;
+  }
+  *wp = '\0';
+  return key;
+}
+
+static void _jb_qcache_entry_free(void *key, void *val) {
+  free(key);
+  if (val) {
+    struct jql *q = val;
+    jql_destroy(&q);
+  }
+}
+
+iwrc ejdb_query_prepared(
+  struct ejdb *db, const char *coll, const char *query, jql_create_mode_t mode,
+  struct jql **qptr) {
+  if (!db || !query || !qptr) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *qptr = 0;
+  if (!db->qcache) {
+    return jql_create2(qptr, coll, query, mode);
+  }
+  iwrc rc = 0;
+  struct jql *tq, *q = 0;
+  char *key = _jb_qcache_key(coll, query);
+  if (!key) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+
+  pthread_mutex_lock(&db->qcache_mtx);
+  tq = iwhmap_get(db->qcache, key);
+  if (tq) {
+    rc = jql_clone(tq, &q);
+  }
+  pthread_mutex_unlock(&db->qcache_mtx);
+  if (tq) {
+    free(key);
+    goto finish;
+  }
+
+  // Parse query outside of cache lock
+  rc = jql_create2(&tq, coll, query, mode);
+  if (rc) {
+    free(key);
+    q = tq; // Query kept on parse error if JQL_KEEP_QUERY_ON_PARSE_ERROR
+    goto finish;
+  }
+  pthread_mutex_lock(&db->qcache_mtx);
+  struct jql *eq = iwhmap_get(db->qcache, key);
+  if (eq) { // Query was cached by concurrent thread
+    jql_destroy(&tq);
+    free(key);
+    tq = eq;
+  } else {
+    rc = iwhmap_put(db->qcache, key, tq);
+    if (rc) {
+      jql_destroy(&tq);
+      free(key);
+    }
+  }
+  if (!rc) {
+    rc = jql_clone(tq, &q);
+  }
+  pthread_mutex_unlock(&db->qcache_mtx);
+
+finish:
+  *qptr = q;
+  return rc;
+}
+
 iwrc ejdb_count2(struct ejdb *db, const char *coll, const char *q, int64_t *count, int64_t limit) {
   struct jql *jql;
-  iwrc rc = jql_create(&jql, coll, q);
+  iwrc rc = ejdb_query_prepared(db, coll, q, 0, &jql);
   RCRET(rc);
   rc = _jb_count(db, jql, count, limit, 0);
   jql_destroy(&jql);
@@ -1054,7 +2431,7 @@ iwrc ejdb_list3(
   list->first = 0;
   list->db = db;
   list->pool = pool;
-  RCC(rc, finish, jql_create(&list->q, coll, query));
+  RCC(rc, finish, ejdb_query_prepared(db, coll, query, 0, &list->q));
   rc = _jb_list(db, list->q, &list->first, limit, log, list->pool);
 
 finish:
@@ -1115,6 +2492,158 @@ void ejdb_list_destroy(struct ejdb_list **listp) {
   }
 }
 
+struct ejdb_cursor {
+  struct ejdb     *db;
+  struct jql      *q;
+  struct iwpool   *pool;    /**< Pool of the current batch */
+  struct ejdb_doc *doc;     /**< Next document to be returned */
+  struct iwxstr   *token;   /**< Keyset continuation token, zero if cursor is not batched */
+  int64_t batch;
+  int64_t limit;
+  int64_t skip;
+  int64_t fetched;          /**< Number of documents fetched so far */
+  bool    owned_q;
+  bool    eof;
+};
+
+static iwrc _jb_cursor_fetch(struct ejdb_cursor *cur) {
+  iwrc rc = 0;
+  struct _list_visitor_ctx lvc = { 0 };
+  int64_t limit = cur->limit - cur->fetched;
+  struct ejdb_exec ux = {
+    .db = cur->db,
+    .q = cur->q,
+    .visitor = _jb_exec_list_visitor,
+    .opaque = &lvc
+  };
+
+  if (cur->pool) {
+    iwpool_destroy(cur->pool);
+    cur->pool = 0;
+  }
+  if (limit < 1) {
+    cur->eof = true;
+    return 0;
+  }
+  RCB(finish, cur->pool = iwpool_create(1024));
+  ux.pool = cur->pool;
+  if (cur->token) {
+    ux.limit = MIN(limit, cur->batch);
+    ux.page_token = cur->fetched ? iwxstr_ptr(cur->token) : 0;
+    ux.next_page_token = cur->token;
+  } else {
+    ux.limit = limit;
+    ux.skip = cur->skip + cur->fetched;
+  }
+  RCC(rc, finish, ejdb_exec(&ux));
+
+  cur->doc = lvc.head;
+  cur->fetched += ux.cnt;
+  if (!cur->token || !ux.cnt) {
+    cur->eof = true;
+  } else if (!iwxstr_size(cur->token)) {
+    if ((ux.cnt == ux.limit) && (ux.limit < limit)) {
+      // Query plan doesn't support keyset continuation, fetch the rest at once
+      iwxstr_destroy(cur->token);
+      cur->token = 0;
+    } else {
+      cur->eof = true;
+    }
+  }
+
+finish:
+  if (rc) {
+    cur->doc = 0;
+    cur->eof = true;
+  }
+  return rc;
+}
+
+iwrc ejdb_cursor_open(struct ejdb *db, struct jql *q, int64_t batch, struct ejdb_cursor **curp) {
+  if (!db || !q || !curp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  iwrc rc = 0;
+  *curp = 0;
+  struct ejdb_cursor *cur = calloc(1, sizeof(*cur));
+  if (!cur) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  cur->db = db;
+  cur->q = q;
+  RCC(rc, finish, jql_get_limit(q, &cur->limit));
+  if (cur->limit < 1) {
+    cur->limit = INT64_MAX;
+  }
+  RCC(rc, finish, jql_get_skip(q, &cur->skip));
+  if ((batch > 0) && !jql_has_apply(q) && !jql_has_aggregates(q)) {
+    cur->batch = batch;
+    RCB(finish, cur->token = iwxstr_new());
+  }
+
+finish:
+  if (rc) {
+    ejdb_cursor_close(&cur);
+  } else {
+    *curp = cur;
+  }
+  return rc;
+}
+
+iwrc ejdb_cursor_open2(
+  struct ejdb         *db,
+  const char          *coll,
+  const char          *query,
+  int64_t              batch,
+  struct ejdb_cursor **curp) {
+  if (!curp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  struct jql *q;
+  *curp = 0;
+  iwrc rc = ejdb_query_prepared(db, coll, query, 0, &q);
+  RCRET(rc);
+  rc = ejdb_cursor_open(db, q, batch, curp);
+  if (rc) {
+    jql_destroy(&q);
+  } else {
+    (*curp)->owned_q = true;
+  }
+  return rc;
+}
+
+iwrc ejdb_cursor_next(struct ejdb_cursor *cur, struct ejdb_doc **docp) {
+  if (!cur || !docp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *docp = 0;
+  if (!cur->doc && !cur->eof) {
+    RCR(_jb_cursor_fetch(cur));
+  }
+  if (cur->doc) {
+    *docp = cur->doc;
+    cur->doc = cur->doc->next;
+  }
+  return 0;
+}
+
+void ejdb_cursor_close(struct ejdb_cursor **curp) {
+  if (curp) {
+    struct ejdb_cursor *cur = *curp;
+    if (cur) {
+      if (cur->owned_q) {
+        jql_destroy(&cur->q);
+      }
+      if (cur->pool) {
+        iwpool_destroy(cur->pool);
+      }
+      iwxstr_destroy(cur->token);
+      free(cur);
+    }
+    *curp = 0;
+  }
+}
+
 iwrc ejdb_remove_index(struct ejdb *db, const char *coll, const char *path, ejdb_idx_mode_t mode) {
   if (!db || !coll || !path) {
     return IW_ERROR_INVALID_ARGS;
@@ -1145,6 +2674,7 @@ iwrc ejdb_remove_index(struct ejdb *db, const char *coll, const char *path, ejdb
       } else {
         jbc->idx = idx->next;
       }
+      ++jbc->idxgen;
       if (idx->idb) {
         iwkv_db_destroy(&idx->idb);
       }
@@ -1216,50 +2746,157 @@ iwrc ejdb_ensure_index(struct ejdb *db, const char *coll, const char *path, ejdb
     idx->idbf |= IWDB_COMPOUND_KEYS;
   }
 
-  RCC(rc, finish, iwkv_new_db(db->iwkv, idx->idbf, &idx->dbid, &idx->idb));
-  RCC(rc, finish, _jb_idx_fill(idx));
+  RCC(rc, finish, iwkv_new_db(db->iwkv, idx->idbf, &idx->dbid, &idx->idb));
+  RCC(rc, finish, _jb_idx_fill(idx));
+
+  // save index meta into metadb
+  imeta = binn_object();
+  if (!imeta) {
+    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    goto finish;
+  }
+
+  if (  !binn_object_set_str(imeta, "ptr", path)
+     || !binn_object_set_uint32(imeta, "mode", idx->mode)
+     || !binn_object_set_uint32(imeta, "idbf", idx->idbf)
+     || !binn_object_set_uint32(imeta, "dbid", idx->dbid)) {
+    rc = JBL_ERROR_CREATION;
+    goto finish;
+  }
+
+  key.data = keybuf;
+  // Full key format: i.<coldbid>.<idxdbid>
+  key.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_IDXMETA "%u" "." "%u", jbc->dbid, idx->dbid);
+  if (key.size >= sizeof(keybuf)) {
+    rc = IW_ERROR_OVERFLOW;
+    goto finish;
+  }
+  val.data = binn_ptr(imeta);
+  val.size = binn_size(imeta);
+  RCC(rc, finish, iwkv_put(db->metadb, &key, &val, 0));
+
+  idx->next = jbc->idx;
+  jbc->idx = idx;
+
+finish:
+  if (rc) {
+    if (idx) {
+      if (idx->idb) {
+        iwkv_db_destroy(&idx->idb);
+        idx->idb = 0;
+      }
+      _jb_idx_release(idx);
+    }
+  }
+  free(ptr);
+  binn_free(imeta);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+/**
+ * Recreates columnar store of collection `jbc` after change of collection columns
+ * and saves collection meta. Called under collection write lock.
+ */
+static iwrc _jb_coll_columns_rebuild_lw(struct jbcoll *jbc) {
+  iwrc rc = 0;
+  struct iwdb *ocoldb = jbc->coldb;
+  uint32_t ocoldbid = jbc->coldbid;
+
+  jbc->coldb = 0;
+  jbc->coldbid = 0;
+  if (jbc->colsnum) {
+    RCC(rc, finish, iwkv_new_db(jbc->db->iwkv, IWDB_VNUM64_KEYS, &jbc->coldbid, &jbc->coldb));
+    RCC(rc, finish, jbi_columns_fill(jbc));
+  }
+  RCC(rc, finish, _jb_coll_meta_save(jbc, jbc->name, 0));
+
+finish:
+  if (rc) {
+    if (jbc->coldb) {
+      iwkv_db_destroy(&jbc->coldb);
+    }
+    jbc->coldb = ocoldb;
+    jbc->coldbid = ocoldbid;
+  } else if (ocoldb) {
+    rc = iwkv_db_destroy(&ocoldb);
+  }
+  return rc;
+}
+
+iwrc ejdb_ensure_column(struct ejdb *db, const char *coll, const char *path) {
+  if (!db || !coll || !path) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  if (db->oflags & IWKV_RDONLY) {
+    return IW_ERROR_READONLY;
+  }
+  int rci;
+  struct jbcoll *jbc;
+  struct jbl_ptr *ptr = 0;
+
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, true, &jbc);
+  RCRET(rc);
 
-  // save index meta into metadb
-  imeta = binn_object();
-  if (!imeta) {
-    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  RCC(rc, finish, jbl_ptr_alloc(path, &ptr));
+  if (ptr->cnt != 1) { // Only top level fields are kept in columns
+    rc = IW_ERROR_INVALID_ARGS;
     goto finish;
   }
-
-  if (  !binn_object_set_str(imeta, "ptr", path)
-     || !binn_object_set_uint32(imeta, "mode", idx->mode)
-     || !binn_object_set_uint32(imeta, "idbf", idx->idbf)
-     || !binn_object_set_uint32(imeta, "dbid", idx->dbid)) {
-    rc = JBL_ERROR_CREATION;
+  for (int i = 0; i < jbc->colsnum; ++i) {
+    if (!jbl_ptr_cmp(jbc->cols[i], ptr)) {
+      goto finish;
+    }
+  }
+  if (jbc->colsnum >= JB_COL_MAX) {
+    rc = IW_ERROR_OUT_OF_BOUNDS;
     goto finish;
   }
+  jbc->cols[jbc->colsnum++] = ptr;
+  rc = _jb_coll_columns_rebuild_lw(jbc);
+  if (rc) {
+    jbc->cols[--jbc->colsnum] = 0;
+  } else {
+    ptr = 0;
+  }
 
-  key.data = keybuf;
-  // Full key format: i.<coldbid>.<idxdbid>
-  key.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_IDXMETA "%u" "." "%u", jbc->dbid, idx->dbid);
-  if (key.size >= sizeof(keybuf)) {
-    rc = IW_ERROR_OVERFLOW;
-    goto finish;
+finish:
+  free(ptr);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_remove_column(struct ejdb *db, const char *coll, const char *path) {
+  if (!db || !coll || !path) {
+    return IW_ERROR_INVALID_ARGS;
   }
-  val.data = binn_ptr(imeta);
-  val.size = binn_size(imeta);
-  RCC(rc, finish, iwkv_put(db->metadb, &key, &val, 0));
+  int rci;
+  struct jbcoll *jbc;
+  struct jbl_ptr *ptr = 0;
 
-  idx->next = jbc->idx;
-  jbc->idx = idx;
+  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, JB_COLL_ACQUIRE_WRITE | JB_COLL_ACQUIRE_EXISTING, &jbc);
+  RCRET(rc);
 
-finish:
-  if (rc) {
-    if (idx) {
-      if (idx->idb) {
-        iwkv_db_destroy(&idx->idb);
-        idx->idb = 0;
+  RCC(rc, finish, jbl_ptr_alloc(path, &ptr));
+  for (int i = 0; i < jbc->colsnum; ++i) {
+    if (!jbl_ptr_cmp(jbc->cols[i], ptr)) {
+      struct jbl_ptr *cptr = jbc->cols[i];
+      memmove(jbc->cols + i, jbc->cols + i + 1, (jbc->colsnum - i - 1) * sizeof(jbc->cols[0]));
+      jbc->cols[--jbc->colsnum] = 0;
+      rc = _jb_coll_columns_rebuild_lw(jbc);
+      if (rc) {
+        memmove(jbc->cols + i + 1, jbc->cols + i, (jbc->colsnum - i) * sizeof(jbc->cols[0]));
+        jbc->cols[i] = cptr;
+        ++jbc->colsnum;
+      } else {
+        free(cptr);
       }
-      _jb_idx_release(idx);
+      break;
     }
   }
+
+finish:
   free(ptr);
-  binn_free(imeta);
   API_COLL_UNLOCK(jbc, rci, rc);
   return rc;
 }
@@ -1279,8 +2916,9 @@ static iwrc _jb_patch(
     .size = sizeof(id)
   };
 
-  iwrc rc = _jb_coll_acquire_keeplock(db, coll, true, &jbc);
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, false, &jbc);
   RCRET(rc);
+  _jb_coll_doc_lock(jbc, id);
 
   rc = iwkv_get(jbc->cdb, &key, &val);
   if (upsert && (rc == IWKV_ERROR_NOTFOUND)) {
@@ -1299,14 +2937,15 @@ static iwrc _jb_patch(
       goto finish;
     }
     rc = _jb_put_impl(jbc, ujbl, id);
-    if (!rc && (jbc->id_seq < id)) {
-      jbc->id_seq = id;
+    if (!rc) {
+      _jb_coll_id_seq_update(jbc, id);
     }
     goto finish;
   } else {
     RCGO(rc, finish);
   }
 
+  RCC(rc, finish, jbi_doc_unpack(jbc, &val));
   RCC(rc, finish, jbl_from_buf_keep_onstack(&sjbl, val.data, val.size));
 
   pool = iwpool_create_empty();
@@ -1343,6 +2982,7 @@ static iwrc _jb_patch(
   rc = _jb_put_impl(jbc, ujbl, id);
 
 finish:
+  _jb_coll_doc_unlock(jbc, id);
   API_COLL_UNLOCK(jbc, rci, rc);
   if (ujbl != patchjbl) {
     jbl_destroy(&ujbl);
@@ -1391,18 +3031,25 @@ iwrc ejdb_merge_or_put_jbl(struct ejdb *db, const char *coll, struct jbl *patch,
   return _jb_patch(db, coll, id, true, 0, 0, patch);
 }
 
+static iwrc _jb_put_lr(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
+  _jb_coll_doc_lock(jbc, id);
+  iwrc rc = _jb_put_impl(jbc, jbl, id);
+  if (!rc) {
+    _jb_coll_id_seq_update(jbc, id);
+  }
+  _jb_coll_doc_unlock(jbc, id);
+  return rc;
+}
+
 iwrc ejdb_put(struct ejdb *db, const char *coll, struct jbl *jbl, int64_t id) {
   if (!jbl) {
     return IW_ERROR_INVALID_ARGS;
   }
   int rci;
   struct jbcoll *jbc;
-  iwrc rc = _jb_coll_acquire_keeplock(db, coll, true, &jbc);
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, false, &jbc);
   RCRET(rc);
-  rc = _jb_put_impl(jbc, jbl, id);
-  if (!rc && (jbc->id_seq < id)) {
-    jbc->id_seq = id;
-  }
+  rc = _jb_put_lr(jbc, jbl, id);
   API_COLL_UNLOCK(jbc, rci, rc);
   return rc;
 }
@@ -1416,28 +3063,55 @@ iwrc ejdb_put_jbn(struct ejdb *db, const char *coll, struct jbl_node *jbn, int64
   return rc;
 }
 
+/**
+ * Puts a new document under collection write lock or within writers group of collection.
+ * Document identifier is reserved atomically, identifiers stored concurrently
+ * by explicit `ejdb_put()` calls are skipped.
+ */
 static iwrc _jb_put_new_lw(struct jbcoll *jbc, struct jbl *jbl, int64_t *id) {
-  iwrc rc = 0;
-  int64_t oid = jbc->id_seq + 1;
-  struct iwkv_val val, key = {
+  int64_t oid;
+  void *zbuf, *xbuf;
+  struct iwkv_val val, pval, xval, key = {
     .data = &oid,
     .size = sizeof(oid)
   };
   struct _jb_put_handler_ctx pctx = {
-    .id = oid,
     .jbc = jbc,
     .jbl = jbl
   };
 
-  RCC(rc, finish, jbl_as_buf(jbl, &val.data, &val.size));
-  RCC(rc, finish, _jb_put_handler_after(iwkv_puth(jbc->cdb, &key, &val, 0, _jb_put_handler, &pctx), &pctx));
-
-  jbc->id_seq = oid;
-  if (id) {
+  iwrc rc = jbl_as_buf(jbl, &val.data, &val.size);
+  RCRET(rc);
+  rc = jbi_doc_pack(jbc, &val, &zbuf);
+  RCRET(rc);
+  pval = val;
+  do {
+    oid = __sync_add_and_fetch(&jbc->id_seq, 1);
+    pctx.id = oid;
+    val = pval;
+    // Stub of large document keeps document id
+    rc = _jb_doc_stub(jbc, oid, jbl, &val, &pctx, &xval, &xbuf);
+    if (rc) {
+      break;
+    }
+    pthread_mutex_lock(_jb_coll_stripe(jbc, oid));
+    rc = _jb_put_handler_after(
+      iwkv_puth(jbc->cdb, &key, &val, IWKV_NO_OVERWRITE, _jb_put_handler, &pctx), &pctx);
+    pthread_mutex_unlock(_jb_coll_stripe(jbc, oid));
+    free(xbuf);
+  } while (rc == IWKV_ERROR_KEY_EXISTS);
+
+  free(zbuf);
+  if (!rc && id) {
     *id = oid;
   }
+  return rc;
+}
 
-finish:
+static iwrc _jb_put_new_lr(struct jbcoll *jbc, struct jbl *jbl, int64_t *id) {
+  _jb_coll_writers_enter(jbc);
+  iwrc rc = _jb_put_new_lw(jbc, jbl, id);
+  _jb_coll_writers_leave(jbc);
   return rc;
 }
 
@@ -1450,86 +3124,489 @@ iwrc ejdb_put_new(struct ejdb *db, const char *coll, struct jbl *jbl, int64_t *i
   if (id) {
     *id = 0;
   }
-  iwrc rc = _jb_coll_acquire_keeplock(db, coll, true, &jbc);
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, false, &jbc);
+  RCRET(rc);
+  rc = _jb_put_new_lr(jbc, jbl, id);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_put_new_jbn(struct ejdb *db, const char *coll, struct jbl_node *jbn, int64_t *id) {
+  struct jbl *jbl = 0;
+  iwrc rc = jbl_from_node(&jbl, jbn);
+  RCRET(rc);
+  rc = ejdb_put_new(db, coll, jbl, id);
+  jbl_destroy(&jbl);
+  return rc;
+}
+
+static iwrc _jb_get_lr(struct jbcoll *jbc, int64_t id, struct jbl **jblp) {
+  struct jbl *jbl = 0;
+  struct iwkv_val val = { 0 };
+  struct iwkv_val key = { .data = &id, .size = sizeof(id) };
+
+  iwrc rc = iwkv_get(jbc->cdb, &key, &val);
+  RCRET(rc);
+  rc = jbi_doc_unpack(jbc, &val);
+  if (!rc) {
+    rc = jbl_from_buf_keep(&jbl, val.data, val.size, false);
+  }
+  if (rc) {
+    iwkv_val_dispose(&val);
+    return rc;
+  }
+  *jblp = jbl;
+  return 0;
+}
+
+iwrc jb_get(struct ejdb *db, const char *coll, int64_t id, jb_coll_acquire_t acm, struct jbl **jblp) {
+  if (!id || !jblp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *jblp = 0;
+
+  int rci;
+  struct jbcoll *jbc;
+  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, acm, &jbc);
+  RCRET(rc);
+  rc = _jb_get_lr(jbc, id, jblp);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_get(struct ejdb *db, const char *coll, int64_t id, struct jbl **jblp) {
+  return jb_get(db, coll, id, JB_COLL_ACQUIRE_EXISTING, jblp);
+}
+
+static iwrc _jb_del_lr(struct jbcoll *jbc, int64_t id) {
+  struct jbl jbl;
+  struct iwkv_val val = { 0 };
+  struct iwkv_val key = { .data = &id, .size = sizeof(id) };
+
+  _jb_coll_doc_lock(jbc, id);
+
+  iwrc rc = iwkv_get(jbc->cdb, &key, &val);
+  RCGO(rc, finish);
+  bool large = jbi_doc_is_large(val.data, val.size);
+  RCC(rc, finish, jbi_doc_unpack(jbc, &val));
+  RCC(rc, finish, jbl_from_buf_keep_onstack(&jbl, val.data, val.size));
+
+  for (struct jbidx *idx = jbc->idx; idx; idx = idx->next) {
+    IWRC(_jb_idx_record_remove(idx, id, &jbl), rc);
+  }
+
+  RCC(rc, finish, iwkv_del(jbc->cdb, &key, 0));
+  if (large) {
+    IWRC(jbi_xdoc_del(jbc, id), rc);
+  }
+  IWRC(jbi_columns_del(jbc, id), rc);
+  _jb_coll_modified(jbc, id);
+  _jb_meta_nrecs_update(jbc->db, jbc->dbid, -1);
+  __sync_sub_and_fetch(&jbc->rnum, 1);
+
+finish:
+  if (val.data) {
+    iwkv_val_dispose(&val);
+  }
+  _jb_coll_doc_unlock(jbc, id);
+  return rc;
+}
+
+iwrc ejdb_del(struct ejdb *db, const char *coll, int64_t id) {
+  int rci;
+  struct jbcoll *jbc;
+  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, JB_COLL_ACQUIRE_EXISTING, &jbc);
+  RCRET(rc);
+  rc = _jb_del_lr(jbc, id);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_coll_open(struct ejdb *db, const char *coll, struct ejdb_coll **collp) {
+  if (!collp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *collp = 0;
+  int rci;
+  struct jbcoll *jbc;
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, false, &jbc);
+  RCRET(rc);
+  struct ejdb_coll *h = malloc(sizeof(*h));
+  if (h) {
+    h->db = db;
+    h->jbc = jbc;
+    __sync_add_and_fetch(&jbc->refs, 1);
+    *collp = h;
+  } else {
+    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_coll_close(struct ejdb_coll **collp) {
+  if (!collp || !*collp) {
+    return 0;
+  }
+  int rci;
+  iwrc rc = 0;
+  struct ejdb_coll *h = *collp;
+  struct jbcoll *jbc = h->jbc;
+  *collp = 0;
+  // Database lock excludes concurrent `ejdb_remove_collection()`
+  rci = jb_db_rlock(h->db);
+  if (rci) {
+    rc = iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci);
+  } else {
+    if (!__sync_sub_and_fetch(&jbc->refs, 1) && jbc->removed) {
+      _jb_coll_release(jbc);
+    }
+    API_UNLOCK(h->db, rci, rc);
+  }
+  free(h);
+  return rc;
+}
+
+/**
+ * Acquires database read lock and collection read lock of handle `h`.
+ */
+static iwrc _jb_coll_acquire_handle(struct ejdb_coll *h) {
+  int rci;
+  if (!h) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  API_RLOCK(h->db, rci);
+  if (h->jbc->removed) {
+    jb_db_unlock(h->db);
+    return EJDB_ERROR_COLLECTION_NOT_FOUND;
+  }
+  rci = pthread_rwlock_rdlock(&h->jbc->rwl);
+  if (rci) {
+    jb_db_unlock(h->db);
+    return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci);
+  }
+  return 0;
+}
+
+iwrc ejdb_coll_get(struct ejdb_coll *coll, int64_t id, struct jbl **jblp) {
+  if (!id || !jblp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *jblp = 0;
+  int rci;
+  iwrc rc = _jb_coll_acquire_handle(coll);
+  RCRET(rc);
+  rc = _jb_get_lr(coll->jbc, id, jblp);
+  API_COLL_UNLOCK(coll->jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_coll_put(struct ejdb_coll *coll, struct jbl *jbl, int64_t id) {
+  if (!jbl) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  int rci;
+  iwrc rc = _jb_coll_acquire_handle(coll);
+  RCRET(rc);
+  rc = _jb_put_lr(coll->jbc, jbl, id);
+  API_COLL_UNLOCK(coll->jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_coll_put_new(struct ejdb_coll *coll, struct jbl *jbl, int64_t *id) {
+  if (!jbl) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  if (id) {
+    *id = 0;
+  }
+  int rci;
+  iwrc rc = _jb_coll_acquire_handle(coll);
   RCRET(rc);
+  rc = _jb_put_new_lr(coll->jbc, jbl, id);
+  API_COLL_UNLOCK(coll->jbc, rci, rc);
+  return rc;
+}
+
+iwrc ejdb_coll_del(struct ejdb_coll *coll, int64_t id) {
+  int rci;
+  iwrc rc = _jb_coll_acquire_handle(coll);
+  RCRET(rc);
+  rc = _jb_del_lr(coll->jbc, id);
+  API_COLL_UNLOCK(coll->jbc, rci, rc);
+  return rc;
+}
+
+IW_INLINE bool _jb_async_is_batched(struct ejdb_async *op) {
+  return op->op == EJDB_ASYNC_PUT || op->op == EJDB_ASYNC_PUT_NEW
+         || op->op == EJDB_ASYNC_GET || op->op == EJDB_ASYNC_DEL;
+}
+
+static iwrc _jb_async_exec_single(struct ejdb *db, struct ejdb_async *op) {
+  switch (op->op) {
+    case EJDB_ASYNC_PATCH:
+      return _jb_patch(db, op->coll, op->id, false, op->patch, 0, 0);
+    case EJDB_ASYNC_MERGE_OR_PUT:
+      return _jb_patch(db, op->coll, op->id, true, op->patch, 0, 0);
+    case EJDB_ASYNC_LIST:
+      return ejdb_list(db, op->q, &op->list, op->limit, op->pool);
+    default:
+      return IW_ERROR_INVALID_ARGS;
+  }
+}
+
+static iwrc _jb_async_exec_lr(struct jbcoll *jbc, struct ejdb_async *op) {
+  switch (op->op) {
+    case EJDB_ASYNC_PUT:
+      return _jb_put_lr(jbc, op->jbl, op->id);
+    case EJDB_ASYNC_PUT_NEW:
+      return _jb_put_new_lr(jbc, op->jbl, &op->id);
+    case EJDB_ASYNC_GET:
+      return _jb_get_lr(jbc, op->id, &op->jbl);
+    case EJDB_ASYNC_DEL:
+      return _jb_del_lr(jbc, op->id);
+    default:
+      return IW_ERROR_INVALID_ARGS;
+  }
+}
+
+/**
+ * Executes list of operations of collection `coll`.
+ * Consecutive put, get and del operations are executed under single collection lock acquisition.
+ * Completion callbacks are called when no locks are held.
+ */
+static void _jb_async_execute(struct ejdb *db, const char *coll, struct ejdb_async *ops) {
+  iwrc rcs[JB_ASYNC_BATCH_MAX];
+  while (ops) {
+    struct ejdb_async *op = ops, *next;
+    if (!_jb_async_is_batched(op)) {
+      ops = op->next;
+      op->cb(op, _jb_async_exec_single(db, op));
+      continue;
+    }
+    int n = 0, rci;
+    struct jbcoll *jbc;
+    jb_coll_acquire_t acm = JB_COLL_ACQUIRE_EXISTING;
+    for (op = ops; op && n < JB_ASYNC_BATCH_MAX && _jb_async_is_batched(op); op = op->next, ++n) {
+      if (op->op == EJDB_ASYNC_PUT || op->op == EJDB_ASYNC_PUT_NEW) {
+        acm = 0;
+      }
+    }
+    iwrc rc = _jb_coll_acquire_keeplock2(db, coll, acm, &jbc);
+    op = ops;
+    for (int i = 0; i < n; ++i, op = op->next) {
+      rcs[i] = rc ? rc : _jb_async_exec_lr(jbc, op);
+    }
+    if (!rc) {
+      API_COLL_UNLOCK(jbc, rci, rc);
+    }
+    for (int i = 0; i < n; ++i, ops = next) {
+      next = ops->next;
+      ops->cb(ops, rcs[i] ? rcs[i] : rc);
+    }
+  }
+}
+
+static void* _jb_async_worker(void *arg) {
+  struct ejdb *db = arg;
+  struct jbasync *as = db->async;
+  pthread_mutex_lock(&as->mtx);
+  while (1) {
+    struct jbaqueue *aq = as->ready;
+    if (!aq) {
+      if (as->shutdown) {
+        break;
+      }
+      pthread_cond_wait(&as->cond, &as->mtx);
+      continue;
+    }
+    as->ready = aq->next;
+    if (!as->ready) {
+      as->ready_tail = 0;
+    }
+    aq->next = 0;
+    // Take a batch of queued operations
+    struct ejdb_async *ops = aq->head, *op = ops;
+    for (int i = 1; i < JB_ASYNC_BATCH_MAX && op->next; ++i) {
+      op = op->next;
+    }
+    aq->head = op->next;
+    if (!aq->head) {
+      aq->tail = 0;
+    }
+    op->next = 0;
+    pthread_mutex_unlock(&as->mtx);
 
-  rc = _jb_put_new_lw(jbc, jbl, id);
+    _jb_async_execute(db, aq->coll, ops);
 
-  API_COLL_UNLOCK(jbc, rci, rc);
-  return rc;
+    pthread_mutex_lock(&as->mtx);
+    if (aq->head) {
+      // Reschedule queue to the end of ready list to give a chance to other collections
+      if (as->ready_tail) {
+        as->ready_tail->next = aq;
+      } else {
+        as->ready = aq;
+      }
+      as->ready_tail = aq;
+    } else {
+      aq->scheduled = false;
+    }
+  }
+  pthread_mutex_unlock(&as->mtx);
+  return 0;
 }
 
-iwrc ejdb_put_new_jbn(struct ejdb *db, const char *coll, struct jbl_node *jbn, int64_t *id) {
-  struct jbl *jbl = 0;
-  iwrc rc = jbl_from_node(&jbl, jbn);
-  RCRET(rc);
-  rc = ejdb_put_new(db, coll, jbl, id);
-  jbl_destroy(&jbl);
-  return rc;
+static void _jb_async_queue_free(void *key, void *val) {
+  if (val) {
+    struct jbaqueue *aq = val;
+    free(aq->coll);
+    free(aq);
+  }
 }
 
-iwrc jb_get(struct ejdb *db, const char *coll, int64_t id, jb_coll_acquire_t acm, struct jbl **jblp) {
-  if (!id || !jblp) {
-    return IW_ERROR_INVALID_ARGS;
+static iwrc _jb_async_start(struct ejdb *db) {
+  iwrc rc = 0;
+  struct jbasync *as = calloc(1, sizeof(*as));
+  if (!as) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  pthread_mutex_init(&as->mtx, 0);
+  pthread_cond_init(&as->cond, 0);
+  db->async = as;
+  RCB(finish, as->queues = iwhmap_create_str(_jb_async_queue_free));
+  RCB(finish, as->threads = calloc(db->opts.async_threads, sizeof(as->threads[0])));
+  as->nthreads = jbi_parallel_start(as->threads, (int) db->opts.async_threads, _jb_async_worker, db, 0);
+  if (as->nthreads < (int) db->opts.async_threads) {
+    rc = IW_ERROR_THREADING;
   }
-  *jblp = 0;
-
-  int rci;
-  struct jbcoll *jbc;
-  struct jbl *jbl = 0;
-  struct iwkv_val val = { 0 };
-  struct iwkv_val key = { .data = &id, .size = sizeof(id) };
-
-  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, acm, &jbc);
-  RCRET(rc);
-
-  RCC(rc, finish, iwkv_get(jbc->cdb, &key, &val));
-  RCC(rc, finish, jbl_from_buf_keep(&jbl, val.data, val.size, false));
-
-  *jblp = jbl;
 
 finish:
-  if (rc) {
-    if (jbl) {
-      jbl_destroy(&jbl);
-    } else {
-      iwkv_val_dispose(&val);
-    }
-  }
-  API_COLL_UNLOCK(jbc, rci, rc);
   return rc;
 }
 
-iwrc ejdb_get(struct ejdb *db, const char *coll, int64_t id, struct jbl **jblp) {
-  return jb_get(db, coll, id, JB_COLL_ACQUIRE_EXISTING, jblp);
+/**
+ * Waits for completion of pending asynchronous operations and stops workers.
+ */
+static void _jb_async_shutdown(struct ejdb *db) {
+  struct jbasync *as = db->async;
+  if (!as) {
+    return;
+  }
+  pthread_mutex_lock(&as->mtx);
+  as->shutdown = true;
+  pthread_cond_broadcast(&as->cond);
+  pthread_mutex_unlock(&as->mtx);
+  if (as->threads) {
+    jbi_parallel_join(as->threads, as->nthreads);
+    free(as->threads);
+    as->threads = 0;
+    as->nthreads = 0;
+  }
 }
 
-iwrc ejdb_del(struct ejdb *db, const char *coll, int64_t id) {
-  int rci;
-  struct jbcoll *jbc;
-  struct jbl jbl;
-  struct iwkv_val val = { 0 };
-  struct iwkv_val key = { .data = &id, .size = sizeof(id) };
-
-  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, JB_COLL_ACQUIRE_WRITE | JB_COLL_ACQUIRE_EXISTING, &jbc);
-  RCRET(rc);
+static void _jb_async_release(struct ejdb *db) {
+  struct jbasync *as = db->async;
+  if (!as) {
+    return;
+  }
+  _jb_async_shutdown(db);
+  iwhmap_destroy(as->queues);
+  pthread_mutex_destroy(&as->mtx);
+  pthread_cond_destroy(&as->cond);
+  free(as);
+  db->async = 0;
+}
 
-  RCC(rc, finish, iwkv_get(jbc->cdb, &key, &val));
-  RCC(rc, finish, jbl_from_buf_keep_onstack(&jbl, val.data, val.size));
+iwrc ejdb_submit(struct ejdb *db, struct ejdb_async *op) {
+  if (!db || !op || !op->cb) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  switch (op->op) {
+    case EJDB_ASYNC_PUT:
+    case EJDB_ASYNC_PUT_NEW:
+      if (!op->jbl) {
+        return IW_ERROR_INVALID_ARGS;
+      }
+      break;
+    case EJDB_ASYNC_GET:
+      if (!op->id) {
+        return IW_ERROR_INVALID_ARGS;
+      }
+      op->jbl = 0;
+      break;
+    case EJDB_ASYNC_DEL:
+      break;
+    case EJDB_ASYNC_PATCH:
+    case EJDB_ASYNC_MERGE_OR_PUT:
+      if (!op->patch) {
+        return IW_ERROR_INVALID_ARGS;
+      }
+      break;
+    case EJDB_ASYNC_LIST:
+      if (!op->q || !op->pool) {
+        return IW_ERROR_INVALID_ARGS;
+      }
+      op->list = 0;
+      break;
+    default:
+      return IW_ERROR_INVALID_ARGS;
+  }
+  const char *coll = op->coll;
+  if (!coll && op->op == EJDB_ASYNC_LIST) {
+    coll = jql_collection(op->q);
+  }
+  if (!coll) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  ENSURE_OPEN(db);
+  op->next = 0;
 
-  for (struct jbidx *idx = jbc->idx; idx; idx = idx->next) {
-    IWRC(_jb_idx_record_remove(idx, id, &jbl), rc);
+  struct jbasync *as = db->async;
+  if (!as) {
+    _jb_async_execute(db, coll, op);
+    return 0;
   }
 
-  RCC(rc, finish, iwkv_del(jbc->cdb, &key, 0));
-  _jb_meta_nrecs_update(jbc->db, jbc->dbid, -1);
-  jbc->rnum -= 1;
+  iwrc rc = 0;
+  pthread_mutex_lock(&as->mtx);
+  if (as->shutdown) {
+    rc = IW_ERROR_INVALID_STATE;
+    goto finish;
+  }
+  struct jbaqueue *aq = iwhmap_get(as->queues, coll);
+  if (!aq) {
+    RCB(finish, aq = calloc(1, sizeof(*aq)));
+    aq->coll = strdup(coll);
+    if (!aq->coll) {
+      rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      free(aq);
+      goto finish;
+    }
+    rc = iwhmap_put(as->queues, aq->coll, aq);
+    if (rc) {
+      _jb_async_queue_free(0, aq);
+      goto finish;
+    }
+  }
+  if (aq->tail) {
+    aq->tail->next = op;
+  } else {
+    aq->head = op;
+  }
+  aq->tail = op;
+  if (!aq->scheduled) {
+    aq->scheduled = true;
+    if (as->ready_tail) {
+      as->ready_tail->next = aq;
+    } else {
+      as->ready = aq;
+    }
+    as->ready_tail = aq;
+    pthread_cond_signal(&as->cond);
+  }
 
 finish:
-  if (val.data) {
-    iwkv_val_dispose(&val);
-  }
-  API_COLL_UNLOCK(jbc, rci, rc);
+  pthread_mutex_unlock(&as->mtx);
   return rc;
 }
 
@@ -1541,8 +3618,11 @@ iwrc jb_del(struct jbcoll *jbc, struct jbl *jbl, int64_t id) {
   }
   rc = iwkv_del(jbc->cdb, &key, 0);
   RCRET(rc);
+  IWRC(jbi_xdoc_del(jbc, id), rc);
+  IWRC(jbi_columns_del(jbc, id), rc);
+  _jb_coll_modified(jbc, id);
   _jb_meta_nrecs_update(jbc->db, jbc->dbid, -1);
-  jbc->rnum -= 1;
+  __sync_sub_and_fetch(&jbc->rnum, 1);
   return rc;
 }
 
@@ -1553,8 +3633,11 @@ iwrc jb_cursor_del(struct jbcoll *jbc, struct iwkv_cursor *cur, int64_t id, stru
   }
   rc = iwkv_cursor_del(cur, 0);
   RCRET(rc);
+  IWRC(jbi_xdoc_del(jbc, id), rc);
+  IWRC(jbi_columns_del(jbc, id), rc);
+  _jb_coll_modified(jbc, id);
   _jb_meta_nrecs_update(jbc->db, jbc->dbid, -1);
-  jbc->rnum -= 1;
+  __sync_sub_and_fetch(&jbc->rnum, 1);
   return rc;
 }
 
@@ -1593,6 +3676,11 @@ iwrc ejdb_remove_collection(struct ejdb *db, const char *coll) {
       RCC(rc, finish, iwkv_del(jbc->db->metadb, &key, 0));
       _jb_meta_nrecs_removedb(db, idx->dbid);
     }
+    for (uint32_t id = 1; id <= jbc->keysnum; ++id) {
+      key.data = keybuf;
+      key.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_KEYDICT "%u" "." "%u", jbc->dbid, id);
+      RCC(rc, finish, iwkv_del(jbc->db->metadb, &key, 0));
+    }
     for (struct jbidx *idx = jbc->idx, *nidx; idx; idx = nidx) {
       IWRC(iwkv_db_destroy(&idx->idb), rc);
       idx->idb = 0;
@@ -1600,8 +3688,15 @@ iwrc ejdb_remove_collection(struct ejdb *db, const char *coll) {
       _jb_idx_release(idx);
     }
     jbc->idx = 0;
+    IWRC(jbi_xdoc_remove_all(db, jbc->dbid), rc);
+    if (jbc->coldb) {
+      IWRC(iwkv_db_destroy(&jbc->coldb), rc);
+    }
     IWRC(iwkv_db_destroy(&jbc->cdb), rc);
+    // Collection referenced by open handles is released by the last `ejdb_coll_close()`
+    jbc->removed = jbc->refs > 0;
     iwhmap_remove(db->mcolls, coll);
+    _jb_jcache_clear(db);
   }
 
 finish:
@@ -1609,10 +3704,120 @@ finish:
   return rc;
 }
 
+iwrc jb_collection_join_fetch(
+  struct jbexec *ctx, const char *coll, const int64_t *ids, int num,
+  iwrc (*visitor)(int64_t id, struct jbl *jbl, void *op), void *op) {
+  int rci;
+  struct jbcoll *jbc;
+  struct iwkv_cursor *cur = 0;
+  struct ejdb *db = ctx->jbc->db;
+
+  iwrc rc = _jb_coll_acquire_keeplock2(db, coll, JB_COLL_ACQUIRE_EXISTING, &jbc);
+  if (rc == IW_ERROR_NOT_EXISTS) {
+    return 0;
+  }
+  RCRET(rc);
+  jb_coll_scan_lock(jbc);
+
+  // Documents are put into cache within collection scanners group
+  // so cached entries are consistent with collection writers
+  for (int i = 0; i < num; ++i) {
+    void *buf = 0;
+    struct jbl jbl;
+    struct jbdocref ref = {
+      .id = ids[i],
+      .coll = jbc->name
+    };
+    if (db->jcache) {
+      pthread_mutex_lock(&db->jcache_mtx);
+      buf = iwhmap_get(db->jcache, &ref);
+      if (buf) {
+        rc = jbl_from_buf_keep_onstack2(&jbl, buf);
+        if (!rc) {
+          rc = visitor(ref.id, &jbl, op);
+        }
+      }
+      pthread_mutex_unlock(&db->jcache_mtx);
+      RCGO(rc, finish);
+      if (buf) {
+        continue;
+      }
+    }
+
+    struct iwkv_val val = { 0 }, key = {
+      .data = &ref.id,
+      .size = sizeof(ref.id)
+    };
+    if (cur) {
+      rc = iwkv_cursor_to_key(cur, IWKV_CURSOR_EQ, &key);
+    } else {
+      rc = iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_EQ, &key);
+    }
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      rc = 0;
+      iwkv_cursor_close(&cur);
+      continue;
+    }
+    RCGO(rc, finish);
+    RCC(rc, finish, iwkv_cursor_val(cur, &val));
+    rc = jbi_doc_unpack(jbc, &val);
+    if (!rc) {
+      rc = jbl_from_buf_keep_onstack(&jbl, val.data, val.size);
+    }
+    if (!rc) {
+      rc = visitor(ref.id, &jbl, op);
+    }
+    if (!rc && db->jcache && (val.size <= db->opts.join_cache_size / JB_JCACHE_MAX_ENTRY_RATIO)) {
+      size_t len = strlen(jbc->name);
+      struct jbjcentry *e = malloc(sizeof(*e) + len + 1);
+      if (e) {
+        char *name = (char*) e + sizeof(*e);
+        memcpy(name, jbc->name, len + 1);
+        e->ref.id = ref.id;
+        e->ref.coll = name;
+        e->db = db;
+        e->size = sizeof(*e) + len + 1 + val.size;
+        pthread_mutex_lock(&db->jcache_mtx);
+        db->jcache_size += e->size;
+        rc = iwhmap_put(db->jcache, e, val.data);
+        if (!rc) {
+          val.data = 0; // Owned by cache
+        } else {
+          db->jcache_size -= e->size;
+          free(e);
+        }
+        pthread_mutex_unlock(&db->jcache_mtx);
+      } else {
+        rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      }
+    }
+    if (val.data) {
+      iwkv_val_dispose(&val);
+    }
+    RCGO(rc, finish);
+  }
+
+finish:
+  if (cur) {
+    iwkv_cursor_close(&cur);
+  }
+  jb_coll_scan_unlock(jbc);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
+static iwrc _jb_join_resolver_visitor(int64_t id, struct jbl *jbl, void *op) {
+  return jbl_clone(jbl, op);
+}
+
 iwrc jb_collection_join_resolver(int64_t id, const char *coll, struct jbl **out, struct jbexec *ctx) {
   assert(out && ctx && coll);
-  struct ejdb *db = ctx->jbc->db;
-  return jb_get(db, coll, id, JB_COLL_ACQUIRE_EXISTING, out);
+  *out = 0;
+  iwrc rc = jb_collection_join_fetch(ctx, coll, &id, 1, _jb_join_resolver_visitor, out);
+  if (!rc && !*out) {
+    rc = IWKV_ERROR_NOTFOUND;
+  }
+  return rc;
 }
 
 int jb_proj_node_cache_cmp(const void *v1, const void *v2) {
@@ -1631,7 +3836,22 @@ void jb_proj_node_kvfree(void *key, void *val) {
 
 uint32_t jb_proj_node_hash(const void *key) {
   const struct jbdocref *ref = key;
-  return wyhash32(key, sizeof(ref), 0xd31c3939);
+  uint32_t h = wyhash32(&ref->id, sizeof(ref->id), 0xd31c3939);
+  return wyhash32(ref->coll, strlen(ref->coll), h);
+}
+
+static void _jb_jcache_entry_free(void *key, void *val) {
+  struct jbjcentry *e = key;
+  if (e) {
+    e->db->jcache_size -= e->size;
+  }
+  free(key);
+  free(val);
+}
+
+static bool _jb_jcache_eviction_needed(struct iwhmap *hm, void *op) {
+  struct ejdb *db = op;
+  return db->jcache_size > db->opts.join_cache_size;
 }
 
 iwrc ejdb_rename_collection(struct ejdb *db, const char *coll, const char *new_coll) {
@@ -1643,9 +3863,7 @@ iwrc ejdb_rename_collection(struct ejdb *db, const char *coll, const char *new_c
   if (db->oflags & IWKV_RDONLY) {
     return IW_ERROR_READONLY;
   }
-  struct iwkv_val key, val;
   struct jbl *nmeta = 0, *jbv = 0;
-  char keybuf[IWNUMBUF_SIZE + sizeof(KEY_PREFIX_COLLMETA)];
 
   API_WLOCK(db, rci);
 
@@ -1660,33 +3878,15 @@ iwrc ejdb_rename_collection(struct ejdb *db, const char *coll, const char *new_c
     goto finish;
   }
 
-  RCC(rc, finish, jbl_create_empty_object(&nmeta));
-  if (!binn_object_set_str(&nmeta->bn, "name", new_coll)) {
-    rc = JBL_ERROR_CREATION;
-    goto finish;
-  }
-
-  if (!binn_object_set_uint32(&nmeta->bn, "id", jbc->dbid)) {
-    rc = JBL_ERROR_CREATION;
-    goto finish;
-  }
-
-  RCC(rc, finish, jbl_as_buf(nmeta, &val.data, &val.size));
-  key.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_COLLMETA "%u", jbc->dbid);
-  if (key.size >= sizeof(keybuf)) {
-    rc = IW_ERROR_OVERFLOW;
-    goto finish;
-  }
-  key.data = keybuf;
-
+  RCC(rc, finish, _jb_coll_meta_save(jbc, new_coll, &nmeta));
   RCC(rc, finish, jbl_at(nmeta, "/name", &jbv));
   const char *new_name = jbl_get_str(jbv);
-  RCC(rc, finish, iwkv_put(db->metadb, &key, &val, IWKV_SYNC));
   RCC(rc, finish, iwhmap_rename(db->mcolls, coll, (void*) new_name));
 
   jbc->name = new_name;
   jbl_destroy(&jbc->meta);
   jbc->meta = nmeta;
+  _jb_jcache_clear(db);
 
 finish:
   if (jbv) {
@@ -1701,6 +3901,106 @@ finish:
   return rc;
 }
 
+/**
+ * Rewrites documents of collection according to its current compression mode
+ * and `EJDB_OPTS.large_document_sz` option.
+ * Called under collection write lock.
+ */
+static iwrc _jb_coll_repack_lw(struct jbcoll *jbc) {
+  struct iwkv_cursor *cur;
+  struct iwkv_val val;
+
+  iwrc rc = iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0);
+  RCRET(rc);
+  while (!(rc = iwkv_cursor_to(cur, IWKV_CURSOR_NEXT))) {
+    int64_t id;
+    size_t sz;
+    RCC(rc, finish, iwkv_cursor_copy_key(cur, &id, sizeof(id), &sz, 0));
+    RCC(rc, finish, iwkv_cursor_val(cur, &val));
+    void *data, *zbuf = 0, *xbuf = 0;
+    struct iwkv_val xval;
+    bool packed = jbi_doc_is_packed(val.data, val.size);
+    bool large = jbi_doc_is_large(val.data, val.size);
+    rc = jbi_doc_unpack(jbc, &val);
+    data = val.data;
+    size_t datasz = val.size;
+    if (!rc) {
+      rc = jbi_doc_pack(jbc, &val, &zbuf);
+    }
+    if (!rc && jbi_xdoc_needed(jbc, val.size)) {
+      xval = val;
+      rc = jbi_xdoc_stub(jbc, id, data, datasz, &val, &xbuf);
+      if (!rc) {
+        rc = jbi_xdoc_put(jbc, id, &xval);
+      }
+    }
+    if (!rc && (packed || zbuf || xbuf)) {
+      rc = iwkv_cursor_set(cur, &val, 0);
+    }
+    if (!rc && large && !xbuf) {
+      rc = jbi_xdoc_del(jbc, id);
+    }
+    free(xbuf);
+    free(zbuf);
+    val.data = data;
+    iwkv_val_dispose(&val);
+    RCGO(rc, finish);
+  }
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+
+finish:
+  IWRC(iwkv_cursor_close(&cur), rc);
+  return rc;
+}
+
+iwrc ejdb_set_compression(struct ejdb *db, const char *coll, ejdb_compression_t mode, uint32_t dict_sample) {
+  if (!coll || (mode & ~(EJDB_COMPRESSION_LZ | EJDB_COMPRESSION_KEYS))) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  if (db->oflags & IWKV_RDONLY) {
+    return IW_ERROR_READONLY;
+  }
+  int rci;
+  struct jbcoll *jbc;
+  uint8_t *dict = 0;
+  uint32_t dictsz = 0;
+  iwrc rc = _jb_coll_acquire_keeplock(db, coll, true, &jbc);
+  RCRET(rc);
+
+  ejdb_compression_t zmode = jbc->zmode;
+  if ((mode & EJDB_COMPRESSION_LZ) && dict_sample && !jbc->zdict) {
+    // Dictionary is never changed once created since stored documents depend on it
+    RCC(rc, finish, jbi_zdict_train(jbc, mode, dict_sample, &dict, &dictsz));
+  }
+  if (mode == zmode && !dict) {
+    goto finish;
+  }
+  if (dict) {
+    RCC(rc, finish, _jb_coll_zdict_set(jbc, dict, dictsz));
+  }
+  jbc->zmode = mode;
+  rc = _jb_coll_meta_save(jbc, jbc->name, 0);
+  if (rc) {
+    jbc->zmode = zmode;
+    if (dict) {
+      free(jbc->zdict);
+      free(jbc->zdict_ht);
+      jbc->zdict = 0;
+      jbc->zdict_ht = 0;
+      jbc->zdictsz = 0;
+    }
+    goto finish;
+  }
+  rc = _jb_coll_repack_lw(jbc);
+
+finish:
+  free(dict);
+  API_COLL_UNLOCK(jbc, rci, rc);
+  return rc;
+}
+
 iwrc ejdb_get_meta(struct ejdb *db, struct jbl **jblp) {
   int rci;
   *jblp = 0;
@@ -1740,6 +4040,12 @@ iwrc ejdb_get_meta(struct ejdb *db, struct jbl **jblp) {
   }
   binn_free(clist);
   clist = 0;
+  if (db->qprof) {
+    RCC(rc, finish, _jb_qprof_add_meta(db, &jbl->bn));
+  }
+  if (db->rcache) {
+    RCC(rc, finish, _jb_rcache_add_meta(db, &jbl->bn));
+  }
 
 finish:
   API_UNLOCK(db, rci, rc);
@@ -1754,6 +4060,37 @@ finish:
   return rc;
 }
 
+iwrc ejdb_get_query_profile(struct ejdb *db, struct jbl **jblp) {
+  if (!db || !jblp) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *jblp = 0;
+  ENSURE_OPEN(db);
+  struct jbl *jbl;
+  iwrc rc = jbl_create_empty_object(&jbl);
+  RCRET(rc);
+  rc = _jb_qprof_add_meta(db, &jbl->bn);
+  if (rc) {
+    jbl_destroy(&jbl);
+  } else {
+    *jblp = jbl;
+  }
+  return rc;
+}
+
+iwrc ejdb_reset_query_profile(struct ejdb *db) {
+  if (!db) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  ENSURE_OPEN(db);
+  if (db->qprof) {
+    pthread_mutex_lock(&db->qprof_mtx);
+    iwhmap_clear(db->qprof);
+    pthread_mutex_unlock(&db->qprof_mtx);
+  }
+  return 0;
+}
+
 iwrc ejdb_online_backup(struct ejdb *db, uint64_t *ts, const char *target_file) {
   ENSURE_OPEN(db);
   return iwkv_online_backup(db->iwkv, ts, target_file);
@@ -1768,8 +4105,9 @@ iwrc ejdb_get_iwkv(struct ejdb *db, IWKV *kvp) {
 }
 
 static void _mcolls_map_entry_free(void *key, void *val) {
-  if (val) {
-    _jb_coll_release(val);
+  struct jbcoll *jbc = val;
+  if (jbc && !jbc->removed) {
+    _jb_coll_release(jbc);
   }
 }
 
@@ -1782,10 +4120,12 @@ iwrc ejdb_open(const struct ejdb_opts *_opts, struct ejdb **ejdbp) {
     return IW_ERROR_INVALID_ARGS;
   }
 
-  struct ejdb *db = calloc(1, sizeof(*db));
-  if (!db) {
-    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  struct ejdb *db;
+  rci = posix_memalign((void**) &db, __alignof__(struct ejdb), sizeof(*db));
+  if (rci) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, rci);
   }
+  memset(db, 0, sizeof(*db));
 
   memcpy(&db->opts, _opts, sizeof(db->opts));
   if (!db->opts.sort_buffer_sz) {
@@ -1800,6 +4140,15 @@ iwrc ejdb_open(const struct ejdb_opts *_opts, struct ejdb **ejdbp) {
   if (db->opts.document_buffer_sz < 16 * 1024) { // Min 16Kb
     db->opts.document_buffer_sz = 16 * 1024;
   }
+  if (db->opts.parallel_threads > JB_PARALLEL_MAX_THREADS) {
+    db->opts.parallel_threads = JB_PARALLEL_MAX_THREADS;
+  }
+  if (!db->opts.query_cache_size) {
+    db->opts.query_cache_size = 1024;
+  }
+  if (db->opts.async_threads > JB_PARALLEL_MAX_THREADS) {
+    db->opts.async_threads = JB_PARALLEL_MAX_THREADS;
+  }
   struct ejdb_http *http = &db->opts.http;
   if (http->bind) {
     http->bind = strdup(http->bind);
@@ -1823,7 +4172,28 @@ iwrc ejdb_open(const struct ejdb_opts *_opts, struct ejdb **ejdbp) {
     free(db);
     return rc;
   }
+  pthread_mutex_init(&db->qcache_mtx, 0);
+  pthread_mutex_init(&db->jcache_mtx, 0);
+  pthread_mutex_init(&db->qprof_mtx, 0);
   RCB(finish, db->mcolls = iwhmap_create_str(_mcolls_map_entry_free));
+  RCB(finish, db->qcache = iwhmap_create_str(_jb_qcache_entry_free));
+  iwhmap_lru_init(db->qcache, iwhmap_lru_eviction_max_count,
+                  (void*) (uintptr_t) db->opts.query_cache_size);
+  if (db->opts.join_cache_size) {
+    RCB(finish, db->jcache = iwhmap_create(jb_proj_node_cache_cmp, jb_proj_node_hash, _jb_jcache_entry_free));
+    iwhmap_lru_init(db->jcache, _jb_jcache_eviction_needed, db);
+  }
+  if (db->opts.query_profiler) {
+    RCB(finish, db->qprof = iwhmap_create_str(_jb_qprof_entry_free));
+    iwhmap_lru_init(db->qprof, iwhmap_lru_eviction_max_count, (void*) (uintptr_t) JB_QPROF_MAX_QUERIES);
+  }
+  if (db->opts.result_cache_size) {
+    RCB(finish, db->rcache = calloc(1, sizeof(*db->rcache)));
+    pthread_mutex_init(&db->rcache->mtx, 0);
+    db->rcache->max_size = db->opts.result_cache_size;
+    RCB(finish, db->rcache->map = iwhmap_create_str(_jb_rcache_entry_free));
+    iwhmap_lru_init(db->rcache->map, _jb_rcache_eviction_needed, db->rcache);
+  }
 
   struct iwkv_opts kvopts;
   memcpy(&kvopts, &db->opts.kv, sizeof(db->opts.kv));
@@ -1835,6 +4205,9 @@ iwrc ejdb_open(const struct ejdb_opts *_opts, struct ejdb **ejdbp) {
 
   db->oflags = kvopts.oflags;
   RCC(rc, finish, _jb_db_meta_load(db));
+  if (db->opts.async_threads) {
+    RCC(rc, finish, _jb_async_start(db));
+  }
 
   if (db->opts.http.enabled) {
     // Maximum WS/HTTP API body size. Default: 64Mb, Min: 512K
@@ -1871,6 +4244,10 @@ iwrc ejdb_close(struct ejdb **ejdbp) {
     return IW_ERROR_INVALID_ARGS;
   }
   struct ejdb *db = *ejdbp;
+  if (db->open) {
+    // Pending asynchronous operations are executed before database is closed
+    _jb_async_shutdown(db);
+  }
   if (!__sync_bool_compare_and_swap(&db->open, 1, 0)) {
     iwlog_error2("Database is closed already");
     return IW_ERROR_INVALID_STATE;
@@ -1922,6 +4299,16 @@ static const char* _ejdb_ecodefn(locale_t locale, uint32_t ecode) {
       return "Target collection exists (EJDB_ERROR_TARGET_COLLECTION_EXISTS)";
     case EJDB_ERROR_PATCH_JSON_NOT_OBJECT:
       return "Patch JSON must be an object (map) (EJDB_ERROR_PATCH_JSON_NOT_OBJECT)";
+    case EJDB_ERROR_INVALID_PAGE_TOKEN:
+      return "Invalid or not applicable query page token (EJDB_ERROR_INVALID_PAGE_TOKEN)";
+    case EJDB_ERROR_QUERY_TIMEOUT:
+      return "Query execution time limit exceeded (EJDB_ERROR_QUERY_TIMEOUT)";
+    case EJDB_ERROR_QUERY_CANCELLED:
+      return "Query execution cancelled (EJDB_ERROR_QUERY_CANCELLED)";
+    case EJDB_ERROR_QUERY_BUDGET_EXCEEDED:
+      return "Query execution resource budget exceeded (EJDB_ERROR_QUERY_BUDGET_EXCEEDED)";
+    case EJDB_ERROR_QUERY_INDEX_REMOVED:
+      return "Index used by query was removed during query execution (EJDB_ERROR_QUERY_INDEX_REMOVED)";
     default:
       break;
   }
@@ -54,6 +54,8 @@
 #define NUMRECSDB_ID        2    // DB for number of records per index/collection
 #define KEY_PREFIX_COLLMETA "c." // Full key format: c.<coldbid>
 #define KEY_PREFIX_IDXMETA  "i." // Full key format: i.<coldbid>.<idxdbid>
+#define KEY_PREFIX_KEYDICT  "k." // Full key format: k.<coldbid>.<keyid>
+#define KEY_XDBID           "x"  // ID of database of large documents stored out of collections
 
 #define ENSURE_OPEN(db_)                        \
         if (!(db_) || !((db_)->open)) {         \
@@ -63,20 +65,20 @@
 
 #define API_RLOCK(db_, rci_)                       \
         ENSURE_OPEN(db_);                          \
-        rci_ = pthread_rwlock_rdlock(&(db_)->rwl); \
+        rci_ = jb_db_rlock(db_);                   \
         if (rci_) return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci_)
 
 #define API_WLOCK(db_, rci_)                       \
         ENSURE_OPEN(db_);                          \
-        rci_ = pthread_rwlock_wrlock(&(db_)->rwl); \
+        rci_ = jb_db_wlock(db_);                   \
         if (rci_) return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci_)
 
 #define API_WLOCK2(db_, rci_)                      \
-        rci_ = pthread_rwlock_wrlock(&(db_)->rwl); \
+        rci_ = jb_db_wlock(db_);                   \
         if (rci_) return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci_)
 
 #define API_UNLOCK(db_, rci_, rc_)                 \
-        rci_ = pthread_rwlock_unlock(&(db_)->rwl); \
+        rci_ = jb_db_unlock(db_);                  \
         if (rci_) IWRC(iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci_), rc_)
 
 #define API_COLL_UNLOCK(jbc_, rci_, rc_)                                       \
@@ -89,7 +91,17 @@
 struct jbidx;
 typedef struct jbidx*JBIDX;
 
-/** Database collection */
+#define JB_COLL_WRITE_STRIPES 32  /**< Number of document writer locks of collection, selected by document id */
+#define JB_COL_MAX            16  /**< Max number of columns of collection */
+
+/**
+ * Database collection.
+ *
+ * Locking: `rwl` is acquired exclusively by index management and queries with apply/delete.
+ * Document writers (put, patch, del) and read-only queries share `rwl`, but are never run in parallel
+ * to each other: queries enter `scanners` group and writers enter `writers` group guarded by `wmtx`.
+ * Writers of distinct documents run in parallel and are serialized only by `stripes` lock of document id.
+ */
 typedef struct jbcoll {
   uint32_t      dbid;       /**< IWKV collection database ID */
   const char   *name;       /**< Collection name */
@@ -98,10 +110,40 @@ typedef struct jbcoll {
   struct jbl   *meta;       /**< Collection meta object */
   struct jbidx *idx;        /**< First index in chain */
   int64_t       rnum;       /**< Number of records stored in collection */
+  uint64_t      wepoch;     /**< Write epoch, changed on every modification of collection documents */
+  uint32_t      idxgen;     /**< Indexes generation, changed on every index removal */
+  uint32_t      wwait;      /**< Number of writers waiting for collection lock or writers group */
+  int32_t       scanners;   /**< Number of running read-only queries */
+  int32_t       writers;    /**< Number of running document writers */
+  pthread_mutex_t wmtx;     /**< Guards `scanners` and `writers` */
+  pthread_cond_t  wcond;    /**< Signalled when `scanners` or `writers` group is empty */
+  pthread_mutex_t stripes[JB_COLL_WRITE_STRIPES];
   pthread_rwlock_t rwl;
-  int64_t id_seq;
+  int64_t  id_seq;
+  uint32_t refs;            /**< Number of open `struct ejdb_coll` handles */
+  bool     removed;         /**< Collection is removed, but it is referenced by open handles */
+  ejdb_compression_t zmode; /**< Compression of stored documents */
+  uint8_t  *zdict;          /**< Compression dictionary stored in collection meta */
+  uint32_t  zdictsz;        /**< Size of compression dictionary */
+  uint32_t *zdict_ht;       /**< Hash table of compression dictionary sequences */
+  pthread_rwlock_t krwl;    /**< Guards keys dictionary */
+  struct iwhmap *kmap;      /**< Keys dictionary of documents stored with interned keys: key => id */
+  char   **keys;            /**< Keys dictionary: id - 1 => key */
+  uint32_t keysnum;         /**< Number of keys in dictionary */
+  uint32_t keysasz;         /**< Allocated size of `keys` in elements */
+  struct iwdb *coldb;       /**< Columnar store of collection fields, see `ejdb_ensure_column()` */
+  uint32_t coldbid;         /**< IWKV columnar store database ID */
+  int      colsnum;         /**< Number of collection columns */
+  struct jbl_ptr *cols[JB_COL_MAX]; /**< Top level fields kept in columnar store */
+  pthread_mutex_t colmtx;   /**< Guards update of columnar store segment shared by parallel writers */
 } *JBCOLL;
 
+/** Collection handle */
+struct ejdb_coll {
+  struct ejdb   *db;
+  struct jbcoll *jbc;
+};
+
 /** Database collection index */
 struct jbidx {
   struct jbidx *next;      /**< Next index in chain */
@@ -120,25 +162,150 @@ struct jbdocref {
   const char *coll;
 };
 
+#define JB_DB_RSLOTS 64  /**< Number of readers counters of database lock */
+
+/** Readers counter of database lock, every counter occupies its own cache line */
+struct jbrslot {
+  uint32_t readers;
+} __attribute__((aligned(64)));
+
+/**
+ * Database lock state.
+ *
+ * Readers don't share any lock word: a reader increments counter of `rslots` selected
+ * by calling thread and proceeds if no writer holds or is acquiring database lock.
+ * Writers are serialized by `rwl` write lock, writer waits until all readers counters are zero.
+ * Readers blocked by writer wait for `rwl` read lock. As before, running readers are preferred
+ * to writers so nested read locks of the same thread never deadlock.
+ */
+#define JB_DB_WSTATE_ACQUIRE 1U  /**< Writer is checking readers counters */
+#define JB_DB_WSTATE_HELD    2U  /**< Writer holds database lock */
+
 struct ejdb {
+  struct jbrslot rslots[JB_DB_RSLOTS];
   struct iwkv *iwkv;
   struct iwdb *metadb;
   struct iwdb *nrecdb;
+  struct iwdb *xdb;          /**< Database of large documents bodies stored out of collections */
 #ifdef JB_HTTP
   struct jbr *jbr;
 #endif
   struct iwhmap   *mcolls;
+  struct iwhmap   *qcache;   /**< Prepared query cache: text => struct jql* */
+  pthread_mutex_t  qcache_mtx;
+  struct iwhmap   *jcache;   /**< Joined documents LRU cache: struct jbjcentry => document buffer */
+  pthread_mutex_t  jcache_mtx;
+  uint64_t         jcache_size; /**< Memory size of joined documents cache entries */
+  struct iwhmap   *qprof;    /**< Query profiler: normalized query text => struct jbqprof* */
+  pthread_mutex_t  qprof_mtx;
+  struct jbrcache *rcache;   /**< Query results cache */
+  struct jbasync  *async;    /**< Executor of asynchronous operations */
+  uint64_t         wepoch;    /**< Sequence of collections write epochs */
   iwkv_openflags   oflags;
-  pthread_rwlock_t rwl;      /**< Main RWL */
+  uint32_t         wstate;   /**< Database lock writer state: `JB_DB_WSTATE_*` */
+  pthread_rwlock_t rwl;      /**< Database lock of writers */
   struct ejdb_opts opts;
   volatile bool    open;
 };
 
+// Query profiler constants
+#define JB_QPROF_MAX_QUERIES 1024  /**< Max number of query texts tracked by profiler */
+#define JB_QPROF_BUCKETS     160   /**< Number of latency histogram buckets: 4 buckets per power of two microseconds */
+
+/**
+ * @brief Query profiler entry
+ */
+struct jbqprof {
+  uint64_t calls;             /**< Number of query executions */
+  uint64_t scanned;           /**< Total number of scanned entries */
+  uint64_t fetched;           /**< Total number of fetched documents */
+  uint64_t returned;          /**< Total number of returned documents */
+  uint64_t spills;            /**< Number of executions spilled data into temp file */
+  uint64_t total_us;          /**< Total execution time */
+  uint64_t max_us;            /**< Max execution time */
+  uint32_t idx_dbid;          /**< Database of index used by the last execution */
+  char    *idx;               /**< Path of index used by the last execution */
+  uint64_t hist[JB_QPROF_BUCKETS]; /**< Execution time histogram */
+};
+
+// Query results cache constants
+#define JB_RCACHE_MAX_ENTRY_RATIO 8  /**< Result set larger than 1/8 of results cache size is not cached */
+
+// Joined documents cache constants
+#define JB_JCACHE_MAX_ENTRY_RATIO 8  /**< Document larger than 1/8 of joined documents cache size is not cached */
+
+/**
+ * @brief Joined documents cache entry key
+ */
+struct jbjcentry {
+  struct jbdocref ref;        /**< Document reference, must be the first member */
+  struct ejdb    *db;         /**< Owner database */
+  size_t size;                /**< Memory size of entry */
+};
+
+/**
+ * @brief Query results cache
+ */
+struct jbrcache {
+  struct iwhmap  *map;        /**< Query key => struct jbrcentry* */
+  pthread_mutex_t mtx;
+  uint64_t size;              /**< Memory size of cached entries */
+  uint64_t max_size;          /**< Max memory size of cached entries */
+  uint64_t hits;              /**< Number of queries served from cache */
+  uint64_t misses;            /**< Number of cacheable queries executed */
+};
+
+/**
+ * @brief Query results cache entry
+ */
+struct jbrcentry {
+  struct jbrcache *cache;     /**< Owner cache */
+  uint64_t epoch;             /**< Write epoch of collection results were collected at */
+  int64_t  cnt;               /**< Number of result set documents */
+  size_t   size;              /**< Memory size of entry */
+  uint32_t refs;              /**< Entry is referenced by cache and visiting queries */
+  uint32_t dsz;               /**< Size of serialized documents */
+  uint8_t  data[];            /**< Serialized documents: id, raw document, projected document */
+};
+
+// Asynchronous operations executor constants
+#define JB_ASYNC_BATCH_MAX 64  /**< Max number of queued operations of collection taken by worker at once */
+
+/**
+ * @brief Queue of asynchronous operations of collection.
+ */
+struct jbaqueue {
+  char *coll;                 /**< Collection name */
+  struct ejdb_async *head;    /**< First queued operation */
+  struct ejdb_async *tail;    /**< Last queued operation */
+  struct jbaqueue   *next;    /**< Next queue in the list of ready queues */
+  bool scheduled;             /**< Queue is in the list of ready queues or processed by worker */
+};
+
+/**
+ * @brief Executor of asynchronous operations.
+ *
+ * Every collection has its own queue of operations, queue having operations
+ * is processed by a single worker at time so operations of collection
+ * are executed in submission order.
+ */
+struct jbasync {
+  struct iwhmap   *queues;    /**< Collection name => struct jbaqueue* */
+  struct jbaqueue *ready;     /**< First queue having operations not taken by worker */
+  struct jbaqueue *ready_tail;
+  pthread_t      *threads;
+  int nthreads;
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+  bool shutdown;              /**< Workers are stopped when ready queues list is empty */
+};
+
 struct _jb_put_handler_ctx {
   int64_t id;
   struct jbcoll  *jbc;
   struct jbl     *jbl;
   struct iwkv_val oldval;
+  struct iwkv_val *xval;   /**< Body of large document stored out of collection after put */
 };
 
 struct jbexec;
@@ -163,6 +330,71 @@ struct jbssc {
   bool      sof_active;
 };
 
+/**
+ * @brief Aggregation consumer context
+ */
+struct jbagc {
+  struct iwhmap *groups;      /**< Aggregated groups by encoded group key */
+  struct iwxstr *kbuf;        /**< Encoded group key buffer */
+  struct iwxstr *vbuf;        /**< Encoded value and spilled group record buffer */
+  struct iwxstr *run;         /**< Index key of the current run of documents in ordered mode */
+  uint64_t *refs;             /**< Offsets of spilled group records */
+  uint32_t  refs_asz;         /**< Spilled group records offsets array allocated size */
+  uint32_t  refs_num;         /**< Number of spilled group records */
+  uint64_t  sof_npos;         /**< Next spilled group record offset */
+  uint8_t  *sof_data;         /**< Mmaped spill file data */
+  IWFS_EXT  sof;              /**< Groups spill file */
+  bool      sof_active;
+  bool      ordered;          /**< Documents are visited in index order of the implied order-by field */
+  bool      stop;             /**< Visitor or limit stopped emitting of groups */
+};
+
+/**
+ * @brief Keyset pagination context
+ */
+struct jbpage {
+  struct iwkv_val key;        /**< Key of the last entry visited by previous page (document id or index key) */
+  uint8_t *buf;               /**< Decoded page token */
+  uint32_t dbid;              /**< Database of the scanned collection or index */
+  uint8_t  step;              /**< Scan cursor step */
+  bool     enabled;           /**< Page token is given or next page token is requested */
+  bool     supported;         /**< Query plan supports keyset continuation */
+  bool     resume;            /**< Scan should be resumed after `key` */
+};
+
+/**
+ * @brief Collection lock release during long read-only scans
+ */
+struct jbyield {
+  struct iwkv_val key;        /**< Key of the last visited entry */
+  uint8_t *buf;               /**< Buffer of `key` */
+  size_t   bufsz;             /**< Size of `buf` */
+  uint64_t deadline_ms;       /**< Time of the next collection lock release */
+  uint32_t idxgen;            /**< Collection indexes generation scan is started with */
+  uint32_t cnt;               /**< Number of visited entries since the last clock check */
+  int64_t  id;                /**< Last modified document used as `key` by queries with apply */
+  int64_t  mark;              /**< Number of modified documents at the last collection lock release */
+  bool     enabled;           /**< Collection lock release is enabled for query */
+  bool     write;             /**< Query with apply holding collection write lock, see `EJDB_OPTS.apply_batch_size` */
+};
+
+/**
+ * @brief Query execution statistics
+ */
+struct jbstats {
+  uint64_t    scanned;        /**< Number of collection or index entries passed to consumer */
+  uint64_t    fetched;        /**< Number of fetched and decoded documents */
+  uint64_t    bytes;          /**< Size of fetched documents */
+  uint64_t    matched;        /**< Number of documents matched query filter */
+  uint64_t    prefiltered;    /**< Number of entries rejected by index prefilter or columnar store without document fetch */
+  uint64_t    yields;         /**< Number of collection lock releases during scan */
+  uint64_t    sort_ms;        /**< Time spent in result set sorting */
+  uint64_t    start_ms;       /**< Query execution start time */
+  uint64_t    start_us;       /**< Query execution start time, microseconds. Used by query profiler */
+  const char *collector;      /**< Name of result set collector */
+  bool spilled;               /**< Collector spilled data into temp file */
+};
+
 struct jbmidx {
   struct jbidx      *idx;             /**< Index matched this filter */
   struct jqp_filter *filter;          /**< Query filter */
@@ -174,6 +406,14 @@ struct jbmidx {
   bool orderby_support;               /**< Index supported first order-by clause */
 };
 
+#define JB_PREFILTER_MAX 4  /**< Max number of index lookups checked for every scanned entry before document fetch */
+
+/** Required equality query expression checked by index lookup before document fetch */
+struct jbprobe {
+  struct jbidx    *idx;  /**< Index on the expression field */
+  struct jqp_expr *expr; /**< Equality expression */
+};
+
 typedef struct jbexec {
   struct ejdb_exec *ux;           /**< User defined context */
   struct jbcoll    *jbc;          /**< Collection */
@@ -184,11 +424,30 @@ typedef struct jbexec {
     jb_scan_consumer consumer);
   uint8_t *jblbuf;                 /**< Buffer used to keep currently processed document */
   size_t   jblbufsz;               /**< Size of jblbuf allocated memory */
+  uint8_t *zbuf;                   /**< Buffer used to keep packed document */
+  size_t   zbufsz;                 /**< Size of zbuf allocated memory */
   bool     sorting;                /**< Resultset sorting needed */
+  bool     projection;             /**< Query projection is applied to visited documents */
+  bool     windowed;               /**< Sorter consumer visits documents by windows of
+                                        JB_JOIN_PREFETCH_WINDOW documents without sorting */
   enum iwkv_cursor_op cursor_init; /**< Initial index cursor position (optional) */
   enum iwkv_cursor_op cursor_step; /**< Next index cursor step */
   struct jbmidx midx;              /**< Index matching context */
+  struct jbprobe prefilter[JB_PREFILTER_MAX]; /**< Index lookups rejecting scanned entries before fetch */
+  int prefilter_num;               /**< Number of prefilter index lookups */
   struct jbssc  ssc;               /**< Result set sorting context */
+  struct jbagc  agc;               /**< Aggregation context */
+  struct jbpage page;              /**< Keyset pagination context */
+  struct jbyield yield;            /**< Collection lock release context */
+  struct jbstats stats;            /**< Query execution statistics */
+  struct iwxstr *plan;             /**< Query execution plan kept for slow queries log */
+  struct iwxstr *rcbuf;            /**< Result set recorded into query results cache */
+  char    *rckey;                  /**< Query results cache key */
+  uint64_t deadline_ms;            /**< Query execution deadline, monotonic time */
+  uint64_t obytes;                 /**< Size of documents passed to visitor */
+  struct jbl *coldoc;              /**< Scanned document assembled from collection columns by columnar scanner */
+  bool     prematched;             /**< Scanned documents are already matched by parallel scan workers */
+  bool     guarded;                /**< Query has time limit, cancellation flag or resources budget */
 
   // JQL joned nodes cache
   struct iwhmap *proj_joined_nodes_cache;
@@ -205,6 +464,45 @@ typedef uint8_t jb_coll_acquire_t;
 #define JB_IDX_EMPIRIC_MIN_INOP_ARRAY_SIZE  10
 #define JB_IDX_EMPIRIC_MAX_INOP_ARRAY_RATIO 200
 
+// Parallel query execution constants
+#define JB_PARALLEL_MAX_THREADS           256
+#define JB_PARALLEL_SCAN_MIN_RNUM         8192   /**< Min number of collection records per parallel scan worker */
+#define JB_PARALLEL_SCAN_CHUNKS_PER_WORKER 4     /**< Number of id ranges scheduled per parallel scan worker */
+#define JB_PARALLEL_SORT_MIN_REFS         16384  /**< Min number of sorted documents per parallel sort worker */
+
+// Aggregation constants
+#define JB_AGGREGATE_SPILL_GROUPS 65536  /**< Max number of in-memory groups before spilling them into temp file */
+
+// Query execution guard constants
+#define JB_EXEC_GUARD_CLOCK_INTERVAL 64  /**< Number of scanned entries between checks of query deadline.
+                                              Must be a power of two */
+
+// Documents compression constants
+#define JB_ZDOC_LZ        0xfe   /**< Marker of stored document packed by built-in codec.
+                                      Never starts binn value of document */
+#define JB_ZDOC_LZ_DICT   0xfd   /**< Marker of stored document packed using collection dictionary */
+#define JB_ZDOC_KEYS      0xfb   /**< Marker of stored document which objects are binn maps
+                                      of collection keys dictionary ids */
+#define JB_ZDOC_HDR_SIZE  5      /**< Packed document header: marker and unpacked size */
+#define JB_ZDOC_MIN_SIZE  64     /**< Documents smaller than given size are stored as is */
+#define JB_ZDOC_HASH_LOG  12     /**< Number of bits of codec hash table */
+#define JB_ZDICT_MAX_SIZE 32768  /**< Max size of compression dictionary */
+
+// Large documents constants
+#define JB_XDOC            0xfc  /**< Marker of stub of large document which body is stored in `ejdb.xdb` */
+#define JB_XDOC_HDR_SIZE   13    /**< Stub header: marker, document id and size of summary object */
+#define JB_XDOC_KEY_SIZE   12    /**< Body key in `ejdb.xdb`: big-endian collection database id and document id */
+#define JB_XDOC_FIELD_MAX  256   /**< Max size of top level field value kept in summary of large document */
+#define JB_XDOC_SUMMARY_MAX 4096 /**< Max size of summary of large document */
+
+// Columnar store constants
+#define JB_COL_SEGMENT_BITS   8   /**< Number of low document id bits addressing slot of column segment */
+#define JB_COL_SEGMENT_SLOTS  (1 << JB_COL_SEGMENT_BITS) /**< Number of documents of column segment */
+#define JB_COL_PREDICATES_MAX 8   /**< Max number of query expressions evaluated over column segments */
+
+// Joins constants
+#define JB_JOIN_PREFETCH_WINDOW 64  /**< Max number of result documents which joined documents are fetched at once */
+
 void jbi_jbl_fill_ikey(struct jbidx *idx, struct jbl *jbv, struct iwkv_val *ikey, char numbuf[static IWNUMBUF_SIZE]);
 void jbi_jqval_fill_ikey(
   struct jbidx *idx, const struct jqval *jqval, struct iwkv_val *ikey,
@@ -217,25 +515,90 @@ iwrc jbi_consumer(struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, int64
 iwrc jbi_sorter_consumer(
   struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, int64_t *step, bool *matched,
   iwrc err);
+iwrc jbi_aggregate_consumer(
+  struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, int64_t *step, bool *matched,
+  iwrc err);
 iwrc jbi_full_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
+iwrc jbi_parallel_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
+int jbi_parallel_scan_threads(struct jbexec *ctx);
+int jbi_parallel_start(pthread_t *threads, int num, void* (*task)(void*), void *args, size_t arg_size);
+void jbi_parallel_join(pthread_t *threads, int num);
 iwrc jbi_selection(struct jbexec *ctx);
 iwrc jbi_pk_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
 iwrc jbi_uniq_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
 iwrc jbi_dup_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
+iwrc jbi_page_init(struct jbexec *ctx);
+void jbi_page_release(struct jbexec *ctx);
+iwrc jbi_page_cursor_open(
+  struct jbexec *ctx, struct iwdb *db, uint32_t dbid, enum iwkv_cursor_op step,
+  struct iwkv_cursor **curp);
+iwrc jbi_page_next_token(struct jbexec *ctx, struct iwkv_cursor *cur, uint32_t dbid, enum iwkv_cursor_op step);
+iwrc jbi_yield(struct jbexec *ctx, struct iwkv_cursor **curp);
+iwrc jbi_yield_write(struct jbexec *ctx, int64_t id, struct iwkv_cursor **curp);
 bool jbi_node_expr_matched(
-  struct jqp_aux     *aux,
+  struct jql         *q,
   struct jbidx       *idx,
   struct iwkv_cursor *cur,
   struct jqp_expr    *expr,
   iwrc               *rcp);
-
+bool jbi_prefilter_matched(struct jbexec *ctx, int64_t id, iwrc *rcp);
+iwrc jbi_doc_fetch(
+  struct jbcoll *jbc, struct jql *q, struct iwkv_cursor *cur, int64_t id, uint8_t **bufp, size_t *bufszp,
+  uint8_t **zbufp, size_t *zbufszp, size_t off, struct jbl *jbl, size_t *vszp, bool *matched);
+iwrc jbi_scan_doc_fetch(
+  struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, struct jbl *jbl, size_t *vszp,
+  bool *matched);
+
+IW_INLINE bool jbi_doc_is_packed(const void *buf, size_t sz) {
+  const uint8_t *b = buf;
+  return sz && (b[0] == JB_ZDOC_LZ || b[0] == JB_ZDOC_LZ_DICT || b[0] == JB_ZDOC_KEYS || b[0] == JB_XDOC);
+}
+
+IW_INLINE bool jbi_doc_is_large(const void *buf, size_t sz) {
+  return sz >= JB_XDOC_HDR_SIZE && *(const uint8_t*) buf == JB_XDOC;
+}
+
+iwrc jbi_doc_pack(struct jbcoll *jbc, struct iwkv_val *val, void **zbufp);
+iwrc jbi_doc_unpack(struct jbcoll *jbc, struct iwkv_val *val);
+iwrc jbi_doc_unpack_buf(
+  struct jbcoll *jbc, uint8_t **bufp, size_t *bufszp, uint8_t **zbufp, size_t *zbufszp,
+  size_t off, size_t *vszp);
+bool jbi_xdoc_needed(struct jbcoll *jbc, size_t sz);
+iwrc jbi_xdoc_stub(struct jbcoll *jbc, int64_t id, const void *doc, size_t docsz, struct iwkv_val *val, void **xbufp);
+iwrc jbi_xdoc_put(struct jbcoll *jbc, int64_t id, struct iwkv_val *val);
+iwrc jbi_xdoc_load(struct jbcoll *jbc, struct iwkv_val *val);
+iwrc jbi_xdoc_load_buf(struct jbcoll *jbc, uint8_t **bufp, size_t *bufszp, size_t off, size_t *vszp);
+bool jbi_xdoc_summary_matched(struct jql *q, const uint8_t *stub, size_t stubsz, bool *matched, iwrc *rcp);
+iwrc jbi_xdoc_del(struct jbcoll *jbc, int64_t id);
+iwrc jbi_xdoc_remove_all(struct ejdb *db, uint32_t dbid);
+iwrc jbi_columns_put(struct jbcoll *jbc, int64_t id, struct jbl *jbl);
+iwrc jbi_columns_del(struct jbcoll *jbc, int64_t id);
+iwrc jbi_columns_fill(struct jbcoll *jbc);
+bool jbi_columns_covered(struct jbexec *ctx);
+iwrc jbi_columns_scanner(struct jbexec *ctx, jb_scan_consumer consumer);
+void jbi_zdict_hash(const uint8_t *dict, uint32_t dictsz, uint32_t *ht);
+iwrc jbi_zdict_train(
+  struct jbcoll *jbc, ejdb_compression_t mode, uint32_t sample, uint8_t **dictp,
+  uint32_t *dictszp);
+
+int jb_db_rlock(struct ejdb *db);
+int jb_db_wlock(struct ejdb *db);
+int jb_db_unlock(struct ejdb *db);
+int jb_coll_wrlock(struct jbcoll *jbc);
+void jb_coll_scan_lock(struct jbcoll *jbc);
+void jb_coll_scan_unlock(struct jbcoll *jbc);
 iwrc jb_get(struct ejdb *db, const char *coll, int64_t id, jb_coll_acquire_t acm, struct jbl **jblp);
 iwrc jb_put(struct jbcoll *jbc, struct jbl *jbl, int64_t id);
 iwrc jb_del(struct jbcoll *jbc, struct jbl *jbl, int64_t id);
 iwrc jb_cursor_set(struct jbcoll *jbc, struct iwkv_cursor *cur, int64_t id, JBL jbl);
 iwrc jb_cursor_del(struct jbcoll *jbc, struct iwkv_cursor *cur, int64_t id, JBL jbl);
+iwrc jb_exec_visit(struct jbexec *ctx, struct ejdb_doc *doc, int64_t *step);
+iwrc jb_exec_guard(struct jbexec *ctx, uint64_t scanned);
 
 iwrc jb_collection_join_resolver(int64_t id, const char *coll, struct jbl **out, struct jbexec *ctx);
+iwrc jb_collection_join_fetch(
+  struct jbexec *ctx, const char *coll, const int64_t *ids, int num,
+  iwrc (*visitor)(int64_t id, struct jbl *jbl, void *op), void *op);
 int jb_proj_node_cache_cmp(const void *v1, const void *v2);
 void jb_proj_node_kvfree(void *key, void *val);
 uint32_t jb_proj_node_hash(const void *key);
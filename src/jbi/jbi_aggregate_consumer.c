@@ -0,0 +1,725 @@
+#include "ejdb2_internal.h"
+#include "sort_r.h"
+
+#include <iowow/wyhash32.h>
+
+/** Decoded atomic value */
+struct _jbi_agg_value {
+  jbl_type_t  type;
+  int64_t     vi64;   /**< Integer or boolean value */
+  double      vf64;
+  const char *vstr;
+  uint32_t    vsize;  /**< String value length */
+};
+
+/** Aggregate function state */
+struct _jbi_agg_state {
+  int64_t  num;       /**< Number of aggregated values */
+  int64_t  isum;      /**< Sum of integer values */
+  double   fsum;      /**< Sum of values after the first float value or integer overflow */
+  bool     fmode;     /**< Sum is kept in `fsum` */
+  uint32_t mvsz;      /**< Encoded min/max value size */
+  uint8_t *mv;        /**< Encoded min/max value */
+};
+
+/** Aggregated group */
+struct _jbi_agg_group {
+  int64_t cnt;        /**< Number of documents in group */
+  int     num;        /**< Number of aggregate function states */
+  struct _jbi_agg_state states[];
+};
+
+/** Encoded group key */
+struct _jbi_agg_key {
+  uint32_t size;
+  uint8_t  data[];
+};
+
+static int _jbi_agg_key_cmp(const void *v1, const void *v2) {
+  const struct _jbi_agg_key *k1 = v1, *k2 = v2;
+  if (k1->size != k2->size) {
+    return k1->size > k2->size ? 1 : -1;
+  }
+  return memcmp(k1->data, k2->data, k1->size);
+}
+
+static uint32_t _jbi_agg_key_hash(const void *v) {
+  const struct _jbi_agg_key *k = v;
+  return wyhash32(k->data, k->size, 0x9a3f1c57);
+}
+
+static void _jbi_agg_group_free(struct _jbi_agg_group *g) {
+  if (g) {
+    for (int i = 0; i < g->num; ++i) {
+      free(g->states[i].mv);
+    }
+    free(g);
+  }
+}
+
+static void _jbi_agg_kv_free(void *key, void *val) {
+  free(key);
+  _jbi_agg_group_free(val);
+}
+
+static void _jbi_agg_release(struct jbexec *ctx) {
+  struct jbagc *agc = &ctx->agc;
+  if (agc->groups) {
+    iwhmap_destroy(agc->groups);
+  }
+  iwxstr_destroy(agc->kbuf);
+  iwxstr_destroy(agc->vbuf);
+  iwxstr_destroy(agc->run);
+  free(agc->refs);
+  if (agc->sof_active) {
+    agc->sof.close(&agc->sof);
+  }
+  memset(agc, 0, sizeof(*agc));
+}
+
+static iwrc _jbi_agg_init(struct jbexec *ctx) {
+  iwrc rc = 0;
+  struct jbagc *agc = &ctx->agc;
+  RCB(finish, agc->groups = iwhmap_create(_jbi_agg_key_cmp, _jbi_agg_key_hash, _jbi_agg_kv_free));
+  RCB(finish, agc->kbuf = iwxstr_new());
+  RCB(finish, agc->vbuf = iwxstr_new());
+  RCB(finish, agc->run = iwxstr_new());
+
+finish:
+  return rc;
+}
+
+/**
+ * @brief Appends encoded boolean, number or string value to `xstr`.
+ *
+ * Integral float numbers are encoded as integers so `1` and `1.0` fall into the same group.
+ * `encoded` is set to `false` for other value types.
+ */
+static iwrc _jbi_agg_value_encode(struct jbl *v, struct iwxstr *xstr, bool *encoded) {
+  iwrc rc = 0;
+  uint8_t type = jbl_type(v);
+  *encoded = true;
+  switch (type) {
+    case JBV_BOOL: {
+      uint8_t bv = jbl_get_i32(v) != 0;
+      RCR(iwxstr_cat(xstr, &type, sizeof(type)));
+      rc = iwxstr_cat(xstr, &bv, sizeof(bv));
+      break;
+    }
+    case JBV_I64: {
+      int64_t llv = jbl_get_i64(v);
+      RCR(iwxstr_cat(xstr, &type, sizeof(type)));
+      rc = iwxstr_cat(xstr, &llv, sizeof(llv));
+      break;
+    }
+    case JBV_F64: {
+      double dv = jbl_get_f64(v);
+      if ((dv >= (double) INT64_MIN) && (dv < (double) INT64_MAX) && (dv == (double) (int64_t) dv)) {
+        int64_t llv = (int64_t) dv;
+        type = JBV_I64;
+        RCR(iwxstr_cat(xstr, &type, sizeof(type)));
+        rc = iwxstr_cat(xstr, &llv, sizeof(llv));
+      } else {
+        RCR(iwxstr_cat(xstr, &type, sizeof(type)));
+        rc = iwxstr_cat(xstr, &dv, sizeof(dv));
+      }
+      break;
+    }
+    case JBV_STR: {
+      uint32_t len = (uint32_t) jbl_size(v);
+      RCR(iwxstr_cat(xstr, &type, sizeof(type)));
+      RCR(iwxstr_cat(xstr, &len, sizeof(len)));
+      rc = iwxstr_cat(xstr, jbl_get_str(v), len);
+      break;
+    }
+    default:
+      *encoded = false;
+      break;
+  }
+  return rc;
+}
+
+static const uint8_t* _jbi_agg_value_decode(const uint8_t *rp, struct _jbi_agg_value *v) {
+  v->type = *rp++;
+  switch (v->type) {
+    case JBV_BOOL:
+      v->vi64 = *rp++;
+      break;
+    case JBV_I64:
+      memcpy(&v->vi64, rp, sizeof(v->vi64));
+      rp += sizeof(v->vi64);
+      break;
+    case JBV_F64:
+      memcpy(&v->vf64, rp, sizeof(v->vf64));
+      rp += sizeof(v->vf64);
+      break;
+    case JBV_STR:
+      memcpy(&v->vsize, rp, sizeof(v->vsize));
+      rp += sizeof(v->vsize);
+      v->vstr = (const char*) rp;
+      rp += v->vsize;
+      break;
+    default:
+      break;
+  }
+  return rp;
+}
+
+/**
+ * Compares decoded values: `bool < number < string`.
+ */
+static int _jbi_agg_value_cmp(const struct _jbi_agg_value *v1, const struct _jbi_agg_value *v2) {
+  int t1 = v1->type == JBV_F64 ? JBV_I64 : v1->type;
+  int t2 = v2->type == JBV_F64 ? JBV_I64 : v2->type;
+  if (t1 != t2) {
+    return t1 - t2;
+  }
+  switch (t1) {
+    case JBV_STR: {
+      int rv = memcmp(v1->vstr, v2->vstr, MIN(v1->vsize, v2->vsize));
+      if (rv) {
+        return rv;
+      }
+      return v1->vsize > v2->vsize ? 1 : v1->vsize < v2->vsize ? -1 : 0;
+    }
+    case JBV_I64:
+      if ((v1->type == JBV_I64) && (v2->type == JBV_I64)) {
+        return v1->vi64 > v2->vi64 ? 1 : v1->vi64 < v2->vi64 ? -1 : 0;
+      } else {
+        double d1 = v1->type == JBV_I64 ? (double) v1->vi64 : v1->vf64;
+        double d2 = v2->type == JBV_I64 ? (double) v2->vi64 : v2->vf64;
+        return d1 > d2 ? 1 : d1 < d2 ? -1 : 0;
+      }
+    default:
+      return (int) (v1->vi64 - v2->vi64);
+  }
+}
+
+static iwrc _jbi_agg_node_add(struct jbl_node *parent, const char *key, const struct _jbi_agg_value *v, IWPOOL *pool) {
+  switch (v->type) {
+    case JBV_BOOL:
+      return jbn_add_item_bool(parent, key, v->vi64 != 0, 0, pool);
+    case JBV_I64:
+      return jbn_add_item_i64(parent, key, v->vi64, 0, pool);
+    case JBV_F64:
+      return jbn_add_item_f64(parent, key, v->vf64, 0, pool);
+    case JBV_STR:
+      return jbn_add_item_str(parent, key, v->vstr, (int) v->vsize, 0, pool);
+    default:
+      return jbn_add_item_null(parent, key, pool);
+  }
+}
+
+/**
+ * Replaces min/max value of `st` by encoded value `mv` if it is less/greater than current one.
+ */
+static iwrc _jbi_agg_state_minmax(
+  jqp_aggregate_op_t     op,
+  struct _jbi_agg_state *st,
+  const uint8_t         *mv,
+  uint32_t               mvsz) {
+  if (st->mv) {
+    struct _jbi_agg_value v1, v2;
+    _jbi_agg_value_decode(st->mv, &v1);
+    _jbi_agg_value_decode(mv, &v2);
+    int cmp = _jbi_agg_value_cmp(&v2, &v1);
+    if ((op == JQP_AGGREGATE_MIN) ? (cmp >= 0) : (cmp <= 0)) {
+      return 0;
+    }
+  }
+  if (st->mvsz != mvsz) {
+    uint8_t *nmv = realloc(st->mv, mvsz);
+    if (!nmv) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    st->mv = nmv;
+    st->mvsz = mvsz;
+  }
+  memcpy(st->mv, mv, mvsz);
+  return 0;
+}
+
+static iwrc _jbi_agg_state_add(struct jbagc *agc, struct jqp_aggregate *agg, struct _jbi_agg_state *st, struct jbl *v) {
+  jbl_type_t type = jbl_type(v);
+  switch (agg->op) {
+    case JQP_AGGREGATE_SUM:
+    case JQP_AGGREGATE_AVG:
+      if ((type != JBV_I64) && (type != JBV_F64)) {
+        return 0;
+      }
+      if (!st->fmode && (type == JBV_I64)) {
+        int64_t sum;
+        if (!__builtin_add_overflow(st->isum, jbl_get_i64(v), &sum)) {
+          st->isum = sum;
+          break;
+        }
+      }
+      if (!st->fmode) {
+        st->fmode = true;
+        st->fsum = (double) st->isum;
+      }
+      st->fsum += jbl_get_f64(v);
+      break;
+    default: {
+      bool encoded;
+      iwxstr_clear(agc->vbuf);
+      RCR(_jbi_agg_value_encode(v, agc->vbuf, &encoded));
+      if (!encoded) {
+        return 0;
+      }
+      RCR(_jbi_agg_state_minmax(agg->op, st, (void*) iwxstr_ptr(agc->vbuf), (uint32_t) iwxstr_size(agc->vbuf)));
+      break;
+    }
+  }
+  ++st->num;
+  return 0;
+}
+
+static iwrc _jbi_agg_state_merge(jqp_aggregate_op_t op, struct _jbi_agg_state *dst, const struct _jbi_agg_state *src) {
+  if (!src->num) {
+    return 0;
+  }
+  switch (op) {
+    case JQP_AGGREGATE_SUM:
+    case JQP_AGGREGATE_AVG: {
+      int64_t sum;
+      if (!dst->fmode && !src->fmode && !__builtin_add_overflow(dst->isum, src->isum, &sum)) {
+        dst->isum = sum;
+      } else {
+        dst->fsum = (dst->fmode ? dst->fsum : (double) dst->isum) + (src->fmode ? src->fsum : (double) src->isum);
+        dst->fmode = true;
+      }
+      break;
+    }
+    default:
+      RCR(_jbi_agg_state_minmax(op, dst, src->mv, src->mvsz));
+      break;
+  }
+  dst->num += src->num;
+  return 0;
+}
+
+/**
+ * Visits document of aggregated group.
+ */
+static iwrc _jbi_agg_emit(struct jbexec *ctx, const uint8_t *key, const struct _jbi_agg_group *g) {
+  iwrc rc = 0;
+  struct _jbi_agg_value v;
+  struct jbl *jbl = 0;
+  struct jbl_node *root;
+  struct jbagc *agc = &ctx->agc;
+  struct ejdb_exec *ux = ctx->ux;
+  struct jqp_aux *aux = ux->q->aux;
+  struct iwpool *pool = ux->pool;
+
+  if (agc->stop) {
+    return 0;
+  }
+  if (ux->skip > 0) {
+    --ux->skip;
+    return 0;
+  }
+  if (!pool) {
+    RCB(finish, pool = iwpool_create(256));
+  }
+  RCB(finish, root = iwpool_calloc(sizeof(*root), pool));
+  root->type = JBV_OBJECT;
+  for (struct jqp_aggregate *agg = aux->groupby; agg; agg = agg->next) {
+    key = _jbi_agg_value_decode(key, &v);
+    RCC(rc, finish, _jbi_agg_node_add(root, agg->name, &v, pool));
+  }
+  if (aux->groupby) {
+    RCC(rc, finish, jbn_add_item_i64(root, "count", g->cnt, 0, pool));
+  }
+  int i = 0;
+  for (struct jqp_aggregate *agg = aux->aggregates; agg; agg = agg->next, ++i) {
+    const struct _jbi_agg_state *st = &g->states[i];
+    if (!st->num) {
+      rc = jbn_add_item_null(root, agg->name, pool);
+    } else if (agg->op == JQP_AGGREGATE_SUM) {
+      if (st->fmode) {
+        rc = jbn_add_item_f64(root, agg->name, st->fsum, 0, pool);
+      } else {
+        rc = jbn_add_item_i64(root, agg->name, st->isum, 0, pool);
+      }
+    } else if (agg->op == JQP_AGGREGATE_AVG) {
+      rc = jbn_add_item_f64(root, agg->name, (st->fmode ? st->fsum : (double) st->isum) / st->num, 0, pool);
+    } else {
+      _jbi_agg_value_decode(st->mv, &v);
+      rc = _jbi_agg_node_add(root, agg->name, &v, pool);
+    }
+    RCGO(rc, finish);
+  }
+  RCC(rc, finish, jbl_from_node(&jbl, root));
+
+  if (!(aux->qmode & JQP_QRY_AGGREGATE)) {
+    struct ejdb_doc doc = {
+      .raw  = jbl,
+      .node = root
+    };
+    do {
+      ctx->istep = 1;
+      RCC(rc, finish, jb_exec_visit(ctx, &doc, &ctx->istep));
+    } while (ctx->istep == -1);
+    if (!ctx->istep) {
+      agc->stop = true;
+    } else if (ctx->istep > 1) {
+      ux->skip += ctx->istep - 1;
+    }
+  }
+  ++ux->cnt;
+  if (--ux->limit < 1) {
+    agc->stop = true;
+  }
+
+finish:
+  jbl_destroy(&jbl);
+  if (pool && (pool != ux->pool)) {
+    iwpool_destroy(pool);
+  }
+  return rc;
+}
+
+/**
+ * Visits all in-memory groups then clears them.
+ */
+static iwrc _jbi_agg_emit_groups(struct jbexec *ctx) {
+  iwrc rc = 0;
+  struct iwhmap_iter iter;
+  struct jbagc *agc = &ctx->agc;
+  iwhmap_iter_init(agc->groups, &iter);
+  while (!agc->stop && iwhmap_iter_next(&iter)) {
+    const struct _jbi_agg_key *key = iter.key;
+    rc = _jbi_agg_emit(ctx, key->data, iter.val);
+    RCBREAK(rc);
+  }
+  iwhmap_clear(agc->groups);
+  return rc;
+}
+
+/**
+ * Appends partial states of in-memory groups to the spill file then clears them.
+ * Spilled record: `[key size:u32][key][cnt:i64]([num:i64][isum:i64][fsum:f64][fmode:u8][mv size:u32][mv])*`
+ */
+static iwrc _jbi_agg_spill(struct jbexec *ctx) {
+  iwrc rc = 0;
+  size_t sz;
+  struct iwhmap_iter iter;
+  struct jbagc *agc = &ctx->agc;
+  struct iwxstr *xstr = agc->vbuf;
+
+  if (!agc->sof_active) {
+    IWFS_EXT_OPTS opts = {
+      .initial_size = 128 * 1024,
+      .rspolicy     = iw_exfile_szpolicy_fibo,
+      .file         = {
+        .path       = "jb-",
+        .omode      = IWFS_OTMP | IWFS_OUNLINK
+      }
+    };
+    RCR(iwfs_exfile_open(&agc->sof, &opts));
+    agc->sof_active = true;
+    ctx->stats.spilled = true;
+    RCR(agc->sof.add_mmap(&agc->sof, 0, SIZE_T_MAX, 0));
+  }
+  iwhmap_iter_init(agc->groups, &iter);
+  while (iwhmap_iter_next(&iter)) {
+    const struct _jbi_agg_key *key = iter.key;
+    const struct _jbi_agg_group *g = iter.val;
+    iwxstr_clear(xstr);
+    RCR(iwxstr_cat(xstr, &key->size, sizeof(key->size)));
+    RCR(iwxstr_cat(xstr, key->data, key->size));
+    RCR(iwxstr_cat(xstr, &g->cnt, sizeof(g->cnt)));
+    for (int i = 0; i < g->num; ++i) {
+      const struct _jbi_agg_state *st = &g->states[i];
+      uint8_t fmode = st->fmode;
+      RCR(iwxstr_cat(xstr, &st->num, sizeof(st->num)));
+      RCR(iwxstr_cat(xstr, &st->isum, sizeof(st->isum)));
+      RCR(iwxstr_cat(xstr, &st->fsum, sizeof(st->fsum)));
+      RCR(iwxstr_cat(xstr, &fmode, sizeof(fmode)));
+      RCR(iwxstr_cat(xstr, &st->mvsz, sizeof(st->mvsz)));
+      if (st->mvsz) {
+        RCR(iwxstr_cat(xstr, st->mv, st->mvsz));
+      }
+    }
+    if (agc->refs_num >= agc->refs_asz) {
+      uint32_t nsz = agc->refs_asz ? agc->refs_asz * 2 : 1024;
+      uint64_t *nrefs = realloc(agc->refs, nsz * sizeof(agc->refs[0]));
+      if (!nrefs) {
+        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      }
+      agc->refs = nrefs;
+      agc->refs_asz = nsz;
+    }
+    RCR(agc->sof.write(&agc->sof, (off_t) agc->sof_npos, iwxstr_ptr(xstr), iwxstr_size(xstr), &sz));
+    agc->refs[agc->refs_num++] = agc->sof_npos;
+    agc->sof_npos += iwxstr_size(xstr);
+  }
+  iwhmap_clear(agc->groups);
+  return rc;
+}
+
+static int _jbi_agg_spill_cmp(const void *o1, const void *o2, void *op) {
+  uint64_t r1, r2;
+  uint32_t s1, s2;
+  struct jbagc *agc = op;
+  memcpy(&r1, o1, sizeof(r1));
+  memcpy(&r2, o2, sizeof(r2));
+  memcpy(&s1, agc->sof_data + r1, sizeof(s1));
+  memcpy(&s2, agc->sof_data + r2, sizeof(s2));
+  if (s1 != s2) {
+    return s1 > s2 ? 1 : -1;
+  }
+  return memcmp(agc->sof_data + r1 + sizeof(s1), agc->sof_data + r2 + sizeof(s2), s1);
+}
+
+/**
+ * Sorts spilled records by group key then merges partial states of every group and visits it.
+ */
+static iwrc _jbi_agg_emit_spilled(struct jbexec *ctx) {
+  iwrc rc = 0;
+  size_t sp;
+  uint32_t ksz = 0;
+  const uint8_t *key = 0;
+  struct jbagc *agc = &ctx->agc;
+  struct jqp_aux *aux = ctx->ux->q->aux;
+  struct _jbi_agg_group *mg;
+
+  RCR(_jbi_agg_spill(ctx));
+  RCR(agc->sof.probe_mmap(&agc->sof, 0, &agc->sof_data, &sp));
+  sort_r(agc->refs, agc->refs_num, sizeof(agc->refs[0]), _jbi_agg_spill_cmp, agc);
+
+  mg = calloc(1, sizeof(*mg) + aux->aggregates_num * sizeof(mg->states[0]));
+  if (!mg) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  mg->num = aux->aggregates_num;
+
+  for (uint32_t i = 0; i < agc->refs_num && !agc->stop; ++i) {
+    uint32_t rksz;
+    int64_t cnt;
+    const uint8_t *rp = agc->sof_data + agc->refs[i];
+    memcpy(&rksz, rp, sizeof(rksz));
+    rp += sizeof(rksz);
+    if (key && ((rksz != ksz) || memcmp(key, rp, ksz))) {
+      RCC(rc, finish, _jbi_agg_emit(ctx, key, mg));
+      key = 0;
+    }
+    if (!key) { // Next group
+      key = rp;
+      ksz = rksz;
+      mg->cnt = 0;
+      for (int j = 0; j < mg->num; ++j) {
+        struct _jbi_agg_state *st = &mg->states[j];
+        free(st->mv);
+        memset(st, 0, sizeof(*st));
+      }
+    }
+    rp += rksz;
+    memcpy(&cnt, rp, sizeof(cnt));
+    rp += sizeof(cnt);
+    mg->cnt += cnt;
+    int j = 0;
+    for (struct jqp_aggregate *agg = aux->aggregates; agg; agg = agg->next, ++j) {
+      uint8_t fmode;
+      struct _jbi_agg_state st;
+      memcpy(&st.num, rp, sizeof(st.num));
+      rp += sizeof(st.num);
+      memcpy(&st.isum, rp, sizeof(st.isum));
+      rp += sizeof(st.isum);
+      memcpy(&st.fsum, rp, sizeof(st.fsum));
+      rp += sizeof(st.fsum);
+      memcpy(&fmode, rp, sizeof(fmode));
+      rp += sizeof(fmode);
+      memcpy(&st.mvsz, rp, sizeof(st.mvsz));
+      rp += sizeof(st.mvsz);
+      st.fmode = fmode;
+      st.mv = (uint8_t*) rp;
+      rp += st.mvsz;
+      RCC(rc, finish, _jbi_agg_state_merge(agg->op, &mg->states[j], &st));
+    }
+  }
+  if (key) {
+    rc = _jbi_agg_emit(ctx, key, mg);
+  }
+
+finish:
+  _jbi_agg_group_free(mg);
+  return rc;
+}
+
+/**
+ * Finds or creates group for the group key in `agc->kbuf`.
+ */
+static iwrc _jbi_agg_group_get(struct jbexec *ctx, struct _jbi_agg_group **out) {
+  struct jbagc *agc = &ctx->agc;
+  struct jqp_aux *aux = ctx->ux->q->aux;
+  uint32_t ksz = (uint32_t) iwxstr_size(agc->kbuf);
+  struct _jbi_agg_key *key = malloc(sizeof(*key) + ksz);
+  if (!key) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  key->size = ksz;
+  memcpy(key->data, iwxstr_ptr(agc->kbuf), ksz);
+
+  struct _jbi_agg_group *g = iwhmap_get(agc->groups, key);
+  if (g) {
+    free(key);
+    *out = g;
+    return 0;
+  }
+  if (!agc->ordered && (iwhmap_count(agc->groups) >= JB_AGGREGATE_SPILL_GROUPS)) {
+    iwrc rc = _jbi_agg_spill(ctx);
+    if (rc) {
+      free(key);
+      return rc;
+    }
+  }
+  g = calloc(1, sizeof(*g) + aux->aggregates_num * sizeof(g->states[0]));
+  if (!g) {
+    free(key);
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  g->num = aux->aggregates_num;
+  iwrc rc = iwhmap_put(agc->groups, key, g);
+  if (rc) {
+    _jbi_agg_kv_free(key, g);
+    return rc;
+  }
+  *out = g;
+  return 0;
+}
+
+/**
+ * Tracks runs of equal index keys of implied order-by field when documents are scanned in index order.
+ * Groups of the finished run cannot appear again so they are visited immediately.
+ * In the case of single `min`/`max` function the scan is stopped after the first run having a value.
+ */
+static iwrc _jbi_agg_ordered_run(struct jbexec *ctx, struct jbl *jbl, int64_t *step) {
+  struct jbl v;
+  struct iwkv_val ikey;
+  char numbuf[IWNUMBUF_SIZE];
+  struct jbagc *agc = &ctx->agc;
+  struct jqp_aux *aux = ctx->ux->q->aux;
+
+  if (!_jbl_at(jbl, aux->orderby_ptrs[0], &v)) {
+    return 0;
+  }
+  jbi_jbl_fill_ikey(ctx->midx.idx, &v, &ikey, numbuf);
+  if (  !ikey.size
+     || (  (ikey.size == iwxstr_size(agc->run))
+        && !memcmp(ikey.data, iwxstr_ptr(agc->run), ikey.size))) {
+    return 0;
+  }
+  if (iwxstr_size(agc->run)) {
+    if (aux->groupby) {
+      RCR(_jbi_agg_emit_groups(ctx));
+      if (agc->stop) {
+        *step = 0;
+      }
+    } else if (iwhmap_count(agc->groups)) {
+      struct iwhmap_iter iter;
+      iwhmap_iter_init(agc->groups, &iter);
+      if (iwhmap_iter_next(&iter) && ((struct _jbi_agg_group*) iter.val)->states[0].num) {
+        *step = 0;
+      }
+    }
+  }
+  iwxstr_clear(agc->run);
+  return iwxstr_cat(agc->run, ikey.data, ikey.size);
+}
+
+static iwrc _jbi_agg_document(struct jbexec *ctx, struct jbl *jbl, int64_t *step) {
+  struct jbl v;
+  struct _jbi_agg_group *g;
+  struct jbagc *agc = &ctx->agc;
+  struct jqp_aux *aux = ctx->ux->q->aux;
+
+  iwxstr_clear(agc->kbuf);
+  for (struct jqp_aggregate *agg = aux->groupby; agg; agg = agg->next) {
+    bool encoded = false;
+    if (_jbl_at(jbl, agg->ptr, &v)) {
+      RCR(_jbi_agg_value_encode(&v, agc->kbuf, &encoded));
+    }
+    if (!encoded) { // Documents without group key value are not aggregated
+      return 0;
+    }
+  }
+  if (agc->ordered) {
+    RCR(_jbi_agg_ordered_run(ctx, jbl, step));
+    if (!*step) {
+      return 0;
+    }
+  }
+  RCR(_jbi_agg_group_get(ctx, &g));
+  ++g->cnt;
+  int i = 0;
+  for (struct jqp_aggregate *agg = aux->aggregates; agg; agg = agg->next, ++i) {
+    if (_jbl_at(jbl, agg->ptr, &v)) {
+      RCR(_jbi_agg_state_add(agc, agg, &g->states[i], &v));
+    }
+  }
+  return 0;
+}
+
+static iwrc _jbi_agg_finish(struct jbexec *ctx) {
+  struct jbagc *agc = &ctx->agc;
+  struct jqp_aux *aux = ctx->ux->q->aux;
+  if (agc->sof_active) {
+    return _jbi_agg_emit_spilled(ctx);
+  }
+  if (!aux->groupby && !iwhmap_count(agc->groups)) {
+    // Aggregate functions without group by produce a document even if nothing matched
+    struct _jbi_agg_group *g;
+    iwxstr_clear(agc->kbuf);
+    RCR(_jbi_agg_group_get(ctx, &g));
+  }
+  return _jbi_agg_emit_groups(ctx);
+}
+
+iwrc jbi_aggregate_consumer(
+  struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id,
+  int64_t *step, bool *matched, iwrc err) {
+  iwrc rc = 0;
+  size_t vsz = 0;
+  struct jbl jbl;
+  struct jbagc *agc = &ctx->agc;
+
+  if (!agc->groups && !err) {
+    RCC(rc, finish, _jbi_agg_init(ctx));
+  }
+  if (!id) {
+    // End of scan
+    if (err) {
+      _jbi_agg_release(ctx);
+      return err;
+    }
+    rc = _jbi_agg_finish(ctx);
+    _jbi_agg_release(ctx);
+    return rc;
+  }
+
+  ++ctx->stats.scanned;
+  if (ctx->guarded) {
+    RCC(rc, finish, jb_exec_guard(ctx, ctx->stats.scanned));
+  }
+  if (ctx->prefilter_num && !jbi_prefilter_matched(ctx, id, &rc)) {
+    *matched = false;
+    goto finish;
+  }
+
+  rc = jbi_scan_doc_fetch(ctx, cur, id, &jbl, &vsz, matched);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    return 0;
+  }
+  RCGO(rc, finish);
+  ++ctx->stats.fetched;
+  ctx->stats.bytes += vsz;
+  if (*matched) {
+    ++ctx->stats.matched;
+    rc = _jbi_agg_document(ctx, &jbl, step);
+  }
+
+finish:
+  return rc;
+}
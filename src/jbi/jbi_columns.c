@@ -0,0 +1,745 @@
+#include "ejdb2_internal.h"
+
+// Columnar store of collection fields.
+//
+// Values of top level fields registered by `ejdb_ensure_column()` are kept in `jbcoll.coldb`
+// by segments of JB_COL_SEGMENT_SLOTS documents, segment key is `id >> JB_COL_SEGMENT_BITS`.
+// Segment: [number of columns:4][reserved:4][column 0]..[column N][strings of column 0]..[strings of column N]
+// Column:  [min:8][max:8][nnum:4][nother:4][strings offset:4][strings size:4][values:8 * SLOTS][tags:SLOTS]
+// Column `min`/`max` is a zone map of numeric values of segment, so segments which cannot match
+// query expressions are skipped as a whole. Other segments are filtered by tight loops over column values
+// and only remaining documents are assembled from columns and matched by query.
+
+#define JB_COL_NONE    0x00U  /**< No document in slot */
+#define JB_COL_MISSING 0x01U  /**< Document has no field */
+#define JB_COL_I64     0x02U
+#define JB_COL_F64     0x03U
+#define JB_COL_STR     0x04U
+#define JB_COL_TRUE    0x05U
+#define JB_COL_FALSE   0x06U
+#define JB_COL_NULL    0x07U
+#define JB_COL_OTHER   0x08U  /**< Object or array value which is not kept in column */
+
+#define JB_COL_SEG_HDR_SIZE 8
+
+struct _jbi_col_hdr {
+  double   min;     /**< Min numeric value of segment */
+  double   max;     /**< Max numeric value of segment */
+  uint32_t nnum;    /**< Number of numeric values */
+  uint32_t nother;  /**< Number of non numeric values, missing fields are not counted */
+  uint32_t stroff;  /**< Offset of column strings in segment */
+  uint32_t strsz;   /**< Size of column strings */
+};
+
+union _jbi_col_val {
+  int64_t i;
+  double  f;
+  struct {
+    uint32_t off;   /**< Offset of zero terminated string in column strings */
+    uint32_t len;   /**< String length */
+  } s;
+};
+
+#define JB_COL_SIZE \
+        (sizeof(struct _jbi_col_hdr) + JB_COL_SEGMENT_SLOTS * (sizeof(union _jbi_col_val) + 1))
+
+/** Query expression evaluated over column segments */
+struct _jbi_col_pred {
+  int col;
+  jqp_op_t op;
+  JQVAL   *val;
+};
+
+IW_INLINE struct _jbi_col_hdr* _jbi_col_hdr(const uint8_t *seg, int col) {
+  return (void*) (seg + JB_COL_SEG_HDR_SIZE + col * JB_COL_SIZE);
+}
+
+IW_INLINE union _jbi_col_val* _jbi_col_vals(const uint8_t *seg, int col) {
+  return (void*) ((uint8_t*) _jbi_col_hdr(seg, col) + sizeof(struct _jbi_col_hdr));
+}
+
+IW_INLINE uint8_t* _jbi_col_tags(const uint8_t *seg, int col) {
+  return (uint8_t*) (_jbi_col_vals(seg, col) + JB_COL_SEGMENT_SLOTS);
+}
+
+IW_INLINE size_t _jbi_col_fixed_size(int ncols) {
+  return JB_COL_SEG_HDR_SIZE + ncols * JB_COL_SIZE;
+}
+
+static int _jbi_col_find(struct jbcoll *jbc, const char *field) {
+  for (int i = 0; i < jbc->colsnum; ++i) {
+    if (!strcmp(jbc->cols[i]->n[0], field)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static iwrc _jbi_col_segment_check(struct jbcoll *jbc, const uint8_t *seg, size_t segsz) {
+  uint32_t ncols;
+  size_t fsz = _jbi_col_fixed_size(jbc->colsnum);
+  if (segsz < fsz) {
+    return IWKV_ERROR_CORRUPTED;
+  }
+  memcpy(&ncols, seg, sizeof(ncols));
+  if (ncols != jbc->colsnum) {
+    return IWKV_ERROR_CORRUPTED;
+  }
+  for (int c = 0; c < jbc->colsnum; ++c) {
+    struct _jbi_col_hdr *h = _jbi_col_hdr(seg, c);
+    if ((h->stroff < fsz) || (h->stroff > segsz) || (h->strsz > segsz - h->stroff)) {
+      return IWKV_ERROR_CORRUPTED;
+    }
+    if (!h->strsz) {
+      continue;
+    }
+    const union _jbi_col_val *v = _jbi_col_vals(seg, c);
+    const uint8_t *tags = _jbi_col_tags(seg, c);
+    for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {
+      if ((tags[i] == JB_COL_STR) && ((uint64_t) v[i].s.off + v[i].s.len >= h->strsz)) {
+        return IWKV_ERROR_CORRUPTED;
+      }
+    }
+  }
+  return 0;
+}
+
+static void _jbi_col_value(struct jbl *jbl, struct jbl_ptr *ptr, uint8_t *tag, union _jbi_col_val *v, const char **str) {
+  struct jbl jv;
+  *str = 0;
+  v->i = 0;
+  if (!_jbl_at(jbl, ptr, &jv)) {
+    *tag = JB_COL_MISSING;
+    return;
+  }
+  switch (jbl_type(&jv)) {
+    case JBV_I64:
+      *tag = JB_COL_I64;
+      v->i = jbl_get_i64(&jv);
+      break;
+    case JBV_F64:
+      *tag = JB_COL_F64;
+      v->f = jbl_get_f64(&jv);
+      break;
+    case JBV_STR:
+      *tag = JB_COL_STR;
+      *str = jbl_get_str(&jv);
+      v->s.len = (uint32_t) jbl_size(&jv);
+      break;
+    case JBV_BOOL:
+      *tag = jbl_get_i32(&jv) ? JB_COL_TRUE : JB_COL_FALSE;
+      break;
+    case JBV_NULL:
+      *tag = JB_COL_NULL;
+      break;
+    default:
+      *tag = JB_COL_OTHER;
+      break;
+  }
+}
+
+/**
+ * Builds new segment from segment `oseg` (optional) where `slot` is set to values of document `jbl`
+ * or cleared if `jbl` is zero. New segment allocated by `malloc()` is returned in `nsegp`,
+ * `emptyp` is set if new segment has no documents.
+ */
+static iwrc _jbi_col_segment_update(
+  struct jbcoll *jbc, const uint8_t *oseg, uint32_t slot, struct jbl *jbl,
+  uint8_t **nsegp, size_t *nsegszp, bool *emptyp) {
+  int ncols = jbc->colsnum;
+  uint8_t tags[JB_COL_MAX];
+  union _jbi_col_val vals[JB_COL_MAX];
+  const char *strs[JB_COL_MAX];
+  size_t fsz = _jbi_col_fixed_size(ncols);
+  size_t nsz = fsz;
+
+  *nsegp = 0;
+  *emptyp = true;
+  for (int c = 0; c < ncols; ++c) {
+    if (jbl) {
+      _jbi_col_value(jbl, jbc->cols[c], &tags[c], &vals[c], &strs[c]);
+    } else {
+      tags[c] = JB_COL_NONE;
+      vals[c].i = 0;
+      strs[c] = 0;
+    }
+    if (oseg) {
+      nsz += _jbi_col_hdr(oseg, c)->strsz;
+    }
+    if (tags[c] == JB_COL_STR) {
+      nsz += vals[c].s.len + 1;
+    }
+  }
+  if (nsz > UINT32_MAX) {
+    return IW_ERROR_OVERFLOW;
+  }
+  uint8_t *nseg = calloc(1, nsz);
+  if (!nseg) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  uint32_t lv = ncols;
+  memcpy(nseg, &lv, sizeof(lv));
+
+  uint32_t spos = (uint32_t) fsz;
+  for (int c = 0; c < ncols; ++c) {
+    struct _jbi_col_hdr *h = _jbi_col_hdr(nseg, c);
+    union _jbi_col_val *v = _jbi_col_vals(nseg, c);
+    uint8_t *t = _jbi_col_tags(nseg, c);
+    const uint8_t *ostrs = 0;
+    if (oseg) {
+      memcpy(v, _jbi_col_vals(oseg, c), JB_COL_SEGMENT_SLOTS * sizeof(*v));
+      memcpy(t, _jbi_col_tags(oseg, c), JB_COL_SEGMENT_SLOTS);
+      ostrs = oseg + _jbi_col_hdr(oseg, c)->stroff;
+    }
+    t[slot] = tags[c];
+    v[slot] = vals[c];
+    h->stroff = spos;
+    h->min = 0;
+    h->max = 0;
+    for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {
+      double dv;
+      switch (t[i]) {
+        case JB_COL_NONE:
+          continue;
+        case JB_COL_MISSING:
+          break;
+        case JB_COL_I64:
+        case JB_COL_F64:
+          dv = (t[i] == JB_COL_I64) ? (double) v[i].i : v[i].f;
+          if (!h->nnum || (dv < h->min)) {
+            h->min = dv;
+          }
+          if (!h->nnum || (dv > h->max)) {
+            h->max = dv;
+          }
+          ++h->nnum;
+          break;
+        case JB_COL_STR: {
+          const char *str = ((uint32_t) i == slot) ? strs[c] : (const char*) ostrs + v[i].s.off;
+          memcpy(nseg + spos, str, v[i].s.len);
+          nseg[spos + v[i].s.len] = '\0';
+          v[i].s.off = spos - h->stroff;
+          spos += v[i].s.len + 1;
+          ++h->nother;
+          break;
+        }
+        default:
+          ++h->nother;
+          break;
+      }
+      if (!c) {
+        *emptyp = false;
+      }
+    }
+    h->strsz = spos - h->stroff;
+  }
+  *nsegp = nseg;
+  *nsegszp = spos;
+  return 0;
+}
+
+static iwrc _jbi_col_segment_store(struct jbcoll *jbc, int64_t segno, uint8_t *seg, size_t segsz, bool empty) {
+  struct iwkv_val key = {
+    .data = &segno,
+    .size = sizeof(segno)
+  };
+  if (empty) {
+    iwrc rc = iwkv_del(jbc->coldb, &key, 0);
+    return rc == IWKV_ERROR_NOTFOUND ? 0 : rc;
+  }
+  struct iwkv_val val = {
+    .data = seg,
+    .size = segsz
+  };
+  return iwkv_put(jbc->coldb, &key, &val, 0);
+}
+
+/**
+ * Updates columns of document `id` of collection `jbc` by values of stored document `jbl`.
+ * Document is removed from columnar store if `jbl` is zero.
+ */
+iwrc jbi_columns_put(struct jbcoll *jbc, int64_t id, struct jbl *jbl) {
+  iwrc rc;
+  bool empty;
+  size_t nsegsz;
+  uint8_t *nseg = 0;
+  struct iwkv_val val = { 0 };
+  int64_t segno = id >> JB_COL_SEGMENT_BITS;
+  struct iwkv_val key = {
+    .data = &segno,
+    .size = sizeof(segno)
+  };
+  if (!jbc->coldb) {
+    return 0;
+  }
+  // Segment is shared by documents which writers run in parallel
+  pthread_mutex_lock(&jbc->colmtx);
+  rc = iwkv_get(jbc->coldb, &key, &val);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+    if (!jbl) {
+      goto finish;
+    }
+  }
+  RCGO(rc, finish);
+  if (val.size) {
+    RCC(rc, finish, _jbi_col_segment_check(jbc, val.data, val.size));
+  }
+  RCC(rc, finish, _jbi_col_segment_update(jbc, val.size ? val.data : 0, id & (JB_COL_SEGMENT_SLOTS - 1),
+                                          jbl, &nseg, &nsegsz, &empty));
+  rc = _jbi_col_segment_store(jbc, segno, nseg, nsegsz, empty);
+
+finish:
+  pthread_mutex_unlock(&jbc->colmtx);
+  if (val.data) {
+    iwkv_val_dispose(&val);
+  }
+  free(nseg);
+  return rc;
+}
+
+iwrc jbi_columns_del(struct jbcoll *jbc, int64_t id) {
+  return jbi_columns_put(jbc, id, 0);
+}
+
+/**
+ * Fills empty columnar store of collection from stored documents.
+ * Called under collection write lock.
+ */
+iwrc jbi_columns_fill(struct jbcoll *jbc) {
+  iwrc rc;
+  bool empty = true;
+  int64_t id, segno = -1;
+  size_t sz, segsz = 0;
+  uint8_t *seg = 0;
+  struct iwkv_cursor *cur;
+  struct iwkv_val val;
+  struct jbl jbl;
+
+  RCR(iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0));
+  while (!(rc = iwkv_cursor_to(cur, IWKV_CURSOR_NEXT))) {
+    uint8_t *nseg;
+    RCC(rc, finish, iwkv_cursor_copy_key(cur, &id, sizeof(id), &sz, 0));
+    if ((id >> JB_COL_SEGMENT_BITS) != segno) {
+      // Documents are visited in ids order so segment is complete
+      if (seg) {
+        RCC(rc, finish, _jbi_col_segment_store(jbc, segno, seg, segsz, empty));
+        free(seg);
+        seg = 0;
+      }
+      segno = id >> JB_COL_SEGMENT_BITS;
+    }
+    RCC(rc, finish, iwkv_cursor_val(cur, &val));
+    rc = jbi_doc_unpack(jbc, &val);
+    if (!rc) {
+      rc = jbl_from_buf_keep_onstack(&jbl, val.data, val.size);
+    }
+    if (!rc) {
+      rc = _jbi_col_segment_update(jbc, seg, id & (JB_COL_SEGMENT_SLOTS - 1), &jbl, &nseg, &segsz, &empty);
+    }
+    iwkv_val_dispose(&val);
+    RCGO(rc, finish);
+    free(seg);
+    seg = nseg;
+  }
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+  if (!rc && seg) {
+    rc = _jbi_col_segment_store(jbc, segno, seg, segsz, empty);
+  }
+
+finish:
+  free(seg);
+  IWRC(iwkv_cursor_close(&cur), rc);
+  return rc;
+}
+
+static bool _jbi_col_field_covered(struct jbcoll *jbc, const char *field, jqp_string_flavours_t flavour) {
+  if (flavour & (JQP_STR_PLACEHOLDER | JQP_STR_STAR | JQP_STR_DBL_STAR)) {
+    return false;
+  }
+  return _jbi_col_find(jbc, field) > -1;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+static bool _jbi_col_expr_covered(struct jbcoll *jbc, const struct jqp_expr_node *en) {
+  if (en->type == JQP_EXPR_NODE_TYPE) {
+    for (const struct jqp_expr_node *cn = en->chain; cn; cn = cn->next) {
+      if (!_jbi_col_expr_covered(jbc, cn)) {
+        return false;
+      }
+    }
+    return true;
+  } else if (en->type == JQP_FILTER_TYPE) {
+    const JQP_NODE *n = ((const JQP_FILTER*) en)->node;
+    if (!n) {
+      return false;
+    }
+    if (n->ntype == JQP_NODE_FIELD) {
+      return _jbi_col_field_covered(jbc, n->value->string.value, n->value->string.flavour);
+    } else if (n->ntype == JQP_NODE_EXPR) {
+      for (const JQP_EXPR *expr = &n->value->expr; expr; expr = expr->next) {
+        const JQPUNIT *left = expr->left;
+        if (  (left->type != JQP_STRING_TYPE)
+           || !_jbi_col_field_covered(jbc, left->string.value, left->string.flavour)) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns true if query of `ctx` reads only collection columns
+ * and doesn't emit stored documents, so it may be executed by `jbi_columns_scanner()`.
+ */
+bool jbi_columns_covered(struct jbexec *ctx) {
+  struct jbcoll *jbc = ctx->jbc;
+  struct jql *q = ctx->ux->q;
+  struct jqp_aux *aux = q->aux;
+  if (!jbc->coldb || ctx->page.enabled || jql_has_apply(q) || (aux->qmode & JQP_QRY_NOIDX)) {
+    return false;
+  }
+  if (jql_has_aggregates(q)) {
+    for (struct jqp_aggregate *agg = aux->groupby; agg; agg = agg->next) {
+      if ((agg->ptr->cnt < 1) || (_jbi_col_find(jbc, agg->ptr->n[0]) < 0)) {
+        return false;
+      }
+    }
+    for (struct jqp_aggregate *agg = aux->aggregates; agg; agg = agg->next) {
+      if ((agg->ptr->cnt < 1) || (_jbi_col_find(jbc, agg->ptr->n[0]) < 0)) {
+        return false;
+      }
+    }
+  } else if (!jql_has_aggregate_count(q) || ctx->sorting) {
+    return false;
+  }
+  struct jqp_expr_node *en = aux->expr;
+  if (en->chain && !en->chain->next && !en->next && (en->chain->type == JQP_FILTER_TYPE)) {
+    JQP_NODE *n = ((JQP_FILTER*) en->chain)->node;
+    if (n && ((n->ntype == JQP_NODE_ANYS) || (n->ntype == JQP_NODE_ANY)) && !n->next) {
+      return true; // Single /* | /** matches anything
+    }
+  }
+  for ( ; en; en = en->next) {
+    if (!_jbi_col_expr_covered(jbc, en)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Collects simple `/[field op value]` expressions required by query
+ * which can be evaluated over column values.
+ */
+// NOLINTNEXTLINE(misc-no-recursion)
+static void _jbi_col_predicates(
+  struct jbexec *ctx, const struct jqp_expr_node *en,
+  struct _jbi_col_pred preds[static JB_COL_PREDICATES_MAX], int *np) {
+  if (en->type == JQP_EXPR_NODE_TYPE) {
+    const struct jqp_expr_node *cn = en->chain;
+    for ( ; cn; cn = cn->next) {
+      if (cn->join && (cn->join->value == JQP_JOIN_OR)) {
+        return;
+      }
+    }
+    for (cn = en->chain; cn; cn = cn->next) {
+      if (!cn->join || !cn->join->negate) {
+        _jbi_col_predicates(ctx, cn, preds, np);
+      }
+    }
+    return;
+  } else if (en->type != JQP_FILTER_TYPE) {
+    return;
+  }
+  const JQP_NODE *n = ((const JQP_FILTER*) en)->node;
+  if (!n || n->next || (n->ntype != JQP_NODE_EXPR)) {
+    return;
+  }
+  for (JQP_EXPR *expr = &n->value->expr; expr; expr = expr->next) {
+    if (expr->join && (expr->join->value == JQP_JOIN_OR)) {
+      return;
+    }
+  }
+  for (JQP_EXPR *expr = &n->value->expr; expr && *np < JB_COL_PREDICATES_MAX; expr = expr->next) {
+    iwrc rc = 0;
+    JQPUNIT *left = expr->left;
+    if (  (expr->join && expr->join->negate)
+       || expr->op->negate
+       || (left->type != JQP_STRING_TYPE)
+       || (left->string.flavour & (JQP_STR_PLACEHOLDER | JQP_STR_STAR | JQP_STR_DBL_STAR))) {
+      continue;
+    }
+    int col = _jbi_col_find(ctx->jbc, left->string.value);
+    if (col < 0) {
+      continue;
+    }
+    JQVAL *rv = jql_unit_to_jqval(ctx->ux->q, expr->right, &rc);
+    if (rc) {
+      continue;
+    }
+    switch (expr->op->value) {
+      case JQP_OP_GT:
+      case JQP_OP_GTE:
+      case JQP_OP_LT:
+      case JQP_OP_LTE:
+        if ((rv->type != JQVAL_I64) && (rv->type != JQVAL_F64)) {
+          continue;
+        }
+        break;
+      case JQP_OP_EQ:
+        if ((rv->type != JQVAL_I64) && (rv->type != JQVAL_F64) && (rv->type != JQVAL_STR)) {
+          continue;
+        }
+        break;
+      default:
+        continue;
+    }
+    preds[(*np)++] = (struct _jbi_col_pred) {
+      .col = col,
+      .op = expr->op->value,
+      .val = rv
+    };
+  }
+}
+
+/**
+ * Returns false if zone map of segment column proves no document of segment matches `p`.
+ */
+static bool _jbi_col_zone_matched(const uint8_t *seg, const struct _jbi_col_pred *p) {
+  const struct _jbi_col_hdr *h = _jbi_col_hdr(seg, p->col);
+  if (!h->nnum && !h->nother) {
+    return false; // Field is missing in all documents
+  }
+  if ((p->val->type == JQVAL_STR) || h->nother || !h->nnum) {
+    return true;
+  }
+  // Rounding to double is monotonic so integer bounds are compared conservatively
+  double cv = (p->val->type == JQVAL_I64) ? (double) p->val->vi64 : p->val->vf64;
+  switch (p->op) {
+    case JQP_OP_EQ:
+      return cv >= h->min && cv <= h->max;
+    case JQP_OP_GT:
+    case JQP_OP_GTE:
+      return h->max >= cv;
+    case JQP_OP_LT:
+    case JQP_OP_LTE:
+      return h->min <= cv;
+    default:
+      return true;
+  }
+}
+
+// Numeric comparison of all column slots written to be vectorized by compiler.
+// Slots without field are rejected, values of other types are left to query matching.
+#define JB_COL_FILTER_NUM(op_, ilhs_, irhs_)                                \
+        for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {                    \
+          uint8_t t = tags[i];                                              \
+          sel[i] &= (t != JB_COL_MISSING)                                   \
+                    & ((t != JB_COL_I64) | ((ilhs_) op_ (irhs_)))           \
+                    & ((t != JB_COL_F64) | (v[i].f op_ cf));                \
+        }
+
+#define JB_COL_FILTER_OPS(ilhs_, irhs_)                                     \
+        switch (p->op) {                                                    \
+          case JQP_OP_EQ:                                                   \
+            JB_COL_FILTER_NUM(==, ilhs_, irhs_);                            \
+            break;                                                          \
+          case JQP_OP_GT:                                                   \
+            JB_COL_FILTER_NUM(>, ilhs_, irhs_);                             \
+            break;                                                          \
+          case JQP_OP_GTE:                                                  \
+            JB_COL_FILTER_NUM(>=, ilhs_, irhs_);                            \
+            break;                                                          \
+          case JQP_OP_LT:                                                   \
+            JB_COL_FILTER_NUM(<, ilhs_, irhs_);                             \
+            break;                                                          \
+          case JQP_OP_LTE:                                                  \
+            JB_COL_FILTER_NUM(<=, ilhs_, irhs_);                            \
+            break;                                                          \
+          default:                                                          \
+            break;                                                          \
+        }
+
+/**
+ * Clears `sel` flags of segment documents not matching `p`.
+ * Numbers are compared the same way as query matching does:
+ * integers are compared exactly, other numbers are compared as doubles.
+ */
+static void _jbi_col_filter(const uint8_t *seg, const struct _jbi_col_pred *p, uint8_t sel[static JB_COL_SEGMENT_SLOTS]) {
+  const uint8_t *tags = _jbi_col_tags(seg, p->col);
+  const union _jbi_col_val *v = _jbi_col_vals(seg, p->col);
+  switch (p->val->type) {
+    case JQVAL_I64: {
+      int64_t ci = p->val->vi64;
+      double cf = (double) ci;
+      JB_COL_FILTER_OPS(v[i].i, ci);
+      break;
+    }
+    case JQVAL_F64: {
+      double cf = p->val->vf64;
+      JB_COL_FILTER_OPS((double) v[i].i, cf);
+      break;
+    }
+    case JQVAL_STR: {
+      const char *cs = p->val->vstr;
+      const uint8_t *strs = seg + _jbi_col_hdr(seg, p->col)->stroff;
+      size_t clen = strlen(cs);
+      for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {
+        if (!sel[i]) {
+          continue;
+        }
+        if (tags[i] == JB_COL_MISSING) {
+          sel[i] = 0;
+        } else if (tags[i] == JB_COL_STR) {
+          sel[i] = (v[i].s.len == clen) && !memcmp(strs + v[i].s.off, cs, clen);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * Selects segment documents which may match query expressions `preds`.
+ * Returns number of documents rejected.
+ */
+static uint32_t _jbi_col_select(
+  const uint8_t *seg, const struct _jbi_col_pred *preds, int npreds,
+  uint8_t sel[static JB_COL_SEGMENT_SLOTS]) {
+  uint32_t num = 0, rnum = 0;
+  const uint8_t *tags = _jbi_col_tags(seg, 0);
+  for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {
+    sel[i] = tags[i] != JB_COL_NONE;
+    num += sel[i];
+  }
+  for (int p = 0; p < npreds; ++p) {
+    if (!_jbi_col_zone_matched(seg, &preds[p])) {
+      memset(sel, 0, JB_COL_SEGMENT_SLOTS);
+      return num;
+    }
+    _jbi_col_filter(seg, &preds[p], sel);
+  }
+  for (int i = 0; i < JB_COL_SEGMENT_SLOTS; ++i) {
+    rnum += sel[i];
+  }
+  return num - rnum;
+}
+
+/**
+ * Assembles document object of columns values kept in `slot` of segment.
+ * `*bnp` is set to zero if document has column value not kept in columnar store.
+ */
+static iwrc _jbi_col_doc(struct jbcoll *jbc, const uint8_t *seg, int slot, binn **bnp) {
+  binn *bn = binn_object();
+  *bnp = 0;
+  if (!bn) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  for (int c = 0; c < jbc->colsnum; ++c) {
+    bool ok = true;
+    char *field = jbc->cols[c]->n[0];
+    const union _jbi_col_val *v = &_jbi_col_vals(seg, c)[slot];
+    switch (_jbi_col_tags(seg, c)[slot]) {
+      case JB_COL_I64:
+        ok = binn_object_set_int64(bn, field, v->i);
+        break;
+      case JB_COL_F64:
+        ok = binn_object_set_double(bn, field, v->f);
+        break;
+      case JB_COL_STR:
+        ok = binn_object_set_str(bn, field, (char*) seg + _jbi_col_hdr(seg, c)->stroff + v->s.off);
+        break;
+      case JB_COL_TRUE:
+      case JB_COL_FALSE:
+        ok = binn_object_set_bool(bn, field, _jbi_col_tags(seg, c)[slot] == JB_COL_TRUE);
+        break;
+      case JB_COL_NULL:
+        ok = binn_object_set_null(bn, field);
+        break;
+      case JB_COL_OTHER:
+        binn_free(bn);
+        return 0;
+      default:
+        break;
+    }
+    if (!ok) {
+      binn_free(bn);
+      return JBL_ERROR_CREATION;
+    }
+  }
+  *bnp = bn;
+  return 0;
+}
+
+iwrc jbi_columns_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
+  iwrc rc;
+  int64_t segno, step = 1;
+  size_t sz, segsz = 0, bufsz = _jbi_col_fixed_size(ctx->jbc->colsnum);
+  uint8_t *buf = malloc(bufsz);
+  int npreds = 0;
+  struct jbl jbl;
+  struct iwkv_cursor *cur = 0;
+  struct jbcoll *jbc = ctx->jbc;
+  struct _jbi_col_pred preds[JB_COL_PREDICATES_MAX];
+  uint8_t sel[JB_COL_SEGMENT_SLOTS];
+
+  RCA(buf, finish);
+  _jbi_col_predicates(ctx, ctx->ux->q->aux->expr, preds, &npreds);
+  RCC(rc, finish, iwkv_cursor_open(jbc->coldb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0));
+  while (step && !(rc = iwkv_cursor_to(cur, IWKV_CURSOR_NEXT))) {
+    RCC(rc, finish, iwkv_cursor_copy_key(cur, &segno, sizeof(segno), &sz, 0));
+    while (1) {
+      RCC(rc, finish, iwkv_cursor_copy_val(cur, buf, bufsz, &segsz));
+      if (segsz <= bufsz) {
+        break;
+      }
+      uint8_t *nbuf = realloc(buf, segsz);
+      RCA(nbuf, finish);
+      buf = nbuf;
+      bufsz = segsz;
+    }
+    RCC(rc, finish, _jbi_col_segment_check(jbc, buf, segsz));
+    ctx->stats.prefiltered += _jbi_col_select(buf, preds, npreds, sel);
+
+    for (int i = JB_COL_SEGMENT_SLOTS - 1; step && i >= 0; --i) {
+      binn *bn;
+      bool matched = false;
+      if (!sel[i]) {
+        continue;
+      }
+      RCC(rc, finish, _jbi_col_doc(jbc, buf, i, &bn));
+      if (bn) {
+        rc = jbl_from_buf_keep_onstack(&jbl, binn_ptr(bn), binn_size(bn));
+        if (rc) {
+          binn_free(bn);
+          goto finish;
+        }
+        ctx->coldoc = &jbl;
+      }
+      step = 1;
+      rc = consumer(ctx, 0, (segno << JB_COL_SEGMENT_BITS) | i, &step, &matched, 0);
+      ctx->coldoc = 0;
+      if (bn) {
+        binn_free(bn);
+      }
+      RCGO(rc, finish);
+    }
+  }
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+
+finish:
+  if (cur) {
+    iwkv_cursor_close(&cur);
+  }
+  free(buf);
+  return consumer(ctx, 0, 0, 0, 0, rc);
+}
@@ -0,0 +1,632 @@
+#include "ejdb2_internal.h"
+
+// Built-in LZ77 codec of stored documents.
+//
+// Packed value layout: [marker:1][unpacked size:4 LE][sequences...]
+// Sequence: [token:1][literals length ext...][literals][match offset:2 LE][match length ext...]
+// Token high 4 bits is a literals length, low 4 bits is a match length minus JB_ZDOC_MIN_MATCH,
+// value 15 is followed by extension bytes added to the length until byte less than 255.
+// The last sequence has literals only. Match offset may reach into collection dictionary
+// which is logically placed right before the unpacked document.
+
+#define JB_ZDOC_MIN_MATCH  4
+#define JB_ZDOC_MAX_OFFSET 65535
+
+IW_INLINE uint32_t _jbi_lz_read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+IW_INLINE uint32_t _jbi_lz_hash(uint32_t seq, int hlog) {
+  return (seq * 2654435761U) >> (32 - hlog);
+}
+
+static uint8_t* _jbi_lz_put_len(uint8_t *op, const uint8_t *oend, size_t len) {
+  for (len -= 15; len >= 255; len -= 255) {
+    if (op >= oend) {
+      return 0;
+    }
+    *op++ = 255;
+  }
+  if (op >= oend) {
+    return 0;
+  }
+  *op++ = (uint8_t) len;
+  return op;
+}
+
+static uint8_t* _jbi_lz_put_seq(
+  uint8_t *op, const uint8_t *oend, const uint8_t *lit, size_t llen,
+  size_t off, size_t mlen) {
+  if (op >= oend) {
+    return 0;
+  }
+  uint8_t *token = op++;
+  *token = (uint8_t) (MIN(llen, 15) << 4);
+  if (llen >= 15 && !(op = _jbi_lz_put_len(op, oend, llen))) {
+    return 0;
+  }
+  if (op + llen > oend) {
+    return 0;
+  }
+  memcpy(op, lit, llen);
+  op += llen;
+  if (!mlen) {
+    return op;
+  }
+  if (op + 2 > oend) {
+    return 0;
+  }
+  *op++ = (uint8_t) off;
+  *op++ = (uint8_t) (off >> 8);
+  mlen -= JB_ZDOC_MIN_MATCH;
+  *token |= (uint8_t) MIN(mlen, 15);
+  if (mlen >= 15) {
+    op = _jbi_lz_put_len(op, oend, mlen);
+  }
+  return op;
+}
+
+/**
+ * Compresses `in[beg, len)` data, preceding `in[0, beg)` data is used as dictionary.
+ * Hash table `ht` of `1 << hlog` entries keeps positions of dictionary sequences plus one.
+ * Returns size of compressed data or zero if it doesn't fit into `outsz`.
+ */
+static size_t _jbi_lz_compress(
+  const uint8_t *in, size_t beg, size_t len, uint8_t *out, size_t outsz,
+  uint32_t *ht, int hlog) {
+  uint8_t *op = out;
+  const uint8_t *oend = out + outsz;
+  size_t ip = beg, anchor = beg;
+
+  while (ip + JB_ZDOC_MIN_MATCH <= len) {
+    uint32_t seq = _jbi_lz_read32(in + ip);
+    uint32_t h = _jbi_lz_hash(seq, hlog);
+    size_t ref = ht[h];
+    ht[h] = (uint32_t) ip + 1;
+    if (!ref || ip - (ref - 1) > JB_ZDOC_MAX_OFFSET || _jbi_lz_read32(in + ref - 1) != seq) {
+      ++ip;
+      continue;
+    }
+    --ref;
+    size_t mlen = JB_ZDOC_MIN_MATCH;
+    while (ip + mlen < len && in[ref + mlen] == in[ip + mlen]) {
+      ++mlen;
+    }
+    op = _jbi_lz_put_seq(op, oend, in + anchor, ip - anchor, ip - ref, mlen);
+    if (!op) {
+      return 0;
+    }
+    ip += mlen;
+    anchor = ip;
+  }
+  op = _jbi_lz_put_seq(op, oend, in + anchor, len - anchor, 0, 0);
+  return op ? (size_t) (op - out) : 0;
+}
+
+static iwrc _jbi_lz_decompress(
+  const uint8_t *in, size_t inlen, uint8_t *out, size_t outlen,
+  const uint8_t *dict, size_t dictsz) {
+  size_t ip = 0, op = 0;
+  while (ip < inlen) {
+    uint8_t b, token = in[ip++];
+    size_t llen = token >> 4, mlen = token & 15, off;
+    if (llen == 15) {
+      do {
+        if (ip >= inlen) {
+          goto corrupted;
+        }
+        b = in[ip++];
+        llen += b;
+      } while (b == 255);
+    }
+    if (ip + llen > inlen || op + llen > outlen) {
+      goto corrupted;
+    }
+    memcpy(out + op, in + ip, llen);
+    ip += llen;
+    op += llen;
+    if (ip == inlen) {
+      break;
+    }
+    if (ip + 2 > inlen) {
+      goto corrupted;
+    }
+    off = in[ip] | (in[ip + 1] << 8);
+    ip += 2;
+    if (mlen == 15) {
+      do {
+        if (ip >= inlen) {
+          goto corrupted;
+        }
+        b = in[ip++];
+        mlen += b;
+      } while (b == 255);
+    }
+    mlen += JB_ZDOC_MIN_MATCH;
+    if (!off || off > op + dictsz || op + mlen > outlen) {
+      goto corrupted;
+    }
+    if (off <= op && off >= mlen) {
+      memcpy(out + op, out + op - off, mlen);
+      op += mlen;
+    } else {
+      for (size_t i = 0; i < mlen; ++i, ++op) {
+        out[op] = off <= op ? out[op - off] : dict[dictsz + op - off];
+      }
+    }
+  }
+  if (op == outlen) {
+    return 0;
+  }
+
+corrupted:
+  iwlog_ecode_error3(IWKV_ERROR_CORRUPTED);
+  return IWKV_ERROR_CORRUPTED;
+}
+
+void jbi_zdict_hash(const uint8_t *dict, uint32_t dictsz, uint32_t *ht) {
+  memset(ht, 0, sizeof(ht[0]) * (1U << JB_ZDOC_HASH_LOG));
+  for (uint32_t i = 0; i + JB_ZDOC_MIN_MATCH <= dictsz; ++i) {
+    ht[_jbi_lz_hash(_jbi_lz_read32(dict + i), JB_ZDOC_HASH_LOG)] = i + 1;
+  }
+}
+
+/**
+ * Compresses `sz` bytes of `data` using optional dictionary.
+ * Returns packed value allocated in `*outp` or zero if data is not compressible.
+ */
+static iwrc _jbi_pack(
+  const uint8_t *data, size_t sz, const uint8_t *dict, uint32_t dictsz, const uint32_t *dictht,
+  uint8_t **outp, size_t *outszp) {
+  uint32_t ht[1U << JB_ZDOC_HASH_LOG];
+  const uint8_t *in = data;
+  uint8_t *buf = 0;
+  int hlog = JB_ZDOC_HASH_LOG;
+
+  *outp = 0;
+  *outszp = 0;
+  if (sz > UINT32_MAX) {
+    return 0;
+  }
+  if (dictsz) {
+    buf = malloc(dictsz + sz);
+    if (!buf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    memcpy(buf, dict, dictsz);
+    memcpy(buf + dictsz, data, sz);
+    memcpy(ht, dictht, sizeof(ht));
+    in = buf;
+  } else {
+    if (sz < 4096) { // Don't spend time on clearing large table for small documents
+      hlog = 10;
+    }
+    memset(ht, 0, sizeof(ht[0]) * (1U << hlog));
+  }
+  // Compressed data is stored only if it saves at least 1/8 of document size
+  size_t outsz = JB_ZDOC_HDR_SIZE + sz - sz / 8;
+  uint8_t *out = malloc(outsz);
+  if (!out) {
+    free(buf);
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  size_t len = _jbi_lz_compress(in, dictsz, dictsz + sz, out + JB_ZDOC_HDR_SIZE,
+                                outsz - JB_ZDOC_HDR_SIZE, ht, hlog);
+  free(buf);
+  if (!len) {
+    free(out);
+    return 0;
+  }
+  uint32_t lv = IW_HTOIL((uint32_t) sz);
+  out[0] = dictsz ? JB_ZDOC_LZ_DICT : JB_ZDOC_LZ;
+  memcpy(out + 1, &lv, sizeof(lv));
+  *outp = out;
+  *outszp = JB_ZDOC_HDR_SIZE + len;
+  return 0;
+}
+
+static iwrc _jbi_unpack(struct jbcoll *jbc, const uint8_t *src, size_t srcsz, uint8_t *out, size_t outsz) {
+  if (src[0] == JB_ZDOC_LZ_DICT) {
+    if (!jbc->zdict) {
+      iwlog_error("Collection %s has no dictionary to unpack document", jbc->name);
+      return IWKV_ERROR_CORRUPTED;
+    }
+    return _jbi_lz_decompress(src + JB_ZDOC_HDR_SIZE, srcsz - JB_ZDOC_HDR_SIZE, out, outsz,
+                              jbc->zdict, jbc->zdictsz);
+  }
+  return _jbi_lz_decompress(src + JB_ZDOC_HDR_SIZE, srcsz - JB_ZDOC_HDR_SIZE, out, outsz, 0, 0);
+}
+
+IW_INLINE size_t _jbi_unpacked_size(const uint8_t *src) {
+  uint32_t lv;
+  memcpy(&lv, src + 1, sizeof(lv));
+  return IW_ITOHL(lv);
+}
+
+/**
+ * Adds `key` into keys dictionary of collection and stores it in meta database.
+ * Called under keys dictionary write lock.
+ */
+static iwrc _jbi_key_add_lw(struct jbcoll *jbc, const char *key, uintptr_t *idp) {
+  iwrc rc = 0;
+  struct iwkv_val kval, val;
+  char keybuf[sizeof(KEY_PREFIX_KEYDICT) + 1 + 2UL * IWNUMBUF_SIZE]; // Full key format: k.<coldbid>.<keyid>
+  uint32_t id = jbc->keysnum + 1;
+
+  if (id > INT32_MAX) {
+    return IW_ERROR_OVERFLOW;
+  }
+  if (jbc->keysnum >= jbc->keysasz) {
+    uint32_t nasz = jbc->keysasz ? jbc->keysasz * 2 : 64;
+    char **nkeys = realloc(jbc->keys, nasz * sizeof(nkeys[0]));
+    if (!nkeys) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    jbc->keys = nkeys;
+    jbc->keysasz = nasz;
+  }
+  char *k = strdup(key);
+  if (!k) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  kval.data = keybuf;
+  kval.size = snprintf(keybuf, sizeof(keybuf), KEY_PREFIX_KEYDICT "%u" "." "%u", jbc->dbid, id);
+  val.data = k;
+  val.size = strlen(k);
+  RCC(rc, finish, iwkv_put(jbc->db->metadb, &kval, &val, 0));
+  RCC(rc, finish, iwhmap_put(jbc->kmap, k, (void*) (uintptr_t) id));
+  jbc->keys[id - 1] = k;
+  jbc->keysnum = id;
+  *idp = id;
+
+finish:
+  if (rc) {
+    free(k);
+  }
+  return rc;
+}
+
+static iwrc _jbi_key_id(struct jbcoll *jbc, const char *key, int klen, int *idp) {
+  iwrc rc = 0;
+  char nbuf[256], *kbuf = nbuf;
+  if (klen < 0) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  if (klen >= sizeof(nbuf)) {
+    kbuf = malloc(klen + 1);
+    if (!kbuf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+  }
+  memcpy(kbuf, key, klen);
+  kbuf[klen] = '\0';
+
+  pthread_rwlock_rdlock(&jbc->krwl);
+  uintptr_t id = (uintptr_t) iwhmap_get(jbc->kmap, kbuf);
+  pthread_rwlock_unlock(&jbc->krwl);
+  if (!id) {
+    pthread_rwlock_wrlock(&jbc->krwl);
+    id = (uintptr_t) iwhmap_get(jbc->kmap, kbuf);
+    if (!id) {
+      rc = _jbi_key_add_lw(jbc, kbuf, &id);
+    }
+    pthread_rwlock_unlock(&jbc->krwl);
+  }
+  if (kbuf != nbuf) {
+    free(kbuf);
+  }
+  *idp = (int) id;
+  return rc;
+}
+
+/**
+ * Copies binn container replacing object keys by ids of collection keys dictionary (`intern`)
+ * or replacing map ids by keys. Keys dictionary read lock is held by caller for keys restoring.
+ */
+static iwrc _jbi_keys_convert(struct jbcoll *jbc, void *ptr, int type, bool intern, binn **outp) {
+  iwrc rc = 0;
+  binn bv, *sub = 0, *out;
+  binn_iter iter;
+  char *key;
+  int klidx, id;
+
+  *outp = 0;
+  if (type == BINN_LIST) {
+    out = binn_list();
+  } else if (intern && type == BINN_OBJECT) {
+    out = binn_map();
+  } else if (!intern && type == BINN_MAP) {
+    out = binn_object();
+  } else {
+    return JBL_ERROR_INVALID;
+  }
+  if (!out) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  if (!binn_iter_init(&iter, ptr, type)) {
+    rc = JBL_ERROR_INVALID;
+    goto finish;
+  }
+  while (binn_read_next_pair2(type, &iter, &klidx, &key, &bv)) {
+    binn *v = &bv;
+    if (bv.type == BINN_OBJECT || bv.type == BINN_MAP || bv.type == BINN_LIST) {
+      RCC(rc, finish, _jbi_keys_convert(jbc, bv.ptr, bv.type, intern, &sub));
+      v = sub;
+    }
+    bool ok;
+    if (type == BINN_LIST) {
+      ok = binn_list_add_value(out, v);
+    } else if (intern) {
+      RCC(rc, finish, _jbi_key_id(jbc, key, klidx, &id));
+      ok = binn_map_set_value(out, id, v);
+    } else {
+      if (klidx < 1 || klidx > jbc->keysnum || !jbc->keys[klidx - 1]) {
+        rc = IWKV_ERROR_CORRUPTED;
+        iwlog_error("Unknown key id %d of collection %s", klidx, jbc->name);
+        goto finish;
+      }
+      ok = binn_object_set_value(out, jbc->keys[klidx - 1], v);
+    }
+    if (sub) {
+      binn_free(sub);
+      sub = 0;
+    }
+    if (!ok) {
+      rc = JBL_ERROR_CREATION;
+      goto finish;
+    }
+  }
+
+finish:
+  if (sub) {
+    binn_free(sub);
+  }
+  if (rc) {
+    binn_free(out);
+  } else {
+    *outp = out;
+  }
+  return rc;
+}
+
+/**
+ * Converts document with interned keys at `data` (starting with `JB_ZDOC_KEYS` marker) back to binn object.
+ */
+static iwrc _jbi_keys_restore(struct jbcoll *jbc, uint8_t *data, binn **outp) {
+  pthread_rwlock_rdlock(&jbc->krwl);
+  iwrc rc = _jbi_keys_convert(jbc, data + 1, BINN_MAP, false, outp);
+  pthread_rwlock_unlock(&jbc->krwl);
+  return rc;
+}
+
+/**
+ * Replaces `val` by the copy of `bn` allocated by `malloc()`.
+ * Copy is prefixed by `marker` byte if it is not zero.
+ */
+static iwrc _jbi_val_from_binn(binn *bn, uint8_t marker, struct iwkv_val *val) {
+  int sz = binn_size(bn);
+  int off = marker ? 1 : 0;
+  uint8_t *buf = malloc(sz + off);
+  if (!buf) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  if (marker) {
+    buf[0] = marker;
+  }
+  memcpy(buf + off, binn_ptr(bn), sz);
+  val->data = buf;
+  val->size = sz + off;
+  return 0;
+}
+
+static iwrc _jbi_doc_pack(
+  struct jbcoll *jbc, ejdb_compression_t mode, const uint8_t *dict, uint32_t dictsz,
+  const uint32_t *dictht, struct iwkv_val *val, void **zbufp) {
+  iwrc rc = 0;
+  uint8_t *out;
+  size_t outsz;
+  struct iwkv_val kval = { 0 };
+
+  *zbufp = 0;
+  if ((mode & EJDB_COMPRESSION_KEYS) && val->size && *(uint8_t*) val->data == BINN_OBJECT) {
+    binn *bn;
+    RCRET(_jbi_keys_convert(jbc, val->data, BINN_OBJECT, true, &bn));
+    rc = _jbi_val_from_binn(bn, JB_ZDOC_KEYS, &kval);
+    binn_free(bn);
+    RCRET(rc);
+    *val = kval;
+  }
+  if ((mode & EJDB_COMPRESSION_LZ) && val->size >= JB_ZDOC_MIN_SIZE) {
+    rc = _jbi_pack(val->data, val->size, dict, dictsz, dictht, &out, &outsz);
+    if (!rc && out) {
+      val->data = out;
+      val->size = outsz;
+      free(kval.data);
+      kval.data = 0;
+      *zbufp = out;
+    }
+  }
+  if (kval.data) {
+    if (rc) {
+      free(kval.data);
+    } else {
+      *zbufp = kval.data;
+    }
+  }
+  return rc;
+}
+
+iwrc jbi_doc_pack(struct jbcoll *jbc, struct iwkv_val *val, void **zbufp) {
+  return _jbi_doc_pack(jbc, jbc->zmode, jbc->zdict, jbc->zdictsz, jbc->zdict_ht, val, zbufp);
+}
+
+iwrc jbi_doc_unpack(struct jbcoll *jbc, struct iwkv_val *val) {
+  if (!jbi_doc_is_packed(val->data, val->size)) {
+    return 0;
+  }
+  iwrc rc = 0;
+  if (jbi_doc_is_large(val->data, val->size)) {
+    RCRET(jbi_xdoc_load(jbc, val));
+    if (!jbi_doc_is_packed(val->data, val->size)) {
+      return 0;
+    }
+  }
+  uint8_t *data = val->data;
+  if (data[0] != JB_ZDOC_KEYS) {
+    if (val->size <= JB_ZDOC_HDR_SIZE) {
+      return IWKV_ERROR_CORRUPTED;
+    }
+    size_t sz = _jbi_unpacked_size(val->data);
+    uint8_t *buf = malloc(sz);
+    if (!buf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    rc = _jbi_unpack(jbc, val->data, val->size, buf, sz);
+    if (rc) {
+      free(buf);
+      return rc;
+    }
+    free(val->data);
+    val->data = buf;
+    val->size = sz;
+  }
+  if (val->size && *(uint8_t*) val->data == JB_ZDOC_KEYS) {
+    binn *bn;
+    struct iwkv_val kval;
+    RCRET(_jbi_keys_restore(jbc, val->data, &bn));
+    rc = _jbi_val_from_binn(bn, 0, &kval);
+    binn_free(bn);
+    RCRET(rc);
+    free(val->data);
+    *val = kval;
+  }
+  return rc;
+}
+
+iwrc jbi_doc_unpack_buf(
+  struct jbcoll *jbc, uint8_t **bufp, size_t *bufszp, uint8_t **zbufp, size_t *zbufszp,
+  size_t off, size_t *vszp) {
+  if (!jbi_doc_is_packed(*bufp + off, *vszp)) {
+    return 0;
+  }
+  iwrc rc;
+  if (jbi_doc_is_large(*bufp + off, *vszp)) {
+    RCRET(jbi_xdoc_load_buf(jbc, bufp, bufszp, off, vszp));
+    if (!jbi_doc_is_packed(*bufp + off, *vszp)) {
+      return 0;
+    }
+  }
+  if ((*bufp)[off] != JB_ZDOC_KEYS) {
+    if (*vszp <= JB_ZDOC_HDR_SIZE) {
+      return IWKV_ERROR_CORRUPTED;
+    }
+    // Packed value is moved to `zbuf` by swapping buffers and it is unpacked right into `buf`
+    uint8_t *tbuf = *zbufp;
+    size_t tbufsz = *zbufszp;
+    *zbufp = *bufp;
+    *zbufszp = *bufszp;
+    *bufp = tbuf;
+    *bufszp = tbufsz;
+
+    const uint8_t *src = *zbufp + off;
+    size_t sz = _jbi_unpacked_size(src);
+    if (off + sz > *bufszp) {
+      size_t nsize = MAX(off + sz, *zbufszp);
+      void *nbuf = realloc(*bufp, nsize);
+      if (!nbuf) {
+        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      }
+      *bufp = nbuf;
+      *bufszp = nsize;
+    }
+    rc = _jbi_unpack(jbc, src, *vszp, *bufp + off, sz);
+    RCRET(rc);
+    *vszp = sz;
+  }
+  if (*vszp && (*bufp)[off] == JB_ZDOC_KEYS) {
+    binn *bn;
+    RCRET(_jbi_keys_restore(jbc, *bufp + off, &bn));
+    size_t sz = binn_size(bn);
+    if (off + sz > *bufszp) {
+      size_t nsize = MAX(off + sz, *bufszp * 2);
+      void *nbuf = realloc(*bufp, nsize);
+      if (!nbuf) {
+        binn_free(bn);
+        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      }
+      *bufp = nbuf;
+      *bufszp = nsize;
+    }
+    memcpy(*bufp + off, binn_ptr(bn), sz);
+    binn_free(bn);
+    *vszp = sz;
+  }
+  return 0;
+}
+
+iwrc jbi_zdict_train(
+  struct jbcoll *jbc, ejdb_compression_t mode, uint32_t sample, uint8_t **dictp,
+  uint32_t *dictszp) {
+  iwrc rc = 0;
+  struct iwkv_cursor *cur;
+  struct iwkv_val val;
+  uint32_t *ht = 0;
+  uint8_t *dict = 0, *out;
+  uint32_t dictsz = 0;
+  size_t outsz;
+  void *kbuf;
+
+  *dictp = 0;
+  *dictszp = 0;
+  RCA(dict = malloc(JB_ZDICT_MAX_SIZE), finish);
+  RCA(ht = malloc(sizeof(ht[0]) * (1U << JB_ZDOC_HASH_LOG)), finish);
+  // The most recent documents are sampled first
+  RCC(rc, finish, iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0));
+  for (uint32_t i = 0; i < sample && dictsz < JB_ZDICT_MAX_SIZE; ++i) {
+    rc = iwkv_cursor_to(cur, IWKV_CURSOR_NEXT);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      rc = 0;
+      break;
+    }
+    RCGO(rc, close);
+    RCC(rc, close, iwkv_cursor_val(cur, &val));
+    rc = jbi_doc_unpack(jbc, &val);
+    void *data = val.data;
+    if (!rc) {
+      // Dictionary is built from documents in the form they are compressed
+      rc = _jbi_doc_pack(jbc, mode & EJDB_COMPRESSION_KEYS, 0, 0, 0, &val, &kbuf);
+    }
+    if (!rc) {
+      // Document is added to dictionary only if it is poorly compressed by dictionary collected so far
+      jbi_zdict_hash(dict, dictsz, ht);
+      rc = _jbi_pack(val.data, val.size, dict, dictsz, ht, &out, &outsz);
+      if (!rc) {
+        if (!out || outsz > val.size / 4) {
+          uint32_t sz = (uint32_t) MIN(val.size, JB_ZDICT_MAX_SIZE - dictsz);
+          memcpy(dict + dictsz, val.data, sz);
+          dictsz += sz;
+        }
+        free(out);
+      }
+      free(kbuf);
+    }
+    val.data = data;
+    iwkv_val_dispose(&val);
+    RCGO(rc, close);
+  }
+
+close:
+  IWRC(iwkv_cursor_close(&cur), rc);
+
+finish:
+  free(ht);
+  if (rc || dictsz < JB_ZDOC_MIN_SIZE) {
+    free(dict);
+  } else {
+    *dictp = dict;
+    *dictszp = dictsz;
+  }
+  return rc;
+}
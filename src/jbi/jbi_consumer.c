@@ -11,50 +11,40 @@ iwrc jbi_consumer(struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, int64
   struct ejdb_exec *ux = ctx->ux;
   struct iwpool *pool = ux->pool;
 
-start:
-  {
-    if (cur) {
-      rc = iwkv_cursor_copy_val(cur, ctx->jblbuf, ctx->jblbufsz, &vsz);
-    } else {
-      struct iwkv_val key = {
-        .data = &id,
-        .size = sizeof(id)
-      };
-      rc = iwkv_get_copy(ctx->jbc->cdb, &key, ctx->jblbuf, ctx->jblbufsz, &vsz);
-    }
-    if (rc == IWKV_ERROR_NOTFOUND) {
-      rc = 0;
-      if (ctx->midx.idx) {
-        iwlog_error("Orphaned index entry."
-                    "\n\tCollection db: %" PRIu32
-                    "\n\tIndex db: %" PRIu32
-                    "\n\tEntry id: %" PRId64, ctx->jbc->dbid, ctx->midx.idx->dbid, id);
-      } else {
-        iwlog_error("Orphaned index entry."
-                    "\n\tCollection db: %" PRIu32
-                    "\n\tEntry id: %" PRId64, ctx->jbc->dbid, id);
-      }
-      goto finish;
-    }
-    RCGO(rc, finish);
+  ++ctx->stats.scanned;
+  if (ctx->guarded) {
+    rc = jb_exec_guard(ctx, ctx->stats.scanned);
+    RCRET(rc);
+  }
+  if (ctx->prefilter_num && !jbi_prefilter_matched(ctx, id, &rc)) {
+    *matched = false;
+    return rc;
+  }
 
-    if (vsz > ctx->jblbufsz) {
-      size_t nsize = MAX(vsz, ctx->jblbufsz * 2);
-      void *nbuf = realloc(ctx->jblbuf, nsize);
-      if (!nbuf) {
-        rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-        goto finish;
-      }
-      ctx->jblbuf = nbuf;
-      ctx->jblbufsz = nsize;
-      goto start;
+  rc = jbi_scan_doc_fetch(ctx, cur, id, &jbl, &vsz, matched);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+    if (ctx->midx.idx) {
+      iwlog_error("Orphaned index entry."
+                  "\n\tCollection db: %" PRIu32
+                  "\n\tIndex db: %" PRIu32
+                  "\n\tEntry id: %" PRId64, ctx->jbc->dbid, ctx->midx.idx->dbid, id);
+    } else {
+      iwlog_error("Orphaned index entry."
+                  "\n\tCollection db: %" PRIu32
+                  "\n\tEntry id: %" PRId64, ctx->jbc->dbid, id);
     }
+    goto finish;
   }
+  RCGO(rc, finish);
+  ++ctx->stats.fetched;
+  ctx->stats.bytes += vsz;
 
-  RCC(rc, finish, jbl_from_buf_keep_onstack(&jbl, ctx->jblbuf, vsz));
-
-  rc = jql_matched(ux->q, &jbl, matched);
-  if (rc || !*matched || (ux->skip && (ux->skip-- > 0))) {
+  if (!*matched) {
+    goto finish;
+  }
+  ++ctx->stats.matched;
+  if (ux->skip && (ux->skip-- > 0)) {
     goto finish;
   }
   if (ctx->istep > 0) {
@@ -70,7 +60,25 @@ start:
       .id = id,
       .raw = &jbl
     };
-    if (aux->apply || aux->apply_placeholder || aux->projection) {
+    if (ctx->projection && !(aux->apply || aux->apply_placeholder)) {
+      if (!pool) {
+        pool = iwpool_create(1024);
+        if (!pool) {
+          rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+          goto finish;
+        }
+      }
+      // Projected tree is built straight from document buffer
+      RCC(rc, finish, jql_project_jbl(q, &jbl, &doc.node, ctx, pool));
+      if (aux->qmode & JQP_QRY_APPLY_DEL) {
+        if (cur) {
+          rc = jb_cursor_del(ctx->jbc, cur, id, &jbl);
+        } else {
+          rc = jb_del(ctx->jbc, &jbl, id);
+        }
+        RCGO(rc, finish);
+      }
+    } else if (aux->apply || aux->apply_placeholder) {
       struct jbl_node *root;
       if (!pool) {
         pool = iwpool_create((size_t) jbl.bn.size * 2);
@@ -99,7 +107,7 @@ start:
         binn_free(&sn.bn);
       }
       RCGO(rc, finish);
-      if (aux->projection) {
+      if (ctx->projection) {
         RCC(rc, finish, jql_project(q, root, pool, ctx));
       }
     } else if (aux->qmode & JQP_QRY_APPLY_DEL) {
@@ -113,7 +121,7 @@ start:
     if (!(aux->qmode & JQP_QRY_AGGREGATE)) {
       do {
         ctx->istep = 1;
-        RCC(rc, finish, ux->visitor(ux, &doc, &ctx->istep));
+        RCC(rc, finish, jb_exec_visit(ctx, &doc, &ctx->istep));
       } while (ctx->istep == -1);
     }
     ++ux->cnt;
@@ -18,11 +18,16 @@ static iwrc _jbi_consume_eq(struct jbexec *ctx, JQVAL *jqval, jb_scan_consumer c
   if (!key.size) {
     return consumer(ctx, 0, 0, 0, 0, 0);
   }
-  rc = iwkv_cursor_open(idx->idb, &cur, IWKV_CURSOR_GE, &key);
-  if (rc == IWKV_ERROR_NOTFOUND) {
-    return consumer(ctx, 0, 0, 0, 0, 0);
+  if (ctx->page.resume) { // Continue scan after the last entry of previous page
+    RCC(rc, finish, jbi_page_cursor_open(ctx, idx->idb, idx->dbid, midx->cursor_step, &cur));
+    RCC(rc, finish, iwkv_cursor_to(cur, midx->cursor_step));
   } else {
-    RCRET(rc);
+    rc = iwkv_cursor_open(idx->idb, &cur, IWKV_CURSOR_GE, &key);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      return consumer(ctx, 0, 0, 0, 0, 0);
+    } else {
+      RCRET(rc);
+    }
   }
 
   do {
@@ -39,6 +44,9 @@ static iwrc _jbi_consume_eq(struct jbexec *ctx, JQVAL *jqval, jb_scan_consumer c
       }
       step = 1;
       RCC(rc, finish, consumer(ctx, 0, id, &step, &matched, 0));
+      if (!step) {
+        RCC(rc, finish, jbi_page_next_token(ctx, cur, idx->dbid, midx->cursor_step));
+      }
     }
   } while (step && !(rc = iwkv_cursor_to(cur, step > 0 ? midx->cursor_step : cursor_reverse_step)));
 
@@ -152,22 +160,27 @@ static iwrc _jbi_consume_scan(struct jbexec *ctx, JQVAL *jqval, jb_scan_consumer
   }
   key.compound = (midx->cursor_step == IWKV_CURSOR_PREV) ? INT64_MIN : INT64_MAX;
 
-  iwrc rc = iwkv_cursor_open(idx->idb, &cur, midx->cursor_init, &key);
-  if ((rc == IWKV_ERROR_NOTFOUND) && ((expr1_op == JQP_OP_LT) || (expr1_op == JQP_OP_LTE))) {
-    iwkv_cursor_close(&cur);
-    key.compound = INT64_MAX;
-    midx->cursor_init = IWKV_CURSOR_BEFORE_FIRST;
-    midx->cursor_step = IWKV_CURSOR_NEXT;
-    RCC(rc, finish, iwkv_cursor_open(idx->idb, &cur, midx->cursor_init, 0));
-    if (!midx->expr2) { // Fail fast
-      midx->expr2 = midx->expr1;
-    }
-  } else if (rc) {
-    goto finish;
-  }
-
-  if (midx->cursor_init < IWKV_CURSOR_NEXT) { // IWKV_CURSOR_BEFORE_FIRST || IWKV_CURSOR_AFTER_LAST
+  iwrc rc;
+  if (ctx->page.resume) { // Continue scan after the last entry of previous page
+    RCC(rc, finish, jbi_page_cursor_open(ctx, idx->idb, idx->dbid, midx->cursor_step, &cur));
     RCC(rc, finish, iwkv_cursor_to(cur, midx->cursor_step));
+  } else {
+    rc = iwkv_cursor_open(idx->idb, &cur, midx->cursor_init, &key);
+    if ((rc == IWKV_ERROR_NOTFOUND) && ((expr1_op == JQP_OP_LT) || (expr1_op == JQP_OP_LTE))) {
+      iwkv_cursor_close(&cur);
+      key.compound = INT64_MAX;
+      midx->cursor_init = IWKV_CURSOR_BEFORE_FIRST;
+      midx->cursor_step = IWKV_CURSOR_NEXT;
+      RCC(rc, finish, iwkv_cursor_open(idx->idb, &cur, midx->cursor_init, 0));
+      if (!midx->expr2) { // Fail fast
+        midx->expr2 = midx->expr1;
+      }
+    } else if (rc) {
+      goto finish;
+    }
+    if (midx->cursor_init < IWKV_CURSOR_NEXT) { // IWKV_CURSOR_BEFORE_FIRST || IWKV_CURSOR_AFTER_LAST
+      RCC(rc, finish, iwkv_cursor_to(cur, midx->cursor_step));
+    }
   }
 
   IWKV_cursor_op cursor_reverse_step = (midx->cursor_step == IWKV_CURSOR_PREV)
@@ -183,21 +196,25 @@ static iwrc _jbi_consume_scan(struct jbexec *ctx, JQVAL *jqval, jb_scan_consumer
       bool matched = false;
       RCC(rc, finish, iwkv_cursor_copy_key(cur, 0, 0, &sz, &id));
       if (  midx->expr2
-         && !midx->expr2->prematched
-         && !jbi_node_expr_matched(ctx->ux->q->aux, midx->idx, cur, midx->expr2, &rc)) {
+         && !jql_expr_prematched(ctx->ux->q, midx->expr2)
+         && !jbi_node_expr_matched(ctx->ux->q, midx->idx, cur, midx->expr2, &rc)) {
         break;
       }
-      if (  (expr1_op == JQP_OP_PREFIX)
-         && !jbi_node_expr_matched(ctx->ux->q->aux, midx->idx, cur, midx->expr1, &rc)) {
+      if (  ((expr1_op == JQP_OP_PREFIX) || (expr1_op == JQP_OP_RE))
+         && !jbi_node_expr_matched(ctx->ux->q, midx->idx, cur, midx->expr1, &rc)) {
         break;
       }
       RCGO(rc, finish);
       step = 1;
       if (id != prev_id) {
         RCC(rc, finish, consumer(ctx, 0, id, &step, &matched, 0));
-        if (!midx->expr1->prematched && matched && (expr1_op != JQP_OP_PREFIX)) {
+        if (!step) {
+          RCC(rc, finish, jbi_page_next_token(ctx, cur, idx->dbid, midx->cursor_step));
+        }
+        if (  !jql_expr_prematched(ctx->ux->q, midx->expr1) && matched
+           && (expr1_op != JQP_OP_PREFIX) && (expr1_op != JQP_OP_RE)) {
           // Further scan will always match main index expression
-          midx->expr1->prematched = true;
+          jql_expr_set_prematched(ctx->ux->q, midx->expr1);
         }
         prev_id = step < 1 ? 0 : id;
       }
@@ -223,9 +240,14 @@ static iwrc _jbi_consume_noxpr_scan(struct jbexec *ctx, jb_scan_consumer consume
   IWKV_cursor_op cursor_reverse_step = (midx->cursor_step == IWKV_CURSOR_PREV)
                                        ? IWKV_CURSOR_NEXT : IWKV_CURSOR_PREV;
 
-  RCC(rc, finish, iwkv_cursor_open(midx->idx->idb, &cur, midx->cursor_init, 0));
-  if (midx->cursor_init < IWKV_CURSOR_NEXT) { // IWKV_CURSOR_BEFORE_FIRST || IWKV_CURSOR_AFTER_LAST
+  if (ctx->page.resume) { // Continue scan after the last entry of previous page
+    RCC(rc, finish, jbi_page_cursor_open(ctx, midx->idx->idb, midx->idx->dbid, midx->cursor_step, &cur));
     RCC(rc, finish, iwkv_cursor_to(cur, midx->cursor_step));
+  } else {
+    RCC(rc, finish, iwkv_cursor_open(midx->idx->idb, &cur, midx->cursor_init, 0));
+    if (midx->cursor_init < IWKV_CURSOR_NEXT) { // IWKV_CURSOR_BEFORE_FIRST || IWKV_CURSOR_AFTER_LAST
+      RCC(rc, finish, iwkv_cursor_to(cur, midx->cursor_step));
+    }
   }
   do {
     if (step > 0) {
@@ -240,6 +262,9 @@ static iwrc _jbi_consume_noxpr_scan(struct jbexec *ctx, jb_scan_consumer consume
       step = 1;
       if (id != prev_id) {
         RCC(rc, finish, consumer(ctx, 0, id, &step, &matched, 0));
+        if (!step) {
+          RCC(rc, finish, jbi_page_next_token(ctx, cur, midx->idx->dbid, midx->cursor_step));
+        }
         prev_id = step < 1 ? 0 : id;
       }
     }
@@ -261,11 +286,11 @@ iwrc jbi_dup_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
   if (!midx->expr1) {
     return _jbi_consume_noxpr_scan(ctx, consumer);
   }
-  JQP_QUERY *qp = ctx->ux->q->qp;
-  JQVAL *jqval = jql_unit_to_jqval(qp->aux, midx->expr1->right, &rc);
+  JQVAL *jqval = jql_unit_to_jqval(ctx->ux->q, midx->expr1->right, &rc);
   RCRET(rc);
   switch (midx->expr1->op->value) {
     case JQP_OP_EQ:
+    case JQP_OP_NI:
       return _jbi_consume_eq(ctx, jqval, consumer);
     case JQP_OP_IN:
       if (jqval->type == JQVAL_JBLNODE) {
@@ -275,6 +300,14 @@ iwrc jbi_dup_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
         return IW_ERROR_ASSERTION;
       }
       break;
+    case JQP_OP_RE: { // Scan keys starting with regexp literal prefix
+      JQVAL pjqv = {
+        .type = JQVAL_STR,
+        .vstr = jql_expr_regexp_prefix(ctx->ux->q, midx->expr1, &rc)
+      };
+      RCRET(rc);
+      return _jbi_consume_scan(ctx, &pjqv, consumer);
+    }
     default:
       break;
   }
@@ -4,7 +4,15 @@ iwrc jbi_full_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
   bool matched;
   IWKV_cursor cur;
   int64_t step = 1;
-  iwrc rc = iwkv_cursor_open(ctx->jbc->cdb, &cur, ctx->cursor_init, 0);
+  iwrc rc;
+  if (ctx->page.resume) { // Continue scan after the last document of previous page
+    rc = jbi_page_cursor_open(ctx, ctx->jbc->cdb, ctx->jbc->dbid, ctx->cursor_step, &cur);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      return consumer(ctx, 0, 0, 0, 0, 0);
+    }
+  } else {
+    rc = iwkv_cursor_open(ctx->jbc->cdb, &cur, ctx->cursor_init, 0);
+  }
   RCRET(rc);
 
   IWKV_cursor_op cursor_reverse_step = (ctx->cursor_step == IWKV_CURSOR_NEXT)
@@ -30,11 +38,21 @@ iwrc jbi_full_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
       matched = false;
       rc = consumer(ctx, cur, id, &step, &matched, 0);
       RCBREAK(rc);
+      if (!step) {
+        rc = jbi_page_next_token(ctx, cur, ctx->jbc->dbid, ctx->cursor_step);
+      } else if ((step > 0) && ctx->yield.enabled) {
+        rc = ctx->yield.write
+             ? jbi_yield_write(ctx, id, &cur)
+             : jbi_yield(ctx, &cur);
+        RCBREAK(rc);
+      }
     }
   }
   if (rc == IWKV_ERROR_NOTFOUND) {
     rc = 0;
   }
-  iwkv_cursor_close(&cur);
+  if (cur) {
+    iwkv_cursor_close(&cur);
+  }
   return consumer(ctx, 0, 0, 0, 0, rc);
 }
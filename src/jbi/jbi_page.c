@@ -0,0 +1,296 @@
+#include "ejdb2_internal.h"
+#include <sched.h>
+
+#define JB_PAGE_TOKEN_VERSION 1
+#define JB_PAGE_TOKEN_HDR_SZ  (2 + sizeof(uint32_t) + sizeof(int64_t))
+
+/**
+ * Page token is a hex encoded position of the last visited entry:
+ * `[version:u8][cursor step:u8][dbid:u32][compound:i64][key]`
+ */
+
+static bool _jbi_page_supported(struct jbexec *ctx) {
+  struct jql *q = ctx->ux->q;
+  struct jbmidx *midx = &ctx->midx;
+  if (ctx->sorting || jql_has_apply(q) || jql_has_aggregates(q)) {
+    return false;
+  }
+  if (ctx->scanner == jbi_full_scanner) {
+    return true;
+  }
+  if ((ctx->scanner != jbi_uniq_scanner) && (ctx->scanner != jbi_dup_scanner)) {
+    return false;
+  }
+  if (!midx->expr1) {
+    return true;
+  }
+  switch (midx->expr1->op->value) {
+    case JQP_OP_IN:
+      return false;
+    case JQP_OP_EQ:
+    case JQP_OP_NI:
+      // Lookup in unique index visits at most one document
+      return ctx->scanner == jbi_dup_scanner;
+    default:
+      return true;
+  }
+}
+
+static int _jbi_page_hexval(char c) {
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  } else if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  } else if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static iwrc _jbi_page_token_decode(struct jbpage *page, const char *token) {
+  size_t len = strlen(token);
+  if ((len & 1) || (len <= 2 * JB_PAGE_TOKEN_HDR_SZ)) {
+    return EJDB_ERROR_INVALID_PAGE_TOKEN;
+  }
+  size_t sz = len / 2;
+  uint8_t *rp = page->buf = malloc(sz);
+  if (!rp) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  for (size_t i = 0; i < sz; ++i) {
+    int hv = _jbi_page_hexval(token[2 * i]);
+    int lv = _jbi_page_hexval(token[2 * i + 1]);
+    if ((hv < 0) || (lv < 0)) {
+      return EJDB_ERROR_INVALID_PAGE_TOKEN;
+    }
+    rp[i] = (uint8_t) ((hv << 4) | lv);
+  }
+  if (*rp++ != JB_PAGE_TOKEN_VERSION) {
+    return EJDB_ERROR_INVALID_PAGE_TOKEN;
+  }
+  page->step = *rp++;
+  if ((page->step != IWKV_CURSOR_NEXT) && (page->step != IWKV_CURSOR_PREV)) {
+    return EJDB_ERROR_INVALID_PAGE_TOKEN;
+  }
+  memcpy(&page->dbid, rp, sizeof(page->dbid));
+  rp += sizeof(page->dbid);
+  memcpy(&page->key.compound, rp, sizeof(page->key.compound));
+  rp += sizeof(page->key.compound);
+  page->key.data = rp;
+  page->key.size = sz - JB_PAGE_TOKEN_HDR_SZ;
+  return 0;
+}
+
+static iwrc _jbi_page_hex_cat(struct iwxstr *xstr, const uint8_t *data, size_t len) {
+  static const char hex[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; ++i) {
+    char hb[2] = { hex[data[i] >> 4], hex[data[i] & 0x0f] };
+    RCR(iwxstr_cat(xstr, hb, sizeof(hb)));
+  }
+  return 0;
+}
+
+iwrc jbi_page_init(struct jbexec *ctx) {
+  iwrc rc = 0;
+  struct jbpage *page = &ctx->page;
+  struct ejdb_exec *ux = ctx->ux;
+  if (!page->enabled) {
+    return 0;
+  }
+  page->supported = _jbi_page_supported(ctx);
+  if (ux->page_token && (*ux->page_token != '\0')) {
+    if (!page->supported) {
+      return EJDB_ERROR_INVALID_PAGE_TOKEN;
+    }
+    RCR(_jbi_page_token_decode(page, ux->page_token));
+    page->resume = true;
+  }
+  if (ux->next_page_token) {
+    // Token is decoded already so the same buffer can be used for `page_token`
+    iwxstr_clear(ux->next_page_token);
+  }
+  return rc;
+}
+
+void jbi_page_release(struct jbexec *ctx) {
+  free(ctx->page.buf);
+  memset(&ctx->page, 0, sizeof(ctx->page));
+}
+
+/**
+ * Opens cursor positioned so the next cursor `step` lands on the entry following `key`.
+ */
+static iwrc _jbi_cursor_open_after(
+  struct iwdb *db, struct iwkv_val *key, IWKV_cursor_op step,
+  struct iwkv_cursor **curp) {
+  iwrc rc = iwkv_cursor_open(db, curp, IWKV_CURSOR_EQ, key);
+  if (rc != IWKV_ERROR_NOTFOUND) {
+    return rc;
+  }
+  // Last visited entry is removed, position cursor at the nearest greater key.
+  // Keys are in descending order along IWKV_CURSOR_NEXT direction.
+  iwkv_cursor_close(curp);
+  rc = iwkv_cursor_open(db, curp, IWKV_CURSOR_GE, key);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    iwkv_cursor_close(curp);
+    if (step == IWKV_CURSOR_NEXT) { // All keys are less than the removed one
+      rc = iwkv_cursor_open(db, curp, IWKV_CURSOR_BEFORE_FIRST, 0);
+    }
+    return rc;
+  }
+  RCRET(rc);
+  if (step == IWKV_CURSOR_PREV) {
+    // Greater key is not visited yet, step back so the next cursor step lands on it
+    rc = iwkv_cursor_to(*curp, IWKV_CURSOR_NEXT);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      iwkv_cursor_close(curp);
+      rc = iwkv_cursor_open(db, curp, IWKV_CURSOR_AFTER_LAST, 0);
+    }
+    if (rc) {
+      iwkv_cursor_close(curp);
+    }
+  }
+  return rc;
+}
+
+iwrc jbi_page_cursor_open(
+  struct jbexec *ctx, struct iwdb *db, uint32_t dbid, IWKV_cursor_op step,
+  struct iwkv_cursor **curp) {
+  struct jbpage *page = &ctx->page;
+  *curp = 0;
+  if ((page->dbid != dbid) || (page->step != step)) {
+    return EJDB_ERROR_INVALID_PAGE_TOKEN;
+  }
+  return _jbi_cursor_open_after(db, &page->key, step, curp);
+}
+
+iwrc jbi_page_next_token(struct jbexec *ctx, struct iwkv_cursor *cur, uint32_t dbid, IWKV_cursor_op step) {
+  iwrc rc;
+  size_t sz;
+  uint8_t kbuf[256];
+  uint8_t hdr[JB_PAGE_TOKEN_HDR_SZ];
+  uint8_t *key = kbuf;
+  int64_t compound = 0;
+  struct iwxstr *xstr = ctx->ux->next_page_token;
+
+  if (!xstr || !ctx->page.supported) {
+    return 0;
+  }
+  RCC(rc, finish, iwkv_cursor_copy_key(cur, kbuf, sizeof(kbuf), &sz, &compound));
+  if (sz > sizeof(kbuf)) {
+    RCB(finish, key = malloc(sz));
+    RCC(rc, finish, iwkv_cursor_copy_key(cur, key, sz, &sz, &compound));
+  }
+  hdr[0] = JB_PAGE_TOKEN_VERSION;
+  hdr[1] = step;
+  memcpy(hdr + 2, &dbid, sizeof(dbid));
+  memcpy(hdr + 2 + sizeof(dbid), &compound, sizeof(compound));
+  iwxstr_clear(xstr);
+  RCC(rc, finish, _jbi_page_hex_cat(xstr, hdr, sizeof(hdr)));
+  rc = _jbi_page_hex_cat(xstr, key, sz);
+
+finish:
+  if (key != kbuf) {
+    free(key);
+  }
+  return rc;
+}
+
+/**
+ * Reopens collection cursor after `yield.key` once collection lock released by scan is reacquired.
+ */
+static iwrc _jbi_yield_resume(struct jbexec *ctx, uint64_t wepoch, struct iwkv_cursor **curp) {
+  uint64_t ts;
+  struct jbyield *y = &ctx->yield;
+  struct jbcoll *jbc = ctx->jbc;
+  ++ctx->stats.yields;
+  if (jbc->idxgen != y->idxgen) {
+    return EJDB_ERROR_QUERY_INDEX_REMOVED;
+  }
+  if (ctx->rcbuf && (wepoch != jbc->wepoch)) {
+    // Result set is not consistent with any collection state, so it is not cached
+    iwxstr_destroy(ctx->rcbuf);
+    ctx->rcbuf = 0;
+  }
+  RCR(iwp_current_time_ms(&ts, true));
+  y->deadline_ms = ts + jbc->db->opts.read_yield_ms;
+  y->cnt = 0;
+  return _jbi_cursor_open_after(jbc->cdb, &y->key, ctx->cursor_step, curp);
+}
+
+/**
+ * Releases collection lock and scanners group of read-only query if it is held longer
+ * than `EJDB_OPTS.read_yield_ms` or a writer is waiting for it. Scan cursor is reopened after the last visited document.
+ * Called by collection full scanner after the document is consumed. Index scans don't release the lock:
+ * index entry of document modified meanwhile may be moved past the scan cursor and visited again.
+ */
+iwrc jbi_yield(struct jbexec *ctx, struct iwkv_cursor **curp) {
+  int rci;
+  size_t sz;
+  uint64_t ts, wepoch;
+  struct jbyield *y = &ctx->yield;
+  struct jbcoll *jbc = ctx->jbc;
+
+  if (!__atomic_load_n(&jbc->wwait, __ATOMIC_RELAXED)) {
+    if (++y->cnt & (JB_EXEC_GUARD_CLOCK_INTERVAL - 1)) {
+      return 0;
+    }
+    RCR(iwp_current_time_ms(&ts, true));
+    if (ts < y->deadline_ms) {
+      return 0;
+    }
+  }
+  RCR(iwkv_cursor_copy_key(*curp, y->buf, y->bufsz, &sz, &y->key.compound));
+  if (sz > y->bufsz) {
+    uint8_t *nbuf = realloc(y->buf, sz);
+    if (!nbuf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    y->buf = nbuf;
+    y->bufsz = sz;
+    RCR(iwkv_cursor_copy_key(*curp, y->buf, y->bufsz, &sz, &y->key.compound));
+  }
+  y->key.data = y->buf;
+  y->key.size = sz;
+  iwkv_cursor_close(curp);
+
+  // Database lock is kept so collection and its indexes cannot be destroyed
+  wepoch = jbc->wepoch;
+  jb_coll_scan_unlock(jbc);
+  rci = pthread_rwlock_unlock(&jbc->rwl);
+  if (rci) {
+    jb_coll_scan_lock(jbc);
+    return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci);
+  }
+  sched_yield();
+  pthread_rwlock_rdlock(&jbc->rwl);
+  jb_coll_scan_lock(jbc);
+  return _jbi_yield_resume(ctx, wepoch, curp);
+}
+
+/**
+ * Releases collection write lock of query with apply after every
+ * `EJDB_OPTS.apply_batch_size` modified documents.
+ * Called by collection full scanner, the scan is continued after document `id`.
+ */
+iwrc jbi_yield_write(struct jbexec *ctx, int64_t id, struct iwkv_cursor **curp) {
+  struct jbyield *y = &ctx->yield;
+  struct jbcoll *jbc = ctx->jbc;
+  if (ctx->ux->cnt - y->mark < jbc->db->opts.apply_batch_size) {
+    return 0;
+  }
+  y->mark = ctx->ux->cnt;
+  y->id = id;
+  y->key.data = &y->id;
+  y->key.size = sizeof(y->id);
+  y->key.compound = 0;
+  iwkv_cursor_close(curp);
+
+  int rci = pthread_rwlock_unlock(&jbc->rwl);
+  if (rci) {
+    return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, rci);
+  }
+  sched_yield();
+  jb_coll_wrlock(jbc);
+  return _jbi_yield_resume(ctx, jbc->wepoch, curp);
+}
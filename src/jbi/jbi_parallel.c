@@ -0,0 +1,317 @@
+#include "ejdb2_internal.h"
+
+/** Range of collection document ids processed by single worker */
+struct _jbi_pchunk {
+  int64_t  lo;          /**< Range low document id (inclusive) */
+  int64_t  hi;          /**< Range high document id (inclusive) */
+  int64_t *ids;         /**< Matched document ids in ascending order */
+  uint32_t num;         /**< Number of matched ids */
+  uint32_t asz;         /**< Allocated size of `ids` in elements */
+  bool     done;        /**< Chunk is completely processed */
+};
+
+/** Parallel scan shared context */
+struct _jbi_pscan {
+  struct jbexec      *ctx;
+  struct _jbi_pchunk *chunks;      /**< Chunks listed in the result order */
+  int  nchunks;
+  int  next_chunk;                 /**< Next chunk to be scheduled */
+  bool asc;                        /**< Ascending order of document ids */
+  volatile bool   stop;            /**< Stop scanning flag */
+  uint64_t        scanned;         /**< Number of entries visited by all workers,
+                                        updated every JB_EXEC_GUARD_CLOCK_INTERVAL entries of worker */
+  iwrc            rc;              /**< First worker error */
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+};
+
+/** Parallel scan worker */
+struct _jbi_pworker {
+  struct _jbi_pscan *ps;
+  struct jql *q;                   /**< Query clone with its own matching state */
+  uint8_t    *buf;                 /**< Document buffer */
+  size_t      bufsz;
+  uint8_t    *zbuf;                /**< Packed document buffer */
+  size_t      zbufsz;
+  uint64_t    scanned;             /**< Number of visited collection entries */
+  uint64_t    fetched;             /**< Number of fetched documents */
+  uint64_t    bytes;               /**< Size of fetched documents */
+};
+
+int jbi_parallel_start(pthread_t *threads, int num, void* (*task)(void*), void *args, size_t arg_size) {
+  int i = 0;
+  for ( ; i < num; ++i) {
+    if (pthread_create(&threads[i], 0, task, (uint8_t*) args + i * arg_size)) {
+      break;
+    }
+  }
+  return i;
+}
+
+void jbi_parallel_join(pthread_t *threads, int num) {
+  for (int i = 0; i < num; ++i) {
+    pthread_join(threads[i], 0);
+  }
+}
+
+int jbi_parallel_scan_threads(struct jbexec *ctx) {
+  struct ejdb *db = ctx->jbc->db;
+  struct jql *q = ctx->ux->q;
+  // Parallel scan has no keyset continuation, paged queries and cursors fall back to serial scan
+  if ((db->opts.parallel_threads < 2) || jql_has_apply(q) || ctx->page.enabled) {
+    return 0;
+  }
+  int64_t num = ctx->jbc->rnum / JB_PARALLEL_SCAN_MIN_RNUM;
+  return (int) MIN(num, (int64_t) db->opts.parallel_threads);
+}
+
+static iwrc _jbi_pchunk_add(struct _jbi_pchunk *chunk, int64_t id) {
+  if (chunk->num >= chunk->asz) {
+    uint32_t nsz = chunk->asz ? chunk->asz * 2 : 256;
+    int64_t *nids = realloc(chunk->ids, nsz * sizeof(chunk->ids[0]));
+    if (!nids) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    chunk->ids = nids;
+    chunk->asz = nsz;
+  }
+  chunk->ids[chunk->num++] = id;
+  return 0;
+}
+
+static iwrc _jbi_pchunk_scan(struct _jbi_pworker *w, struct _jbi_pchunk *chunk) {
+  int64_t id;
+  size_t sz, vsz;
+  bool matched;
+  struct jbl jbl;
+  struct iwkv_cursor *cur;
+  struct _jbi_pscan *ps = w->ps;
+  struct iwkv_val key = {
+    .data = &chunk->lo,
+    .size = sizeof(chunk->lo)
+  };
+
+  iwrc rc = iwkv_cursor_open(ps->ctx->jbc->cdb, &cur, IWKV_CURSOR_GE, &key);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    return 0;
+  }
+  RCRET(rc);
+
+  do {
+    if (ps->stop) {
+      break;
+    }
+    RCC(rc, finish, iwkv_cursor_copy_key(cur, &id, sizeof(id), &sz, 0));
+    if (sz != sizeof(id)) {
+      rc = IWKV_ERROR_CORRUPTED;
+      iwlog_ecode_error3(rc);
+      goto finish;
+    }
+    if (id > chunk->hi) {
+      break;
+    }
+    ++w->scanned;
+    if (ps->ctx->guarded && !(w->scanned & (JB_EXEC_GUARD_CLOCK_INTERVAL - 1))) {
+      uint64_t scanned = __sync_add_and_fetch(&ps->scanned, JB_EXEC_GUARD_CLOCK_INTERVAL);
+      RCC(rc, finish, jb_exec_guard(ps->ctx, scanned));
+    }
+    RCC(rc, finish, jbi_doc_fetch(ps->ctx->jbc, w->q, cur, id, &w->buf, &w->bufsz, &w->zbuf, &w->zbufsz, 0,
+                                  &jbl, &vsz, &matched));
+    ++w->fetched;
+    w->bytes += vsz;
+    if (matched) {
+      RCC(rc, finish, _jbi_pchunk_add(chunk, id));
+    }
+  } while (!(rc = iwkv_cursor_to(cur, IWKV_CURSOR_PREV))); // Move to the next greater id
+
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+
+finish:
+  iwkv_cursor_close(&cur);
+  return rc;
+}
+
+static void* _jbi_pworker(void *op) {
+  struct _jbi_pworker *w = op;
+  struct _jbi_pscan *ps = w->ps;
+  while (!ps->stop) {
+    int c = __sync_fetch_and_add(&ps->next_chunk, 1);
+    if (c >= ps->nchunks) {
+      break;
+    }
+    struct _jbi_pchunk *chunk = &ps->chunks[c];
+    iwrc rc = _jbi_pchunk_scan(w, chunk);
+    pthread_mutex_lock(&ps->mtx);
+    chunk->done = true;
+    if (rc && !ps->rc) {
+      ps->rc = rc;
+      ps->stop = true;
+    }
+    pthread_cond_broadcast(&ps->cond);
+    pthread_mutex_unlock(&ps->mtx);
+  }
+  return 0;
+}
+
+static iwrc _jbi_pscan_wait(struct _jbi_pscan *ps, struct _jbi_pchunk *chunk) {
+  iwrc rc;
+  pthread_mutex_lock(&ps->mtx);
+  while (!chunk->done && !ps->rc) {
+    pthread_cond_wait(&ps->cond, &ps->mtx);
+  }
+  rc = ps->rc;
+  pthread_mutex_unlock(&ps->mtx);
+  return rc;
+}
+
+static iwrc _jbi_pscan_id_bounds(struct jbcoll *jbc, int64_t *min, int64_t *max) {
+  size_t sz;
+  struct iwkv_cursor *cur;
+  *min = 0;
+  *max = 0;
+  iwrc rc = iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_BEFORE_FIRST, 0);
+  RCRET(rc);
+  RCC(rc, finish, iwkv_cursor_to(cur, IWKV_CURSOR_NEXT));
+  RCC(rc, finish, iwkv_cursor_copy_key(cur, max, sizeof(*max), &sz, 0));
+  iwkv_cursor_close(&cur);
+  RCC(rc, finish, iwkv_cursor_open(jbc->cdb, &cur, IWKV_CURSOR_AFTER_LAST, 0));
+  RCC(rc, finish, iwkv_cursor_to(cur, IWKV_CURSOR_PREV));
+  RCC(rc, finish, iwkv_cursor_copy_key(cur, min, sizeof(*min), &sz, 0));
+
+finish:
+  iwkv_cursor_close(&cur);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+  return rc;
+}
+
+/**
+ * Consumes matched document ids in the result order.
+ * Documents are fetched again by consumer but not matched again.
+ */
+static iwrc _jbi_pscan_consume(struct _jbi_pscan *ps, jb_scan_consumer consumer) {
+  iwrc rc = 0;
+  int c = 0;
+  int64_t i = 0, step = 1;
+  bool matched;
+  struct jbexec *ctx = ps->ctx;
+  struct ejdb_exec *ux = ctx->ux;
+  bool count_only = (consumer == jbi_consumer) && (ux->q->aux->qmode & JQP_QRY_AGGREGATE);
+
+  ctx->prematched = true;
+  while (c >= 0 && c < ps->nchunks) {
+    struct _jbi_pchunk *chunk = &ps->chunks[c];
+    RCC(rc, finish, _jbi_pscan_wait(ps, chunk));
+    if (i >= chunk->num) {
+      if (++c < ps->nchunks) {
+        i = 0;
+      }
+      continue;
+    } else if (i < 0) {
+      if (--c >= 0) {
+        i = (int64_t) ps->chunks[c].num - 1;
+      }
+      continue;
+    }
+    if (count_only) { // No need to fetch matched documents again
+      ++ctx->stats.matched;
+      if (!(ux->skip && (ux->skip-- > 0))) {
+        ++ux->cnt;
+        if (--ux->limit < 1) {
+          break;
+        }
+      }
+      ++i;
+      continue;
+    }
+    int64_t id = chunk->ids[ps->asc ? i : chunk->num - 1 - i];
+    step = 1;
+    matched = false;
+    RCC(rc, finish, consumer(ctx, 0, id, &step, &matched, 0));
+    if (!step) {
+      break;
+    }
+    i += step > 0 ? 1 : -1;
+  }
+
+finish:
+  ctx->prematched = false;
+  return rc;
+}
+
+iwrc jbi_parallel_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
+  int64_t min, max;
+  int nworkers = jbi_parallel_scan_threads(ctx), nstarted = 0;
+  struct _jbi_pworker *workers = 0;
+  pthread_t *threads = 0;
+  struct _jbi_pscan ps = {
+    .ctx = ctx,
+    .asc = (ctx->cursor_step == IWKV_CURSOR_PREV)
+  };
+  pthread_mutex_init(&ps.mtx, 0);
+  pthread_cond_init(&ps.cond, 0);
+
+  iwrc rc = _jbi_pscan_id_bounds(ctx->jbc, &min, &max);
+  RCGO(rc, finish);
+  if (max < 1 || nworkers < 1) {
+    goto finish;
+  }
+
+  uint64_t span = (uint64_t) (max - min) + 1;
+  ps.nchunks = (int) MIN(span, (uint64_t) nworkers * JB_PARALLEL_SCAN_CHUNKS_PER_WORKER);
+  RCA(ps.chunks = calloc(ps.nchunks, sizeof(ps.chunks[0])), finish);
+  uint64_t width = span / ps.nchunks + (span % ps.nchunks ? 1 : 0);
+  for (int i = 0; i < ps.nchunks; ++i) {
+    // First chunk holds the greatest ids in the case of descending order
+    struct _jbi_pchunk *chunk = &ps.chunks[ps.asc ? i : ps.nchunks - 1 - i];
+    chunk->lo = min + (int64_t) (width * i);
+    chunk->hi = (i == ps.nchunks - 1) ? max : chunk->lo + (int64_t) width - 1;
+  }
+
+  RCA(workers = calloc(nworkers, sizeof(workers[0])), finish);
+  RCA(threads = calloc(nworkers, sizeof(threads[0])), finish);
+  for (int i = 0; i < nworkers; ++i) {
+    struct _jbi_pworker *w = &workers[i];
+    w->ps = &ps;
+    w->bufsz = ctx->jblbufsz;
+    RCA(w->buf = malloc(w->bufsz), finish);
+    RCC(rc, finish, jql_clone_bound(ctx->ux->q, &w->q));
+  }
+
+  nstarted = jbi_parallel_start(threads, nworkers, _jbi_pworker, workers, sizeof(workers[0]));
+  if (!nstarted) { // Unable to start threads, do all work in the current thread
+    _jbi_pworker(&workers[0]);
+  }
+  rc = _jbi_pscan_consume(&ps, consumer);
+
+finish:
+  ps.stop = true;
+  jbi_parallel_join(threads, nstarted);
+  if (!rc) {
+    rc = ps.rc;
+  }
+  if (workers) {
+    for (int i = 0; i < nworkers; ++i) {
+      ctx->stats.scanned += workers[i].scanned;
+      ctx->stats.fetched += workers[i].fetched;
+      ctx->stats.bytes += workers[i].bytes;
+      free(workers[i].buf);
+      free(workers[i].zbuf);
+      jql_destroy(&workers[i].q);
+    }
+    free(workers);
+  }
+  if (ps.chunks) {
+    for (int i = 0; i < ps.nchunks; ++i) {
+      free(ps.chunks[i].ids);
+    }
+    free(ps.chunks);
+  }
+  free(threads);
+  pthread_cond_destroy(&ps.cond);
+  pthread_mutex_destroy(&ps.mtx);
+  return consumer(ctx, 0, 0, 0, 0, rc);
+}
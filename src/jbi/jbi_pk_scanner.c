@@ -9,7 +9,7 @@ iwrc jbi_pk_scanner(struct jbexec *ctx, jb_scan_consumer consumer) {
   assert(aux->expr->flags & JQP_EXPR_NODE_FLAG_PK);
   JQP_EXPR_NODE_PK *pk = (void*) aux->expr;
   assert(pk->argument);
-  JQVAL *jqvp = jql_unit_to_jqval(aux, pk->argument, &rc);
+  JQVAL *jqvp = jql_unit_to_jqval(ctx->ux->q, pk->argument, &rc);
   RCGO(rc, finish);
 
   if ((jqvp->type == JQVAL_JBLNODE) && (jqvp->vnode->type == JBV_ARRAY)) {
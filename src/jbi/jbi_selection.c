@@ -89,7 +89,7 @@ IW_INLINE int _jbi_idx_expr_op_weight(struct jbmidx *midx) {
     case JQP_OP_EQ:
       return 10;
     case JQP_OP_IN:
-      //case JQP_OP_NI: todo
+    case JQP_OP_NI:
       return 9;
     default:
       break;
@@ -102,6 +102,7 @@ IW_INLINE int _jbi_idx_expr_op_weight(struct jbmidx *midx) {
     case JQP_OP_GTE:
       return 7;
     case JQP_OP_PREFIX:
+    case JQP_OP_RE:
       return 6;
     case JQP_OP_LT:
     case JQP_OP_LTE:
@@ -114,10 +115,9 @@ IW_INLINE int _jbi_idx_expr_op_weight(struct jbmidx *midx) {
 static bool _jbi_is_solid_node_expression(const JQP_NODE *n) {
   JQPUNIT *unit = n->value;
   for (const JQP_EXPR *expr = &unit->expr; expr; expr = expr->next) {
-    if (  expr->op->negate
-       || (expr->join && (expr->join->negate || (expr->join->value == JQP_JOIN_OR)))
-       || (expr->op->value == JQP_OP_RE)) {
-      // No negate conditions, No OR, No regexp
+    if (  (expr->op->negate && (expr->op->value != JQP_OP_EQ) && (expr->op->value != JQP_OP_IN))
+       || (expr->join && (expr->join->negate || (expr->join->value == JQP_JOIN_OR)))) {
+      // No negate conditions except `!=` and `not in`, No OR
       return false;
     }
     JQPUNIT *left = expr->left;
@@ -134,21 +134,33 @@ static iwrc _jbi_compute_index_rules(JBEXEC *ctx, struct jbmidx *mctx) {
   if (!expr) {
     return 0;
   }
-  JQP_AUX *aux = ctx->ux->q->aux;
+  JQL q = ctx->ux->q;
+  JQP_AUX *aux = q->aux;
 
   for ( ; expr; expr = expr->next) {
     iwrc rc = 0;
     jqp_op_t op = expr->op->value;
-    JQVAL *rv = jql_unit_to_jqval(aux, expr->right, &rc);
+    JQVAL *rv = jql_unit_to_jqval(q, expr->right, &rc);
     RCRET(rc);
-    if (expr->left->type != JQP_STRING_TYPE) {
+    if (  (expr->left->type != JQP_STRING_TYPE)
+       || ((expr != mctx->nexpr) && strcmp(expr->left->string.value, mctx->nexpr->left->string.value))) {
+      // Expression is not on the indexed field
+      continue;
+    }
+    if (expr->op->negate) {
+      // Documents matched by negated expression may have no index keys at all
+      // (null, object or empty array values), leave such expressions to documents matching
       continue;
     }
     switch (rv->type) {
       case JQVAL_NULL:
-      case JQVAL_RE:
       case JQVAL_BINN:
         continue;
+      case JQVAL_RE:
+        if (op != JQP_OP_RE) {
+          continue;
+        }
+        break;
       case JQVAL_JBLNODE: {
         if ((op != JQP_OP_IN) || (rv->vnode->type != JBV_ARRAY)) {
           continue;
@@ -167,11 +179,30 @@ static iwrc _jbi_compute_index_rules(JBEXEC *ctx, struct jbmidx *mctx) {
         break;
     }
     switch (op) {
+      case JQP_OP_NI:
+        // Array field contains value: lookup of array elements in index,
+        // unique indexes do not keep elements of array fields
+        if ((rv->type >= JQVAL_RE) || !(mctx->idx->idbf & IWDB_COMPOUND_KEYS)) {
+          continue;
+        }
+      // fallthrough
       case JQP_OP_EQ:
         mctx->cursor_init = IWKV_CURSOR_EQ;
         mctx->expr1 = expr;
         mctx->expr2 = 0;
         return 0;
+      case JQP_OP_RE: {
+        // Index range of anchored regexp literal prefix, regexp itself is matched as the residual filter
+        if (!(mctx->idx->mode & EJDB_IDX_STR)) {
+          continue;
+        }
+        const char *prefix = jql_expr_regexp_prefix(q, expr, &rc);
+        RCRET(rc);
+        if (*prefix == '\0') {
+          continue;
+        }
+      }
+      // fallthrough
       case JQP_OP_PREFIX:
         if (!(mctx->idx->mode & EJDB_IDX_STR)) {
           mctx->expr1 = 0;
@@ -183,8 +214,9 @@ static iwrc _jbi_compute_index_rules(JBEXEC *ctx, struct jbmidx *mctx) {
       case JQP_OP_GT:
       case JQP_OP_GTE:
         if (mctx->cursor_init != IWKV_CURSOR_EQ) {
-          if (mctx->expr1 && (mctx->cursor_init == IWKV_CURSOR_GE) && (op != JQP_OP_PREFIX)) {
-            JQVAL *pval = jql_unit_to_jqval(aux, mctx->expr1->right, &rc);
+          if (  mctx->expr1 && (mctx->cursor_init == IWKV_CURSOR_GE)
+             && (op != JQP_OP_PREFIX) && (op != JQP_OP_RE)) {
+            JQVAL *pval = jql_unit_to_jqval(q, mctx->expr1->right, &rc);
             RCRET(rc);
             int cv = jql_cmp_jqval_pair(pval, rv, &rc);
             RCRET(rc);
@@ -200,7 +232,7 @@ static iwrc _jbi_compute_index_rules(JBEXEC *ctx, struct jbmidx *mctx) {
       case JQP_OP_LT:
       case JQP_OP_LTE:
         if (mctx->expr2) {
-          JQVAL *pval = jql_unit_to_jqval(aux, mctx->expr2->right, &rc);
+          JQVAL *pval = jql_unit_to_jqval(q, mctx->expr2->right, &rc);
           RCRET(rc);
           int cv = jql_cmp_jqval_pair(pval, rv, &rc);
           RCRET(rc);
@@ -388,6 +420,37 @@ static int _jbi_idx_cmp(const void *o1, const void *o2) {
   return (d1->idx->ptr->cnt - d2->idx->ptr->cnt);
 }
 
+/**
+ * Returns true if index matched by required equality expression can be used
+ * to reject entries scanned by selected index before document fetch.
+ */
+static bool _jbi_is_prefilter_index(JBEXEC *ctx, struct jbmidx *mctx) {
+  JQP_EXPR *expr = mctx->expr1;
+  if (  (mctx->idx == ctx->midx.idx)
+     || (expr == ctx->midx.expr1)
+     || (expr->op->value != JQP_OP_EQ)
+     || expr->op->negate
+     || (expr->left->string.flavour & JQP_STR_DBL_STAR)) {
+    return false;
+  }
+  iwrc rc = 0;
+  JQVAL *rv = jql_unit_to_jqval(ctx->ux->q, expr->right, &rc);
+  if (rc) {
+    return false;
+  }
+  // Value type must be native for index so index key is the same as for index lookups by `=`
+  switch (mctx->idx->mode & ~EJDB_IDX_UNIQUE) {
+    case EJDB_IDX_STR:
+      return rv->type == JQVAL_STR;
+    case EJDB_IDX_I64:
+      return rv->type == JQVAL_I64;
+    case EJDB_IDX_F64:
+      return rv->type == JQVAL_F64;
+    default:
+      return false;
+  }
+}
+
 static struct jbidx* _jbi_select_index_for_orderby(JBEXEC *ctx) {
   struct jqp_aux *aux = ctx->ux->q->aux;
   struct jbl_ptr *obp = aux->orderby_ptrs[0];
@@ -442,12 +505,24 @@ iwrc jbi_selection(JBEXEC *ctx) {
       struct jbmidx *midx = &ctx->midx;
       jqp_op_t op = midx->expr1->op->value;
       if ((op == JQP_OP_EQ) || (op == JQP_OP_IN) || ((op == JQP_OP_GTE) && (ctx->cursor_init == IWKV_CURSOR_GE))) {
-        midx->expr1->prematched = true;
+        jql_expr_set_prematched(ctx->ux->q, midx->expr1);
       }
       if (ctx->ux->log) {
         iwxstr_cat2(ctx->ux->log, "[INDEX] SELECTED ");
         _jbi_log_index_rules(ctx->ux->log, &ctx->midx);
       }
+      for (size_t i = 1; i < snp && ctx->prefilter_num < JB_PREFILTER_MAX; ++i) {
+        if (_jbi_is_prefilter_index(ctx, &fctx[i])) {
+          ctx->prefilter[ctx->prefilter_num++] = (struct jbprobe) {
+            .idx = fctx[i].idx,
+            .expr = fctx[i].expr1
+          };
+          if (ctx->ux->log) {
+            iwxstr_cat2(ctx->ux->log, "[INDEX] PREFILTER ");
+            _jbi_log_index_rules(ctx->ux->log, &fctx[i]);
+          }
+        }
+      }
       if (midx->orderby_support && (aux->orderby_num == 1)) {
         // Turn off final sorting since it supported by natural index scan order
         ctx->sorting = false;
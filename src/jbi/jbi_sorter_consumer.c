@@ -12,12 +12,19 @@ static void _jbi_scan_sorter_release(struct jbexec *ctx) {
   memset(ssc, 0, sizeof(*ssc));
 }
 
-static int _jbi_scan_sorter_cmp(const void *o1, const void *o2, void *op) {
+/** Parallel sorting task */
+struct _jbi_sort_task {
+  struct jbexec *ctx;
+  uint32_t      *refs;  /**< Sorted refs range */
+  uint32_t       num;   /**< Number of refs in the range */
+  iwrc rc;              /**< First comparison error */
+};
+
+static int _jbi_scan_sorter_cmp_impl(struct jbexec *ctx, const void *o1, const void *o2, iwrc *rcp) {
   int rv = 0;
   iwrc rc;
   uint32_t r1, r2;
   struct jbl d1, d2;
-  struct jbexec *ctx = op;
   struct jbssc *ssc = &ctx->ssc;
   struct jqp_aux *aux = ctx->ux->q->aux;
   uint8_t *p1, *p2;
@@ -46,6 +53,15 @@ static int _jbi_scan_sorter_cmp(const void *o1, const void *o2, void *op) {
   }
 
 finish:
+  *rcp = rc;
+  return rv;
+}
+
+static int _jbi_scan_sorter_cmp(const void *o1, const void *o2, void *op) {
+  iwrc rc;
+  struct jbexec *ctx = op;
+  struct jbssc *ssc = &ctx->ssc;
+  int rv = _jbi_scan_sorter_cmp_impl(ctx, o1, o2, &rc);
   if (rc) {
     ssc->rc = rc;
     longjmp(ssc->fatal_jmp, 1);
@@ -53,10 +69,105 @@ finish:
   return rv;
 }
 
+static int _jbi_scan_sorter_task_cmp(const void *o1, const void *o2, void *op) {
+  iwrc rc;
+  struct _jbi_sort_task *task = op;
+  if (task->rc) { // Stop comparing after the first error
+    return 0;
+  }
+  int rv = _jbi_scan_sorter_cmp_impl(task->ctx, o1, o2, &rc);
+  if (rc) {
+    task->rc = rc;
+  }
+  return rv;
+}
+
+static void* _jbi_scan_sorter_task(void *op) {
+  struct _jbi_sort_task *task = op;
+  sort_r(task->refs, task->num, sizeof(task->refs[0]), _jbi_scan_sorter_task_cmp, task);
+  return 0;
+}
+
+/**
+ * Sorts document refs ranges in worker threads then merges sorted ranges in the current thread.
+ */
+static iwrc _jbi_scan_sorter_parallel(struct jbexec *ctx, int nthreads) {
+  iwrc rc = 0;
+  int nstarted = 0;
+  struct jbssc *ssc = &ctx->ssc;
+  uint32_t rnum = ssc->refs_num;
+  uint32_t width = rnum / nthreads + (rnum % nthreads ? 1 : 0);
+  uint32_t *buf = 0, *src = ssc->refs, *dst;
+  pthread_t *threads = 0;
+  struct _jbi_sort_task *tasks = 0;
+
+  RCA(tasks = calloc(nthreads, sizeof(tasks[0])), finish);
+  RCA(threads = calloc(nthreads, sizeof(threads[0])), finish);
+  RCA(buf = malloc(rnum * sizeof(buf[0])), finish);
+  dst = buf;
+
+  for (int i = 0; i < nthreads; ++i) {
+    uint32_t off = width * i;
+    tasks[i].ctx = ctx;
+    tasks[i].refs = src + off;
+    tasks[i].num = off < rnum ? MIN(width, rnum - off) : 0;
+  }
+  nstarted = jbi_parallel_start(threads, nthreads, _jbi_scan_sorter_task, tasks, sizeof(tasks[0]));
+  for (int i = nstarted; i < nthreads; ++i) { // Sort remaining ranges in the current thread
+    _jbi_scan_sorter_task(&tasks[i]);
+  }
+  jbi_parallel_join(threads, nstarted);
+  for (int i = 0; i < nthreads; ++i) {
+    RCC(rc, finish, tasks[i].rc);
+  }
+
+  // Merge sorted ranges pairwise
+  for (uint32_t w = width; w < rnum; w *= 2) {
+    for (uint32_t lo = 0; lo < rnum; lo += 2 * w) {
+      uint32_t mid = MIN(lo + w, rnum), hi = MIN(lo + 2 * w, rnum);
+      uint32_t i = lo, j = mid, k = lo;
+      while (i < mid && j < hi) {
+        int rv = _jbi_scan_sorter_cmp_impl(ctx, &src[j], &src[i], &rc);
+        RCGO(rc, finish);
+        if (rv < 0) {
+          dst[k++] = src[j++];
+        } else {
+          dst[k++] = src[i++];
+        }
+      }
+      memcpy(dst + k, src + i, (mid - i) * sizeof(src[0]));
+      k += mid - i;
+      memcpy(dst + k, src + j, (hi - j) * sizeof(src[0]));
+    }
+    uint32_t *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  if (src == buf) {
+    buf = ssc->refs;
+    ssc->refs = src;
+    ssc->refs_asz = rnum * sizeof(src[0]);
+  }
+
+finish:
+  free(buf);
+  free(threads);
+  free(tasks);
+  return rc;
+}
+
 static iwrc _jbi_scan_sorter_apply(IWPOOL *pool, struct jbexec *ctx, JQL q, struct ejdb_doc *doc) {
   JBL_NODE root;
   JBL jbl = doc->raw;
   struct jqp_aux *aux = q->aux;
+  if (!(aux->apply || aux->apply_placeholder)) {
+    iwrc rc = jql_project_jbl(q, jbl, &doc->node, ctx, pool);
+    RCRET(rc);
+    if (aux->qmode & JQP_QRY_APPLY_DEL) {
+      rc = jb_del(ctx->jbc, jbl, doc->id);
+    }
+    return rc;
+  }
   iwrc rc = jbl_to_node(jbl, &root, true, pool);
   RCRET(rc);
   doc->node = root;
@@ -73,13 +184,32 @@ static iwrc _jbi_scan_sorter_apply(IWPOOL *pool, struct jbexec *ctx, JQL q, stru
     binn_free(&sn.bn);
     RCRET(rc);
   }
-  if (aux->projection) {
+  if (ctx->projection) {
     rc = jql_project(q, root, ctx->ux->pool, ctx);
   }
   return rc;
 }
 
-static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
+/**
+ * Fetches documents joined by projection to the collected documents `[from, to)`.
+ */
+static iwrc _jbi_scan_sorter_prefetch(struct jbexec *ctx, int64_t from, int64_t to) {
+  int num = 0;
+  struct jbl docs[JB_JOIN_PREFETCH_WINDOW];
+  struct jbssc *ssc = &ctx->ssc;
+  for (int64_t i = from; i < to && num < JB_JOIN_PREFETCH_WINDOW; ++i) {
+    uint8_t *rp = ssc->docs + ssc->refs[i] + sizeof(int64_t) /*id*/;
+    iwrc rc = jbl_from_buf_keep_onstack2(&docs[num++], rp);
+    RCRET(rc);
+  }
+  return jql_proj_joins_prefetch(ctx->ux->q, docs, num, ctx);
+}
+
+/**
+ * Visits collected documents.
+ * In windowed mode `stepp` is set to zero if no more documents should be collected.
+ */
+static iwrc _jbi_scan_sorter_do(struct jbexec *ctx, int64_t *stepp) {
   iwrc rc = 0;
   int64_t step = 1, id;
   struct jbl jbl;
@@ -88,6 +218,8 @@ static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
   uint32_t rnum = ssc->refs_num;
   struct jqp_aux *aux = ux->q->aux;
   IWPOOL *pool = ux->pool;
+  bool joins = ctx->projection && jql_has_projection_joins(ux->q);
+  int64_t i = ctx->windowed ? 0 : ux->skip; // Skipped documents are not collected in windowed mode
 
   if (rnum) {
     if (setjmp(ssc->fatal_jmp)) { // Init error jump
@@ -99,10 +231,31 @@ static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
       RCC(rc, finish, ssc->sof.probe_mmap(&ssc->sof, 0, &ssc->docs, &sp));
     }
 
-    sort_r(ssc->refs, rnum, sizeof(ssc->refs[0]), _jbi_scan_sorter_cmp, ctx);
+    int nthreads = (int) MIN(rnum / JB_PARALLEL_SORT_MIN_REFS, ctx->jbc->db->opts.parallel_threads);
+    if (ctx->windowed || !aux->orderby_num) {
+      // Documents are visited in the order of collecting
+    } else {
+      uint64_t ts = 0, te = 0;
+      if (ux->stats) {
+        RCC(rc, finish, iwp_current_time_ms(&ts, true));
+      }
+      if (nthreads > 1) {
+        RCC(rc, finish, _jbi_scan_sorter_parallel(ctx, nthreads));
+      } else {
+        sort_r(ssc->refs, rnum, sizeof(ssc->refs[0]), _jbi_scan_sorter_cmp, ctx);
+      }
+      if (ux->stats) {
+        RCC(rc, finish, iwp_current_time_ms(&te, true));
+        ctx->stats.sort_ms += te - ts;
+      }
+    }
   }
 
-  for (int64_t i = ux->skip; step && i < rnum && i >= 0; ) {
+  for (int64_t pf = i; step && i < rnum && i >= 0; ) {
+    if (joins && (i >= pf)) {
+      RCC(rc, finish, _jbi_scan_sorter_prefetch(ctx, i, MIN(i + JB_JOIN_PREFETCH_WINDOW, rnum)));
+      pf = i + JB_JOIN_PREFETCH_WINDOW;
+    }
     uint8_t *rp = ssc->docs + ssc->refs[i];
     memcpy(&id, rp, sizeof(id));
     rp += sizeof(id);
@@ -113,7 +266,7 @@ static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
       .raw = &jbl
     };
 
-    if (aux->apply || aux->projection) {
+    if (aux->apply || ctx->projection) {
       if (!pool) {
         pool = iwpool_create((size_t) jbl.bn.size * 2);
         if (!pool) {
@@ -129,7 +282,7 @@ static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
     if (!(aux->qmode & JQP_QRY_AGGREGATE)) {
       do {
         step = 1;
-        RCC(rc, finish, ux->visitor(ux, &doc, &step));
+        RCC(rc, finish, jb_exec_visit(ctx, &doc, &step));
       } while (step == -1);
     }
 
@@ -140,9 +293,16 @@ static iwrc _jbi_scan_sorter_do(struct jbexec *ctx) {
       pool = 0;
     }
     if (--ux->limit < 1) {
+      step = 0;
       break;
     }
   }
+  if (ctx->windowed && (i > rnum)) {
+    // Documents skipped by visitor belong to the next window
+    ux->skip += i - rnum;
+  }
+  // Visitor cannot step back behind the window start
+  *stepp = step ? 1 : 0;
 
 finish:
   if (pool != ux->pool) {
@@ -180,7 +340,8 @@ iwrc jbi_sorter_consumer(
       _jbi_scan_sorter_release(ctx);
       return err;
     } else {
-      return _jbi_scan_sorter_do(ctx);
+      int64_t dstep;
+      return _jbi_scan_sorter_do(ctx, &dstep);
     }
   }
 
@@ -191,41 +352,37 @@ iwrc jbi_sorter_consumer(
   EJDB db = ctx->jbc->db;
   IWFS_EXT *sof = &ssc->sof;
 
-start:
-  {
-    if (cur) {
-      rc = iwkv_cursor_copy_val(cur, ctx->jblbuf + sizeof(id), ctx->jblbufsz - sizeof(id), &vsz);
-    } else {
-      IWKV_val key = {
-        .data = &id,
-        .size = sizeof(id)
-      };
-      rc = iwkv_get_copy(ctx->jbc->cdb, &key, ctx->jblbuf + sizeof(id), ctx->jblbufsz - sizeof(id), &vsz);
-    }
-    if (rc == IWKV_ERROR_NOTFOUND) {
-      rc = 0;
-    } else {
-      RCRET(rc);
-    }
-    if (vsz + sizeof(id) > ctx->jblbufsz) {
-      size_t nsize = MAX(vsz + sizeof(id), ctx->jblbufsz * 2);
-      void *nbuf = realloc(ctx->jblbuf, nsize);
-      if (!nbuf) {
-        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
-      }
-      ctx->jblbuf = nbuf;
-      ctx->jblbufsz = nsize;
-      goto start;
-    }
+  ++ctx->stats.scanned;
+  if (ctx->guarded) {
+    rc = jb_exec_guard(ctx, ctx->stats.scanned);
+    RCRET(rc);
+  }
+  if (ctx->prefilter_num && !jbi_prefilter_matched(ctx, id, &rc)) {
+    *matched = false;
+    return rc;
   }
 
-  rc = jbl_from_buf_keep_onstack(&jbl, ctx->jblbuf + sizeof(id), vsz);
+  rc = jbi_doc_fetch(
+    ctx->jbc, ctx->prematched ? 0 : ctx->ux->q, cur, id, &ctx->jblbuf, &ctx->jblbufsz, &ctx->zbuf, &ctx->zbufsz,
+    sizeof(id), &jbl, &vsz, matched);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    return 0;
+  }
   RCRET(rc);
+  if (ctx->prematched) {
+    *matched = true;
+  }
+  ++ctx->stats.fetched;
+  ctx->stats.bytes += vsz;
 
-  rc = jql_matched(ctx->ux->q, &jbl, matched);
   if (!*matched) {
     return 0;
   }
+  ++ctx->stats.matched;
+  if (ctx->windowed && (ctx->ux->skip > 0)) {
+    --ctx->ux->skip;
+    return 0;
+  }
 
   if (!ssc->refs) {
     ssc->refs_asz = db->opts.document_buffer_sz;
@@ -248,6 +405,9 @@ start:
   }
 
   vsz += sizeof(id);
+  if ((ctx->ux->max_sort_bytes > 0) && (ssc->docs_npos + vsz > (uint64_t) ctx->ux->max_sort_bytes)) {
+    return EJDB_ERROR_QUERY_BUDGET_EXCEEDED;
+  }
   memcpy(ctx->jblbuf, &id, sizeof(id));
 
 start2:
@@ -265,6 +425,7 @@ start2:
           free(ssc->docs);
           ssc->docs = 0;
           ssc->sof_active = true;
+          ctx->stats.spilled = true;
           goto start2;
         } else {
           void *nbuf = realloc(ssc->docs, ssc->docs_asz);
@@ -284,5 +445,9 @@ start2:
     ssc->docs_npos += vsz;
   }
 
+  if (  ctx->windowed
+     && ((ssc->refs_num >= JB_JOIN_PREFETCH_WINDOW) || (ssc->refs_num >= ctx->ux->limit))) {
+    rc = _jbi_scan_sorter_do(ctx, step);
+  }
   return rc;
 }
@@ -235,7 +235,7 @@ void jbi_node_fill_ikey(JBIDX idx, JBL_NODE node, IWKV_val *ikey, char numbuf[st
   }
 }
 
-bool jbi_node_expr_matched(JQP_AUX *aux, JBIDX idx, IWKV_cursor cur, JQP_EXPR *expr, iwrc *rcp) {
+bool jbi_node_expr_matched(JQL q, JBIDX idx, IWKV_cursor cur, JQP_EXPR *expr, iwrc *rcp) {
   size_t sz;
   char skey[1024];
   char *kbuf = skey;
@@ -245,7 +245,7 @@ bool jbi_node_expr_matched(JQP_AUX *aux, JBIDX idx, IWKV_cursor cur, JQP_EXPR *e
   if (!(idx->mode & (EJDB_IDX_STR | EJDB_IDX_I64 | EJDB_IDX_F64))) {
     return false;
   }
-  JQVAL lv, *rv = jql_unit_to_jqval(aux, expr->right, &rc);
+  JQVAL lv, *rv = jql_unit_to_jqval(q, expr->right, &rc);
   RCGO(rc, finish);
 
   rc = iwkv_cursor_copy_key(cur, kbuf, sizeof(skey) - 1, &sz, 0);
@@ -272,7 +272,12 @@ bool jbi_node_expr_matched(JQP_AUX *aux, JBIDX idx, IWKV_cursor cur, JQP_EXPR *e
     lv.vf64 = (double) iwatof(kbuf);
   }
 
-  ret = jql_match_jqval_pair(aux, &lv, expr->op, rv, &rc);
+  if (expr->op->value == JQP_OP_RE) { // Index scan range is bounded by regexp literal prefix
+    const char *prefix = jql_expr_regexp_prefix(q, expr, &rc);
+    ret = !rc && (lv.type == JQVAL_STR) && !strncmp(lv.vstr, prefix, strlen(prefix));
+  } else {
+    ret = jql_match_jqval_pair(q, &lv, expr->op, rv, &rc);
+  }
 
 finish:
   if (kbuf != skey) {
@@ -281,3 +286,131 @@ finish:
   *rcp = rc;
   return ret;
 }
+
+/**
+ * Checks required equality expressions on indexed fields by index lookups of entry `id`,
+ * so entries which will not match query are rejected without document fetch.
+ */
+bool jbi_prefilter_matched(struct jbexec *ctx, int64_t id, iwrc *rcp) {
+  size_t sz;
+  uint64_t vid;
+  IWKV_val key;
+  char numbuf[IWNUMBUF_SIZE];
+  char vnbuf[IWNUMBUF_SIZE];
+  iwrc rc = 0;
+
+  for (int i = 0; i < ctx->prefilter_num; ++i) {
+    struct jbprobe *p = &ctx->prefilter[i];
+    JQVAL *rv = jql_unit_to_jqval(ctx->ux->q, p->expr->right, &rc);
+    RCGO(rc, finish);
+    jbi_jqval_fill_ikey(p->idx, rv, &key, numbuf);
+    if (!key.size) {
+      continue;
+    }
+    if (p->idx->idbf & IWDB_COMPOUND_KEYS) {
+      key.compound = id;
+      rc = iwkv_get_copy(p->idx->idb, &key, vnbuf, sizeof(vnbuf), &sz);
+    } else {
+      // Unique index: document id is stored as index entry value
+      rc = iwkv_get_copy(p->idx->idb, &key, vnbuf, sizeof(vnbuf), &sz);
+      if (!rc) {
+        IW_READVNUMBUF64_2(vnbuf, vid);
+        if (vid != (uint64_t) id) {
+          rc = IWKV_ERROR_NOTFOUND;
+        }
+      }
+    }
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      rc = 0;
+      ++ctx->stats.prefiltered;
+      *rcp = 0;
+      return false;
+    }
+    RCGO(rc, finish);
+  }
+
+finish:
+  *rcp = rc;
+  return rc == 0;
+}
+
+/**
+ * Reads document `id` into the reusable scan buffer `*bufp` at offset `off`
+ * then unpacks it and initializes `jbl` as view over buffer data.
+ * The resulting `jbl` is valid until the next fetch into the same buffer,
+ * so consumers should copy document data only when it is emitted.
+ * If query `q` is given document is matched against it, large documents
+ * rejected by their summary are not fetched and `jbl` is not initialized.
+ */
+iwrc jbi_doc_fetch(
+  struct jbcoll *jbc, struct jql *q, struct iwkv_cursor *cur, int64_t id, uint8_t **bufp, size_t *bufszp,
+  uint8_t **zbufp, size_t *zbufszp, size_t off, struct jbl *jbl, size_t *vszp, bool *matched) {
+  iwrc rc;
+  size_t vsz = 0;
+  struct iwkv_val key = {
+    .data = &id,
+    .size = sizeof(id)
+  };
+  if (*bufszp < off) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  while (1) {
+    if (cur) {
+      rc = iwkv_cursor_copy_val(cur, *bufp + off, *bufszp - off, &vsz);
+    } else {
+      rc = iwkv_get_copy(jbc->cdb, &key, *bufp + off, *bufszp - off, &vsz);
+    }
+    RCRET(rc);
+    if (vsz + off <= *bufszp) {
+      break;
+    }
+    // Buffer is grown with headroom so subsequent documents of similar size are read by single copy
+    size_t nsize = MAX(vsz + off, *bufszp * 2);
+    void *nbuf = realloc(*bufp, nsize);
+    if (!nbuf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    *bufp = nbuf;
+    *bufszp = nsize;
+  }
+  if (q && jbi_doc_is_large(*bufp + off, vsz)) {
+    if (jbi_xdoc_summary_matched(q, *bufp + off, vsz, matched, &rc) && !*matched) {
+      if (vszp) {
+        *vszp = vsz;
+      }
+      return 0;
+    }
+    RCRET(rc);
+  }
+  RCRET(jbi_doc_unpack_buf(jbc, bufp, bufszp, zbufp, zbufszp, off, &vsz));
+  RCRET(jbl_from_buf_keep_onstack(jbl, *bufp + off, vsz));
+  if (vszp) {
+    *vszp = vsz;
+  }
+  if (q) {
+    rc = jql_matched(q, jbl, matched);
+  }
+  return rc;
+}
+
+/**
+ * Fetches document `id` visited by query scanner into `ctx->jblbuf` using `jbi_doc_fetch()`.
+ * Document assembled from collection columns by columnar scanner is matched as is,
+ * documents already matched by parallel scan workers are not matched again.
+ */
+iwrc jbi_scan_doc_fetch(
+  struct jbexec *ctx, struct iwkv_cursor *cur, int64_t id, struct jbl *jbl, size_t *vszp,
+  bool *matched) {
+  if (ctx->coldoc) {
+    *jbl = *ctx->coldoc;
+    *vszp = (size_t) jbl->bn.size;
+    return jql_matched(ctx->ux->q, jbl, matched);
+  }
+  iwrc rc = jbi_doc_fetch(
+    ctx->jbc, ctx->prematched ? 0 : ctx->ux->q, cur, id, &ctx->jblbuf, &ctx->jblbufsz, &ctx->zbuf, &ctx->zbufsz, 0,
+    jbl, vszp, matched);
+  if (!rc && ctx->prematched) {
+    *matched = true;
+  }
+  return rc;
+}
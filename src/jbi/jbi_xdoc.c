@@ -0,0 +1,309 @@
+#include "ejdb2_internal.h"
+
+// Out-of-line storage of large documents.
+//
+// Stored document larger than `EJDB_OPTS.large_document_sz` is replaced in collection database by stub:
+// [JB_XDOC:1][document id:8][summary size:4 LE][summary object][omitted keys list]
+// Summary object keeps small top level fields of document, names of other top level fields
+// are listed in omitted keys list. Document body is stored in `ejdb.xdb` as is.
+// Query is matched against summary when all top level fields used by query filters are in summary,
+// so only matched documents bodies are fetched.
+
+IW_INLINE void _jbi_xdoc_key(uint32_t dbid, int64_t id, uint8_t kbuf[static JB_XDOC_KEY_SIZE]) {
+  uint64_t llv = (uint64_t) id;
+  for (int i = 3; i >= 0; --i) {
+    kbuf[i] = dbid & 0xffU;
+    dbid >>= 8;
+  }
+  for (int i = JB_XDOC_KEY_SIZE - 1; i >= 4; --i) {
+    kbuf[i] = llv & 0xffU;
+    llv >>= 8;
+  }
+}
+
+IW_INLINE int64_t _jbi_xdoc_id(const uint8_t *stub) {
+  int64_t id;
+  memcpy(&id, stub + 1, sizeof(id));
+  return IW_ITOHLL(id);
+}
+
+IW_INLINE uint32_t _jbi_xdoc_summary_size(const uint8_t *stub) {
+  uint32_t lv;
+  memcpy(&lv, stub + 1 + sizeof(int64_t), sizeof(lv));
+  return IW_ITOHL(lv);
+}
+
+bool jbi_xdoc_needed(struct jbcoll *jbc, size_t sz) {
+  struct ejdb *db = jbc->db;
+  return db->xdb && db->opts.large_document_sz && sz > db->opts.large_document_sz;
+}
+
+/**
+ * Replaces packed document `val` of collection `jbc` by document stub allocated in `*xbufp`.
+ * Summary of stub is built from unpacked document `doc`.
+ */
+iwrc jbi_xdoc_stub(struct jbcoll *jbc, int64_t id, const void *doc, size_t docsz, struct iwkv_val *val, void **xbufp) {
+  iwrc rc = 0;
+  binn bv;
+  binn_iter iter;
+  char *key, kbuf[256];
+  int klen;
+  uint32_t ssz = 0;
+  binn *summary = 0, *omitted = 0;
+
+  *xbufp = 0;
+  RCA(omitted = binn_list(), finish);
+  if (docsz && (*(const uint8_t*) doc == BINN_OBJECT)) {
+    RCA(summary = binn_object(), finish);
+    if (!binn_iter_init(&iter, (void*) doc, BINN_OBJECT)) {
+      rc = JBL_ERROR_INVALID;
+      goto finish;
+    }
+    while (binn_read_next_pair2(BINN_OBJECT, &iter, &klen, &key, &bv)) {
+      memcpy(kbuf, key, klen);
+      kbuf[klen] = '\0';
+      bool ok;
+      if (  (bv.size <= JB_XDOC_FIELD_MAX)
+         && (binn_size(summary) + klen + bv.size + 8 <= JB_XDOC_SUMMARY_MAX)) {
+        ok = binn_object_set_value(summary, kbuf, &bv);
+      } else {
+        ok = binn_list_add_str(omitted, kbuf);
+      }
+      if (!ok) {
+        rc = JBL_ERROR_CREATION;
+        goto finish;
+      }
+    }
+    ssz = binn_size(summary);
+  }
+
+  int osz = binn_size(omitted);
+  uint8_t *stub = malloc(JB_XDOC_HDR_SIZE + ssz + osz);
+  RCA(stub, finish);
+  int64_t llv = IW_HTOILL(id);
+  uint32_t lv = IW_HTOIL(ssz);
+  stub[0] = JB_XDOC;
+  memcpy(stub + 1, &llv, sizeof(llv));
+  memcpy(stub + 1 + sizeof(llv), &lv, sizeof(lv));
+  if (ssz) {
+    memcpy(stub + JB_XDOC_HDR_SIZE, binn_ptr(summary), ssz);
+  }
+  memcpy(stub + JB_XDOC_HDR_SIZE + ssz, binn_ptr(omitted), osz);
+  val->data = stub;
+  val->size = JB_XDOC_HDR_SIZE + ssz + osz;
+  *xbufp = stub;
+
+finish:
+  if (summary) {
+    binn_free(summary);
+  }
+  if (omitted) {
+    binn_free(omitted);
+  }
+  return rc;
+}
+
+/**
+ * Stores body `val` of large document `id` of collection `jbc`.
+ */
+iwrc jbi_xdoc_put(struct jbcoll *jbc, int64_t id, struct iwkv_val *val) {
+  uint8_t xkey[JB_XDOC_KEY_SIZE];
+  _jbi_xdoc_key(jbc->dbid, id, xkey);
+  struct iwkv_val xk = {
+    .data = xkey,
+    .size = sizeof(xkey)
+  };
+  return iwkv_put(jbc->db->xdb, &xk, val, 0);
+}
+
+/**
+ * Replaces document stub `val` allocated by `malloc()` with document body.
+ */
+iwrc jbi_xdoc_load(struct jbcoll *jbc, struct iwkv_val *val) {
+  struct iwkv_val bval;
+  uint8_t xkey[JB_XDOC_KEY_SIZE];
+  if (!jbc->db->xdb) {
+    return IWKV_ERROR_CORRUPTED;
+  }
+  _jbi_xdoc_key(jbc->dbid, _jbi_xdoc_id(val->data), xkey);
+  struct iwkv_val xk = {
+    .data = xkey,
+    .size = sizeof(xkey)
+  };
+  iwrc rc = iwkv_get(jbc->db->xdb, &xk, &bval);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = IWKV_ERROR_CORRUPTED;
+  }
+  RCRET(rc);
+  free(val->data);
+  *val = bval;
+  return 0;
+}
+
+/**
+ * Replaces document stub placed in buffer `*bufp` at offset `off` with document body.
+ */
+iwrc jbi_xdoc_load_buf(struct jbcoll *jbc, uint8_t **bufp, size_t *bufszp, size_t off, size_t *vszp) {
+  iwrc rc;
+  size_t vsz = 0;
+  uint8_t xkey[JB_XDOC_KEY_SIZE];
+  if (!jbc->db->xdb) {
+    return IWKV_ERROR_CORRUPTED;
+  }
+  _jbi_xdoc_key(jbc->dbid, _jbi_xdoc_id(*bufp + off), xkey);
+  struct iwkv_val xk = {
+    .data = xkey,
+    .size = sizeof(xkey)
+  };
+  while (1) {
+    rc = iwkv_get_copy(jbc->db->xdb, &xk, *bufp + off, *bufszp - off, &vsz);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      rc = IWKV_ERROR_CORRUPTED;
+    }
+    RCRET(rc);
+    if (vsz + off <= *bufszp) {
+      break;
+    }
+    size_t nsize = MAX(vsz + off, *bufszp * 2);
+    void *nbuf = realloc(*bufp, nsize);
+    if (!nbuf) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    *bufp = nbuf;
+    *bufszp = nsize;
+  }
+  *vszp = vsz;
+  return 0;
+}
+
+static bool _jbi_xdoc_field_in_summary(const char *field, jqp_string_flavours_t flavour, void *omitted) {
+  binn bv;
+  binn_iter iter;
+  if (flavour & (JQP_STR_PLACEHOLDER | JQP_STR_STAR | JQP_STR_DBL_STAR)) {
+    return false;
+  }
+  if (!binn_iter_init(&iter, omitted, BINN_LIST)) {
+    return false;
+  }
+  while (binn_list_next(&iter, &bv)) {
+    if ((bv.type == BINN_STRING) && !strcmp(bv.ptr, field)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+static bool _jbi_xdoc_expr_in_summary(const struct jqp_expr_node *en, void *omitted) {
+  if (en->flags & JQP_EXPR_NODE_FLAG_PK) {
+    return true;
+  }
+  if (en->type == JQP_EXPR_NODE_TYPE) {
+    for (const struct jqp_expr_node *cn = en->chain; cn; cn = cn->next) {
+      if (!_jbi_xdoc_expr_in_summary(cn, omitted)) {
+        return false;
+      }
+    }
+    return true;
+  } else if (en->type == JQP_FILTER_TYPE) {
+    const JQP_NODE *n = ((const JQP_FILTER*) en)->node;
+    if (!n) {
+      return false;
+    }
+    if (n->ntype == JQP_NODE_FIELD) {
+      return _jbi_xdoc_field_in_summary(n->value->string.value, n->value->string.flavour, omitted);
+    } else if (n->ntype == JQP_NODE_EXPR) {
+      for (const JQP_EXPR *expr = &n->value->expr; expr; expr = expr->next) {
+        const JQPUNIT *left = expr->left;
+        if (  (left->type != JQP_STRING_TYPE)
+           || !_jbi_xdoc_field_in_summary(left->string.value, left->string.flavour, omitted)) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Matches query `q` against summary of large document stub.
+ * Returns false if summary doesn't contain all top level fields used by query filters
+ * so document body should be matched instead.
+ */
+bool jbi_xdoc_summary_matched(struct jql *q, const uint8_t *stub, size_t stubsz, bool *matched, iwrc *rcp) {
+  struct jbl sjbl;
+  *rcp = 0;
+  uint32_t ssz = _jbi_xdoc_summary_size(stub);
+  if (!ssz || (JB_XDOC_HDR_SIZE + ssz >= stubsz)) {
+    return false;
+  }
+  void *omitted = (void*) (stub + JB_XDOC_HDR_SIZE + ssz);
+  struct jqp_expr_node *en = q->aux->expr;
+  for ( ; en; en = en->next) {
+    if (!_jbi_xdoc_expr_in_summary(en, omitted)) {
+      return false;
+    }
+  }
+  iwrc rc = jbl_from_buf_keep_onstack(&sjbl, (void*) (stub + JB_XDOC_HDR_SIZE), ssz);
+  if (!rc) {
+    rc = jql_matched(q, &sjbl, matched);
+  }
+  *rcp = rc;
+  return rc == 0;
+}
+
+iwrc jbi_xdoc_del(struct jbcoll *jbc, int64_t id) {
+  uint8_t xkey[JB_XDOC_KEY_SIZE];
+  if (!jbc->db->xdb) {
+    return 0;
+  }
+  _jbi_xdoc_key(jbc->dbid, id, xkey);
+  struct iwkv_val xk = {
+    .data = xkey,
+    .size = sizeof(xkey)
+  };
+  iwrc rc = iwkv_del(jbc->db->xdb, &xk, 0);
+  if (rc == IWKV_ERROR_NOTFOUND) {
+    rc = 0;
+  }
+  return rc;
+}
+
+/**
+ * Removes bodies of large documents of collection database `dbid`.
+ * Called under database write lock.
+ */
+iwrc jbi_xdoc_remove_all(struct ejdb *db, uint32_t dbid) {
+  iwrc rc = 0;
+  size_t sz;
+  uint8_t xkey[JB_XDOC_KEY_SIZE], ckey[JB_XDOC_KEY_SIZE];
+  struct iwkv_cursor *cur;
+  if (!db->xdb) {
+    return 0;
+  }
+  _jbi_xdoc_key(dbid, 0, xkey);
+  struct iwkv_val xk = {
+    .data = xkey,
+    .size = sizeof(xkey)
+  };
+  while (1) {
+    rc = iwkv_cursor_open(db->xdb, &cur, IWKV_CURSOR_GE, &xk);
+    if (rc == IWKV_ERROR_NOTFOUND) {
+      return 0;
+    }
+    RCRET(rc);
+    rc = iwkv_cursor_copy_key(cur, ckey, sizeof(ckey), &sz, 0);
+    iwkv_cursor_close(&cur);
+    RCRET(rc);
+    if ((sz != sizeof(ckey)) || memcmp(ckey, xkey, 4)) {
+      return 0;
+    }
+    struct iwkv_val ck = {
+      .data = ckey,
+      .size = sizeof(ckey)
+    };
+    RCRET(iwkv_del(db->xdb, &ck, 0));
+  }
+  return rc;
+}
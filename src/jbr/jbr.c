@@ -26,6 +26,14 @@ struct jbr {
   EJDB db;
 };
 
+/** Query execution limits requested by client */
+struct jbr_budget {
+  int64_t timeout_ms;
+  int64_t max_scanned;
+  int64_t max_sort_bytes;
+  int64_t max_output_bytes;
+};
+
 struct rctx {
   struct iwn_wf_req  *req;
   struct iwn_ws_sess *ws;
@@ -34,8 +42,10 @@ struct rctx {
   pthread_mutex_t mtx;
   pthread_cond_t  cond;
   EJDB_EXEC       ux;
+  struct jbr_budget budget;     /**< Query limits of websocket session */
   int64_t   id;
   pthread_t request_thread;
+  volatile bool cancelled;      /**< Client is not able to receive query results anymore */
   bool      read_anon;
   bool      visitor_started;
   bool      visitor_finished;
@@ -321,7 +331,9 @@ start:
   } else {
     rc = iwn_http_response_chunk_end(req);
   }
-
+  if (rc) {
+    ctx->cancelled = true; // Stop query execution since client is gone
+  }
   return rc == 0;
 }
 
@@ -365,23 +377,128 @@ finish:
   return rc;
 }
 
+static int64_t _budget_min(int64_t server, int64_t client) {
+  if ((server > 0) && (client > 0)) {
+    return MIN(server, client);
+  }
+  return server > 0 ? server : client > 0 ? client : 0;
+}
+
+/**
+ * Sets query execution limits: server side limits can only be lowered by client.
+ */
+static void _budget_apply(struct rctx *ctx, const struct jbr_budget *b, EJDB_EXEC *ux) {
+  const EJDB_HTTP *http = ctx->jbr->http;
+  ux->timeout_ms = (uint32_t) MIN(_budget_min(http->query_timeout_ms, b->timeout_ms), UINT32_MAX);
+  ux->max_scanned = _budget_min(http->query_max_scanned, b->max_scanned);
+  ux->max_sort_bytes = _budget_min(http->query_max_sort_bytes, b->max_sort_bytes);
+  ux->max_output_bytes = _budget_min(http->query_max_output_bytes, b->max_output_bytes);
+  ux->cancel = &ctx->cancelled;
+}
+
+static int64_t _header_i64(struct rctx *ctx, const char *name, size_t name_len) {
+  struct iwn_val val = iwn_http_request_header_get(ctx->req->http, name, name_len);
+  if (!val.len) {
+    return 0;
+  }
+  char buf[val.len + 1];
+  memcpy(buf, val.buf, val.len);
+  buf[val.len] = '\0';
+  return iwatoi(buf);
+}
+
+/**
+ * Binds query placeholders from JSON `params` object (named placeholders)
+ * or array (positional `?` placeholders).
+ */
+static iwrc _query_bind_params(JQL q, JBL_NODE params) {
+  iwrc rc = 0;
+  int idx = 0;
+  for (JBL_NODE n = params->child; n && !rc; n = n->next, ++idx) {
+    const char *name = 0;
+    char nbuf[params->type == JBV_OBJECT ? n->klidx + 1 : 1];
+    if (params->type == JBV_OBJECT) {
+      memcpy(nbuf, n->key, n->klidx);
+      nbuf[n->klidx] = '\0';
+      name = nbuf;
+    }
+    switch (n->type) {
+      case JBV_NULL:
+        rc = jql_set_null(q, name, idx);
+        break;
+      case JBV_BOOL:
+        rc = jql_set_bool(q, name, idx, n->vbool);
+        break;
+      case JBV_I64:
+        rc = jql_set_i64(q, name, idx, n->vi64);
+        break;
+      case JBV_F64:
+        rc = jql_set_f64(q, name, idx, n->vf64);
+        break;
+      case JBV_STR:
+        rc = jql_set_str3(q, name, idx, n->vptr, n->vsize);
+        break;
+      default:
+        rc = jql_set_json(q, name, idx, n);
+        break;
+    }
+  }
+  return rc;
+}
+
 static int _on_query(struct rctx *ctx) {
   if (ctx->req->body_len < 1) {
     return 400;
   }
   iwrc rc = 0;
   int ret = 500;
+  IWPOOL *pool = 0;
+  JBL_NODE params = 0;
+  char *page_header = 0;
+  const char *page = 0;
+  const char *query = ctx->req->body;
 
   ctx->ux.opaque = ctx;
   ctx->ux.db = ctx->jbr->db;
   ctx->ux.visitor = _query_visitor;
 
+  while (isspace((unsigned char) *query)) {
+    ++query;
+  }
+  if (*query == '{') { // JSON body: {"query": "...", "params": {...} | [...]}
+    JBL_NODE n, root;
+    query = 0;
+    RCA(pool = iwpool_create(ctx->req->body_len), finish);
+    if (jbn_from_json(ctx->req->body, &root, pool) || root->type != JBV_OBJECT) {
+      ret = 400;
+      goto finish;
+    }
+    for (n = root->child; n; n = n->next) {
+      if (n->type == JBV_STR && n->klidx == IW_LLEN("query") && !strncmp(n->key, "query", n->klidx)) {
+        query = n->vptr;
+      } else if (  (n->type == JBV_OBJECT || n->type == JBV_ARRAY)
+                && n->klidx == IW_LLEN("params") && !strncmp(n->key, "params", n->klidx)) {
+        params = n;
+      } else if (n->type == JBV_STR && n->klidx == IW_LLEN("page") && !strncmp(n->key, "page", n->klidx)) {
+        page = n->vptr;
+      }
+    }
+    if (!query) {
+      ret = 400;
+      goto finish;
+    }
+  }
+
   RCC(rc, finish,
-      jql_create2(&ctx->ux.q, 0, ctx->req->body, JQL_SILENT_ON_PARSE_ERROR | JQL_KEEP_QUERY_ON_PARSE_ERROR));
+      ejdb_query_prepared(ctx->ux.db, 0, query,
+                          JQL_SILENT_ON_PARSE_ERROR | JQL_KEEP_QUERY_ON_PARSE_ERROR, &ctx->ux.q));
 
   if (ctx->read_anon && jql_has_apply(ctx->ux.q)) {
-    jql_destroy(&ctx->ux.q);
-    return 403;
+    ret = 403;
+    goto finish;
+  }
+  if (params) {
+    RCC(rc, finish, _query_bind_params(ctx->ux.q, params));
   }
 
   struct iwn_val val = iwn_http_request_header_get(ctx->req->http, "x-hints", IW_LLEN("x-hints"));
@@ -389,13 +506,55 @@ static int _on_query(struct rctx *ctx) {
     char buf[val.len + 1];
     memcpy(buf, val.buf, val.len);
     buf[val.len] = '\0';
-    if (strstr(buf, "explain")) {
+    if (strstr(buf, "explain") || strstr(buf, "analyze")) {
       RCA(ctx->ux.log = iwxstr_new(), finish);
     }
+    if (strstr(buf, "analyze")) {
+      RCA(ctx->ux.stats = iwxstr_new(), finish);
+    }
+  }
+
+  val = iwn_http_request_header_get(ctx->req->http, "x-page", IW_LLEN("x-page"));
+  if (val.len) { // `-` is used to request the first page
+    RCA(page_header = strndup(val.buf, val.len), finish);
+    page = strcmp(page_header, "-") ? page_header : "";
+  }
+  if (page) {
+    RCA(ctx->ux.next_page_token = iwxstr_new(), finish);
+    ctx->ux.page_token = page;
   }
 
+  _budget_apply(ctx, &(struct jbr_budget) {
+    .timeout_ms = _header_i64(ctx, "x-timeout", IW_LLEN("x-timeout")),
+    .max_scanned = _header_i64(ctx, "x-max-scanned", IW_LLEN("x-max-scanned")),
+    .max_sort_bytes = _header_i64(ctx, "x-max-sort-bytes", IW_LLEN("x-max-sort-bytes")),
+    .max_output_bytes = _header_i64(ctx, "x-max-output-bytes", IW_LLEN("x-max-output-bytes"))
+  }, &ctx->ux);
+
   rc = ejdb_exec(&ctx->ux);
 
+  if (  !rc && ctx->visitor_started
+     && (ctx->ux.stats || (ctx->ux.next_page_token && iwxstr_size(ctx->ux.next_page_token)))) {
+    // Query execution statistics and continuation token of the next page as the last lines of response
+    iwrc rc2 = 0;
+    IWXSTR *xstr = iwxstr_new();
+    if (xstr && ctx->ux.stats) {
+      rc2 = iwxstr_printf(xstr, "\r\nstats\t%s", iwxstr_ptr(ctx->ux.stats));
+    }
+    if (xstr && !rc2 && ctx->ux.next_page_token && iwxstr_size(ctx->ux.next_page_token)) {
+      rc2 = iwxstr_printf(xstr, "\r\nnext\t%s", iwxstr_ptr(ctx->ux.next_page_token));
+    }
+    if (xstr && !rc2) {
+      size_t sz = iwxstr_size(xstr);
+      char *buf = iwxstr_destroy_keep_ptr(xstr);
+      pthread_mutex_lock(&ctx->mtx);
+      iwn_val_add_new(&ctx->vals, buf, sz);
+      pthread_mutex_unlock(&ctx->mtx);
+    } else {
+      iwxstr_destroy(xstr);
+    }
+  }
+
   pthread_mutex_lock(&ctx->mtx);
   ctx->visitor_finished = true;
   pthread_cond_broadcast(&ctx->cond);
@@ -404,6 +563,9 @@ static int _on_query(struct rctx *ctx) {
 
   if (!ctx->visitor_started) {
     if (ctx->ux.log) {
+      if (ctx->ux.stats) {
+        iwxstr_printf(ctx->ux.log, "stats\t%s\n", iwxstr_ptr(ctx->ux.stats));
+      }
       iwxstr_cat(ctx->ux.log, "--------------------", 20);
       if (jql_has_aggregate_count(ctx->ux.q)) {
         iwxstr_printf(ctx->ux.log, "\n%" PRId64, ctx->ux.cnt);
@@ -432,9 +594,18 @@ finish:
         break;
       }
       case JQL_ERROR_NO_COLLECTION:
+      case EJDB_ERROR_INVALID_PAGE_TOKEN:
+      case JQL_ERROR_INVALID_PLACEHOLDER:
+      case JQL_ERROR_UNSET_PLACEHOLDER:
+      case JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE:
         ret = 400;
         JBR_RC_REPORT(ret, ctx->req->http, rc);
         break;
+      case EJDB_ERROR_QUERY_TIMEOUT:
+      case EJDB_ERROR_QUERY_BUDGET_EXCEEDED:
+        ret = 503;
+        JBR_RC_REPORT(ret, ctx->req->http, rc);
+        break;
       default:
         JBR_RC_REPORT(ret, ctx->req->http, rc);
         break;
@@ -442,6 +613,10 @@ finish:
   }
   jql_destroy(&ctx->ux.q);
   iwxstr_destroy(ctx->ux.log);
+  iwxstr_destroy(ctx->ux.stats);
+  iwxstr_destroy(ctx->ux.next_page_token);
+  iwpool_destroy(pool);
+  free(page_header);
   return ret;
 }
 
@@ -549,10 +724,14 @@ typedef enum {
   JBWS_PATCH,
   JBWS_QUERY,
   JBWS_EXPLAIN,
+  JBWS_ANALYZE,
   JBWS_INFO,
+  JBWS_PROFILE,
   JBWS_IDX,
   JBWS_NIDX,
   JBWS_REMOVE_COLL,
+  JBWS_PAGE,
+  JBWS_BUDGET,
 } jbws_e;
 
 static int _on_ws_session_http(struct iwn_wf_req *req, struct iwn_ws_handler_spec *spec) {
@@ -611,7 +790,7 @@ static bool _ws_rc_send(struct iwn_ws_sess *ws, const char *key, iwrc rc, const
   return _ws_error_send(ws, key, error ? error : "unknown", extra);
 }
 
-static bool _ws_info(struct iwn_ws_sess *ws, struct mctx *mctx) {
+static bool _ws_info(struct iwn_ws_sess *ws, struct mctx *mctx, bool profile) {
   iwrc rc;
   JBL jbl = 0;
   IWXSTR *xstr = 0;
@@ -621,7 +800,11 @@ static bool _ws_info(struct iwn_ws_sess *ws, struct mctx *mctx) {
     rc = JBR_ERROR_WS_ACCESS_DENIED;
     goto finish;
   }
-  RCC(rc, finish, ejdb_get_meta(ctx->jbr->db, &jbl));
+  if (profile) {
+    RCC(rc, finish, ejdb_get_query_profile(ctx->jbr->db, &jbl));
+  } else {
+    RCC(rc, finish, ejdb_get_meta(ctx->jbr->db, &jbl));
+  }
   RCA(xstr = iwxstr_new2((size_t) jbl->bn.size * 2), finish);
   RCC(rc, finish, iwxstr_printf(xstr, "%s\t", mctx->key));
   RCC(rc, finish, jbl_as_json(jbl, jbl_xstr_json_printer, xstr, JBL_PRINT_PRETTY));
@@ -811,6 +994,8 @@ static iwrc _ws_query_visitor(EJDB_EXEC *ux, EJDB_DOC doc, int64_t *step) {
     RCC(rc, finish, jbl_as_json(doc->raw, jbl_xstr_json_printer, mctx->wbuf, 0));
   }
   if (!iwn_ws_server_write(mctx->ctx->ws, iwxstr_ptr(mctx->wbuf), iwxstr_size(mctx->wbuf))) {
+    // Websocket session is closed, query is stopped and subsequent queries of session are cancelled
+    mctx->ctx->cancelled = true;
     *step = 0;
   }
 
@@ -818,7 +1003,9 @@ finish:
   return rc;
 }
 
-static bool _ws_query(struct iwn_ws_sess *ws, struct mctx *mctx, const char *query, bool explain) {
+static bool _ws_query(
+  struct iwn_ws_sess *ws, struct mctx *mctx, const char *query, bool explain,
+  bool analyze, const char *page) {
   iwrc rc;
   bool ret = false;
   struct rctx *ctx = mctx->ctx;
@@ -830,20 +1017,35 @@ static bool _ws_query(struct iwn_ws_sess *ws, struct mctx *mctx, const char *que
   };
 
   RCC(rc, finish,
-      jql_create2(&ux.q, mctx->cname, query, JQL_SILENT_ON_PARSE_ERROR | JQL_KEEP_QUERY_ON_PARSE_ERROR));
+      ejdb_query_prepared(ux.db, mctx->cname, query,
+                          JQL_SILENT_ON_PARSE_ERROR | JQL_KEEP_QUERY_ON_PARSE_ERROR, &ux.q));
   if (ctx->read_anon && jql_has_apply(ux.q)) {
     rc = JBR_ERROR_WS_ACCESS_DENIED;
     goto finish;
   }
-  if (explain) {
+  if (explain || analyze) {
     RCA(ux.log = iwxstr_new(), finish);
   }
+  if (analyze) {
+    RCA(ux.stats = iwxstr_new(), finish);
+  }
+  if (page) {
+    RCA(ux.next_page_token = iwxstr_new(), finish);
+    ux.page_token = page;
+  }
+  _budget_apply(ctx, &ctx->budget, &ux);
   RCC(rc, finish, ejdb_exec(&ux));
   if (ux.log) {
     ret = iwn_ws_server_printf(mctx->ctx->ws, "%s\texplain\t%s", mctx->key, iwxstr_ptr(ux.log));
   } else {
     ret = true;
   }
+  if (ret && ux.stats) {
+    ret = iwn_ws_server_printf(ws, "%s\tstats\t%s", mctx->key, iwxstr_ptr(ux.stats));
+  }
+  if (ret && ux.next_page_token && iwxstr_size(ux.next_page_token)) {
+    ret = iwn_ws_server_printf(ws, "%s\tnext\t%s", mctx->key, iwxstr_ptr(ux.next_page_token));
+  }
 
 finish:
   if (rc) {
@@ -866,9 +1068,38 @@ finish:
   }
   jql_destroy(&ux.q);
   iwxstr_destroy(ux.log);
+  iwxstr_destroy(ux.stats);
+  iwxstr_destroy(ux.next_page_token);
   return ret;
 }
 
+/**
+ * Sets query limits of websocket session:
+ * `<timeout ms> [<max scanned> [<max sort bytes> [<max output bytes>]]]`
+ */
+static bool _ws_budget(struct iwn_ws_sess *ws, struct mctx *mctx, const char *args) {
+  int64_t vals[4] = { 0 };
+  for (int i = 0; i < sizeof(vals) / sizeof(vals[0]); ++i) {
+    char *ep;
+    for ( ; isspace(*args); ++args);
+    if (*args == '\0') {
+      break;
+    }
+    vals[i] = strtoll(args, &ep, 10);
+    if ((ep == args) || (vals[i] < 0) || (*ep != '\0' && !isspace(*ep))) {
+      return _ws_rc_send(ws, mctx->key, JBR_ERROR_WS_INVALID_MESSAGE, "Invalid budget value");
+    }
+    args = ep;
+  }
+  mctx->ctx->budget = (struct jbr_budget) {
+    .timeout_ms = vals[0],
+    .max_scanned = vals[1],
+    .max_sort_bytes = vals[2],
+    .max_output_bytes = vals[3]
+  };
+  return iwn_ws_server_write(ws, mctx->key, -1);
+}
+
 static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const char *msg_, size_t len) {
   if (len < 1) {
     return true;
@@ -891,6 +1122,7 @@ static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const cha
   if (len == 1 && msg[0] == '?') {
     static const char help[]
       = "<key> info"
+        "\n<key> profile"
         "\n<key> get     <collection> <id>"
         "\n<key> set     <collection> <id> <document json>"
         "\n<key> add     <collection> <document json>"
@@ -901,6 +1133,9 @@ static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const cha
         "\n<key> rmc     <collection>"
         "\n<key> query   <collection> <query>"
         "\n<key> explain <collection> <query>"
+        "\n<key> analyze <collection> <query>"
+        "\n<key> page    <collection> <page token | -> <query>"
+        "\n<key> budget  <timeout ms> [max scanned] [max sort bytes] [max output bytes]"
         "\n<key> <query>";
     return iwn_ws_server_write(ws, help, sizeof(help) - 1);
   }
@@ -941,20 +1176,32 @@ static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const cha
       wsop = JBWS_PATCH;
     } else if (!strncmp("explain", msg, pos)) {
       wsop = JBWS_EXPLAIN;
+    } else if (!strncmp("analyze", msg, pos)) {
+      wsop = JBWS_ANALYZE;
     } else if (!strncmp("info", msg, pos)) {
       wsop = JBWS_INFO;
+    } else if (!strncmp("profile", msg, pos)) {
+      wsop = JBWS_PROFILE;
     } else if (!strncmp("idx", msg, pos)) {
       wsop = JBWS_IDX;
     } else if (!strncmp("rmi", msg, pos)) {
       wsop = JBWS_NIDX;
     } else if (!strncmp("rmc", msg, pos)) {
       wsop = JBWS_REMOVE_COLL;
+    } else if (!strncmp("page", msg, pos)) {
+      wsop = JBWS_PAGE;
+    } else if (!strncmp("budget", msg, pos)) {
+      wsop = JBWS_BUDGET;
     }
   }
 
   if (wsop > JBWS_NONE) {
-    if (wsop == JBWS_INFO) {
-      return _ws_info(ws, mctx);
+    if (wsop == JBWS_INFO || wsop == JBWS_PROFILE) {
+      return _ws_info(ws, mctx, wsop == JBWS_PROFILE);
+    }
+    if (wsop == JBWS_BUDGET) {
+      msg[len] = '\0';
+      return _ws_budget(ws, mctx, msg + pos);
     }
     for ( ; pos < len && isspace(msg[pos]); ++pos);
     len -= pos;
@@ -994,8 +1241,28 @@ static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const cha
         return _ws_document_add(ws, mctx, msg);
       case JBWS_QUERY:
       case JBWS_EXPLAIN:
+      case JBWS_ANALYZE:
         msg[len] = '\0';
-        return _ws_query(ws, mctx, msg, (wsop == JBWS_EXPLAIN));
+        return _ws_query(ws, mctx, msg, (wsop == JBWS_EXPLAIN), (wsop == JBWS_ANALYZE), 0);
+      case JBWS_PAGE: {
+        const char *page = msg;
+        for (pos = 0; pos < len && !isspace(msg[pos]); ++pos);
+        if (pos >= len) {
+          return _ws_rc_send(ws, mctx->key, JBR_ERROR_WS_INVALID_MESSAGE, JBR_WS_STR_PREMATURE_END);
+        }
+        msg[pos] = '\0';
+        if (!strcmp(page, "-")) { // First page
+          page = "";
+        }
+        for (++pos; pos < len && isspace(msg[pos]); ++pos);
+        len -= pos;
+        msg += pos;
+        if (len < 1) {
+          return _ws_rc_send(ws, mctx->key, JBR_ERROR_WS_INVALID_MESSAGE, JBR_WS_STR_PREMATURE_END);
+        }
+        msg[len] = '\0';
+        return _ws_query(ws, mctx, msg, false, false, page);
+      }
       default: {
         char nbuf[IWNUMBUF_SIZE];
         for (pos = 0; pos < len && pos < IWNUMBUF_SIZE - 1 && isdigit(msg[pos]); ++pos) {
@@ -1031,7 +1298,7 @@ static bool _on_ws_msg_impl(struct iwn_ws_sess *ws, struct mctx *mctx, const cha
     }
   } else {
     msg[len] = '\0';
-    return _ws_query(ws, mctx, msg, false);
+    return _ws_query(ws, mctx, msg, false, false, 0);
   }
 }
 
@@ -40,8 +40,27 @@ static int _usage(const char *err) {
           "Default: 16777216, min: 1048576\n");
   fprintf(stderr, "\t-D, --dsz=NUM            Initial size of buffer to process/store document on queries."
           " Preferable average size of document. Default: 65536, min: 16384\n");
+  fprintf(stderr, "\t-P, --threads=NUM        Max number of threads used to scan collections and sort results"
+          " of read-only queries. Default: 0 (disabled)\n");
   fprintf(stderr, "\t-T, --trylock            Exit with error if database is locked by another process."
-          " If not set, current process will wait for lock release.");
+          " If not set, current process will wait for lock release.\n");
+  fprintf(stderr, "\t-Q, --profile            Enable query profiler, see websocket `profile` command.\n");
+  fprintf(stderr, "\t-L, --slow=NUM           Log queries executed longer than NUM milliseconds"
+          " along with query plan. Default: 0 (disabled)\n");
+  fprintf(stderr, "\t-R, --rcache=NUM         Max memory size of query results cache in bytes."
+          " Default: 0 (disabled)\n");
+  fprintf(stderr, "\t-O, --timeout=NUM        Max query execution time in milliseconds."
+          " Default: 0 (unlimited)\n");
+  fprintf(stderr, "\t-M, --max-scanned=NUM    Max number of documents scanned by query."
+          " Default: 0 (unlimited)\n");
+  fprintf(stderr, "\t-B, --max-sort=NUM       Max memory size in bytes of query sort buffer."
+          " Default: 0 (unlimited)\n");
+  fprintf(stderr, "\t-X, --max-output=NUM     Max size in bytes of documents returned by query."
+          " Default: 0 (unlimited)\n");
+  fprintf(stderr, "\t-Y, --yield=NUM          Read-only full collection scans release collection lock"
+          " at least once per NUM milliseconds. Default: 0 (disabled)\n");
+  fprintf(stderr, "\t-U, --apply-batch=NUM    Queries with apply or del release collection lock"
+          " after every NUM modified documents. Default: 0 (disabled)");
   fprintf(stderr, "\n\n");
   return 1;
 }
@@ -102,10 +121,20 @@ int main(int argc, char *argv[]) {
     { "wal", 0, 0, 'w' },
     { "sbz", 1, 0, 'S' },
     { "dsz", 1, 0, 'D' },
-    { "trylock", 0, 0, 'T' }
+    { "threads", 1, 0, 'P' },
+    { "trylock", 0, 0, 'T' },
+    { "profile", 0, 0, 'Q' },
+    { "slow", 1, 0, 'L' },
+    { "rcache", 1, 0, 'R' },
+    { "timeout", 1, 0, 'O' },
+    { "max-scanned", 1, 0, 'M' },
+    { "max-sort", 1, 0, 'B' },
+    { "max-output", 1, 0, 'X' },
+    { "yield", 1, 0, 'Y' },
+    { "apply-batch", 1, 0, 'U' }
   };
 
-  while ((ch = getopt_long(argc, argv, "f:p:b:l:k:c:a:S:D:rCtwThv", long_options, 0)) != -1) {
+  while ((ch = getopt_long(argc, argv, "f:p:b:l:k:c:a:S:D:P:L:R:O:M:B:X:Y:U:rCtwTQhv", long_options, 0)) != -1) {
     switch (ch) {
       case 'h':
         ec = _usage(0);
@@ -148,12 +177,42 @@ int main(int argc, char *argv[]) {
       case 'D':
         env.opts.document_buffer_sz = iwatoi(optarg);
         break;
+      case 'P':
+        env.opts.parallel_threads = iwatoi(optarg);
+        break;
       case 'T':
         env.opts.kv.file_lock_fail_fast = true;
         break;
       case 'r':
         env.opts.http.read_anon = true;
         break;
+      case 'Q':
+        env.opts.query_profiler = true;
+        break;
+      case 'L':
+        env.opts.slow_query_ms = (uint32_t) iwatoi(optarg);
+        break;
+      case 'R':
+        env.opts.result_cache_size = (uint32_t) iwatoi(optarg);
+        break;
+      case 'O':
+        env.opts.http.query_timeout_ms = (uint32_t) iwatoi(optarg);
+        break;
+      case 'M':
+        env.opts.http.query_max_scanned = iwatoi(optarg);
+        break;
+      case 'B':
+        env.opts.http.query_max_sort_bytes = iwatoi(optarg);
+        break;
+      case 'X':
+        env.opts.http.query_max_output_bytes = iwatoi(optarg);
+        break;
+      case 'Y':
+        env.opts.read_yield_ms = (uint32_t) iwatoi(optarg);
+        break;
+      case 'U':
+        env.opts.apply_batch_size = (uint32_t) iwatoi(optarg);
+        break;
       default:
         ec = _usage(0);
         goto finish;
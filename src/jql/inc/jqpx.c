@@ -887,6 +887,63 @@ static void _jqp_set_aggregate_count(yycontext *yy) {
   aux->projection = 0; // No projections in aggregate mode
 }
 
+static void _jqp_set_aggregate_op(yycontext *yy, const char *text) {
+  struct jqp_aux *aux = yy->aux;
+  if (!strcmp(text, "sum")) {
+    aux->aggregate_op = JQP_AGGREGATE_SUM;
+  } else if (!strcmp(text, "avg")) {
+    aux->aggregate_op = JQP_AGGREGATE_AVG;
+  } else if (!strcmp(text, "min")) {
+    aux->aggregate_op = JQP_AGGREGATE_MIN;
+  } else if (!strcmp(text, "max")) {
+    aux->aggregate_op = JQP_AGGREGATE_MAX;
+  } else {
+    iwlog_error("Invalid aggregate function: %s", text);
+    JQRC(yy, JQL_ERROR_QUERY_PARSE);
+  }
+}
+
+static struct jqp_aggregate* _jqp_aggregate(yycontext *yy, jqp_aggregate_op_t op, union jqp_unit *unit) {
+  struct jqp_aux *aux = yy->aux;
+  if (unit->type != JQP_STRING_TYPE) {
+    iwlog_error("Unexpected type for aggregate: %d", unit->type);
+    JQRC(yy, JQL_ERROR_QUERY_PARSE);
+  }
+  struct jqp_aggregate *agg = iwpool_calloc(sizeof(*agg), aux->pool);
+  if (!agg) {
+    JQRC(yy, iwrc_set_errno(IW_ERROR_ALLOC, errno));
+  }
+  agg->op = op;
+  agg->value = &unit->string;
+  aux->qmode |= JQP_QRY_GROUP;
+  return agg;
+}
+
+static void _jqp_add_aggregate(yycontext *yy, union jqp_unit *unit) {
+  struct jqp_aux *aux = yy->aux;
+  struct jqp_aggregate *agg = _jqp_aggregate(yy, aux->aggregate_op, unit), *last = aux->aggregates;
+  aux->aggregate_op = 0;
+  aux->aggregates_num++;
+  if (!last) {
+    aux->aggregates = agg;
+  } else {
+    while (last->next) last = last->next;
+    last->next = agg;
+  }
+}
+
+static void _jqp_add_groupby(yycontext *yy, union jqp_unit *unit) {
+  struct jqp_aux *aux = yy->aux;
+  struct jqp_aggregate *agg = _jqp_aggregate(yy, JQP_AGGREGATE_GROUP, unit), *last = aux->groupby;
+  aux->groupby_num++;
+  if (!last) {
+    aux->groupby = agg;
+  } else {
+    while (last->next) last = last->next;
+    last->next = agg;
+  }
+}
+
 static void _jqp_set_noidx(yycontext *yy) {
   struct jqp_aux *aux = yy->aux;
   aux->qmode |= JQP_QRY_NOIDX;
@@ -924,6 +981,76 @@ static void _jqp_set_projection(yycontext *yy, union jqp_unit *unit) {
   }
 }
 
+static iwrc _jqp_aggregate_init(struct jqp_aux *aux, struct jqp_aggregate *agg, struct iwxstr *xstr) {
+  static const char *fnames[] = { "", "sum", "avg", "min", "max" };
+  iwrc rc = 0;
+  iwxstr_clear(xstr);
+  for (struct jqp_string *n = agg->value; n; n = n->subnext) {
+    RCR(iwxstr_cat(xstr, "/", 1));
+    RCR(iwxstr_cat(xstr, n->value, strlen(n->value)));
+  }
+  RCR(jbl_ptr_alloc_pool(iwxstr_ptr(xstr), &agg->ptr, aux->pool));
+  if (agg->op == JQP_AGGREGATE_GROUP) {
+    agg->name = iwpool_strdup(aux->pool, iwxstr_ptr(xstr), &rc);
+  } else {
+    agg->name = iwpool_printf(aux->pool, "%s(%s)", fnames[agg->op], iwxstr_ptr(xstr));
+    if (!agg->name) {
+      rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+  }
+  return rc;
+}
+
+/**
+ * Builds pointers of aggregate functions and group by keys.
+ * If query has no order-by clause the first group by key
+ * or the field of single `min`/`max` function becomes an implied
+ * order-by pointer in order to scan documents by index over this field.
+ */
+static iwrc _jqp_finish_aggregates(struct jqp_aux *aux) {
+  iwrc rc = 0;
+  struct jbl_ptr *optr = 0;
+  if (  aux->apply || aux->apply_placeholder
+     || (aux->qmode & (JQP_QRY_APPLY_DEL | JQP_QRY_APPLY_UPSERT))) {
+    return JQL_ERROR_AGGREGATE_WITH_APPLY;
+  }
+  struct iwxstr *xstr = iwxstr_new();
+  if (!xstr) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  for (struct jqp_aggregate *agg = aux->groupby; agg; agg = agg->next) {
+    RCC(rc, finish, _jqp_aggregate_init(aux, agg, xstr));
+  }
+  for (struct jqp_aggregate *agg = aux->aggregates; agg; agg = agg->next) {
+    RCC(rc, finish, _jqp_aggregate_init(aux, agg, xstr));
+  }
+  aux->projection = 0; // No projections in aggregate mode
+  if (aux->orderby_num) {
+    if (aux->groupby) {
+      // Groups are emitted in index order or in hash order, they are never sorted
+      rc = JQL_ERROR_AGGREGATE_WITH_ORDERBY;
+    }
+    goto finish;
+  }
+  if (aux->groupby) {
+    optr = aux->groupby->ptr;
+  } else if (  (aux->aggregates_num == 1)
+            && ((aux->aggregates->op == JQP_AGGREGATE_MIN) || (aux->aggregates->op == JQP_AGGREGATE_MAX))) {
+    optr = aux->aggregates->ptr;
+    optr->op = (aux->aggregates->op == JQP_AGGREGATE_MAX); // Desc for max
+  }
+  if (optr) {
+    RCA(aux->orderby_ptrs = iwpool_alloc(sizeof(struct jbl_ptr*), aux->pool), finish);
+    aux->orderby_ptrs[0] = optr;
+    aux->orderby_num = 1;
+    aux->aggregate_orderby = true;
+  }
+
+finish:
+  iwxstr_destroy(xstr);
+  return rc;
+}
+
 static void _jqp_finish(yycontext *yy) {
   iwrc rc = 0;
   int cnt = 0;
@@ -967,6 +1094,10 @@ static void _jqp_finish(yycontext *yy) {
     }
   }
 
+  if (aux->qmode & JQP_QRY_GROUP) {
+    RCC(rc, finish, _jqp_finish_aggregates(aux));
+  }
+
 finish:
   if (xstr) {
     iwxstr_destroy(xstr);
@@ -1380,6 +1511,25 @@ static iwrc _jqp_print_opts(const struct jqp_query *q, jbl_json_printer pt, void
     }
     ob = ob->next;
   }
+  for (int i = 0; i < 2; ++i) {
+    for (struct jqp_aggregate *agg = i ? aux->aggregates : aux->groupby; agg; agg = agg->next) {
+      if (c++ > 0) {
+        PT("\n ", 2, 0, 0);
+      }
+      if (agg->op == JQP_AGGREGATE_GROUP) {
+        PT(" group by ", 10, 0, 0);
+      } else {
+        PT(0, 0, ' ', 1);
+        PT(agg->name, (int) (strchr(agg->name, '(') - agg->name), 0, 0);
+        PT(0, 0, ' ', 1);
+      }
+      struct jqp_string *n = agg->value;
+      do {
+        PT(0, 0, '/', 1);
+        PT(n->value, -1, 0, 0);
+      } while ((n = n->subnext));
+    }
+  }
   if (aux->skip || aux->limit) {
     if (c > 0) {
       PT("\n ", 2, 0, 0);
@@ -1435,7 +1585,7 @@ iwrc jqp_print_query(const struct jqp_query *q, jbl_json_printer pt, void *op) {
     rc = _jqp_print_projection(aux->projection, pt, op);
     RCRET(rc);
   }
-  if (aux->skip || aux->limit || aux->orderby) {
+  if (aux->skip || aux->limit || aux->orderby || (aux->qmode & JQP_QRY_GROUP)) {
     PT(0, 0, '\n', 1);
     rc = _jqp_print_opts(q, pt, op);
   }
@@ -10,6 +10,7 @@
 
 #include <iowow/iwre.h>
 #include <errno.h>
+#include <ctype.h>
 #include <stddef.h>
 
 #define IWRE_UNUSED_PTR ((void*) (intptr_t) -1)
@@ -24,24 +25,11 @@ typedef struct MCTX {
   JBL_VCTX    *vctx;
 } MCTX;
 
-/** Expression node matching context */
-typedef struct MENCTX {
-  bool matched;
-} MENCTX;
-
-/** Filter matching context */
-typedef struct MFCTX {
-  bool      matched;
-  int       last_lvl;     /**< Last matched level */
-  JQP_NODE *nodes;
-  JQP_NODE *last_node;
-  JQP_FILTER *qpf;
-} MFCTX;
-
 static JQP_NODE* _jql_match_node(MCTX *mctx, JQP_NODE *n, bool *res, iwrc *rcp);
+static void _jql_rx_cache_reset(JQL q);
 
-IW_INLINE void _jql_jqval_destroy(JQP_STRING *pv) {
-  JQVAL *qv = pv->opaque;
+IW_INLINE void _jql_jqval_destroy(JQL q, JQP_STRING *pv) {
+  JQVAL *qv = q->pvals[pv->idx];
   if (qv) {
     void *ptr;
     switch (qv->type) {
@@ -69,7 +57,7 @@ IW_INLINE void _jql_jqval_destroy(JQP_STRING *pv) {
       }
       free(qv);
     }
-    pv->opaque = 0;
+    q->pvals[pv->idx] = 0;
   }
 }
 
@@ -77,7 +65,7 @@ static JQVAL* _jql_find_placeholder(JQL q, const char *name) {
   JQP_AUX *aux = q->aux;
   for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) {
     if (!strcmp(pv->value, name)) {
-      return pv->opaque;
+      return q->pvals[pv->idx];
     }
   }
   return 0;
@@ -98,9 +86,10 @@ static iwrc _jql_set_placeholder(JQL q, const char *placeholder, int index, JQVA
         if ((pv->flavour & (JQP_STR_PROJFIELD | JQP_STR_PROJPATH)) && val->type != JQVAL_STR) {
           return JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
         }
-        _jql_jqval_destroy(pv);
-        pv->opaque = val;
+        _jql_jqval_destroy(q, pv);
+        q->pvals[pv->idx] = val;
         val->refs++;
+        _jql_rx_cache_reset(q);
         return 0;
       }
     }
@@ -111,8 +100,8 @@ static iwrc _jql_set_placeholder(JQL q, const char *placeholder, int index, JQVA
           rc = JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
           goto finish;
         }
-        _jql_jqval_destroy(pv);
-        pv->opaque = val;
+        _jql_jqval_destroy(q, pv);
+        q->pvals[pv->idx] = val;
         val->refs++;
         rc = 0;
       }
@@ -122,10 +111,12 @@ finish:
   if (rc) {
     val->refs = 0;
     for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) {
-      if (pv->opaque == val) {
-        pv->opaque = 0;
+      if (q->pvals[pv->idx] == val) {
+        q->pvals[pv->idx] = 0;
       }
     }
+  } else { // Regexps compiled from previous placeholder values
+    _jql_rx_cache_reset(q);
   }
   return rc;
 }
@@ -329,15 +320,15 @@ iwrc jql_set_null(JQL q, const char *placeholder, int index) {
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-static bool _jql_need_deeper_match(JQP_EXPR_NODE *en, int lvl) {
+static bool _jql_need_deeper_match(JQL q, JQP_EXPR_NODE *en, int lvl) {
   for (en = en->chain; en; en = en->next) {
     if (en->type == JQP_EXPR_NODE_TYPE) {
-      if (_jql_need_deeper_match(en, lvl)) {
+      if (_jql_need_deeper_match(q, en, lvl)) {
         return true;
       }
     } else if (en->type == JQP_FILTER_TYPE) {
-      MFCTX *fctx = ((JQP_FILTER*) en)->opaque;
-      if (!fctx->matched && (fctx->last_lvl == lvl)) {
+      struct jql_enode_state *fs = &q->enodes[en->idx];
+      if (!fs->matched && (fs->last_lvl == lvl)) {
         return true;
       }
     }
@@ -345,118 +336,379 @@ static bool _jql_need_deeper_match(JQP_EXPR_NODE *en, int lvl) {
   return false;
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-static void _jql_reset_expression_node(JQP_EXPR_NODE *en, JQP_AUX *aux, bool reset_match_cache) {
-  MENCTX *ectx = en->opaque;
-  ectx->matched = false;
-  for (en = en->chain; en; en = en->next) {
-    if (en->type == JQP_EXPR_NODE_TYPE) {
-      _jql_reset_expression_node(en, aux, reset_match_cache);
-    } else if (en->type == JQP_FILTER_TYPE) {
-      MFCTX *fctx = ((JQP_FILTER*) en)->opaque;
-      fctx->matched = false;
-      fctx->last_lvl = -1;
-      for (JQP_NODE *n = fctx->nodes; n; n = n->next) {
-        n->start = -1;
-        n->end = -1;
-        JQPUNIT *unit = n->value;
-        if (reset_match_cache && (unit->type == JQP_EXPR_TYPE)) {
-          for (JQP_EXPR *expr = &unit->expr; expr; expr = expr->next) expr->prematched = false;
-        }
+/**
+ * Creates value of non placeholder query unit.
+ * Values are created at query parsing stage so parsed query is never modified on query matching.
+ */
+static iwrc _jql_init_unit(JQPUNIT *unit, JQP_AUX *aux) {
+  void **vp;
+  switch (unit->type) {
+    case JQP_STRING_TYPE:
+      if (unit->string.flavour & JQP_STR_PLACEHOLDER) {
+        return 0;
+      }
+      vp = &unit->string.opaque;
+      break;
+    case JQP_JSON_TYPE:
+      vp = &unit->json.opaque;
+      break;
+    case JQP_INTEGER_TYPE:
+      vp = &unit->intval.opaque;
+      break;
+    case JQP_DOUBLE_TYPE:
+      vp = &unit->dblval.opaque;
+      break;
+    default:
+      return 0;
+  }
+  if (*vp) {
+    return 0;
+  }
+  JQVAL *qv = iwpool_calloc(sizeof(*qv), aux->pool);
+  if (!qv) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  switch (unit->type) {
+    case JQP_STRING_TYPE:
+      qv->type = JQVAL_STR;
+      qv->vstr = unit->string.value;
+      break;
+    case JQP_JSON_TYPE: {
+      struct jbl_node *jn = &unit->json.jn;
+      switch (jn->type) {
+        case JBV_BOOL:
+          qv->type = JQVAL_BOOL;
+          qv->vbool = jn->vbool;
+          break;
+        case JBV_I64:
+          qv->type = JQVAL_I64;
+          qv->vi64 = jn->vi64;
+          break;
+        case JBV_F64:
+          qv->type = JQVAL_F64;
+          qv->vf64 = jn->vf64;
+          break;
+        case JBV_STR:
+          qv->type = JQVAL_STR;
+          qv->vstr = jn->vptr;
+          break;
+        case JBV_NULL:
+          qv->type = JQVAL_NULL;
+          break;
+        default:
+          qv->type = JQVAL_JBLNODE;
+          qv->vnode = &unit->json.jn;
+          break;
       }
+      break;
     }
+    case JQP_INTEGER_TYPE:
+      qv->type = JQVAL_I64;
+      qv->vi64 = unit->intval.value;
+      break;
+    default:
+      qv->type = JQVAL_F64;
+      qv->vf64 = unit->dblval.value;
+      break;
   }
+  *vp = qv;
+  return 0;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+static iwrc _jql_init_expr(JQP_EXPR *expr, JQP_AUX *aux) {
+  expr->idx = aux->num_exprs++;
+  if (expr->left->type == JQP_EXPR_TYPE) {
+    iwrc rc = _jql_init_expr(&expr->left->expr, aux);
+    RCRET(rc);
+  }
+  return _jql_init_unit(expr->right, aux);
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
 static iwrc _jql_init_expression_node(JQP_EXPR_NODE *en, JQP_AUX *aux) {
-  en->opaque = iwpool_calloc(sizeof(MENCTX), aux->pool);
-  if (!en->opaque) {
-    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  iwrc rc = 0;
+  en->idx = aux->num_enodes++;
+  if (en->flags & JQP_EXPR_NODE_FLAG_PK) {
+    JQP_EXPR_NODE_PK *pk = (void*) en;
+    return pk->argument ? _jql_init_unit(pk->argument, aux) : 0;
   }
   for (en = en->chain; en; en = en->next) {
     if (en->type == JQP_EXPR_NODE_TYPE) {
-      iwrc rc = _jql_init_expression_node(en, aux);
+      rc = _jql_init_expression_node(en, aux);
       RCRET(rc);
     } else if (en->type == JQP_FILTER_TYPE) {
-      MFCTX *fctx = iwpool_calloc(sizeof(*fctx), aux->pool);
       JQP_FILTER *f = (JQP_FILTER*) en;
-      if (!fctx) {
-        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
-      }
-      f->opaque = fctx;
-      fctx->last_lvl = -1;
-      fctx->qpf = f;
-      fctx->nodes = f->node;
+      f->idx = aux->num_enodes++;
       for (JQP_NODE *n = f->node; n; n = n->next) {
-        fctx->last_node = n;
-        n->start = -1;
-        n->end = -1;
+        n->idx = aux->num_nodes++;
+        if (n->value->type == JQP_EXPR_TYPE) {
+          for (JQP_EXPR *expr = &n->value->expr; expr; expr = expr->next) {
+            rc = _jql_init_expr(expr, aux);
+            RCRET(rc);
+          }
+        }
       }
     }
   }
+  return rc;
+}
+
+/**
+ * Assigns indexes of query object state slots to the parsed query units
+ * and creates values of query units.
+ */
+static iwrc _jql_init(JQP_AUX *aux) {
+  iwrc rc = _jql_init_expression_node(aux->expr, aux);
+  RCRET(rc);
+  for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) {
+    pv->idx = aux->num_placeholder_units++;
+  }
+  for (JQP_OP *op = aux->start_op; op; op = op->next) {
+    op->idx = aux->num_ops++;
+  }
+  for (JQP_PROJECTION *p = aux->projection; p; p = p->next) {
+    p->idx = aux->num_projections++;
+  }
+  if (aux->skip) {
+    RCC(rc, finish, _jql_init_unit(aux->skip, aux));
+  }
+  if (aux->limit) {
+    RCC(rc, finish, _jql_init_unit(aux->limit, aux));
+  }
+
+finish:
+  return rc;
+}
+
+/**
+ * Creates query object with empty matching state for the given parsed query.
+ * Caller is responsible for incrementing of `aux->refs`.
+ */
+static iwrc _jql_create_object(JQP_AUX *aux, const char *coll, JQL *qptr) {
+  JQL q;
+  size_t sz = sizeof(*q)
+              + aux->num_enodes * sizeof(q->enodes[0])
+              + aux->num_nodes * sizeof(q->nodes[0])
+              + aux->num_ops * sizeof(q->rxs[0])
+              + aux->num_ops * sizeof(q->rxpfx[0])
+              + aux->num_placeholder_units * sizeof(q->pvals[0])
+              + aux->num_exprs * sizeof(q->prematched[0]);
+  IWPOOL *pool = iwpool_create(sz);
+  if (!pool) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  uint8_t *ptr = iwpool_calloc(sz, pool);
+  if (!ptr) {
+    iwpool_destroy(pool);
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  q = (void*) ptr;
+  ptr += sizeof(*q);
+  q->pool = pool;
+  q->aux = aux;
+  q->qp = aux->query;
+  q->coll = coll;
+  if (aux->num_enodes) {
+    q->enodes = (void*) ptr;
+    ptr += aux->num_enodes * sizeof(q->enodes[0]);
+  }
+  if (aux->num_nodes) {
+    q->nodes = (void*) ptr;
+    ptr += aux->num_nodes * sizeof(q->nodes[0]);
+  }
+  if (aux->num_ops) {
+    q->rxs = (void*) ptr;
+    ptr += aux->num_ops * sizeof(q->rxs[0]);
+    q->rxpfx = (void*) ptr;
+    ptr += aux->num_ops * sizeof(q->rxpfx[0]);
+  }
+  if (aux->num_placeholder_units) {
+    q->pvals = (void*) ptr;
+    ptr += aux->num_placeholder_units * sizeof(q->pvals[0]);
+  }
+  if (aux->num_exprs) {
+    q->prematched = (void*) ptr;
+  }
+  jql_reset(q, true, false);
+  *qptr = q;
   return 0;
 }
 
+static void _jql_rx_cache_reset(JQL q) {
+  for (int i = 0; i < q->aux->num_ops; ++i) {
+    if (q->rxs[i]) {
+      if (q->rxs[i] != IWRE_UNUSED_PTR) {
+        iwre_destroy(q->rxs[i]);
+      }
+      q->rxs[i] = 0;
+    }
+    if (q->rxpfx[i]) {
+      free(q->rxpfx[i]);
+      q->rxpfx[i] = 0;
+    }
+  }
+}
+
 iwrc jql_create2(JQL *qptr, const char *coll, const char *query, jql_create_mode_t mode) {
   if (!qptr || !query) {
     return IW_ERROR_INVALID_ARGS;
   }
   *qptr = 0;
 
-  JQL q;
+  JQL q = 0;
   JQP_AUX *aux;
+  const char *qcoll = 0;
   iwrc rc = jqp_aux_create(&aux, query);
   RCRET(rc);
 
-  q = iwpool_calloc(sizeof(*q), aux->pool);
-  if (!q) {
-    rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-    goto finish;
-  }
   aux->mode = mode;
-  q->aux = aux;
+  aux->refs = 1;
 
-  RCC(rc, finish, jqp_parse(aux));
-
-  if (coll && *coll != '\0') {
-    // Get a copy of collection name
-    q->coll = iwpool_strdup2(aux->pool, coll);
+  rc = jqp_parse(aux);
+  if (!rc) {
+    if (coll && *coll != '\0') {
+      // Get a copy of collection name
+      qcoll = iwpool_strdup2(aux->pool, coll);
+    } else {
+      // Try to set collection from first query anchor
+      qcoll = aux->first_anchor;
+    }
+    if (qcoll) {
+      rc = _jql_init(aux);
+    } else {
+      rc = JQL_ERROR_NO_COLLECTION;
+    }
   }
 
-  q->qp = aux->query;
-
-  if (!q->coll) {
-    // Try to set collection from first query anchor
-    q->coll = aux->first_anchor;
-    if (!q->coll) {
-      rc = JQL_ERROR_NO_COLLECTION;
-      goto finish;
+  if (  !rc
+     || ((rc == JQL_ERROR_QUERY_PARSE) && (mode & JQL_KEEP_QUERY_ON_PARSE_ERROR))) {
+    iwrc rc2 = _jql_create_object(aux, qcoll, &q);
+    if (rc2) {
+      rc = rc2;
     }
   }
+  if (q) {
+    *qptr = q;
+  } else {
+    jqp_aux_destroy(&aux);
+  }
+  return rc;
+}
 
-  rc = _jql_init_expression_node(aux->expr, aux);
+iwrc jql_create(JQL *qptr, const char *coll, const char *query) {
+  return jql_create2(qptr, coll, query, 0);
+}
 
-finish:
+iwrc jql_clone(JQL q, JQL *qptr) {
+  if (!q || !qptr) {
+    return IW_ERROR_INVALID_ARGS;
+  }
+  *qptr = 0;
+  if (!q->coll) { // Query was not parsed
+    return IW_ERROR_INVALID_STATE;
+  }
+  __sync_fetch_and_add(&q->aux->refs, 1);
+  iwrc rc = _jql_create_object(q->aux, q->coll, qptr);
   if (rc) {
-    if (  (rc == JQL_ERROR_QUERY_PARSE)
-       && (mode & JQL_KEEP_QUERY_ON_PARSE_ERROR)) {
-      *qptr = q;
+    __sync_fetch_and_sub(&q->aux->refs, 1);
+  }
+  return rc;
+}
+
+iwrc jql_clone_bound(JQL src, JQL *qptr) {
+  JQL q;
+  iwrc rc = jql_clone(src, &q);
+  RCRET(rc);
+  for (int i = 0; i < src->aux->num_placeholder_units; ++i) {
+    JQVAL *sqv = src->pvals[i];
+    if (!sqv) {
+      continue;
+    }
+    if ((sqv->type == JQVAL_RE) && (sqv->vre != IWRE_UNUSED_PTR)) {
+      // Compiled regexp cannot be shared between threads
+      JQVAL *qv = malloc(sizeof(*qv));
+      if (!qv) {
+        rc = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+        goto finish;
+      }
+      memcpy(qv, sqv, sizeof(*qv));
+      qv->refs = 1;
+      qv->freefn = 0; // Pattern is owned by `src`
+      qv->freefn_op = 0;
+      qv->vre = iwre_create(iwre_pattern_get(sqv->vre));
+      if (!qv->vre) {
+        free(qv);
+        rc = JQL_ERROR_REGEXP_INVALID;
+        goto finish;
+      }
+      q->pvals[i] = qv;
     } else {
-      jqp_aux_destroy(&aux);
+      sqv->refs++;
+      q->pvals[i] = sqv;
     }
+  }
+
+finish:
+  if (rc) {
+    jql_destroy(&q);
   } else {
     *qptr = q;
   }
   return rc;
 }
 
-iwrc jql_create(JQL *qptr, const char *coll, const char *query) {
-  return jql_create2(qptr, coll, query, 0);
+iwrc jql_placeholders_key(JQL q, struct iwxstr *xstr) {
+  iwrc rc = 0;
+  for (int i = 0; !rc && i < q->aux->num_placeholder_units; ++i) {
+    JQVAL *qv = q->pvals[i];
+    if (!qv) {
+      rc = iwxstr_cat2(xstr, "\n-");
+      continue;
+    }
+    rc = iwxstr_printf(xstr, "\n%d:", (int) qv->type);
+    RCBREAK(rc);
+    switch (qv->type) {
+      case JQVAL_I64:
+        rc = iwxstr_printf(xstr, "%" PRId64, qv->vi64);
+        break;
+      case JQVAL_F64:
+        rc = iwxstr_printf(xstr, "%.17g", qv->vf64);
+        break;
+      case JQVAL_BOOL:
+        rc = iwxstr_cat2(xstr, qv->vbool ? "1" : "0");
+        break;
+      case JQVAL_STR:
+        rc = iwxstr_printf(xstr, "%zu:%s", strlen(qv->vstr), qv->vstr);
+        break;
+      case JQVAL_RE: {
+        const char *expr = (qv->vre != IWRE_UNUSED_PTR) ? iwre_pattern_get(qv->vre) : "";
+        rc = iwxstr_printf(xstr, "%zu:%s", strlen(expr), expr);
+        break;
+      }
+      case JQVAL_JBLNODE:
+        rc = jbn_as_json(qv->vnode, jbl_xstr_json_printer, xstr, 0);
+        break;
+      case JQVAL_BINN: {
+        const uint8_t *data = binn_ptr(qv->vbinn);
+        int size = binn_size(qv->vbinn);
+        for (int j = 0; !rc && j < size; ++j) {
+          rc = iwxstr_printf(xstr, "%02x", data[j]);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return rc;
 }
 
 size_t jql_estimate_allocated_size(JQL q) {
   size_t ret = sizeof(struct jql);
+  if (q->pool) {
+    ret += iwpool_allocated_size(q->pool);
+  }
   if (q->aux && q->aux->pool) {
     ret += iwpool_allocated_size(q->aux->pool);
   }
@@ -468,14 +720,26 @@ const char* jql_collection(JQL q) {
 }
 
 void jql_reset(JQL q, bool reset_match_cache, bool reset_placeholders) {
+  JQP_AUX *aux = q->aux;
   q->matched = false;
   q->dirty = false;
-  JQP_AUX *aux = q->aux;
-  _jql_reset_expression_node(aux->expr, aux, reset_match_cache);
-  if (reset_placeholders) {
+  for (int i = 0; i < aux->num_enodes; ++i) {
+    q->enodes[i].matched = false;
+    q->enodes[i].last_lvl = -1;
+  }
+  for (int i = 0; i < aux->num_nodes; ++i) {
+    q->nodes[i].start = -1;
+    q->nodes[i].end = -1;
+  }
+  if (reset_match_cache && aux->num_exprs) {
+    memset(q->prematched, 0, aux->num_exprs * sizeof(q->prematched[0]));
+  }
+  if (reset_placeholders && q->pvals) {
     for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) { // Cleanup placeholders
-      _jql_jqval_destroy(pv);
+      _jql_jqval_destroy(q, pv);
     }
+    // Regexps may be compiled from placeholder values
+    _jql_rx_cache_reset(q);
   }
 }
 
@@ -486,17 +750,16 @@ void jql_destroy(JQL *qptr) {
   JQL q = *qptr;
   if (q) {
     JQP_AUX *aux = q->aux;
-    for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) { // Cleanup placeholders
-      _jql_jqval_destroy(pv);
-    }
-    for (JQP_OP *op = aux->start_op; op; op = op->next) {
-      if (op->opaque) {
-        if (op->value == JQP_OP_RE && op->opaque != IWRE_UNUSED_PTR) {
-          iwre_destroy(op->opaque);
-        }
+    if (q->pvals) {
+      for (JQP_STRING *pv = aux->start_placeholder; pv; pv = pv->placeholder_next) { // Cleanup placeholders
+        _jql_jqval_destroy(q, pv);
       }
     }
-    jqp_aux_destroy(&aux);
+    _jql_rx_cache_reset(q);
+    if (__sync_sub_and_fetch(&aux->refs, 1) == 0) {
+      jqp_aux_destroy(&aux);
+    }
+    iwpool_destroy(q->pool);
   }
   *qptr = 0;
 }
@@ -762,7 +1025,7 @@ int jql_cmp_jqval_pair(const JQVAL *left, const JQVAL *right, iwrc *rcp) {
 }
 
 static bool _jql_match_regexp(
-  JQP_AUX *aux,
+  JQL q,
   JQVAL *left, JQP_OP *jqop, JQVAL *right,
   iwrc *rcp) {
   struct iwre *rx;
@@ -784,8 +1047,8 @@ static bool _jql_match_regexp(
     return false;
   }
 
-  if (jqop->opaque) {
-    rx = jqop->opaque;
+  if (q->rxs[jqop->idx]) {
+    rx = q->rxs[jqop->idx];
   } else if (right->type == JQVAL_RE) {
     rx = right->vre;
   } else {
@@ -799,7 +1062,7 @@ static bool _jql_match_regexp(
         break;
       case JQVAL_I64: {
         iwitoa(rv->vi64, nbuf, IWNUMBUF_SIZE);
-        expr = iwpool_strdup(aux->pool, nbuf, rcp);
+        expr = iwpool_strdup(q->pool, nbuf, rcp);
         if (*rcp) {
           return false;
         }
@@ -808,7 +1071,7 @@ static bool _jql_match_regexp(
       case JQVAL_F64: {
         size_t osz;
         iwjson_ftoa(rv->vf64, nbuf, &osz);
-        expr = iwpool_strdup(aux->pool, nbuf, rcp);
+        expr = iwpool_strdup(q->pool, nbuf, rcp);
         if (*rcp) {
           return false;
         }
@@ -831,7 +1094,7 @@ static bool _jql_match_regexp(
         return false;
       }
     }
-    jqop->opaque = rx;
+    q->rxs[jqop->idx] = rx;
   }
 
   switch (lv->type) {
@@ -865,6 +1128,106 @@ static bool _jql_match_regexp(
   }
 }
 
+/**
+ * Extracts literal prefix of anchored regexp `expr` into `buf`.
+ * `buf` must be at least of `strlen(expr) + 1` bytes.
+ */
+static void _jql_regexp_literal_prefix(const char *expr, char *buf) {
+  int depth = 0;
+  char *wp = buf;
+  *wp = '\0';
+  if (*expr != '^') {
+    return;
+  }
+  // Top level alternation, eg: `^abc|def` has no common prefix
+  for (const char *rp = expr; *rp; ++rp) {
+    if (*rp == '\\') {
+      if (!*++rp) {
+        break;
+      }
+    } else if (*rp == '[') {
+      while (*rp && *rp != ']') {
+        if ((*rp == '\\') && rp[1]) {
+          ++rp;
+        }
+        ++rp;
+      }
+      if (!*rp) {
+        break;
+      }
+    } else if (*rp == '(') {
+      ++depth;
+    } else if (*rp == ')') {
+      --depth;
+    } else if ((*rp == '|') && (depth < 1)) {
+      return;
+    }
+  }
+  for (const char *rp = expr + 1; *rp; ) {
+    char *lp = wp; // Start of the current literal
+    unsigned char c = *rp;
+    if (c == '\\') {
+      c = rp[1];
+      if (!c || isalnum(c)) { // Character class escape, eg: `\d`
+        break;
+      }
+      *wp++ = (char) c;
+      rp += 2;
+    } else if (strchr(".[]()*+?{}|$^", c)) {
+      break;
+    } else {
+      *wp++ = *rp++;
+      if (c >= 0xc0) { // Multibyte UTF-8 sequence
+        while ((*rp & 0xc0) == 0x80) {
+          *wp++ = *rp++;
+        }
+      }
+    }
+    if ((*rp == '*') || (*rp == '?') || (*rp == '{')) { // Last literal is optional
+      wp = lp;
+      break;
+    } else if (*rp == '+') {
+      break;
+    }
+  }
+  *wp = '\0';
+}
+
+const char* jql_expr_regexp_prefix(JQL q, JQP_EXPR *expr, iwrc *rcp) {
+  *rcp = 0;
+  JQP_OP *jqop = expr->op;
+  if (q->rxpfx[jqop->idx]) {
+    return q->rxpfx[jqop->idx];
+  }
+  const char *rx = 0;
+  JQVAL sv, *rv = jql_unit_to_jqval(q, expr->right, rcp);
+  if (*rcp) {
+    return "";
+  }
+  if (rv->type == JQVAL_JBLNODE) {
+    _jql_node_to_jqval(rv->vnode, &sv);
+    rv = &sv;
+  }
+  if ((jqop->value == JQP_OP_RE) && !jqop->negate) {
+    if (rv->type == JQVAL_STR) {
+      rx = rv->vstr;
+    } else if ((rv->type == JQVAL_RE) && (rv->vre != IWRE_UNUSED_PTR)) {
+      rx = iwre_pattern_get(rv->vre);
+    }
+  }
+  if (!rx) {
+    rx = "";
+  }
+  char *prefix = malloc(strlen(rx) + 1);
+  if (!prefix) {
+    *rcp = iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    return "";
+  }
+  _jql_regexp_literal_prefix(rx, prefix);
+  q->rxpfx[jqop->idx] = prefix;
+  return prefix;
+}
+
 static bool _jql_match_in(
   JQVAL *left, JQP_OP *jqop, JQVAL *right,
   iwrc *rcp) {
@@ -1009,7 +1372,7 @@ static bool _jql_match_starts(
 }
 
 static bool _jql_match_jqval_pair(
-  JQP_AUX *aux,
+  JQL q,
   JQVAL *left, JQP_OP *jqop, JQVAL *right,
   iwrc *rcp) {
   bool match = false;
@@ -1041,7 +1404,7 @@ static bool _jql_match_jqval_pair(
   } else {
     switch (op) {
       case JQP_OP_RE:
-        match = _jql_match_regexp(aux, left, jqop, right, rcp);
+        match = _jql_match_regexp(q, left, jqop, right, rcp);
         break;
       case JQP_OP_IN:
         match = _jql_match_in(left, jqop, right, rcp);
@@ -1070,109 +1433,48 @@ finish:
 }
 
 bool jql_match_jqval_pair(
-  JQP_AUX *aux,
+  JQL q,
   JQVAL *left, JQP_OP *jqop, JQVAL *right,
   iwrc *rcp) {
-  return _jql_match_jqval_pair(aux, left, jqop, right, rcp);
+  return _jql_match_jqval_pair(q, left, jqop, right, rcp);
 }
 
-static JQVAL* _jql_unit_to_jqval(JQP_AUX *aux, JQPUNIT *unit, iwrc *rcp) {
+static JQVAL* _jql_unit_to_jqval(JQL q, JQPUNIT *unit, iwrc *rcp) {
+  JQVAL *qv;
   *rcp = 0;
   switch (unit->type) {
-    case JQP_STRING_TYPE: {
-      if (unit->string.opaque) {
-        return (JQVAL*) unit->string.opaque;
-      }
+    case JQP_STRING_TYPE:
       if (unit->string.flavour & JQP_STR_PLACEHOLDER) {
-        *rcp = JQL_ERROR_INVALID_PLACEHOLDER;
-        return 0;
-      } else {
-        JQVAL *qv = iwpool_calloc(sizeof(*qv), aux->pool);
+        qv = q->pvals[unit->string.idx];
         if (!qv) {
-          *rcp = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-          return 0;
+          *rcp = JQL_ERROR_INVALID_PLACEHOLDER;
         }
-        unit->string.opaque = qv;
-        qv->type = JQVAL_STR;
-        qv->vstr = unit->string.value;
-      }
-      return unit->string.opaque;
-    }
-    case JQP_JSON_TYPE: {
-      if (unit->json.opaque) {
-        return (JQVAL*) unit->json.opaque;
-      }
-      JQVAL *qv = iwpool_calloc(sizeof(*qv), aux->pool);
-      if (!qv) {
-        *rcp = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-        return 0;
+        return qv;
       }
-      unit->json.opaque = qv;
-      struct jbl_node *jn = &unit->json.jn;
-      switch (jn->type) {
-        case JBV_BOOL:
-          qv->type = JQVAL_BOOL;
-          qv->vbool = jn->vbool;
-          break;
-        case JBV_I64:
-          qv->type = JQVAL_I64;
-          qv->vi64 = jn->vi64;
-          break;
-        case JBV_F64:
-          qv->type = JQVAL_F64;
-          qv->vf64 = jn->vf64;
-          break;
-        case JBV_STR:
-          qv->type = JQVAL_STR;
-          qv->vstr = jn->vptr;
-          break;
-        case JBV_NULL:
-          qv->type = JQVAL_NULL;
-          break;
-        default:
-          qv->type = JQVAL_JBLNODE;
-          qv->vnode = &unit->json.jn;
-          break;
-      }
-      return unit->json.opaque;
-    }
-    case JQP_INTEGER_TYPE: {
-      if (unit->intval.opaque) {
-        return (JQVAL*) unit->intval.opaque;
-      }
-      JQVAL *qv = iwpool_calloc(sizeof(*qv), aux->pool);
-      if (!qv) {
-        *rcp = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-        return 0;
-      }
-      unit->intval.opaque = qv;
-      qv->type = JQVAL_I64;
-      qv->vi64 = unit->intval.value;
-      return unit->intval.opaque;
-    }
-    case JQP_DOUBLE_TYPE: {
-      if (unit->dblval.opaque) {
-        return (JQVAL*) unit->dblval.opaque;
-      }
-      JQVAL *qv = iwpool_calloc(sizeof(*qv), aux->pool);
-      if (!qv) {
-        *rcp = iwrc_set_errno(IW_ERROR_ALLOC, errno);
-        return 0;
-      }
-      unit->dblval.opaque = qv;
-      qv->type = JQVAL_F64;
-      qv->vf64 = unit->dblval.value;
-      return unit->dblval.opaque;
-    }
+      qv = unit->string.opaque;
+      break;
+    case JQP_JSON_TYPE:
+      qv = unit->json.opaque;
+      break;
+    case JQP_INTEGER_TYPE:
+      qv = unit->intval.opaque;
+      break;
+    case JQP_DOUBLE_TYPE:
+      qv = unit->dblval.opaque;
+      break;
     default:
-      iwlog_ecode_error3(IW_ERROR_ASSERTION);
-      *rcp = IW_ERROR_ASSERTION;
-      return 0;
+      qv = 0;
+      break;
+  }
+  if (!qv) { // Unit values are created in `_jql_init_unit()`
+    iwlog_ecode_error3(IW_ERROR_ASSERTION);
+    *rcp = IW_ERROR_ASSERTION;
   }
+  return qv;
 }
 
-JQVAL* jql_unit_to_jqval(JQP_AUX *aux, JQPUNIT *unit, iwrc *rcp) {
-  return _jql_unit_to_jqval(aux, unit, rcp);
+JQVAL* jql_unit_to_jqval(JQL q, JQPUNIT *unit, iwrc *rcp) {
+  return _jql_unit_to_jqval(q, unit, rcp);
 }
 
 bool jql_jqval_as_int(JQVAL *jqval, int64_t *out) {
@@ -1216,7 +1518,7 @@ bool jql_jqval_as_int(JQVAL *jqval, int64_t *out) {
 }
 
 static bool _jql_match_node_expr_impl(MCTX *mctx, JQP_EXPR *expr, iwrc *rcp) {
-  if (expr->prematched) {
+  if (mctx->q->prematched[expr->idx]) {
     return true;
   }
   const bool negate = (expr->join && expr->join->negate);
@@ -1225,13 +1527,13 @@ static bool _jql_match_node_expr_impl(MCTX *mctx, JQP_EXPR *expr, iwrc *rcp) {
   JQPUNIT *right = expr->right;
   if (left->type == JQP_STRING_TYPE) {
     if (left->string.flavour & JQP_STR_STAR) {
-      JQVAL lv, *rv = _jql_unit_to_jqval(mctx->aux, right, rcp);
+      JQVAL lv, *rv = _jql_unit_to_jqval(mctx->q, right, rcp);
       if (*rcp) {
         return false;
       }
       lv.type = JQVAL_STR;
       lv.vstr = mctx->key;
-      bool ret = _jql_match_jqval_pair(mctx->aux, &lv, op, rv, rcp);
+      bool ret = _jql_match_jqval_pair(mctx->q, &lv, op, rv, rcp);
       return negate != (0 == !ret);
     } else if (  !(left->string.flavour & JQP_STR_DBL_STAR)
               && (strcmp(mctx->key, left->string.value) != 0)) {
@@ -1243,29 +1545,30 @@ static bool _jql_match_node_expr_impl(MCTX *mctx, JQP_EXPR *expr, iwrc *rcp) {
       *rcp = IW_ERROR_ASSERTION;
       return false;
     }
-    JQVAL lv, *rv = _jql_unit_to_jqval(mctx->aux, left->expr.right, rcp);
+    JQVAL lv, *rv = _jql_unit_to_jqval(mctx->q, left->expr.right, rcp);
     if (*rcp) {
       return false;
     }
     lv.type = JQVAL_STR;
     lv.vstr = mctx->key;
-    if (!_jql_match_jqval_pair(mctx->aux, &lv, left->expr.op, rv, rcp)) {
+    if (!_jql_match_jqval_pair(mctx->q, &lv, left->expr.op, rv, rcp)) {
       return negate;
     }
   }
-  JQVAL lv, *rv = _jql_unit_to_jqval(mctx->aux, right, rcp);
+  JQVAL lv, *rv = _jql_unit_to_jqval(mctx->q, right, rcp);
   if (*rcp) {
     return false;
   }
   lv.type = JQVAL_BINN;
   lv.vbinn = mctx->bv;
-  bool ret = _jql_match_jqval_pair(mctx->aux, &lv, expr->op, rv, rcp);
+  bool ret = _jql_match_jqval_pair(mctx->q, &lv, expr->op, rv, rcp);
   return negate != (0 == !ret);
 }
 
 static bool _jql_match_node_expr(MCTX *mctx, JQP_NODE *n, iwrc *rcp) {
-  n->start = mctx->lvl;
-  n->end = n->start;
+  struct jql_node_state *ns = &mctx->q->nodes[n->idx];
+  ns->start = mctx->lvl;
+  ns->end = ns->start;
   JQPUNIT *unit = n->value;
   if (unit->type != JQP_EXPR_TYPE) {
     iwlog_ecode_error3(IW_ERROR_ASSERTION);
@@ -1294,8 +1597,9 @@ static bool _jql_match_node_expr(MCTX *mctx, JQP_NODE *n, iwrc *rcp) {
 }
 
 IW_INLINE bool _jql_match_node_field(MCTX *mctx, JQP_NODE *n, iwrc *rcp) {
-  n->start = mctx->lvl;
-  n->end = n->start;
+  struct jql_node_state *ns = &mctx->q->nodes[n->idx];
+  ns->start = mctx->lvl;
+  ns->end = ns->start;
   if (n->value->type != JQP_STRING_TYPE) {
     iwlog_ecode_error3(IW_ERROR_ASSERTION);
     *rcp = IW_ERROR_ASSERTION;
@@ -1306,19 +1610,20 @@ IW_INLINE bool _jql_match_node_field(MCTX *mctx, JQP_NODE *n, iwrc *rcp) {
 
 // NOLINTNEXTLINE(misc-no-recursion)
 IW_INLINE JQP_NODE* _jql_match_node_anys(MCTX *mctx, JQP_NODE *n, bool *res, iwrc *rcp) {
-  if (n->start < 0) {
-    n->start = mctx->lvl;
+  struct jql_node_state *ns = &mctx->q->nodes[n->idx];
+  if (ns->start < 0) {
+    ns->start = mctx->lvl;
   }
   if (n->next) {
     JQP_NODE *nn = _jql_match_node(mctx, n->next, res, rcp);
     if (*res) {
-      n->end = -mctx->lvl; // Exclude node from matching
+      ns->end = -mctx->lvl; // Exclude node from matching
       n = nn;
     } else {
-      n->end = INT_MAX; // Gather next level
+      ns->end = INT_MAX; // Gather next level
     }
   } else {
-    n->end = INT_MAX;
+    ns->end = INT_MAX;
   }
   *res = true;
   return n;
@@ -1333,11 +1638,13 @@ static JQP_NODE* _jql_match_node(MCTX *mctx, JQP_NODE *n, bool *res, iwrc *rcp)
     case JQP_NODE_EXPR:
       *res = _jql_match_node_expr(mctx, n, rcp);
       return n;
-    case JQP_NODE_ANY:
-      n->start = mctx->lvl;
-      n->end = n->start;
+    case JQP_NODE_ANY: {
+      struct jql_node_state *ns = &mctx->q->nodes[n->idx];
+      ns->start = mctx->lvl;
+      ns->end = ns->start;
       *res = true;
       return n;
+    }
     case JQP_NODE_ANYS:
       return _jql_match_node_anys(mctx, n, res, rcp);
   }
@@ -1345,47 +1652,49 @@ static JQP_NODE* _jql_match_node(MCTX *mctx, JQP_NODE *n, bool *res, iwrc *rcp)
 }
 
 static bool _jql_match_filter(JQP_FILTER *f, MCTX *mctx, iwrc *rcp) {
-  MFCTX *fctx = f->opaque;
-  if (fctx->matched) {
+  struct jql_node_state *nodes = mctx->q->nodes;
+  struct jql_enode_state *fs = &mctx->q->enodes[f->idx];
+  if (fs->matched) {
     return true;
   }
   bool matched = false;
   const int lvl = mctx->lvl;
-  if (fctx->last_lvl + 1 < lvl) {
+  if (fs->last_lvl + 1 < lvl) {
     return false;
   }
-  if (fctx->last_lvl >= lvl) {
-    fctx->last_lvl = lvl - 1;
-    for (JQP_NODE *n = fctx->nodes; n; n = n->next) {
-      if ((n->start >= lvl) || (-n->end >= lvl)) {
-        n->start = -1;
-        n->end = -1;
+  if (fs->last_lvl >= lvl) {
+    fs->last_lvl = lvl - 1;
+    for (JQP_NODE *n = f->node; n; n = n->next) {
+      struct jql_node_state *ns = &nodes[n->idx];
+      if ((ns->start >= lvl) || (-ns->end >= lvl)) {
+        ns->start = -1;
+        ns->end = -1;
       }
     }
   }
-  for (JQP_NODE *n = fctx->nodes; n; n = n->next) {
-    if ((n->start < 0) || ((lvl >= n->start) && (lvl <= n->end))) {
+  for (JQP_NODE *n = f->node; n; n = n->next) {
+    struct jql_node_state *ns = &nodes[n->idx];
+    if ((ns->start < 0) || ((lvl >= ns->start) && (lvl <= ns->end))) {
       n = _jql_match_node(mctx, n, &matched, rcp);
       if (*rcp) {
         return false;
       }
       if (matched) {
-        if (n == fctx->last_node) {
-          fctx->matched = true;
+        if (!n->next) { // Last filter node matched
+          fs->matched = true;
           mctx->q->dirty = true;
         }
-        fctx->last_lvl = lvl;
+        fs->last_lvl = lvl;
       }
       break;
     }
   }
-  return fctx->matched;
+  return fs->matched;
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
 static bool _jql_match_expression_node(JQP_EXPR_NODE *en, MCTX *mctx, iwrc *rcp) {
-  MENCTX *enctx = en->opaque;
-  if (enctx->matched) {
+  if (mctx->q->enodes[en->idx].matched) {
     return true;
   }
   bool prev = false;
@@ -1439,7 +1748,7 @@ static jbl_visitor_cmd_t _jql_match_visitor(int lvl, binn *bv, const char *key,
   }
   if (q->dirty) {
     q->dirty = false;
-    if (!_jql_need_deeper_match(mctx.aux->expr, lvl)) {
+    if (!_jql_need_deeper_match(q, mctx.aux->expr, lvl)) {
       return JBL_VCMD_SKIP_NESTED;
     }
   }
@@ -1518,6 +1827,10 @@ bool jql_has_aggregate_count(JQL q) {
   return (q->aux->qmode & JQP_QRY_AGGREGATE);
 }
 
+bool jql_has_aggregates(JQL q) {
+  return (q->aux->qmode & JQP_QRY_GROUP);
+}
+
 iwrc jql_get_skip(JQL q, int64_t *out) {
   iwrc rc = 0;
   *out = 0;
@@ -1526,7 +1839,7 @@ iwrc jql_get_skip(JQL q, int64_t *out) {
   if (!skip) {
     return 0;
   }
-  JQVAL *val = _jql_unit_to_jqval(aux, skip, &rc);
+  JQVAL *val = _jql_unit_to_jqval(q, skip, &rc);
   RCRET(rc);
   if ((val->type != JQVAL_I64) || (val->vi64 < 0)) { // -V522
     return JQL_ERROR_INVALID_PLACEHOLDER;
@@ -1543,7 +1856,7 @@ iwrc jql_get_limit(JQL q, int64_t *out) {
   if (!limit) {
     return 0;
   }
-  JQVAL *val = _jql_unit_to_jqval(aux, limit, &rc);
+  JQVAL *val = _jql_unit_to_jqval(q, limit, &rc);
   RCRET(rc);
   if ((val->type != JQVAL_I64) || (val->vi64 < 0)) { // -V522
     return JQL_ERROR_INVALID_PLACEHOLDER;
@@ -1558,11 +1871,19 @@ iwrc jql_get_limit(JQL q, int64_t *out) {
 #define PROJ_MARK_KEEP      0x02
 #define PROJ_MARK_FROM_JOIN 0x04
 
+/** Projection matching state */
+typedef struct _PROJ_STATE {
+  int16_t pos;          // Current matching position
+  int16_t cnt;          // Number of projection sections
+} PROJ_STATE;
+
 typedef struct _PROJ_CTX {
   JQL q;
   JQP_PROJECTION *proj;
+  PROJ_STATE     *pstates; // Indexed by `JQP_PROJECTION.idx`
   IWPOOL *pool;
   JBEXEC *exec_ctx; // Optional!
+  bool    has_exclude; // Has exclude projections
 } PROJ_CTX;
 
 static void _jql_proj_mark_up(JBL_NODE n, int amask) {
@@ -1575,139 +1896,194 @@ static void _jql_proj_mark_up(JBL_NODE n, int amask) {
 static bool _jql_proj_matched(
   int16_t lvl, JBL_NODE n,
   const char *key, int keylen,
-  JBN_VCTX *vctx, JQP_PROJECTION *proj,
+  PROJ_CTX *pctx, JQP_PROJECTION *proj,
   iwrc *rc) {
-  if (proj->cnt <= lvl) {
+  PROJ_STATE *pst = &pctx->pstates[proj->idx];
+  if (pst->cnt <= lvl) {
     return false;
   }
-  if (proj->pos >= lvl) {
-    proj->pos = lvl - 1;
+  if (pst->pos >= lvl) {
+    pst->pos = lvl - 1;
   }
-  if (proj->pos + 1 == lvl) {
+  if (pst->pos + 1 == lvl) {
     JQP_STRING *ps = proj->value;
     for (int i = 0; i < lvl; ps = ps->next, ++i); // -V529
     assert(ps);
     if (ps->flavour & JQP_STR_PROJFIELD) {
       for (JQP_STRING *sn = ps; sn; sn = sn->subnext) {
-        const char *pv = IW_UNLIKELY(sn->flavour & JQP_STR_PLACEHOLDER) ? ((JQVAL*) sn->opaque)->vstr : sn->value;
+        const char *pv = IW_UNLIKELY(sn->flavour & JQP_STR_PLACEHOLDER) ? pctx->q->pvals[sn->idx]->vstr : sn->value;
         int pvlen = (int) strlen(pv);
         if ((pvlen == keylen) && !strncmp(key, pv, keylen)) {
-          proj->pos = lvl;
-          return (proj->cnt == lvl + 1);
+          pst->pos = lvl;
+          return (pst->cnt == lvl + 1);
         }
       }
     } else {
-      const char *pv = IW_UNLIKELY(ps->flavour & JQP_STR_PLACEHOLDER) ? ((JQVAL*) ps->opaque)->vstr : ps->value;
+      const char *pv = IW_UNLIKELY(ps->flavour & JQP_STR_PLACEHOLDER) ? pctx->q->pvals[ps->idx]->vstr : ps->value;
       int pvlen = (int) strlen(pv);
       if (((pvlen == keylen) && !strncmp(key, pv, keylen)) || ((pv[0] == '*') && (pv[1] == '\0'))) {
-        proj->pos = lvl;
-        return (proj->cnt == lvl + 1);
+        pst->pos = lvl;
+        return (pst->cnt == lvl + 1);
       }
     }
   }
   return false;
 }
 
-static bool _jql_proj_join_matched(
-  int16_t lvl, JBL_NODE n,
+/**
+ * Matches `key` against last section of join projection `proj`.
+ * Sets `collp` to the name of joined collection if `key` holds joined document id.
+ */
+static bool _jql_proj_join_key_matched(
+  int16_t lvl,
   const char *key, int keylen,
-  JBN_VCTX *vctx, JQP_PROJECTION *proj,
-  JBL *out,
-  iwrc *rcp) {
-  PROJ_CTX *pctx = vctx->op;
-  if (proj->cnt != lvl + 1) {
-    return _jql_proj_matched(lvl, n, key, keylen, vctx, proj, rcp);
+  PROJ_CTX *pctx, JQP_PROJECTION *proj,
+  const char **collp) {
+  *collp = 0;
+  PROJ_STATE *pst = &pctx->pstates[proj->idx];
+  if (pst->cnt != lvl + 1) {
+    return _jql_proj_matched(lvl, 0, key, keylen, pctx, proj, 0);
+  }
+  if (pst->pos >= lvl) {
+    pst->pos = lvl - 1;
+  }
+  if (pst->pos + 1 != lvl) {
+    return false;
   }
-
-  iwrc rc = 0;
-  JBL jbl = 0;
-  const char *pv, *spos;
-  bool ret = false;
   JQP_STRING *ps = proj->value;
   for (int i = 0; i < lvl; ps = ps->next, ++i); // -V529
   assert(ps);
 
-  if (ps->flavour & JQP_STR_PROJFIELD) {
-    for (JQP_STRING *sn = ps; sn; sn = sn->subnext) {
-      pv = IW_UNLIKELY(sn->flavour & JQP_STR_PLACEHOLDER) ? ((JQVAL*) sn->opaque)->vstr : sn->value;
-      spos = strchr(pv, '<');
-      if (!spos) {
-        if ((strlen(pv) == keylen) && !strncmp(key, pv, keylen)) {
-          proj->pos = lvl;
-          return true;
+  for (JQP_STRING *sn = ps; sn; sn = (ps->flavour & JQP_STR_PROJFIELD) ? sn->subnext : 0) {
+    const char *pv = IW_UNLIKELY(sn->flavour & JQP_STR_PLACEHOLDER) ? pctx->q->pvals[sn->idx]->vstr : sn->value;
+    const char *spos = strchr(pv, '<');
+    int pvlen = spos ? (int) (spos - pv) : (int) strlen(pv);
+    if ((pvlen == keylen) && !strncmp(key, pv, keylen)) {
+      if (spos) {
+        if (spos[1] == '\0') {
+          return false;
         }
+        *collp = spos + 1;
       }
-      ret = !strncmp(key, pv, spos - pv);
-      if (ret) {
-        break;
-      }
-    }
-  } else {
-    pv = IW_UNLIKELY(ps->flavour & JQP_STR_PLACEHOLDER) ? ((JQVAL*) ps->opaque)->vstr : ps->value;
-    spos = strchr(pv, '<');
-    assert(spos);
-    ret = !strncmp(key, pv, spos - pv);
-  }
-  if (ret) {
-    JBL_NODE nn;
-    JQVAL jqval;
-    int64_t id;
-    JBEXEC *exec_ctx = pctx->exec_ctx;
-    const char *coll = spos + 1;
-    if (*coll == '\0') {
-      return false;
-    }
-    jql_node_to_jqval(n, &jqval);
-    if (!jql_jqval_as_int(&jqval, &id)) {
-      // Unable to convert current node value as int number
-      return false;
+      pst->pos = lvl;
+      return true;
     }
-    IWHMAP *cache = exec_ctx->proj_joined_nodes_cache;
-    IWPOOL *pool = exec_ctx->ux->pool;
+  }
+  return false;
+}
+
+/**
+ * Returns joined nodes cache of query execution context.
+ * Cache is reset if it is backed by execution context own pool grown too big.
+ */
+static iwrc _jql_proj_join_cache(JBEXEC *exec_ctx, IWHMAP **cachep, IWPOOL **poolp) {
+  IWHMAP *cache = exec_ctx->proj_joined_nodes_cache;
+  IWPOOL *pool = exec_ctx->ux->pool;
+  if (!pool) {
+    pool = exec_ctx->proj_joined_nodes_pool;
     if (!pool) {
-      pool = exec_ctx->proj_joined_nodes_pool;
+      pool = iwpool_create(512);
       if (!pool) {
-        pool = iwpool_create(512);
-        RCGA(pool, finish);
-        exec_ctx->proj_joined_nodes_pool = pool;
-      } else if (cache && (iwpool_used_size(pool) > 10UL * 1024 * 1024)) { // 10Mb
-        exec_ctx->proj_joined_nodes_cache = 0;
-        iwhmap_destroy(exec_ctx->proj_joined_nodes_cache);
-        cache = 0;
-        iwpool_destroy(pool);
-        pool = iwpool_create(1024UL * 1024); // 1Mb
-        RCGA(pool, finish);
+        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
       }
+      exec_ctx->proj_joined_nodes_pool = pool;
+    } else if (cache && (iwpool_used_size(pool) > 10UL * 1024 * 1024)) { // 10Mb
+      iwhmap_destroy(cache);
+      exec_ctx->proj_joined_nodes_cache = 0;
+      cache = 0;
+      iwpool_destroy(pool);
+      exec_ctx->proj_joined_nodes_pool = 0;
+      pool = iwpool_create(1024UL * 1024); // 1Mb
+      if (!pool) {
+        return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+      }
+      exec_ctx->proj_joined_nodes_pool = pool;
     }
+  }
+  if (!cache) {
+    cache = iwhmap_create(jb_proj_node_cache_cmp, jb_proj_node_hash, jb_proj_node_kvfree);
     if (!cache) {
-      RCB(finish, cache = iwhmap_create(jb_proj_node_cache_cmp, jb_proj_node_hash, jb_proj_node_kvfree));
-      exec_ctx->proj_joined_nodes_cache = cache;
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
     }
-    struct jbdocref ref = {
-      .id = id,
-      .coll = coll
-    };
-    nn = iwhmap_get(cache, &ref);
-    if (!nn) {
-      rc = jb_collection_join_resolver(id, coll, &jbl, exec_ctx);
-      if (rc) {
-        if ((rc == IW_ERROR_NOT_EXISTS) || (rc == IWKV_ERROR_NOTFOUND)) {
-          // If collection is not exists or record is not found just
-          // keep all untouched
-          rc = 0;
-          ret = false;
-        }
-        goto finish;
+    exec_ctx->proj_joined_nodes_cache = cache;
+  }
+  *cachep = cache;
+  *poolp = pool;
+  return 0;
+}
+
+static iwrc _jql_proj_join_cache_put(IWHMAP *cache, IWPOOL *pool, const struct jbdocref *ref, JBL jbl, JBL_NODE *out) {
+  JBL_NODE nn;
+  iwrc rc = jbl_to_node(jbl, &nn, true, pool);
+  RCRET(rc);
+  struct jbdocref *refkey = malloc(sizeof(*refkey));
+  if (!refkey) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  *refkey = *ref;
+  rc = iwhmap_put(cache, refkey, nn);
+  if (rc) {
+    free(refkey);
+    return rc;
+  }
+  if (out) {
+    *out = nn;
+  }
+  return 0;
+}
+
+static bool _jql_proj_join_matched(
+  int16_t lvl, JBL_NODE n,
+  const char *key, int keylen,
+  JBN_VCTX *vctx, JQP_PROJECTION *proj,
+  JBL *out,
+  iwrc *rcp) {
+  PROJ_CTX *pctx = vctx->op;
+  PROJ_STATE *pst = &pctx->pstates[proj->idx];
+  const char *coll;
+  bool ret = _jql_proj_join_key_matched(lvl, key, keylen, pctx, proj, &coll);
+  if (!ret || !coll) {
+    return ret;
+  }
+
+  iwrc rc = 0;
+  JBL jbl = 0;
+  JBL_NODE nn;
+  JQVAL jqval;
+  int64_t id;
+  IWHMAP *cache;
+  IWPOOL *pool;
+  JBEXEC *exec_ctx = pctx->exec_ctx;
+  if (!exec_ctx) { // Joins are resolved only within query execution
+    return false;
+  }
+
+  jql_node_to_jqval(n, &jqval);
+  if (!jql_jqval_as_int(&jqval, &id)) {
+    // Unable to convert current node value as int number
+    return false;
+  }
+  RCC(rc, finish, _jql_proj_join_cache(exec_ctx, &cache, &pool));
+  struct jbdocref ref = {
+    .id = id,
+    .coll = coll
+  };
+  nn = iwhmap_get(cache, &ref);
+  if (!nn) {
+    rc = jb_collection_join_resolver(id, coll, &jbl, exec_ctx);
+    if (rc) {
+      if ((rc == IW_ERROR_NOT_EXISTS) || (rc == IWKV_ERROR_NOTFOUND)) {
+        // If collection is not exists or record is not found just
+        // keep all untouched
+        rc = 0;
+        ret = false;
       }
-      RCC(rc, finish, jbl_to_node(jbl, &nn, true, pool));
-      struct jbdocref *refkey = malloc(sizeof(*refkey));
-      RCGA(refkey, finish);
-      *refkey = ref;
-      RCC(rc, finish, iwhmap_put(cache, refkey, nn));
+      goto finish;
     }
-    jbn_apply_from(n, nn);
-    proj->pos = lvl;
+    RCC(rc, finish, _jql_proj_join_cache_put(cache, pool, &ref, jbl, &nn));
   }
+  jbn_apply_from(n, nn);
+  pst->pos = lvl;
 
 finish:
   jbl_destroy(&jbl);
@@ -1735,7 +2111,7 @@ static jbn_visitor_cmd_t _jql_proj_visitor(int lvl, JBL_NODE n, const char *key,
     if (flags & JQP_PROJECTION_FLAG_JOINS) {
       matched = _jql_proj_join_matched((int16_t) lvl, n, keyptr, klidx, vctx, p, &jbl, rc);
     } else {
-      matched = _jql_proj_matched((int16_t) lvl, n, keyptr, klidx, vctx, p, rc);
+      matched = _jql_proj_matched((int16_t) lvl, n, keyptr, klidx, pctx, p, rc);
     }
     RCRET(*rc);
     if (matched) {
@@ -1763,6 +2139,23 @@ static jbn_visitor_cmd_t _jql_proj_keep_visitor(
   return JBN_VCMD_DELETE;
 }
 
+static iwrc _jql_proj_states_init(JQL q, PROJ_STATE *pstates) {
+  for (JQP_PROJECTION *p = q->aux->projection; p; p = p->next) {
+    PROJ_STATE *pst = &pstates[p->idx];
+    pst->pos = -1;
+    pst->cnt = 0;
+    for (JQP_STRING *s = p->value; s; s = s->next) {
+      if (s->flavour & JQP_STR_PLACEHOLDER) {
+        if (q->pvals[s->idx] == 0 || q->pvals[s->idx]->type != JQVAL_STR) {
+          return JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
+        }
+      }
+      pst->cnt++;
+    }
+  }
+  return 0;
+}
+
 static iwrc _jql_project(JBL_NODE root, JQL q, IWPOOL *pool, JBEXEC *exec_ctx) {
   iwrc rc;
   JQP_AUX *aux = q->aux;
@@ -1771,9 +2164,11 @@ static iwrc _jql_project(JBL_NODE root, JQL q, IWPOOL *pool, JBEXEC *exec_ctx) {
     return 0;
   }
   JQP_PROJECTION *proj = aux->projection;
+  PROJ_STATE pstates[aux->num_projections];
   PROJ_CTX pctx = {
     .q = q,
     .proj = proj,
+    .pstates = pstates,
     .pool = pool,
     .exec_ctx = exec_ctx,
   };
@@ -1781,18 +2176,7 @@ static iwrc _jql_project(JBL_NODE root, JQL q, IWPOOL *pool, JBEXEC *exec_ctx) {
     // No pool no exec_ctx
     pctx.exec_ctx = 0;
   }
-  for (JQP_PROJECTION *p = proj; p; p = p->next) {
-    p->pos = -1;
-    p->cnt = 0;
-    for (JQP_STRING *s = p->value; s; s = s->next) {
-      if (s->flavour & JQP_STR_PLACEHOLDER) {
-        if (s->opaque == 0 || ((JQVAL*) s->opaque)->type != JQVAL_STR) {
-          return JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE;
-        }
-      }
-      p->cnt++;
-    }
-  }
+  RCRET(_jql_proj_states_init(q, pstates));
   JBN_VCTX vctx = {
     .root = root,
     .op = &pctx
@@ -1807,6 +2191,268 @@ finish:
   return rc;
 }
 
+/**
+ * Projects binn container `bn` at level `lvl` into `parent` node
+ * copying only retained values. Whole document tree is never built.
+ *
+ * @param keep Container is retained as whole, so only excluded values are skipped.
+ * @param [out] pathp Set to true if some nested value is retained by keep projection.
+ */
+static iwrc _jql_proj_binn(PROJ_CTX *pctx, int16_t lvl, const binn *bn, JBL_NODE parent, bool keep, bool *pathp) {
+  iwrc rc = 0;
+  binn bv;
+  binn_iter iter;
+  char *key;
+  int klidx;
+  char nbuf[IWNUMBUF_SIZE];
+  JQP_AUX *aux = pctx->q->aux;
+
+  if (!binn_iter_init(&iter, bn->ptr, bn->type)) {
+    return JBL_ERROR_INVALID;
+  }
+  while (binn_read_next_pair2(bn->type, &iter, &klidx, &key, &bv)) {
+    JBL_NODE n = 0;
+    int keylen = klidx;
+    const char *keyptr = key;
+    bool excluded = false, included = false, path = false;
+    if (!key) {
+      iwitoa(klidx, nbuf, IWNUMBUF_SIZE);
+      keyptr = nbuf;
+      keylen = (int) strlen(keyptr);
+    }
+    for (JQP_PROJECTION *p = pctx->proj; p; p = p->next) {
+      if (_jql_proj_matched(lvl, 0, keyptr, keylen, pctx, p, &rc)) {
+        if (p->flags & JQP_PROJECTION_FLAG_EXCLUDE) {
+          excluded = true;
+          break;
+        } else if (p->flags & JQP_PROJECTION_FLAG_INCLUDE) {
+          included = true;
+        }
+      }
+    }
+    if (included) {
+      *pathp = true;
+    }
+    if (excluded) {
+      continue;
+    }
+    bool retain = keep || included || !aux->has_keep_projections;
+    if (  ((bv.type == BINN_OBJECT) || (bv.type == BINN_LIST))
+       && !(retain && !pctx->has_exclude)) {
+      RCB(finish, n = iwpool_calloc(sizeof(*n), pctx->pool));
+      n->type = (bv.type == BINN_OBJECT) ? JBV_OBJECT : JBV_ARRAY;
+      RCC(rc, finish, _jql_proj_binn(pctx, lvl + 1, &bv, n, retain, &path));
+      if (path) {
+        *pathp = true;
+        retain = true;
+      }
+    } else if (retain) {
+      RCC(rc, finish, _jbl_node_from_binn(&bv, &n, true, pctx->pool));
+    }
+    if (retain) {
+      if (parent->type == JBV_OBJECT) {
+        RCB(finish, n->key = iwpool_strndup2(pctx->pool, key, klidx));
+        n->klidx = klidx;
+      }
+      jbn_add_item(parent, n);
+    }
+  }
+
+finish:
+  return rc;
+}
+
+static iwrc _jql_project_binn(JBL jbl, JQL q, IWPOOL *pool, JBL_NODE *out) {
+  bool path = false;
+  JQP_AUX *aux = q->aux;
+  PROJ_STATE pstates[aux->num_projections];
+  PROJ_CTX pctx = {
+    .q = q,
+    .proj = aux->projection,
+    .pstates = pstates,
+    .pool = pool
+  };
+  JBL_NODE root = iwpool_calloc(sizeof(*root), pool);
+  if (!root) {
+    return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+  }
+  root->type = (jbl->bn.type == BINN_OBJECT) ? JBV_OBJECT : JBV_ARRAY;
+  if (!aux->has_exclude_all_projection) {
+    RCRET(_jql_proj_states_init(q, pstates));
+    for (JQP_PROJECTION *p = aux->projection; p; p = p->next) {
+      if (p->flags & JQP_PROJECTION_FLAG_EXCLUDE) {
+        pctx.has_exclude = true;
+        break;
+      }
+    }
+    RCRET(_jql_proj_binn(&pctx, 0, &jbl->bn, root, false, &path));
+  }
+  *out = root;
+  return 0;
+}
+
+/** Joined documents references collected from documents */
+struct _jql_join_refs {
+  struct jbdocref *refs;
+  int num;
+  int asz;
+};
+
+/** Joined documents fetch context */
+struct _jql_join_fetch {
+  IWHMAP     *cache;
+  IWPOOL     *pool;
+  const char *coll;
+};
+
+static iwrc _jql_join_refs_add(struct _jql_join_refs *jr, const char *coll, int64_t id) {
+  if (jr->num >= jr->asz) {
+    int nsz = jr->asz ? jr->asz * 2 : 64;
+    struct jbdocref *nrefs = realloc(jr->refs, nsz * sizeof(jr->refs[0]));
+    if (!nrefs) {
+      return iwrc_set_errno(IW_ERROR_ALLOC, errno);
+    }
+    jr->refs = nrefs;
+    jr->asz = nsz;
+  }
+  jr->refs[jr->num++] = (struct jbdocref) {
+    .id = id,
+    .coll = coll
+  };
+  return 0;
+}
+
+static int _jql_join_refs_cmp(const void *v1, const void *v2) {
+  const struct jbdocref *r1 = v1;
+  const struct jbdocref *r2 = v2;
+  int ret = strcmp(r1->coll, r2->coll);
+  if (!ret) {
+    return r1->id > r2->id ? 1 : r1->id < r2->id ? -1 : 0;
+  }
+  return ret;
+}
+
+/**
+ * Collects ids of joined documents referenced from binn container `bn` at level `lvl`.
+ */
+static iwrc _jql_join_refs_binn(PROJ_CTX *pctx, int16_t lvl, const binn *bn, struct _jql_join_refs *jr) {
+  iwrc rc = 0;
+  binn bv;
+  binn_iter iter;
+  char *key;
+  int klidx;
+  char nbuf[IWNUMBUF_SIZE];
+
+  if (!binn_iter_init(&iter, bn->ptr, bn->type)) {
+    return JBL_ERROR_INVALID;
+  }
+  while (binn_read_next_pair2(bn->type, &iter, &klidx, &key, &bv)) {
+    bool nested = false;
+    int keylen = klidx;
+    const char *keyptr = key;
+    if (!key) {
+      iwitoa(klidx, nbuf, IWNUMBUF_SIZE);
+      keyptr = nbuf;
+      keylen = (int) strlen(keyptr);
+    }
+    for (JQP_PROJECTION *p = pctx->proj; p; p = p->next) {
+      const char *coll;
+      if (!(p->flags & JQP_PROJECTION_FLAG_JOINS)) {
+        continue;
+      }
+      PROJ_STATE *pst = &pctx->pstates[p->idx];
+      if (_jql_proj_join_key_matched(lvl, keyptr, keylen, pctx, p, &coll) && coll) {
+        int64_t id;
+        JQVAL jqval;
+        jql_binn_to_jqval(&bv, &jqval);
+        if (jql_jqval_as_int(&jqval, &id)) {
+          RCRET(_jql_join_refs_add(jr, coll, id));
+        }
+      } else if ((pst->pos == lvl) && (pst->cnt > lvl + 1)) {
+        nested = true;
+      }
+    }
+    if (nested && ((bv.type == BINN_OBJECT) || (bv.type == BINN_LIST))) {
+      RCRET(_jql_join_refs_binn(pctx, lvl + 1, &bv, jr));
+    }
+  }
+  return rc;
+}
+
+static iwrc _jql_join_fetch_visitor(int64_t id, JBL jbl, void *op) {
+  struct _jql_join_fetch *f = op;
+  struct jbdocref ref = {
+    .id = id,
+    .coll = f->coll
+  };
+  return _jql_proj_join_cache_put(f->cache, f->pool, &ref, jbl, 0);
+}
+
+iwrc jql_proj_joins_prefetch(JQL q, struct jbl *docs, int num, struct jbexec *exec_ctx) {
+  iwrc rc = 0;
+  IWHMAP *cache;
+  IWPOOL *pool;
+  int64_t *ids = 0;
+  JQP_AUX *aux = q->aux;
+  struct _jql_join_refs jr = { 0 };
+  PROJ_STATE pstates[aux->num_projections];
+  PROJ_CTX pctx = {
+    .q = q,
+    .proj = aux->projection,
+    .pstates = pstates,
+    .exec_ctx = exec_ctx
+  };
+  if (aux->has_exclude_all_projection || !exec_ctx) {
+    return 0;
+  }
+  for (int i = 0; i < num; ++i) {
+    if ((docs[i].bn.type == BINN_OBJECT) || (docs[i].bn.type == BINN_LIST)) {
+      RCC(rc, finish, _jql_proj_states_init(q, pstates));
+      RCC(rc, finish, _jql_join_refs_binn(&pctx, 0, &docs[i].bn, &jr));
+    }
+  }
+  if (!jr.num) {
+    goto finish;
+  }
+  RCC(rc, finish, _jql_proj_join_cache(exec_ctx, &cache, &pool));
+  RCA(ids = malloc(jr.num * sizeof(ids[0])), finish);
+  qsort(jr.refs, jr.num, sizeof(jr.refs[0]), _jql_join_refs_cmp);
+
+  // Fetch not cached documents in ascending order of ids per joined collection
+  for (int i = 0; i < jr.num; ) {
+    int n = 0;
+    const char *coll = jr.refs[i].coll;
+    for ( ; i < jr.num && !strcmp(jr.refs[i].coll, coll); ++i) {
+      if ((n && (ids[n - 1] == jr.refs[i].id)) || iwhmap_get(cache, &jr.refs[i])) {
+        continue;
+      }
+      ids[n++] = jr.refs[i].id;
+    }
+    if (n) {
+      struct _jql_join_fetch f = {
+        .cache = cache,
+        .pool = pool,
+        .coll = coll
+      };
+      RCC(rc, finish, jb_collection_join_fetch(exec_ctx, coll, ids, n, _jql_join_fetch_visitor, &f));
+    }
+  }
+
+finish:
+  free(jr.refs);
+  free(ids);
+  return rc;
+}
+
+bool jql_has_projection_joins(JQL q) {
+  for (JQP_PROJECTION *p = q->aux->projection; p; p = p->next) {
+    if (p->flags & JQP_PROJECTION_FLAG_JOINS) {
+      return true;
+    }
+  }
+  return false;
+}
+
 #undef PROJ_MARK_PATH
 #undef PROJ_MARK_KEEP
 
@@ -1834,12 +2480,35 @@ iwrc jql_project(JQL q, JBL_NODE root, IWPOOL *pool, void *exec_ctx) {
   }
 }
 
+iwrc jql_project_jbl(JQL q, JBL jbl, JBL_NODE *out, void *exec_ctx, IWPOOL *pool) {
+  *out = 0;
+  JQP_AUX *aux = q->aux;
+  if (!aux->projection) {
+    return 0;
+  }
+  if (jql_has_projection_joins(q) || ((jbl->bn.type != BINN_OBJECT) && (jbl->bn.type != BINN_LIST))) {
+    // Joined documents are applied to the document tree
+    JBL_NODE root;
+    iwrc rc = jbl_to_node(jbl, &root, true, pool);
+    RCRET(rc);
+    rc = _jql_project(root, q, pool, exec_ctx);
+    if (!rc) {
+      *out = root;
+    }
+    return rc;
+  }
+  return _jql_project_binn(jbl, q, pool, out);
+}
+
 iwrc jql_apply_and_project(JQL q, JBL jbl, JBL_NODE *out, void *exec_ctx, IWPOOL *pool) {
   *out = 0;
   JQP_AUX *aux = q->aux;
   if (!(aux->apply || aux->apply_placeholder || aux->projection)) {
     return 0;
   }
+  if (!(aux->apply || aux->apply_placeholder)) {
+    return jql_project_jbl(q, jbl, out, exec_ctx, pool);
+  }
   JBL_NODE root;
   iwrc rc = jbl_to_node(jbl, &root, false, pool);
   RCRET(rc);
@@ -1879,6 +2548,12 @@ static const char* _ecodefn(locale_t locale, uint32_t ecode) {
       return "No collection specified in query (JQL_ERROR_NO_COLLECTION)";
     case JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE:
       return "Invalid type of placeholder value (JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE)";
+    case JQL_ERROR_AGGREGATE_WITH_APPLY:
+      return "Aggregate functions and group by cannot be used with apply, upsert or del "
+             "(JQL_ERROR_AGGREGATE_WITH_APPLY)";
+    case JQL_ERROR_AGGREGATE_WITH_ORDERBY:
+      return "Groups of group by query cannot be ordered by asc/desc clauses "
+             "(JQL_ERROR_AGGREGATE_WITH_ORDERBY)";
     default:
       break;
   }
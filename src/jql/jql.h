@@ -60,6 +60,12 @@ typedef enum {
   JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE,
   /**< Invalid type of placeholder value
      (JQL_ERROR_INVALID_PLACEHOLDER_VALUE_TYPE) */
+  JQL_ERROR_AGGREGATE_WITH_APPLY,
+  /**< Aggregate functions and group by cannot be used with apply, upsert or del
+     (JQL_ERROR_AGGREGATE_WITH_APPLY) */
+  JQL_ERROR_AGGREGATE_WITH_ORDERBY,
+  /**< Groups of group by query cannot be ordered by asc/desc clauses
+     (JQL_ERROR_AGGREGATE_WITH_ORDERBY) */
   _JQL_ERROR_END,
   _JQL_ERROR_UNMATCHED,
 } jql_ecode_t;
@@ -83,6 +89,19 @@ IW_EXPORT WUR iwrc jql_create(struct jql * *qptr, const char *coll, const char *
 
 IW_EXPORT WUR iwrc jql_create2(struct jql * *qptr, const char *coll, const char *query, jql_create_mode_t mode);
 
+/**
+ * @brief Create a new query object sharing parsed query with `q`.
+ *
+ * Parsed query is immutable so any number of query objects created by `jql_clone()`
+ * can be executed concurrently in different threads. Every query object has its own
+ * matching state and placeholder values, placeholder values of `q` are not copied.
+ * Parsed query is released when the last of sharing query objects is destroyed.
+ *
+ * @param q Source query object
+ * @param qptr Pointer to resulting query object
+ */
+IW_EXPORT WUR iwrc jql_clone(struct jql *q, struct jql * *qptr);
+
 IW_EXPORT const char* jql_collection(struct jql *q);
 
 /**
@@ -155,6 +174,14 @@ IW_EXPORT bool jql_has_orderby(struct jql *q);
 
 IW_EXPORT bool jql_has_aggregate_count(struct jql *q);
 
+/**
+ * @brief Returns `true` if query has aggregate functions (`sum`, `avg`, `min`, `max`)
+ *        or `group by`/`distinct` clauses.
+ *
+ * Such query is visited by documents of aggregated groups instead of collection documents.
+ */
+IW_EXPORT bool jql_has_aggregates(struct jql *q);
+
 IW_EXPORT iwrc jql_get_skip(struct jql *q, int64_t *out);
 
 IW_EXPORT iwrc jql_get_limit(struct jql *q, int64_t *out);
@@ -163,6 +190,20 @@ IW_EXPORT WUR iwrc jql_apply(struct jql *q, struct jbl_node *root, struct iwpool
 
 IW_EXPORT WUR iwrc jql_project(struct jql *q, struct jbl_node *root, struct iwpool *pool, void *exec_ctx);
 
+/**
+ * @brief Builds projected document tree of `jbl` allocated in `pool`.
+ *
+ * Only values retained by query projection are copied from `jbl` binary buffer,
+ * the whole document tree is built only if projection contains joins.
+ * Sets `out` to zero if query has no projection.
+ */
+IW_EXPORT WUR iwrc jql_project_jbl(
+  struct jql       *q,
+  struct jbl       *jbl,
+  struct jbl_node **out,
+  void             *exec_ctx,
+  struct iwpool    *pool);
+
 IW_EXPORT WUR iwrc jql_apply_and_project(
   struct jql       *q,
   struct jbl       *jbl,
@@ -8,14 +8,37 @@
 #include <iowow/iwre.h>
 #include <math.h>
 
-/** Query object */
+/** Matching state of query expression node or filter */
+struct jql_enode_state {
+  bool matched;
+  int  last_lvl;     /**< Last matched level, used by filters */
+};
+
+/** Matching state of filter node */
+struct jql_node_state {
+  int start;
+  int end;
+};
+
+/**
+ * Query object.
+ * Keeps query matching state and placeholder values bound to
+ * the immutable parsed query `aux` what can be shared by many query objects.
+ */
 struct jql {
   bool       dirty;
   bool       matched;
   JQP_QUERY *qp;
   JQP_AUX   *aux;
-  const char *coll;
-  void       *opaque;
+  const char    *coll;
+  void          *opaque;
+  struct iwpool *pool;                   /**< Query object memory pool */
+  struct jql_enode_state *enodes;        /**< Expression nodes matching state, indexed by `JQP_EXPR_NODE.idx` */
+  struct jql_node_state  *nodes;         /**< Filter nodes matching state, indexed by `JQP_NODE.idx` */
+  bool *prematched;                      /**< Expressions matched by index scanners, indexed by `JQP_EXPR.idx` */
+  struct iwre  **rxs;                    /**< Compiled regexp cache, indexed by `JQP_OP.idx` */
+  char         **rxpfx;                  /**< Literal prefixes of anchored regexps, indexed by `JQP_OP.idx` */
+  struct jqval **pvals;                  /**< Placeholder values, indexed by `JQP_STRING.idx` */
 };
 
 /** Placeholder value type */
@@ -49,7 +72,20 @@ typedef struct jqval {
 
 JQVAL* jql_find_placeholder(JQL q, const char *name);
 
-JQVAL* jql_unit_to_jqval(JQP_AUX *aux, JQPUNIT *unit, iwrc *rcp);
+/**
+ * @brief Creates a clone of `src` query object with the same placeholder values.
+ * @note Placeholder values are shared with `src` so clone must be destroyed before `src`
+ *       and in the same thread.
+ */
+iwrc jql_clone_bound(JQL src, JQL *qptr);
+
+/**
+ * @brief Appends text representation of query placeholder values to `xstr`.
+ *        Used to build query results cache keys.
+ */
+iwrc jql_placeholders_key(JQL q, struct iwxstr *xstr);
+
+JQVAL* jql_unit_to_jqval(JQL q, JQPUNIT *unit, iwrc *rcp);
 
 bool jql_jqval_as_int(JQVAL *jqval, int64_t *out);
 
@@ -59,6 +95,32 @@ void jql_node_to_jqval(JBL_NODE jn, JQVAL *qv);
 
 int jql_cmp_jqval_pair(const JQVAL *left, const JQVAL *right, iwrc *rcp);
 
-bool jql_match_jqval_pair(JQP_AUX *aux, JQVAL *left, JQP_OP *jqop, JQVAL *right, iwrc *rcp);
+bool jql_match_jqval_pair(JQL q, JQVAL *left, JQP_OP *jqop, JQVAL *right, iwrc *rcp);
+
+/**
+ * @brief Returns literal prefix of anchored regexp used in `re` expression,
+ *        eg: `abc` for `^abc.*`. Empty string returned if there is no such prefix.
+ *        Computed prefix is cached in query object until placeholders are rebound.
+ */
+const char* jql_expr_regexp_prefix(JQL q, JQP_EXPR *expr, iwrc *rcp);
+
+bool jql_has_projection_joins(JQL q);
+
+struct jbexec;
+
+/**
+ * @brief Fetches documents referenced by join projections from `num` documents `docs`
+ *        into joined nodes cache of query execution context.
+ *        Joined documents of every collection are read in ascending order of their ids.
+ */
+iwrc jql_proj_joins_prefetch(JQL q, struct jbl *docs, int num, struct jbexec *exec_ctx);
+
+IW_INLINE bool jql_expr_prematched(JQL q, const JQP_EXPR *expr) {
+  return q->prematched[expr->idx];
+}
+
+IW_INLINE void jql_expr_set_prematched(JQL q, const JQP_EXPR *expr) {
+  q->prematched[expr->idx] = true;
+}
 
 #endif
@@ -3,7 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#define YYRULECOUNT 63
+#define YYRULECOUNT 65
 #line 1 "./jqp.leg"
 
 #include "jqp.h"
@@ -38,6 +38,9 @@ static void _jqp_set_skip(struct _yycontext *yy, JQPUNIT *unit);
 static void _jqp_set_limit(struct _yycontext *yy, JQPUNIT *unit);
 static void _jqp_add_orderby(struct _yycontext *yy, JQPUNIT *unit);
 static void _jqp_set_aggregate_count(struct _yycontext *yy);
+static void _jqp_set_aggregate_op(struct _yycontext *yy, const char *text);
+static void _jqp_add_aggregate(struct _yycontext *yy, JQPUNIT *unit);
+static void _jqp_add_groupby(struct _yycontext *yy, JQPUNIT *unit);
 static void _jqp_set_noidx(struct _yycontext *yy);
 static void _jqp_set_inverse(struct _yycontext *yy);
 
@@ -346,45 +349,47 @@ YY_LOCAL(void) yySet(yycontext * yy, char *text, int count) {
 
 #define YYACCEPT yyAccept(yy, yythunkpos0)
 
-YY_RULE(int) yy_EOL(yycontext * yy);           /* 63 */
-YY_RULE(int) yy_SPACE(yycontext * yy);         /* 62 */
-YY_RULE(int) yy_NUME(yycontext * yy);          /* 61 */
-YY_RULE(int) yy_NUMF(yycontext * yy);          /* 60 */
-YY_RULE(int) yy_NUMJ(yycontext * yy);          /* 59 */
-YY_RULE(int) yy_STRJ(yycontext * yy);          /* 58 */
-YY_RULE(int) yy_SARRJ(yycontext * yy);         /* 57 */
-YY_RULE(int) yy_PAIRJ(yycontext * yy);         /* 56 */
-YY_RULE(int) yy_SOBJJ(yycontext * yy);         /* 55 */
-YY_RULE(int) yy_CHJ(yycontext * yy);           /* 54 */
-YY_RULE(int) yy_CHP(yycontext * yy);           /* 53 */
-YY_RULE(int) yy_VALJ(yycontext * yy);          /* 52 */
-YY_RULE(int) yy_NEXPRLEFT(yycontext * yy);     /* 51 */
-YY_RULE(int) yy_STRSTAR(yycontext * yy);       /* 50 */
-YY_RULE(int) yy_DBLSTAR(yycontext * yy);       /* 49 */
-YY_RULE(int) yy_NEXRIGHT(yycontext * yy);      /* 48 */
-YY_RULE(int) yy_NEXOP(yycontext * yy);         /* 47 */
-YY_RULE(int) yy_NEXLEFT(yycontext * yy);       /* 46 */
-YY_RULE(int) yy_NEXJOIN(yycontext * yy);       /* 45 */
-YY_RULE(int) yy_NEXPAIR(yycontext * yy);       /* 44 */
-YY_RULE(int) yy_STRP(yycontext * yy);          /* 43 */
-YY_RULE(int) yy_NEXPR(yycontext * yy);         /* 42 */
-YY_RULE(int) yy_NODE(yycontext * yy);          /* 41 */
-YY_RULE(int) yy_FILTER(yycontext * yy);        /* 40 */
-YY_RULE(int) yy_FILTERFACTOR(yycontext * yy);  /* 39 */
-YY_RULE(int) yy_HEX(yycontext * yy);           /* 38 */
-YY_RULE(int) yy_PCHP(yycontext * yy);          /* 37 */
-YY_RULE(int) yy_PSTRP(yycontext * yy);         /* 36 */
-YY_RULE(int) yy_STRN(yycontext * yy);          /* 35 */
-YY_RULE(int) yy_PROJFIELDS(yycontext * yy);    /* 34 */
-YY_RULE(int) yy_PROJNODE(yycontext * yy);      /* 33 */
-YY_RULE(int) yy_PROJALL(yycontext * yy);       /* 32 */
-YY_RULE(int) yy_PROJPROP(yycontext * yy);      /* 31 */
-YY_RULE(int) yy_ORDERNODE(yycontext * yy);     /* 30 */
-YY_RULE(int) yy_ORDERNODES(yycontext * yy);    /* 29 */
-YY_RULE(int) yy_NUMI(yycontext * yy);          /* 28 */
-YY_RULE(int) yy_INVERSE(yycontext * yy);       /* 27 */
-YY_RULE(int) yy_NOIDX(yycontext * yy);         /* 26 */
-YY_RULE(int) yy_COUNT(yycontext * yy);         /* 25 */
+YY_RULE(int) yy_EOL(yycontext * yy);           /* 65 */
+YY_RULE(int) yy_SPACE(yycontext * yy);         /* 64 */
+YY_RULE(int) yy_NUME(yycontext * yy);          /* 63 */
+YY_RULE(int) yy_NUMF(yycontext * yy);          /* 62 */
+YY_RULE(int) yy_NUMJ(yycontext * yy);          /* 61 */
+YY_RULE(int) yy_STRJ(yycontext * yy);          /* 60 */
+YY_RULE(int) yy_SARRJ(yycontext * yy);         /* 59 */
+YY_RULE(int) yy_PAIRJ(yycontext * yy);         /* 58 */
+YY_RULE(int) yy_SOBJJ(yycontext * yy);         /* 57 */
+YY_RULE(int) yy_CHJ(yycontext * yy);           /* 56 */
+YY_RULE(int) yy_CHP(yycontext * yy);           /* 55 */
+YY_RULE(int) yy_VALJ(yycontext * yy);          /* 54 */
+YY_RULE(int) yy_NEXPRLEFT(yycontext * yy);     /* 53 */
+YY_RULE(int) yy_STRSTAR(yycontext * yy);       /* 52 */
+YY_RULE(int) yy_DBLSTAR(yycontext * yy);       /* 51 */
+YY_RULE(int) yy_NEXRIGHT(yycontext * yy);      /* 50 */
+YY_RULE(int) yy_NEXOP(yycontext * yy);         /* 49 */
+YY_RULE(int) yy_NEXLEFT(yycontext * yy);       /* 48 */
+YY_RULE(int) yy_NEXJOIN(yycontext * yy);       /* 47 */
+YY_RULE(int) yy_NEXPAIR(yycontext * yy);       /* 46 */
+YY_RULE(int) yy_STRP(yycontext * yy);          /* 45 */
+YY_RULE(int) yy_NEXPR(yycontext * yy);         /* 44 */
+YY_RULE(int) yy_NODE(yycontext * yy);          /* 43 */
+YY_RULE(int) yy_FILTER(yycontext * yy);        /* 42 */
+YY_RULE(int) yy_FILTERFACTOR(yycontext * yy);  /* 41 */
+YY_RULE(int) yy_HEX(yycontext * yy);           /* 40 */
+YY_RULE(int) yy_PCHP(yycontext * yy);          /* 39 */
+YY_RULE(int) yy_PSTRP(yycontext * yy);         /* 38 */
+YY_RULE(int) yy_STRN(yycontext * yy);          /* 37 */
+YY_RULE(int) yy_PROJFIELDS(yycontext * yy);    /* 36 */
+YY_RULE(int) yy_PROJNODE(yycontext * yy);      /* 35 */
+YY_RULE(int) yy_PROJALL(yycontext * yy);       /* 34 */
+YY_RULE(int) yy_PROJPROP(yycontext * yy);      /* 33 */
+YY_RULE(int) yy_ORDERNODE(yycontext * yy);     /* 32 */
+YY_RULE(int) yy_ORDERNODES(yycontext * yy);    /* 31 */
+YY_RULE(int) yy_NUMI(yycontext * yy);          /* 30 */
+YY_RULE(int) yy_INVERSE(yycontext * yy);       /* 29 */
+YY_RULE(int) yy_NOIDX(yycontext * yy);         /* 28 */
+YY_RULE(int) yy_COUNT(yycontext * yy);         /* 27 */
+YY_RULE(int) yy_AGGREGATE(yycontext * yy);     /* 26 */
+YY_RULE(int) yy_GROUPBY(yycontext * yy);       /* 25 */
 YY_RULE(int) yy_ORDERBY(yycontext * yy);       /* 24 */
 YY_RULE(int) yy_LIMIT(yycontext * yy);         /* 23 */
 YY_RULE(int) yy_SKIP(yycontext * yy);          /* 22 */
@@ -419,7 +424,7 @@ YY_ACTION(void) yy_4_NUMPK_ARR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_NUMPK_ARR\n"));
   {
-#line 235
+#line 243
     __ = _jqp_json_collect(yy, JBV_ARRAY, s);
     ;
   }
@@ -439,7 +444,7 @@ YY_ACTION(void) yy_3_NUMPK_ARR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_NUMPK_ARR\n"));
   {
-#line 234
+#line 242
     _jqp_unit_push(yy, v);
     ;
   }
@@ -459,7 +464,7 @@ YY_ACTION(void) yy_2_NUMPK_ARR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_NUMPK_ARR\n"));
   {
-#line 234
+#line 242
     _jqp_unit_push(yy, fv);
     ;
   }
@@ -479,7 +484,7 @@ YY_ACTION(void) yy_1_NUMPK_ARR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NUMPK_ARR\n"));
   {
-#line 233
+#line 241
     _jqp_unit_push(yy, s);
     ;
   }
@@ -496,7 +501,7 @@ YY_ACTION(void) yy_1_NUMPK(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NUMPK\n"));
   {
-#line 231
+#line 239
     __ = _jqp_json_number(yy, yytext);
     ;
   }
@@ -510,7 +515,7 @@ YY_ACTION(void) yy_1_NUMJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NUMJ\n"));
   {
-#line 229
+#line 237
     __ = _jqp_json_number(yy, yytext);
     ;
   }
@@ -524,7 +529,7 @@ YY_ACTION(void) yy_1_STRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_STRJ\n"));
   {
-#line 214
+#line 222
     __ = _jqp_json_string(yy, yytext);
     ;
   }
@@ -538,7 +543,7 @@ YY_ACTION(void) yy_3_VALJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_VALJ\n"));
   {
-#line 212
+#line 220
     __ = _jqp_json_true_false_null(yy, "null");
     ;
   }
@@ -552,7 +557,7 @@ YY_ACTION(void) yy_2_VALJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_VALJ\n"));
   {
-#line 211
+#line 219
     __ = _jqp_json_true_false_null(yy, "false");
     ;
   }
@@ -566,7 +571,7 @@ YY_ACTION(void) yy_1_VALJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_VALJ\n"));
   {
-#line 210
+#line 218
     __ = _jqp_json_true_false_null(yy, "true");
     ;
   }
@@ -582,7 +587,7 @@ YY_ACTION(void) yy_1_PAIRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PAIRJ\n"));
   {
-#line 204
+#line 212
     __ = _jqp_json_pair(yy, s, v);
     ;
   }
@@ -598,7 +603,7 @@ YY_ACTION(void) yy_1_SARRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_SARRJ\n"));
   {
-#line 202
+#line 210
     __ = _jqp_unit(yy);
     ;
   }
@@ -612,7 +617,7 @@ YY_ACTION(void) yy_1_SOBJJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_SOBJJ\n"));
   {
-#line 200
+#line 208
     __ = _jqp_unit(yy);
     ;
   }
@@ -629,7 +634,7 @@ YY_ACTION(void) yy_4_ARRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_ARRJ\n"));
   {
-#line 198
+#line 206
     __ = _jqp_json_collect(yy, JBV_ARRAY, s);
     ;
   }
@@ -649,7 +654,7 @@ YY_ACTION(void) yy_3_ARRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_ARRJ\n"));
   {
-#line 197
+#line 205
     _jqp_unit_push(yy, v);
     ;
   }
@@ -669,7 +674,7 @@ YY_ACTION(void) yy_2_ARRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_ARRJ\n"));
   {
-#line 197
+#line 205
     _jqp_unit_push(yy, fv);
     ;
   }
@@ -689,7 +694,7 @@ YY_ACTION(void) yy_1_ARRJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_ARRJ\n"));
   {
-#line 196
+#line 204
     _jqp_unit_push(yy, s);
     ;
   }
@@ -709,7 +714,7 @@ YY_ACTION(void) yy_4_OBJJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_OBJJ\n"));
   {
-#line 194
+#line 202
     __ = _jqp_json_collect(yy, JBV_OBJECT, s);
     ;
   }
@@ -729,7 +734,7 @@ YY_ACTION(void) yy_3_OBJJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_OBJJ\n"));
   {
-#line 193
+#line 201
     _jqp_unit_push(yy, p);
     ;
   }
@@ -749,7 +754,7 @@ YY_ACTION(void) yy_2_OBJJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_OBJJ\n"));
   {
-#line 193
+#line 201
     _jqp_unit_push(yy, fp);
     ;
   }
@@ -769,7 +774,7 @@ YY_ACTION(void) yy_1_OBJJ(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_OBJJ\n"));
   {
-#line 192
+#line 200
     _jqp_unit_push(yy, s);
     ;
   }
@@ -786,7 +791,7 @@ YY_ACTION(void) yy_1_STRN(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_STRN\n"));
   {
-#line 190
+#line 198
     __ = _jqp_unescaped_string(yy, JQP_STR_QUOTED, yytext);
     ;
   }
@@ -800,7 +805,7 @@ YY_ACTION(void) yy_1_STRSTAR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_STRSTAR\n"));
   {
-#line 188
+#line 196
     __ = _jqp_unescaped_string(yy, JQP_STR_STAR, "*");
     ;
   }
@@ -814,7 +819,7 @@ YY_ACTION(void) yy_1_DBLSTAR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_DBLSTAR\n"));
   {
-#line 186
+#line 194
     __ = _jqp_unescaped_string(yy, JQP_STR_DBL_STAR, "**");
     ;
   }
@@ -828,7 +833,7 @@ YY_ACTION(void) yy_1_STRP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_STRP\n"));
   {
-#line 184
+#line 192
     __ = _jqp_unescaped_string(yy, 0, yytext);
     ;
   }
@@ -842,7 +847,7 @@ YY_ACTION(void) yy_9_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_9_NEXOP\n"));
   {
-#line 182
+#line 190
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -856,7 +861,7 @@ YY_ACTION(void) yy_8_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_8_NEXOP\n"));
   {
-#line 181
+#line 189
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -870,7 +875,7 @@ YY_ACTION(void) yy_7_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_7_NEXOP\n"));
   {
-#line 180
+#line 188
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -884,7 +889,7 @@ YY_ACTION(void) yy_6_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_6_NEXOP\n"));
   {
-#line 179
+#line 187
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -898,7 +903,7 @@ YY_ACTION(void) yy_5_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_5_NEXOP\n"));
   {
-#line 179
+#line 187
     _jqp_op_negate(yy);
     ;
   }
@@ -912,7 +917,7 @@ YY_ACTION(void) yy_4_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_NEXOP\n"));
   {
-#line 178
+#line 186
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -926,7 +931,7 @@ YY_ACTION(void) yy_3_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_NEXOP\n"));
   {
-#line 177
+#line 185
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -940,7 +945,7 @@ YY_ACTION(void) yy_2_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_NEXOP\n"));
   {
-#line 176
+#line 184
     __ = _jqp_unit_op(yy, yytext);
     ;
   }
@@ -954,7 +959,7 @@ YY_ACTION(void) yy_1_NEXOP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NEXOP\n"));
   {
-#line 176
+#line 184
     _jqp_op_negate(yy);
     ;
   }
@@ -968,7 +973,7 @@ YY_ACTION(void) yy_1_PLACEHOLDER(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PLACEHOLDER\n"));
   {
-#line 174
+#line 182
     __ = _jqp_placeholder(yy, yytext);
     ;
   }
@@ -985,7 +990,7 @@ YY_ACTION(void) yy_1_NEXPRLEFT(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NEXPRLEFT\n"));
   {
-#line 170
+#line 178
     __ = _jqp_expr(yy, l, o, r);
     ;
   }
@@ -1005,7 +1010,7 @@ YY_ACTION(void) yy_1_NEXPAIR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NEXPAIR\n"));
   {
-#line 166
+#line 174
     __ = _jqp_expr(yy, l, o, r);
     ;
   }
@@ -1022,7 +1027,7 @@ YY_ACTION(void) yy_2_NEXJOIN(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_NEXJOIN\n"));
   {
-#line 164
+#line 172
     __ = _jqp_unit_join(yy, yytext);
     ;
   }
@@ -1036,7 +1041,7 @@ YY_ACTION(void) yy_1_NEXJOIN(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NEXJOIN\n"));
   {
-#line 164
+#line 172
     _jqp_op_negate(yy);
     ;
   }
@@ -1053,7 +1058,7 @@ YY_ACTION(void) yy_4_NEXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_NEXPR\n"));
   {
-#line 162
+#line 170
     __ = _jqp_pop_expr_chain(yy, n);
     ;
   }
@@ -1073,7 +1078,7 @@ YY_ACTION(void) yy_3_NEXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_NEXPR\n"));
   {
-#line 161
+#line 169
     _jqp_unit_push(yy, np);
     ;
   }
@@ -1093,7 +1098,7 @@ YY_ACTION(void) yy_2_NEXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_NEXPR\n"));
   {
-#line 161
+#line 169
     _jqp_unit_push(yy, j);
     ;
   }
@@ -1113,7 +1118,7 @@ YY_ACTION(void) yy_1_NEXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NEXPR\n"));
   {
-#line 160
+#line 168
     _jqp_unit_push(yy, n);
     ;
   }
@@ -1131,7 +1136,7 @@ YY_ACTION(void) yy_1_NODE(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NODE\n"));
   {
-#line 158
+#line 166
     __ = _jqp_node(yy, n);
     ;
   }
@@ -1146,7 +1151,7 @@ YY_ACTION(void) yy_1_FILTERANCHOR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_FILTERANCHOR\n"));
   {
-#line 155
+#line 163
     __ = _jqp_string(yy, JQP_STR_ANCHOR, yytext);
     ;
   }
@@ -1163,7 +1168,7 @@ YY_ACTION(void) yy_4_FILTER(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_FILTER\n"));
   {
-#line 153
+#line 161
     __ = _jqp_pop_node_chain(yy, fn);
     ;
   }
@@ -1183,7 +1188,7 @@ YY_ACTION(void) yy_3_FILTER(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_FILTER\n"));
   {
-#line 153
+#line 161
     _jqp_unit_push(yy, n);
     ;
   }
@@ -1203,7 +1208,7 @@ YY_ACTION(void) yy_2_FILTER(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_FILTER\n"));
   {
-#line 153
+#line 161
     _jqp_unit_push(yy, fn);
     ;
   }
@@ -1223,7 +1228,7 @@ YY_ACTION(void) yy_1_FILTER(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_FILTER\n"));
   {
-#line 153
+#line 161
     _jqp_unit_push(yy, a);
     ;
   }
@@ -1243,7 +1248,7 @@ YY_ACTION(void) yy_4_FILTEREXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_FILTEREXPR\n"));
   {
-#line 151
+#line 159
     __ = _jqp_pop_filter_factor_chain(yy, ff);
     ;
   }
@@ -1263,7 +1268,7 @@ YY_ACTION(void) yy_3_FILTEREXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_FILTEREXPR\n"));
   {
-#line 151
+#line 159
     _jqp_unit_push(yy, f);
     ;
   }
@@ -1283,7 +1288,7 @@ YY_ACTION(void) yy_2_FILTEREXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_FILTEREXPR\n"));
   {
-#line 151
+#line 159
     _jqp_unit_push(yy, j);
     ;
   }
@@ -1303,7 +1308,7 @@ YY_ACTION(void) yy_1_FILTEREXPR(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_FILTEREXPR\n"));
   {
-#line 150
+#line 158
     _jqp_unit_push(yy, ff);
     ;
   }
@@ -1320,7 +1325,7 @@ YY_ACTION(void) yy_1_PSTRP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PSTRP\n"));
   {
-#line 140
+#line 148
     __ = _jqp_string(yy, 0, yytext);
     ;
   }
@@ -1336,7 +1341,7 @@ YY_ACTION(void) yy_3_PROJFIELDS(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_PROJFIELDS\n"));
   {
-#line 134
+#line 142
     __ = _jqp_pop_projfields_chain(yy, sp);
     ;
   }
@@ -1354,7 +1359,7 @@ YY_ACTION(void) yy_2_PROJFIELDS(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_PROJFIELDS\n"));
   {
-#line 133
+#line 141
     _jqp_unit_push(yy, p);
     ;
   }
@@ -1372,7 +1377,7 @@ YY_ACTION(void) yy_1_PROJFIELDS(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PROJFIELDS\n"));
   {
-#line 133
+#line 141
     _jqp_unit_push(yy, sp);
     ;
   }
@@ -1388,7 +1393,7 @@ YY_ACTION(void) yy_1_PROJALL(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PROJALL\n"));
   {
-#line 129
+#line 137
     __ = _jqp_string(yy, JQP_STR_PROJALIAS, "all");
     ;
   }
@@ -1405,7 +1410,7 @@ YY_ACTION(void) yy_4_PROJNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_PROJNODES\n"));
   {
-#line 127
+#line 135
     __ = _jqp_pop_projection_nodes(yy, sn);
     ;
   }
@@ -1425,7 +1430,7 @@ YY_ACTION(void) yy_3_PROJNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_PROJNODES\n"));
   {
-#line 127
+#line 135
     _jqp_unit_push(yy, n);
     ;
   }
@@ -1445,7 +1450,7 @@ YY_ACTION(void) yy_2_PROJNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_PROJNODES\n"));
   {
-#line 127
+#line 135
     _jqp_unit_push(yy, sn);
     ;
   }
@@ -1465,7 +1470,7 @@ YY_ACTION(void) yy_1_PROJNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PROJNODES\n"));
   {
-#line 126
+#line 134
     __ = _jqp_projection(yy, a, 0);
     ;
   }
@@ -1484,7 +1489,7 @@ YY_ACTION(void) yy_3_ORDERNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_ORDERNODES\n"));
   {
-#line 122
+#line 130
     __ = _jqp_pop_ordernodes(yy, sn);
   }
 #undef yythunkpos
@@ -1501,7 +1506,7 @@ YY_ACTION(void) yy_2_ORDERNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_ORDERNODES\n"));
   {
-#line 122
+#line 130
     _jqp_unit_push(yy, n);
     ;
   }
@@ -1519,7 +1524,7 @@ YY_ACTION(void) yy_1_ORDERNODES(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_ORDERNODES\n"));
   {
-#line 122
+#line 130
     _jqp_unit_push(yy, sn);
     ;
   }
@@ -1536,7 +1541,7 @@ YY_ACTION(void) yy_2_ORDERBY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_ORDERBY\n"));
   {
-#line 120
+#line 128
     p->string.flavour |= (yy->aux->negate ? JQP_STR_NEGATE : 0);
     _jqp_op_negate_reset(yy);
     _jqp_add_orderby(yy, p);
@@ -1554,7 +1559,7 @@ YY_ACTION(void) yy_1_ORDERBY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_ORDERBY\n"));
   {
-#line 118
+#line 126
     _jqp_op_negate(yy);
     ;
   }
@@ -1569,7 +1574,7 @@ YY_ACTION(void) yy_1_INVERSE(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_INVERSE\n"));
   {
-#line 116
+#line 124
     _jqp_set_inverse(yy);
     ;
   }
@@ -1583,7 +1588,7 @@ YY_ACTION(void) yy_1_NOIDX(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_NOIDX\n"));
   {
-#line 114
+#line 122
     _jqp_set_noidx(yy);
     ;
   }
@@ -1591,13 +1596,61 @@ YY_ACTION(void) yy_1_NOIDX(yycontext * yy, char *yytext, int yyleng) {
 #undef yypos
 #undef yy
 }
+YY_ACTION(void) yy_2_AGGREGATE(yycontext * yy, char *yytext, int yyleng) {
+#define p          yy->__val[-1]
+#define __         yy->__
+#define yypos      yy->__pos
+#define yythunkpos yy->__thunkpos
+  yyprintf((stderr, "do yy_2_AGGREGATE\n"));
+  {
+#line 120
+    _jqp_add_aggregate(yy, p);
+    ;
+  }
+#undef yythunkpos
+#undef yypos
+#undef yy
+#undef p
+}
+YY_ACTION(void) yy_1_AGGREGATE(yycontext * yy, char *yytext, int yyleng) {
+#define p          yy->__val[-1]
+#define __         yy->__
+#define yypos      yy->__pos
+#define yythunkpos yy->__thunkpos
+  yyprintf((stderr, "do yy_1_AGGREGATE\n"));
+  {
+#line 119
+    _jqp_set_aggregate_op(yy, yytext);
+    ;
+  }
+#undef yythunkpos
+#undef yypos
+#undef yy
+#undef p
+}
+YY_ACTION(void) yy_1_GROUPBY(yycontext * yy, char *yytext, int yyleng) {
+#define p          yy->__val[-1]
+#define __         yy->__
+#define yypos      yy->__pos
+#define yythunkpos yy->__thunkpos
+  yyprintf((stderr, "do yy_1_GROUPBY\n"));
+  {
+#line 117
+    _jqp_add_groupby(yy, p);
+    ;
+  }
+#undef yythunkpos
+#undef yypos
+#undef yy
+#undef p
+}
 YY_ACTION(void) yy_1_COUNT(yycontext * yy, char *yytext, int yyleng) {
 #define __         yy->__
 #define yypos      yy->__pos
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_COUNT\n"));
   {
-#line 112
+#line 115
     _jqp_set_aggregate_count(yy);
     ;
   }
@@ -1612,7 +1665,7 @@ YY_ACTION(void) yy_3_LIMIT(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_LIMIT\n"));
   {
-#line 110
+#line 113
     _jqp_set_limit(yy, __);
     ;
   }
@@ -1628,7 +1681,7 @@ YY_ACTION(void) yy_2_LIMIT(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_LIMIT\n"));
   {
-#line 110
+#line 113
     __ = p;
     ;
   }
@@ -1644,7 +1697,7 @@ YY_ACTION(void) yy_1_LIMIT(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_LIMIT\n"));
   {
-#line 110
+#line 113
     __ = _jqp_number(yy, JQP_INT_LIMIT, yytext);
     ;
   }
@@ -1660,7 +1713,7 @@ YY_ACTION(void) yy_3_SKIP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_SKIP\n"));
   {
-#line 108
+#line 111
     _jqp_set_skip(yy, __);
     ;
   }
@@ -1676,7 +1729,7 @@ YY_ACTION(void) yy_2_SKIP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_SKIP\n"));
   {
-#line 108
+#line 111
     __ = p;
     ;
   }
@@ -1692,7 +1745,7 @@ YY_ACTION(void) yy_1_SKIP(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_SKIP\n"));
   {
-#line 108
+#line 111
     __ = _jqp_number(yy, JQP_INT_SKIP, yytext);
     ;
   }
@@ -1709,7 +1762,7 @@ YY_ACTION(void) yy_4_PROJECTION(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_PROJECTION\n"));
   {
-#line 102
+#line 105
     __ = _jqp_pop_joined_projections(yy, sn);
     ;
   }
@@ -1727,7 +1780,7 @@ YY_ACTION(void) yy_3_PROJECTION(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_PROJECTION\n"));
   {
-#line 101
+#line 104
     _jqp_push_joined_projection(yy, n);
     ;
   }
@@ -1745,7 +1798,7 @@ YY_ACTION(void) yy_2_PROJECTION(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_PROJECTION\n"));
   {
-#line 101
+#line 104
     _jqp_string_push(yy, yytext, true);
     ;
   }
@@ -1763,7 +1816,7 @@ YY_ACTION(void) yy_1_PROJECTION(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_PROJECTION\n"));
   {
-#line 100
+#line 103
     _jqp_unit_push(yy, sn);
     ;
   }
@@ -1779,7 +1832,7 @@ YY_ACTION(void) yy_2_FILTERJOIN(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_FILTERJOIN\n"));
   {
-#line 94
+#line 97
     __ = _jqp_unit_join(yy, yytext);
     ;
   }
@@ -1793,7 +1846,7 @@ YY_ACTION(void) yy_1_FILTERJOIN(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_FILTERJOIN\n"));
   {
-#line 94
+#line 97
     _jqp_op_negate(yy);
     ;
   }
@@ -1809,7 +1862,7 @@ YY_ACTION(void) yy_2_FILTEREXPR_PK(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_FILTEREXPR_PK\n"));
   {
-#line 92
+#line 95
     __ = _jqp_create_filterexpr_pk(yy, p);
   }
 #undef yythunkpos
@@ -1826,7 +1879,7 @@ YY_ACTION(void) yy_1_FILTEREXPR_PK(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_FILTEREXPR_PK\n"));
   {
-#line 90
+#line 93
     _jqp_unit_push(yy, a);
     ;
   }
@@ -1846,7 +1899,7 @@ YY_ACTION(void) yy_6_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_6_QUERY\n"));
   {
-#line 86
+#line 89
     _jqp_finish(yy);
     ;
   }
@@ -1868,7 +1921,7 @@ YY_ACTION(void) yy_5_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_5_QUERY\n"));
   {
-#line 84
+#line 87
     _jqp_set_projection(yy, p);
     ;
   }
@@ -1890,7 +1943,7 @@ YY_ACTION(void) yy_4_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_4_QUERY\n"));
   {
-#line 83
+#line 86
     _jqp_set_apply_upsert(yy, u);
     ;
   }
@@ -1912,7 +1965,7 @@ YY_ACTION(void) yy_3_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_3_QUERY\n"));
   {
-#line 83
+#line 86
     _jqp_set_apply_delete(yy);
     ;
   }
@@ -1934,7 +1987,7 @@ YY_ACTION(void) yy_2_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_2_QUERY\n"));
   {
-#line 83
+#line 86
     _jqp_set_apply(yy, a);
     ;
   }
@@ -1956,7 +2009,7 @@ YY_ACTION(void) yy_1_QUERY(yycontext * yy, char *yytext, int yyleng) {
 #define yythunkpos yy->__thunkpos
   yyprintf((stderr, "do yy_1_QUERY\n"));
   {
-#line 82
+#line 85
     _jqp_set_filters_expr(yy, s);
     ;
   }
@@ -3875,13 +3928,23 @@ l149:
   yyprintf((stderr, "  fail %s @ %s\n", "COUNT", yy->__buf + yy->__pos));
   return 0;
 }
-YY_RULE(int) yy_ORDERBY(yycontext * yy) {
+YY_RULE(int) yy_AGGREGATE(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyDo(yy, yyPush, 1, 0);
-  yyprintf((stderr, "%s\n", "ORDERBY"));
+  yyprintf((stderr, "%s\n", "AGGREGATE"));
+  yyText(yy, yy->__begin, yy->__end);
+  {
+#define yytext yy->__text
+#define yyleng yy->__textlen
+    if (!(YY_BEGIN)) {
+      goto l150;
+    }
+#undef yytext
+#undef yyleng
+  }
   {
     int yypos151 = yy->__pos, yythunkpos151 = yy->__thunkpos;
-    if (!yymatchString(yy, "asc")) {
+    if (!yymatchString(yy, "sum")) {
       goto l152;
     }
     goto l151;
@@ -3889,39 +3952,147 @@ l152:
     ;
     yy->__pos = yypos151;
     yy->__thunkpos = yythunkpos151;
-    if (!yymatchString(yy, "desc")) {
+    if (!yymatchString(yy, "avg")) {
+      goto l153;
+    }
+    goto l151;
+l153:
+    ;
+    yy->__pos = yypos151;
+    yy->__thunkpos = yythunkpos151;
+    if (!yymatchString(yy, "min")) {
+      goto l154;
+    }
+    goto l151;
+l154:
+    ;
+    yy->__pos = yypos151;
+    yy->__thunkpos = yythunkpos151;
+    if (!yymatchString(yy, "max")) {
       goto l150;
     }
-    yyDo(yy, yy_1_ORDERBY, yy->__begin, yy->__end);
   }
 l151:
   ;
+  yyText(yy, yy->__begin, yy->__end);
+  {
+#define yytext yy->__text
+#define yyleng yy->__textlen
+    if (!(YY_END)) {
+      goto l150;
+    }
+#undef yytext
+#undef yyleng
+  }  yyDo(yy, yy_1_AGGREGATE, yy->__begin, yy->__end);
   if (!yy___(yy)) {
     goto l150;
   }
+  if (!yy_ORDERNODES(yy)) {
+    goto l150;
+  }
+  yyDo(yy, yySet, -1, 0);
+  yyDo(yy, yy_2_AGGREGATE, yy->__begin, yy->__end);
+  yyprintf((stderr, "  ok   %s @ %s\n", "AGGREGATE", yy->__buf + yy->__pos));
+  yyDo(yy, yyPop, 1, 0);
+  return 1;
+l150:
+  ;
+  yy->__pos = yypos0;
+  yy->__thunkpos = yythunkpos0;
+  yyprintf((stderr, "  fail %s @ %s\n", "AGGREGATE", yy->__buf + yy->__pos));
+  return 0;
+}
+YY_RULE(int) yy_GROUPBY(yycontext * yy) {
+  int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
+  yyDo(yy, yyPush, 1, 0);
+  yyprintf((stderr, "%s\n", "GROUPBY"));
+  {
+    int yypos156 = yy->__pos, yythunkpos156 = yy->__thunkpos;
+    if (!yymatchString(yy, "group")) {
+      goto l157;
+    }
+    if (!yy___(yy)) {
+      goto l157;
+    }
+    if (!yymatchString(yy, "by")) {
+      goto l157;
+    }
+    goto l156;
+l157:
+    ;
+    yy->__pos = yypos156;
+    yy->__thunkpos = yythunkpos156;
+    if (!yymatchString(yy, "distinct")) {
+      goto l155;
+    }
+  }
+l156:
+  ;
+  if (!yy___(yy)) {
+    goto l155;
+  }
+  if (!yy_ORDERNODES(yy)) {
+    goto l155;
+  }
+  yyDo(yy, yySet, -1, 0);
+  yyDo(yy, yy_1_GROUPBY, yy->__begin, yy->__end);
+  yyprintf((stderr, "  ok   %s @ %s\n", "GROUPBY", yy->__buf + yy->__pos));
+  yyDo(yy, yyPop, 1, 0);
+  return 1;
+l155:
+  ;
+  yy->__pos = yypos0;
+  yy->__thunkpos = yythunkpos0;
+  yyprintf((stderr, "  fail %s @ %s\n", "GROUPBY", yy->__buf + yy->__pos));
+  return 0;
+}
+YY_RULE(int) yy_ORDERBY(yycontext * yy) {
+  int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
+  yyDo(yy, yyPush, 1, 0);
+  yyprintf((stderr, "%s\n", "ORDERBY"));
+  {
+    int yypos159 = yy->__pos, yythunkpos159 = yy->__thunkpos;
+    if (!yymatchString(yy, "asc")) {
+      goto l160;
+    }
+    goto l159;
+l160:
+    ;
+    yy->__pos = yypos159;
+    yy->__thunkpos = yythunkpos159;
+    if (!yymatchString(yy, "desc")) {
+      goto l158;
+    }
+    yyDo(yy, yy_1_ORDERBY, yy->__begin, yy->__end);
+  }
+l159:
+  ;
+  if (!yy___(yy)) {
+    goto l158;
+  }
   {
-    int yypos153 = yy->__pos, yythunkpos153 = yy->__thunkpos;
+    int yypos161 = yy->__pos, yythunkpos161 = yy->__thunkpos;
     if (!yy_ORDERNODES(yy)) {
-      goto l154;
+      goto l162;
     }
     yyDo(yy, yySet, -1, 0);
-    goto l153;
-l154:
+    goto l161;
+l162:
     ;
-    yy->__pos = yypos153;
-    yy->__thunkpos = yythunkpos153;
+    yy->__pos = yypos161;
+    yy->__thunkpos = yythunkpos161;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l150;
+      goto l158;
     }
     yyDo(yy, yySet, -1, 0);
   }
-l153:
+l161:
   ;
   yyDo(yy, yy_2_ORDERBY, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "ORDERBY", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 1, 0);
   return 1;
-l150:
+l158:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -3933,53 +4104,53 @@ YY_RULE(int) yy_LIMIT(yycontext * yy) {
   yyDo(yy, yyPush, 1, 0);
   yyprintf((stderr, "%s\n", "LIMIT"));
   if (!yymatchString(yy, "limit")) {
-    goto l155;
+    goto l163;
   }
   if (!yy___(yy)) {
-    goto l155;
+    goto l163;
   }
   {
-    int yypos156 = yy->__pos, yythunkpos156 = yy->__thunkpos;
+    int yypos164 = yy->__pos, yythunkpos164 = yy->__thunkpos;
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_BEGIN)) {
-        goto l157;
+        goto l165;
       }
 #undef yytext
 #undef yyleng
     }  if (!yy_NUMI(yy)) {
-      goto l157;
+      goto l165;
     }
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_END)) {
-        goto l157;
+        goto l165;
       }
 #undef yytext
 #undef yyleng
     }  yyDo(yy, yy_1_LIMIT, yy->__begin, yy->__end);
-    goto l156;
-l157:
+    goto l164;
+l165:
     ;
-    yy->__pos = yypos156;
-    yy->__thunkpos = yythunkpos156;
+    yy->__pos = yypos164;
+    yy->__thunkpos = yythunkpos164;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l155;
+      goto l163;
     }
     yyDo(yy, yySet, -1, 0);
     yyDo(yy, yy_2_LIMIT, yy->__begin, yy->__end);
   }
-l156:
+l164:
   ;
   yyDo(yy, yy_3_LIMIT, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "LIMIT", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 1, 0);
   return 1;
-l155:
+l163:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -3991,53 +4162,53 @@ YY_RULE(int) yy_SKIP(yycontext * yy) {
   yyDo(yy, yyPush, 1, 0);
   yyprintf((stderr, "%s\n", "SKIP"));
   if (!yymatchString(yy, "skip")) {
-    goto l158;
+    goto l166;
   }
   if (!yy___(yy)) {
-    goto l158;
+    goto l166;
   }
   {
-    int yypos159 = yy->__pos, yythunkpos159 = yy->__thunkpos;
+    int yypos167 = yy->__pos, yythunkpos167 = yy->__thunkpos;
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_BEGIN)) {
-        goto l160;
+        goto l168;
       }
 #undef yytext
 #undef yyleng
     }  if (!yy_NUMI(yy)) {
-      goto l160;
+      goto l168;
     }
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_END)) {
-        goto l160;
+        goto l168;
       }
 #undef yytext
 #undef yyleng
     }  yyDo(yy, yy_1_SKIP, yy->__begin, yy->__end);
-    goto l159;
-l160:
+    goto l167;
+l168:
     ;
-    yy->__pos = yypos159;
-    yy->__thunkpos = yythunkpos159;
+    yy->__pos = yypos167;
+    yy->__thunkpos = yythunkpos167;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l158;
+      goto l166;
     }
     yyDo(yy, yySet, -1, 0);
     yyDo(yy, yy_2_SKIP, yy->__begin, yy->__end);
   }
-l159:
+l167:
   ;
   yyDo(yy, yy_3_SKIP, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "SKIP", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 1, 0);
   return 1;
-l158:
+l166:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4048,56 +4219,72 @@ YY_RULE(int) yy_OPT(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "OPT"));
   {
-    int yypos162 = yy->__pos, yythunkpos162 = yy->__thunkpos;
+    int yypos170 = yy->__pos, yythunkpos170 = yy->__thunkpos;
     if (!yy_SKIP(yy)) {
-      goto l163;
+      goto l171;
     }
-    goto l162;
-l163:
+    goto l170;
+l171:
     ;
-    yy->__pos = yypos162;
-    yy->__thunkpos = yythunkpos162;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
     if (!yy_LIMIT(yy)) {
-      goto l164;
+      goto l172;
     }
-    goto l162;
-l164:
+    goto l170;
+l172:
     ;
-    yy->__pos = yypos162;
-    yy->__thunkpos = yythunkpos162;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
     if (!yy_ORDERBY(yy)) {
-      goto l165;
+      goto l173;
     }
-    goto l162;
-l165:
+    goto l170;
+l173:
     ;
-    yy->__pos = yypos162;
-    yy->__thunkpos = yythunkpos162;
-    if (!yy_COUNT(yy)) {
-      goto l166;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
+    if (!yy_GROUPBY(yy)) {
+      goto l174;
     }
-    goto l162;
-l166:
+    goto l170;
+l174:
+    ;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
+    if (!yy_AGGREGATE(yy)) {
+      goto l175;
+    }
+    goto l170;
+l175:
     ;
-    yy->__pos = yypos162;
-    yy->__thunkpos = yythunkpos162;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
+    if (!yy_COUNT(yy)) {
+      goto l176;
+    }
+    goto l170;
+l176:
+    ;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
     if (!yy_NOIDX(yy)) {
-      goto l167;
+      goto l177;
     }
-    goto l162;
-l167:
+    goto l170;
+l177:
     ;
-    yy->__pos = yypos162;
-    yy->__thunkpos = yythunkpos162;
+    yy->__pos = yypos170;
+    yy->__thunkpos = yythunkpos170;
     if (!yy_INVERSE(yy)) {
-      goto l161;
+      goto l169;
     }
   }
-l162:
+l170:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "OPT", yy->__buf + yy->__pos));
   return 1;
-l161:
+l169:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4108,24 +4295,24 @@ YY_RULE(int) yy_PROJOIN(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "PROJOIN"));
   {
-    int yypos169 = yy->__pos, yythunkpos169 = yy->__thunkpos;
+    int yypos179 = yy->__pos, yythunkpos179 = yy->__thunkpos;
     if (!yymatchChar(yy, '+')) {
-      goto l170;
+      goto l180;
     }
-    goto l169;
-l170:
+    goto l179;
+l180:
     ;
-    yy->__pos = yypos169;
-    yy->__thunkpos = yythunkpos169;
+    yy->__pos = yypos179;
+    yy->__thunkpos = yythunkpos179;
     if (!yymatchChar(yy, '-')) {
-      goto l168;
+      goto l178;
     }
   }
-l169:
+l179:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "PROJOIN", yy->__buf + yy->__pos));
   return 1;
-l168:
+l178:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4137,44 +4324,44 @@ YY_RULE(int) yy_PROJNODES(yycontext * yy) {
   yyDo(yy, yyPush, 3, 0);
   yyprintf((stderr, "%s\n", "PROJNODES"));
   {
-    int yypos172 = yy->__pos, yythunkpos172 = yy->__thunkpos;
+    int yypos182 = yy->__pos, yythunkpos182 = yy->__thunkpos;
     if (!yy_PROJALL(yy)) {
-      goto l173;
+      goto l183;
     }
     yyDo(yy, yySet, -3, 0);
     yyDo(yy, yy_1_PROJNODES, yy->__begin, yy->__end);
-    goto l172;
-l173:
+    goto l182;
+l183:
     ;
-    yy->__pos = yypos172;
-    yy->__thunkpos = yythunkpos172;
+    yy->__pos = yypos182;
+    yy->__thunkpos = yythunkpos182;
     if (!yy_PROJNODE(yy)) {
-      goto l171;
+      goto l181;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_2_PROJNODES, yy->__begin, yy->__end);
-l174:
+l184:
     ;
     {
-      int yypos175 = yy->__pos, yythunkpos175 = yy->__thunkpos;
+      int yypos185 = yy->__pos, yythunkpos185 = yy->__thunkpos;
       if (!yy_PROJNODE(yy)) {
-        goto l175;
+        goto l185;
       }
       yyDo(yy, yySet, -1, 0);
       yyDo(yy, yy_3_PROJNODES, yy->__begin, yy->__end);
-      goto l174;
-l175:
+      goto l184;
+l185:
       ;
-      yy->__pos = yypos175;
-      yy->__thunkpos = yythunkpos175;
+      yy->__pos = yypos185;
+      yy->__thunkpos = yythunkpos185;
     }  yyDo(yy, yy_4_PROJNODES, yy->__begin, yy->__end);
   }
-l172:
+l182:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "PROJNODES", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 3, 0);
   return 1;
-l171:
+l181:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4186,62 +4373,62 @@ YY_RULE(int) yy_ARRJ(yycontext * yy) {
   yyDo(yy, yyPush, 3, 0);
   yyprintf((stderr, "%s\n", "ARRJ"));
   if (!yy_SARRJ(yy)) {
-    goto l176;
+    goto l186;
   }
   yyDo(yy, yySet, -3, 0);
   yyDo(yy, yy_1_ARRJ, yy->__begin, yy->__end);
   if (!yy__(yy)) {
-    goto l176;
+    goto l186;
   }
   {
-    int yypos177 = yy->__pos, yythunkpos177 = yy->__thunkpos;
+    int yypos187 = yy->__pos, yythunkpos187 = yy->__thunkpos;
     if (!yy_VALJ(yy)) {
-      goto l177;
+      goto l187;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_2_ARRJ, yy->__begin, yy->__end);
-l179:
+l189:
     ;
     {
-      int yypos180 = yy->__pos, yythunkpos180 = yy->__thunkpos;
+      int yypos190 = yy->__pos, yythunkpos190 = yy->__thunkpos;
       if (!yy__(yy)) {
-        goto l180;
+        goto l190;
       }
       if (!yymatchChar(yy, ',')) {
-        goto l180;
+        goto l190;
       }
       if (!yy__(yy)) {
-        goto l180;
+        goto l190;
       }
       if (!yy_VALJ(yy)) {
-        goto l180;
+        goto l190;
       }
       yyDo(yy, yySet, -1, 0);
       yyDo(yy, yy_3_ARRJ, yy->__begin, yy->__end);
-      goto l179;
-l180:
+      goto l189;
+l190:
       ;
-      yy->__pos = yypos180;
-      yy->__thunkpos = yythunkpos180;
-    }  goto l178;
-l177:
+      yy->__pos = yypos190;
+      yy->__thunkpos = yythunkpos190;
+    }  goto l188;
+l187:
     ;
-    yy->__pos = yypos177;
-    yy->__thunkpos = yythunkpos177;
+    yy->__pos = yypos187;
+    yy->__thunkpos = yythunkpos187;
   }
-l178:
+l188:
   ;
   if (!yy__(yy)) {
-    goto l176;
+    goto l186;
   }
   if (!yymatchChar(yy, ']')) {
-    goto l176;
+    goto l186;
   }
   yyDo(yy, yy_4_ARRJ, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "ARRJ", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 3, 0);
   return 1;
-l176:
+l186:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4253,62 +4440,62 @@ YY_RULE(int) yy_OBJJ(yycontext * yy) {
   yyDo(yy, yyPush, 3, 0);
   yyprintf((stderr, "%s\n", "OBJJ"));
   if (!yy_SOBJJ(yy)) {
-    goto l181;
+    goto l191;
   }
   yyDo(yy, yySet, -3, 0);
   yyDo(yy, yy_1_OBJJ, yy->__begin, yy->__end);
   if (!yy__(yy)) {
-    goto l181;
+    goto l191;
   }
   {
-    int yypos182 = yy->__pos, yythunkpos182 = yy->__thunkpos;
+    int yypos192 = yy->__pos, yythunkpos192 = yy->__thunkpos;
     if (!yy_PAIRJ(yy)) {
-      goto l182;
+      goto l192;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_2_OBJJ, yy->__begin, yy->__end);
-l184:
+l194:
     ;
     {
-      int yypos185 = yy->__pos, yythunkpos185 = yy->__thunkpos;
+      int yypos195 = yy->__pos, yythunkpos195 = yy->__thunkpos;
       if (!yy__(yy)) {
-        goto l185;
+        goto l195;
       }
       if (!yymatchChar(yy, ',')) {
-        goto l185;
+        goto l195;
       }
       if (!yy__(yy)) {
-        goto l185;
+        goto l195;
       }
       if (!yy_PAIRJ(yy)) {
-        goto l185;
+        goto l195;
       }
       yyDo(yy, yySet, -1, 0);
       yyDo(yy, yy_3_OBJJ, yy->__begin, yy->__end);
-      goto l184;
-l185:
+      goto l194;
+l195:
       ;
-      yy->__pos = yypos185;
-      yy->__thunkpos = yythunkpos185;
-    }  goto l183;
-l182:
+      yy->__pos = yypos195;
+      yy->__thunkpos = yythunkpos195;
+    }  goto l193;
+l192:
     ;
-    yy->__pos = yypos182;
-    yy->__thunkpos = yythunkpos182;
+    yy->__pos = yypos192;
+    yy->__thunkpos = yythunkpos192;
   }
-l183:
+l193:
   ;
   if (!yy__(yy)) {
-    goto l181;
+    goto l191;
   }
   if (!yymatchChar(yy, '}')) {
-    goto l181;
+    goto l191;
   }
   yyDo(yy, yy_4_OBJJ, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "OBJJ", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 3, 0);
   return 1;
-l181:
+l191:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4319,24 +4506,24 @@ YY_RULE(int) yy___(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "__"));
   if (!yy_SPACE(yy)) {
-    goto l186;
+    goto l196;
   }
-l187:
+l197:
   ;
   {
-    int yypos188 = yy->__pos, yythunkpos188 = yy->__thunkpos;
+    int yypos198 = yy->__pos, yythunkpos198 = yy->__thunkpos;
     if (!yy_SPACE(yy)) {
-      goto l188;
+      goto l198;
     }
-    goto l187;
-l188:
+    goto l197;
+l198:
     ;
-    yy->__pos = yypos188;
-    yy->__thunkpos = yythunkpos188;
+    yy->__pos = yypos198;
+    yy->__thunkpos = yythunkpos198;
   }
   yyprintf((stderr, "  ok   %s @ %s\n", "__", yy->__buf + yy->__pos));
   return 1;
-l186:
+l196:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4351,58 +4538,58 @@ YY_RULE(int) yy_FILTERJOIN(yycontext * yy) {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_BEGIN)) {
-      goto l189;
+      goto l199;
     }
 #undef yytext
 #undef yyleng
   }
   {
-    int yypos190 = yy->__pos, yythunkpos190 = yy->__thunkpos;
+    int yypos200 = yy->__pos, yythunkpos200 = yy->__thunkpos;
     if (!yymatchString(yy, "and")) {
-      goto l191;
+      goto l201;
     }
-    goto l190;
-l191:
+    goto l200;
+l201:
     ;
-    yy->__pos = yypos190;
-    yy->__thunkpos = yythunkpos190;
+    yy->__pos = yypos200;
+    yy->__thunkpos = yythunkpos200;
     if (!yymatchString(yy, "or")) {
-      goto l189;
+      goto l199;
     }
   }
-l190:
+l200:
   ;
   yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_END)) {
-      goto l189;
+      goto l199;
     }
 #undef yytext
 #undef yyleng
   }
   {
-    int yypos192 = yy->__pos, yythunkpos192 = yy->__thunkpos;
+    int yypos202 = yy->__pos, yythunkpos202 = yy->__thunkpos;
     if (!yy___(yy)) {
-      goto l192;
+      goto l202;
     }
     if (!yymatchString(yy, "not")) {
-      goto l192;
+      goto l202;
     }
     yyDo(yy, yy_1_FILTERJOIN, yy->__begin, yy->__end);
-    goto l193;
-l192:
+    goto l203;
+l202:
     ;
-    yy->__pos = yypos192;
-    yy->__thunkpos = yythunkpos192;
+    yy->__pos = yypos202;
+    yy->__thunkpos = yythunkpos202;
   }
-l193:
+l203:
   ;
   yyDo(yy, yy_2_FILTERJOIN, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "FILTERJOIN", yy->__buf + yy->__pos));
   return 1;
-l189:
+l199:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4414,62 +4601,62 @@ YY_RULE(int) yy_NUMPK_ARR(yycontext * yy) {
   yyDo(yy, yyPush, 3, 0);
   yyprintf((stderr, "%s\n", "NUMPK_ARR"));
   if (!yy_SARRJ(yy)) {
-    goto l194;
+    goto l204;
   }
   yyDo(yy, yySet, -3, 0);
   yyDo(yy, yy_1_NUMPK_ARR, yy->__begin, yy->__end);
   if (!yy__(yy)) {
-    goto l194;
+    goto l204;
   }
   {
-    int yypos195 = yy->__pos, yythunkpos195 = yy->__thunkpos;
+    int yypos205 = yy->__pos, yythunkpos205 = yy->__thunkpos;
     if (!yy_NUMPK(yy)) {
-      goto l195;
+      goto l205;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_2_NUMPK_ARR, yy->__begin, yy->__end);
-l197:
+l207:
     ;
     {
-      int yypos198 = yy->__pos, yythunkpos198 = yy->__thunkpos;
+      int yypos208 = yy->__pos, yythunkpos208 = yy->__thunkpos;
       if (!yy__(yy)) {
-        goto l198;
+        goto l208;
       }
       if (!yymatchChar(yy, ',')) {
-        goto l198;
+        goto l208;
       }
       if (!yy__(yy)) {
-        goto l198;
+        goto l208;
       }
       if (!yy_NUMPK(yy)) {
-        goto l198;
+        goto l208;
       }
       yyDo(yy, yySet, -1, 0);
       yyDo(yy, yy_3_NUMPK_ARR, yy->__begin, yy->__end);
-      goto l197;
-l198:
+      goto l207;
+l208:
       ;
-      yy->__pos = yypos198;
-      yy->__thunkpos = yythunkpos198;
-    }  goto l196;
-l195:
+      yy->__pos = yypos208;
+      yy->__thunkpos = yythunkpos208;
+    }  goto l206;
+l205:
     ;
-    yy->__pos = yypos195;
-    yy->__thunkpos = yythunkpos195;
+    yy->__pos = yypos205;
+    yy->__thunkpos = yythunkpos205;
   }
-l196:
+l206:
   ;
   if (!yy__(yy)) {
-    goto l194;
+    goto l204;
   }
   if (!yymatchChar(yy, ']')) {
-    goto l194;
+    goto l204;
   }
   yyDo(yy, yy_4_NUMPK_ARR, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "NUMPK_ARR", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 3, 0);
   return 1;
-l194:
+l204:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4484,26 +4671,26 @@ YY_RULE(int) yy_NUMPK(yycontext * yy) {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_BEGIN)) {
-      goto l199;
+      goto l209;
     }
 #undef yytext
 #undef yyleng
   }  if (!yy_NUMI(yy)) {
-    goto l199;
+    goto l209;
   }
   yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_END)) {
-      goto l199;
+      goto l209;
     }
 #undef yytext
 #undef yyleng
   }  yyDo(yy, yy_1_NUMPK, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "NUMPK", yy->__buf + yy->__pos));
   return 1;
-l199:
+l209:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4514,65 +4701,65 @@ YY_RULE(int) yy_PLACEHOLDER(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "PLACEHOLDER"));
   if (!yymatchChar(yy, ':')) {
-    goto l200;
+    goto l210;
   }
   yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_BEGIN)) {
-      goto l200;
+      goto l210;
     }
 #undef yytext
 #undef yyleng
   }
   {
-    int yypos201 = yy->__pos, yythunkpos201 = yy->__thunkpos;
+    int yypos211 = yy->__pos, yythunkpos211 = yy->__thunkpos;
     if (!yymatchClass(yy,
                       (unsigned char*)
                       "\000\000\000\000\000\000\377\003\376\377\377\007\376\377\377\007\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"))
     {
-      goto l202;
+      goto l212;
     }
-l203:
+l213:
     ;
     {
-      int yypos204 = yy->__pos, yythunkpos204 = yy->__thunkpos;
+      int yypos214 = yy->__pos, yythunkpos214 = yy->__thunkpos;
       if (!yymatchClass(yy,
                         (unsigned char*)
                         "\000\000\000\000\000\000\377\003\376\377\377\007\376\377\377\007\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"))
       {
-        goto l204;
+        goto l214;
       }
-      goto l203;
-l204:
+      goto l213;
+l214:
       ;
-      yy->__pos = yypos204;
-      yy->__thunkpos = yythunkpos204;
-    }  goto l201;
-l202:
+      yy->__pos = yypos214;
+      yy->__thunkpos = yythunkpos214;
+    }  goto l211;
+l212:
     ;
-    yy->__pos = yypos201;
-    yy->__thunkpos = yythunkpos201;
+    yy->__pos = yypos211;
+    yy->__thunkpos = yythunkpos211;
     if (!yymatchChar(yy, '?')) {
-      goto l200;
+      goto l210;
     }
   }
-l201:
+l211:
   ;
   yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_END)) {
-      goto l200;
+      goto l210;
     }
 #undef yytext
 #undef yyleng
   }  yyDo(yy, yy_1_PLACEHOLDER, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "PLACEHOLDER", yy->__buf + yy->__pos));
   return 1;
-l200:
+l210:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4583,14 +4770,14 @@ YY_RULE(int) yy_FILTERANCHOR(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "FILTERANCHOR"));
   if (!yymatchChar(yy, '@')) {
-    goto l205;
+    goto l215;
   }
   yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_BEGIN)) {
-      goto l205;
+      goto l215;
     }
 #undef yytext
 #undef yyleng
@@ -4598,36 +4785,36 @@ YY_RULE(int) yy_FILTERANCHOR(yycontext * yy) {
                        (unsigned char*)
                        "\000\000\000\000\000\040\377\003\376\377\377\207\376\377\377\007\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"))
   {
-    goto l205;
+    goto l215;
   }
-l206:
+l216:
   ;
   {
-    int yypos207 = yy->__pos, yythunkpos207 = yy->__thunkpos;
+    int yypos217 = yy->__pos, yythunkpos217 = yy->__thunkpos;
     if (!yymatchClass(yy,
                       (unsigned char*)
                       "\000\000\000\000\000\040\377\003\376\377\377\207\376\377\377\007\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000"))
     {
-      goto l207;
+      goto l217;
     }
-    goto l206;
-l207:
+    goto l216;
+l217:
     ;
-    yy->__pos = yypos207;
-    yy->__thunkpos = yythunkpos207;
+    yy->__pos = yypos217;
+    yy->__thunkpos = yythunkpos217;
   }  yyText(yy, yy->__begin, yy->__end);
   {
 #define yytext yy->__text
 #define yyleng yy->__textlen
     if (!(YY_END)) {
-      goto l205;
+      goto l215;
     }
 #undef yytext
 #undef yyleng
   }  yyDo(yy, yy_1_FILTERANCHOR, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "FILTERANCHOR", yy->__buf + yy->__pos));
   return 1;
-l205:
+l215:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4639,40 +4826,40 @@ YY_RULE(int) yy_FILTEREXPR(yycontext * yy) {
   yyDo(yy, yyPush, 3, 0);
   yyprintf((stderr, "%s\n", "FILTEREXPR"));
   if (!yy_FILTERFACTOR(yy)) {
-    goto l208;
+    goto l218;
   }
   yyDo(yy, yySet, -3, 0);
   yyDo(yy, yy_1_FILTEREXPR, yy->__begin, yy->__end);
-l209:
+l219:
   ;
   {
-    int yypos210 = yy->__pos, yythunkpos210 = yy->__thunkpos;
+    int yypos220 = yy->__pos, yythunkpos220 = yy->__thunkpos;
     if (!yy___(yy)) {
-      goto l210;
+      goto l220;
     }
     if (!yy_FILTERJOIN(yy)) {
-      goto l210;
+      goto l220;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_2_FILTEREXPR, yy->__begin, yy->__end);
     if (!yy___(yy)) {
-      goto l210;
+      goto l220;
     }
     if (!yy_FILTERFACTOR(yy)) {
-      goto l210;
+      goto l220;
     }
     yyDo(yy, yySet, -1, 0);
     yyDo(yy, yy_3_FILTEREXPR, yy->__begin, yy->__end);
-    goto l209;
-l210:
+    goto l219;
+l220:
     ;
-    yy->__pos = yypos210;
-    yy->__thunkpos = yythunkpos210;
+    yy->__pos = yypos220;
+    yy->__thunkpos = yythunkpos220;
   }  yyDo(yy, yy_4_FILTEREXPR, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "FILTEREXPR", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 3, 0);
   return 1;
-l208:
+l218:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4684,64 +4871,64 @@ YY_RULE(int) yy_FILTEREXPR_PK(yycontext * yy) {
   yyDo(yy, yyPush, 2, 0);
   yyprintf((stderr, "%s\n", "FILTEREXPR_PK"));
   {
-    int yypos212 = yy->__pos, yythunkpos212 = yy->__thunkpos;
+    int yypos222 = yy->__pos, yythunkpos222 = yy->__thunkpos;
     if (!yy_FILTERANCHOR(yy)) {
-      goto l212;
+      goto l222;
     }
     yyDo(yy, yySet, -2, 0);
     yyDo(yy, yy_1_FILTEREXPR_PK, yy->__begin, yy->__end);
-    goto l213;
-l212:
+    goto l223;
+l222:
     ;
-    yy->__pos = yypos212;
-    yy->__thunkpos = yythunkpos212;
+    yy->__pos = yypos222;
+    yy->__thunkpos = yythunkpos222;
   }
-l213:
+l223:
   ;
   if (!yymatchChar(yy, '/')) {
-    goto l211;
+    goto l221;
   }
   if (!yy__(yy)) {
-    goto l211;
+    goto l221;
   }
   if (!yymatchChar(yy, '=')) {
-    goto l211;
+    goto l221;
   }
   if (!yy__(yy)) {
-    goto l211;
+    goto l221;
   }
   {
-    int yypos214 = yy->__pos, yythunkpos214 = yy->__thunkpos;
+    int yypos224 = yy->__pos, yythunkpos224 = yy->__thunkpos;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l215;
+      goto l225;
     }
     yyDo(yy, yySet, -1, 0);
-    goto l214;
-l215:
+    goto l224;
+l225:
     ;
-    yy->__pos = yypos214;
-    yy->__thunkpos = yythunkpos214;
+    yy->__pos = yypos224;
+    yy->__thunkpos = yythunkpos224;
     if (!yy_NUMPK(yy)) {
-      goto l216;
+      goto l226;
     }
     yyDo(yy, yySet, -1, 0);
-    goto l214;
-l216:
+    goto l224;
+l226:
     ;
-    yy->__pos = yypos214;
-    yy->__thunkpos = yythunkpos214;
+    yy->__pos = yypos224;
+    yy->__thunkpos = yythunkpos224;
     if (!yy_NUMPK_ARR(yy)) {
-      goto l211;
+      goto l221;
     }
     yyDo(yy, yySet, -1, 0);
   }
-l214:
+l224:
   ;
   yyDo(yy, yy_2_FILTEREXPR_PK, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "FILTEREXPR_PK", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 2, 0);
   return 1;
-l211:
+l221:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4752,19 +4939,19 @@ YY_RULE(int) yy_EOF(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "EOF"));
   {
-    int yypos218 = yy->__pos, yythunkpos218 = yy->__thunkpos;
+    int yypos228 = yy->__pos, yythunkpos228 = yy->__thunkpos;
     if (!yymatchDot(yy)) {
-      goto l218;
+      goto l228;
     }
-    goto l217;
-l218:
+    goto l227;
+l228:
     ;
-    yy->__pos = yypos218;
-    yy->__thunkpos = yythunkpos218;
+    yy->__pos = yypos228;
+    yy->__thunkpos = yythunkpos228;
   }
   yyprintf((stderr, "  ok   %s @ %s\n", "EOF", yy->__buf + yy->__pos));
   return 1;
-l217:
+l227:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4775,33 +4962,33 @@ YY_RULE(int) yy_OPTS(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "OPTS"));
   if (!yymatchChar(yy, '|')) {
-    goto l219;
+    goto l229;
   }
   if (!yy__(yy)) {
-    goto l219;
+    goto l229;
   }
   if (!yy_OPT(yy)) {
-    goto l219;
+    goto l229;
   }
-l220:
+l230:
   ;
   {
-    int yypos221 = yy->__pos, yythunkpos221 = yy->__thunkpos;
+    int yypos231 = yy->__pos, yythunkpos231 = yy->__thunkpos;
     if (!yy___(yy)) {
-      goto l221;
+      goto l231;
     }
     if (!yy_OPT(yy)) {
-      goto l221;
+      goto l231;
     }
-    goto l220;
-l221:
+    goto l230;
+l231:
     ;
-    yy->__pos = yypos221;
-    yy->__thunkpos = yythunkpos221;
+    yy->__pos = yypos231;
+    yy->__thunkpos = yythunkpos231;
   }
   yyprintf((stderr, "  ok   %s @ %s\n", "OPTS", yy->__buf + yy->__pos));
   return 1;
-l219:
+l229:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4813,63 +5000,63 @@ YY_RULE(int) yy_PROJECTION(yycontext * yy) {
   yyDo(yy, yyPush, 2, 0);
   yyprintf((stderr, "%s\n", "PROJECTION"));
   if (!yymatchChar(yy, '|')) {
-    goto l222;
+    goto l232;
   }
   if (!yy__(yy)) {
-    goto l222;
+    goto l232;
   }
   if (!yy_PROJNODES(yy)) {
-    goto l222;
+    goto l232;
   }
   yyDo(yy, yySet, -2, 0);
   yyDo(yy, yy_1_PROJECTION, yy->__begin, yy->__end);
-l223:
+l233:
   ;
   {
-    int yypos224 = yy->__pos, yythunkpos224 = yy->__thunkpos;
+    int yypos234 = yy->__pos, yythunkpos234 = yy->__thunkpos;
     if (!yy__(yy)) {
-      goto l224;
+      goto l234;
     }
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_BEGIN)) {
-        goto l224;
+        goto l234;
       }
 #undef yytext
 #undef yyleng
     }  if (!yy_PROJOIN(yy)) {
-      goto l224;
+      goto l234;
     }
     yyText(yy, yy->__begin, yy->__end);
     {
 #define yytext yy->__text
 #define yyleng yy->__textlen
       if (!(YY_END)) {
-        goto l224;
+        goto l234;
       }
 #undef yytext
 #undef yyleng
     }  yyDo(yy, yy_2_PROJECTION, yy->__begin, yy->__end);
     if (!yy__(yy)) {
-      goto l224;
+      goto l234;
     }
     if (!yy_PROJNODES(yy)) {
-      goto l224;
+      goto l234;
     }
     yyDo(yy, yySet, -1, 0);
     yyDo(yy, yy_3_PROJECTION, yy->__begin, yy->__end);
-    goto l223;
-l224:
+    goto l233;
+l234:
     ;
-    yy->__pos = yypos224;
-    yy->__thunkpos = yythunkpos224;
+    yy->__pos = yypos234;
+    yy->__thunkpos = yythunkpos234;
   }  yyDo(yy, yy_4_PROJECTION, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "PROJECTION", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 2, 0);
   return 1;
-l222:
+l232:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4880,38 +5067,38 @@ YY_RULE(int) yy_UPSERT(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "UPSERT"));
   if (!yymatchString(yy, "upsert")) {
-    goto l225;
+    goto l235;
   }
   if (!yy___(yy)) {
-    goto l225;
+    goto l235;
   }
   {
-    int yypos226 = yy->__pos, yythunkpos226 = yy->__thunkpos;
+    int yypos236 = yy->__pos, yythunkpos236 = yy->__thunkpos;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l227;
+      goto l237;
     }
-    goto l226;
-l227:
+    goto l236;
+l237:
     ;
-    yy->__pos = yypos226;
-    yy->__thunkpos = yythunkpos226;
+    yy->__pos = yypos236;
+    yy->__thunkpos = yythunkpos236;
     if (!yy_OBJJ(yy)) {
-      goto l228;
+      goto l238;
     }
-    goto l226;
-l228:
+    goto l236;
+l238:
     ;
-    yy->__pos = yypos226;
-    yy->__thunkpos = yythunkpos226;
+    yy->__pos = yypos236;
+    yy->__thunkpos = yythunkpos236;
     if (!yy_ARRJ(yy)) {
-      goto l225;
+      goto l235;
     }
   }
-l226:
+l236:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "UPSERT", yy->__buf + yy->__pos));
   return 1;
-l225:
+l235:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4922,38 +5109,38 @@ YY_RULE(int) yy_APPLY(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "APPLY"));
   if (!yymatchString(yy, "apply")) {
-    goto l229;
+    goto l239;
   }
   if (!yy___(yy)) {
-    goto l229;
+    goto l239;
   }
   {
-    int yypos230 = yy->__pos, yythunkpos230 = yy->__thunkpos;
+    int yypos240 = yy->__pos, yythunkpos240 = yy->__thunkpos;
     if (!yy_PLACEHOLDER(yy)) {
-      goto l231;
+      goto l241;
     }
-    goto l230;
-l231:
+    goto l240;
+l241:
     ;
-    yy->__pos = yypos230;
-    yy->__thunkpos = yythunkpos230;
+    yy->__pos = yypos240;
+    yy->__thunkpos = yythunkpos240;
     if (!yy_OBJJ(yy)) {
-      goto l232;
+      goto l242;
     }
-    goto l230;
-l232:
+    goto l240;
+l242:
     ;
-    yy->__pos = yypos230;
-    yy->__thunkpos = yythunkpos230;
+    yy->__pos = yypos240;
+    yy->__thunkpos = yythunkpos240;
     if (!yy_ARRJ(yy)) {
-      goto l229;
+      goto l239;
     }
   }
-l230:
+l240:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "APPLY", yy->__buf + yy->__pos));
   return 1;
-l229:
+l239:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -4962,18 +5149,18 @@ l229:
 }
 YY_RULE(int) yy__(yycontext * yy) {
   yyprintf((stderr, "%s\n", "_"));
-l234:
+l244:
   ;
   {
-    int yypos235 = yy->__pos, yythunkpos235 = yy->__thunkpos;
+    int yypos245 = yy->__pos, yythunkpos245 = yy->__thunkpos;
     if (!yy_SPACE(yy)) {
-      goto l235;
+      goto l245;
     }
-    goto l234;
-l235:
+    goto l244;
+l245:
     ;
-    yy->__pos = yypos235;
-    yy->__thunkpos = yythunkpos235;
+    yy->__pos = yypos245;
+    yy->__thunkpos = yythunkpos245;
   }
   yyprintf((stderr, "  ok   %s @ %s\n", "_", yy->__buf + yy->__pos));
   return 1;
@@ -4982,24 +5169,24 @@ YY_RULE(int) yy_QEXPR(yycontext * yy) {
   int yypos0 = yy->__pos, yythunkpos0 = yy->__thunkpos;
   yyprintf((stderr, "%s\n", "QEXPR"));
   {
-    int yypos237 = yy->__pos, yythunkpos237 = yy->__thunkpos;
+    int yypos247 = yy->__pos, yythunkpos247 = yy->__thunkpos;
     if (!yy_FILTEREXPR_PK(yy)) {
-      goto l238;
+      goto l248;
     }
-    goto l237;
-l238:
+    goto l247;
+l248:
     ;
-    yy->__pos = yypos237;
-    yy->__thunkpos = yythunkpos237;
+    yy->__pos = yypos247;
+    yy->__thunkpos = yythunkpos247;
     if (!yy_FILTEREXPR(yy)) {
-      goto l236;
+      goto l246;
     }
   }
-l237:
+l247:
   ;
   yyprintf((stderr, "  ok   %s @ %s\n", "QEXPR", yy->__buf + yy->__pos));
   return 1;
-l236:
+l246:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -5011,103 +5198,103 @@ YY_RULE(int) yy_QUERY(yycontext * yy) {
   yyDo(yy, yyPush, 4, 0);
   yyprintf((stderr, "%s\n", "QUERY"));
   if (!yy_QEXPR(yy)) {
-    goto l239;
+    goto l249;
   }
   yyDo(yy, yySet, -4, 0);
   yyDo(yy, yy_1_QUERY, yy->__begin, yy->__end);
   {
-    int yypos240 = yy->__pos, yythunkpos240 = yy->__thunkpos;
+    int yypos250 = yy->__pos, yythunkpos250 = yy->__thunkpos;
     if (!yy__(yy)) {
-      goto l240;
+      goto l250;
     }
     if (!yymatchChar(yy, '|')) {
-      goto l240;
+      goto l250;
     }
     if (!yy__(yy)) {
-      goto l240;
+      goto l250;
     }
     {
-      int yypos242 = yy->__pos, yythunkpos242 = yy->__thunkpos;
+      int yypos252 = yy->__pos, yythunkpos252 = yy->__thunkpos;
       if (!yy_APPLY(yy)) {
-        goto l243;
+        goto l253;
       }
       yyDo(yy, yySet, -3, 0);
       yyDo(yy, yy_2_QUERY, yy->__begin, yy->__end);
-      goto l242;
-l243:
+      goto l252;
+l253:
       ;
-      yy->__pos = yypos242;
-      yy->__thunkpos = yythunkpos242;
+      yy->__pos = yypos252;
+      yy->__thunkpos = yythunkpos252;
       if (!yymatchString(yy, "del")) {
-        goto l244;
+        goto l254;
       }
       yyDo(yy, yy_3_QUERY, yy->__begin, yy->__end);
-      goto l242;
-l244:
+      goto l252;
+l254:
       ;
-      yy->__pos = yypos242;
-      yy->__thunkpos = yythunkpos242;
+      yy->__pos = yypos252;
+      yy->__thunkpos = yythunkpos252;
       if (!yy_UPSERT(yy)) {
-        goto l240;
+        goto l250;
       }
       yyDo(yy, yySet, -2, 0);
       yyDo(yy, yy_4_QUERY, yy->__begin, yy->__end);
     }
-l242:
+l252:
     ;
-    goto l241;
-l240:
+    goto l251;
+l250:
     ;
-    yy->__pos = yypos240;
-    yy->__thunkpos = yythunkpos240;
+    yy->__pos = yypos250;
+    yy->__thunkpos = yythunkpos250;
   }
-l241:
+l251:
   ;
   {
-    int yypos245 = yy->__pos, yythunkpos245 = yy->__thunkpos;
+    int yypos255 = yy->__pos, yythunkpos255 = yy->__thunkpos;
     if (!yy__(yy)) {
-      goto l245;
+      goto l255;
     }
     if (!yy_PROJECTION(yy)) {
-      goto l245;
+      goto l255;
     }
     yyDo(yy, yySet, -1, 0);
     yyDo(yy, yy_5_QUERY, yy->__begin, yy->__end);
-    goto l246;
-l245:
+    goto l256;
+l255:
     ;
-    yy->__pos = yypos245;
-    yy->__thunkpos = yythunkpos245;
+    yy->__pos = yypos255;
+    yy->__thunkpos = yythunkpos255;
   }
-l246:
+l256:
   ;
   {
-    int yypos247 = yy->__pos, yythunkpos247 = yy->__thunkpos;
+    int yypos257 = yy->__pos, yythunkpos257 = yy->__thunkpos;
     if (!yy__(yy)) {
-      goto l247;
+      goto l257;
     }
     if (!yy_OPTS(yy)) {
-      goto l247;
+      goto l257;
     }
-    goto l248;
-l247:
+    goto l258;
+l257:
     ;
-    yy->__pos = yypos247;
-    yy->__thunkpos = yythunkpos247;
+    yy->__pos = yypos257;
+    yy->__thunkpos = yythunkpos257;
   }
-l248:
+l258:
   ;
   if (!yy__(yy)) {
-    goto l239;
+    goto l249;
   }
   if (!yy_EOF(yy)) {
-    goto l239;
+    goto l249;
   }
   yyDo(yy, yy_6_QUERY, yy->__begin, yy->__end);
   yyprintf((stderr, "  ok   %s @ %s\n", "QUERY", yy->__buf + yy->__pos));
   yyDo(yy, yyPop, 4, 0);
   return 1;
-l239:
+l249:
   ;
   yy->__pos = yypos0;
   yy->__thunkpos = yythunkpos0;
@@ -5159,7 +5346,7 @@ YY_PARSE(yycontext*) YYRELEASE(yycontext * yyctx) {
 }
 
 #endif
-#line 253 "./jqp.leg"
+#line 261 "./jqp.leg"
 
 
 #include "./inc/jqpx.c"
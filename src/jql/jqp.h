@@ -111,7 +111,7 @@ typedef union jqp_unit JQPUNIT;
         jqp_unit_t type;            \
         struct jqp_expr_node *next; \
         struct jqp_join *join;      \
-        void *opaque;               \
+        int idx;                    \
         uint8_t flags;
 
 typedef struct jqp_expr_node { // Base for JQP_FILTER
@@ -143,8 +143,7 @@ typedef struct jqp_node {
   jqp_node_type_t  ntype;
   struct jqp_node *next;
   JQPUNIT *value;
-  int      start; // Used in query matching
-  int      end;   // Used in query matching
+  int      idx;   // Index of node matching state in query object
 } JQP_NODE;
 
 typedef struct jqp_string {
@@ -155,6 +154,7 @@ typedef struct jqp_string {
   struct jqp_string *subnext;
   struct jqp_string *placeholder_next;
   void *opaque;
+  int   idx;        // Index of placeholder value in query object
 } JQP_STRING;
 
 typedef struct jqp_integer {
@@ -176,7 +176,7 @@ typedef struct jqp_op {
   bool       negate;
   jqp_op_t   value;
   struct jqp_op *next;
-  void *opaque;
+  int idx;          // Index of compiled regexp in query object
 } JQP_OP;
 
 typedef struct jqp_join {
@@ -192,15 +192,14 @@ typedef struct jqp_expr {
   JQPUNIT *left;
   JQPUNIT *right;
   struct jqp_expr *next;
-  bool prematched;
+  int idx;          // Index of prematched flag in query object
 } JQP_EXPR;
 
 typedef struct jqp_projection {
   jqp_unit_t type;
   struct jqp_string     *value;
   struct jqp_projection *next;
-  int16_t pos;          // Current matching position, used in jql.c#_jql_project
-  int16_t cnt;          // Number of projection sections, used in jql.c#_jql_project
+  int     idx;          // Index of projection matching state, used in jql.c#_jql_project
 
 #define JQP_PROJECTION_FLAG_EXCLUDE 0x01U
 #define JQP_PROJECTION_FLAG_INCLUDE 0x02U
@@ -208,6 +207,26 @@ typedef struct jqp_projection {
   uint8_t flags;
 } JQP_PROJECTION;
 
+typedef uint8_t jqp_aggregate_op_t;
+/** Group by key */
+#define JQP_AGGREGATE_GROUP ((jqp_aggregate_op_t) 0x00U)
+/** Sum of numeric values */
+#define JQP_AGGREGATE_SUM ((jqp_aggregate_op_t) 0x01U)
+/** Average of numeric values */
+#define JQP_AGGREGATE_AVG ((jqp_aggregate_op_t) 0x02U)
+/** Min value */
+#define JQP_AGGREGATE_MIN ((jqp_aggregate_op_t) 0x03U)
+/** Max value */
+#define JQP_AGGREGATE_MAX ((jqp_aggregate_op_t) 0x04U)
+
+typedef struct jqp_aggregate {
+  jqp_aggregate_op_t    op;
+  struct jqp_string    *value;  /**< Field path nodes chain */
+  struct jbl_ptr       *ptr;    /**< Field path pointer */
+  const char           *name;   /**< Field name in result documents */
+  struct jqp_aggregate *next;
+} JQP_AGGREGATE;
+
 typedef struct jqp_query {
   jqp_unit_t      type;
   struct jqp_aux *aux;
@@ -260,6 +279,7 @@ typedef uint8_t jqp_query_mode_t;
 #define JQP_QRY_APPLY_DEL    ((jqp_query_mode_t) 0x04U)
 #define JQP_QRY_INVERSE      ((jqp_query_mode_t) 0x08U)
 #define JQP_QRY_APPLY_UPSERT ((jqp_query_mode_t) 0x10U)
+#define JQP_QRY_GROUP        ((jqp_query_mode_t) 0x20U)
 
 #define JQP_QRY_AGGREGATE (JQP_QRY_COUNT)
 
@@ -268,6 +288,15 @@ typedef struct jqp_aux {
   int     stackn;
   int     num_placeholders;
   int     orderby_num;                  /**< Number of order-by blocks */
+  int     refs;                         /**< Number of query objects sharing this parsed query */
+  int     num_enodes;                   /**< Number of expression nodes and filters */
+  int     num_nodes;                    /**< Number of filter nodes */
+  int     num_exprs;                    /**< Number of filter node expressions */
+  int     num_ops;                      /**< Number of expression operations */
+  int     num_projections;              /**< Number of projections */
+  int     num_placeholder_units;        /**< Number of placeholder units including repeated named ones */
+  int     aggregates_num;               /**< Number of aggregate functions */
+  int     groupby_num;                  /**< Number of group by keys */
   iwrc    rc;
   jmp_buf fatal_jmp;
   const char       *buf;
@@ -283,6 +312,8 @@ typedef struct jqp_aux {
   struct jqp_string     *end_placeholder;
   struct jqp_string     *orderby;
   struct jbl_ptr       **orderby_ptrs;        /**< Order-by pointers, orderby_num - number of pointers allocated */
+  struct jqp_aggregate  *aggregates;          /**< Aggregate functions */
+  struct jqp_aggregate  *groupby;             /**< Group by keys */
   struct jqp_op   *start_op;
   struct jqp_op   *end_op;
   union jqp_unit  *skip;
@@ -291,7 +322,9 @@ typedef struct jqp_aux {
   const char      *apply_placeholder;
   const char      *first_anchor;
   jqp_query_mode_t qmode;
+  jqp_aggregate_op_t aggregate_op;      /**< Aggregate function of the clause being parsed */
   bool negate;
+  bool aggregate_orderby;               /**< Order-by pointer is implied by aggregation */
   bool has_keep_projections;
   bool has_exclude_all_projection;
   struct jqp_stack stackpool[JQP_AUX_STACKPOOL_NUM];
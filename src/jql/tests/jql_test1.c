@@ -4,6 +4,7 @@
 #include <iowow/iwutils.h>
 #include <CUnit/Basic.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 int init_suite(void) {
   int rc = ejdb_init();
@@ -75,7 +76,7 @@ static void jql_test1_1(void) {
   for (int i = 11; i <= 13; ++i) {
     _jql_test1_1(i, JQL_ERROR_QUERY_PARSE);
   }
-  for (int i = 14; i <= 22; ++i) {
+  for (int i = 14; i <= 23; ++i) {
     _jql_test1_1(i, 0);
   }
 }
@@ -276,6 +277,11 @@ static void jql_test_1_4(void) {
   _jql_test1_3(true, "{'foo':{'bar':22}}", "/** | /zzz", "{}");
   _jql_test1_3(true, "{'foo':{'bar':22}}", "/** | /fooo", "{}");
   _jql_test1_3(true, "{'foo':{'bar':22},'name':'test'}", "/** | all - /name", "{'foo':{'bar':22}}");
+  _jql_test1_3(true, "{'foo':{'bar':{'baz':[1,2]}},'name':'test'}", "/** | /foo", "{'foo':{'bar':{'baz':[1,2]}}}");
+  _jql_test1_3(true, "{'foo':[{'a':1,'b':2},{'a':3}],'name':'test'}", "/** | /foo - /foo/*/b",
+               "{'foo':[{'a':1},{'a':3}]}");
+  _jql_test1_3(true, "{'x':{'a':1,'b':2},'y':{'a':3},'z':5}", "/** | /*/a", "{'x':{'a':1},'y':{'a':3}}");
+  _jql_test1_3(true, "{'x':{'a':1,'b':2},'y':[],'z':{}}", "/** | /x/a + /y + /z", "{'x':{'a':1},'y':[],'z':{}}");
 }
 
 // Test placeholder projecttion
@@ -325,6 +331,63 @@ static void jql_test_1_6(void) {
   jql_destroy(&q);
 }
 
+struct _jql_test1_7_task {
+  JQL  q;
+  JBL  jbl;
+  int  num;
+  bool fail;
+};
+
+static void* _jql_test1_7_worker(void *op) {
+  struct _jql_test1_7_task *task = op;
+  for (int i = 0; i < 1000; ++i) {
+    bool m = false;
+    iwrc rc = jql_matched(task->q, task->jbl, &m);
+    // Query matches only for the task bound to the document `num` value
+    if (rc || (m != (task->num == 2))) {
+      task->fail = true;
+      break;
+    }
+  }
+  return 0;
+}
+
+// Concurrent execution of queries sharing the same parsed query
+static void jql_test_1_7(void) {
+  JQL q = 0;
+  JBL jbl = 0;
+  pthread_t threads[4];
+  struct _jql_test1_7_task tasks[4] = { 0 };
+
+  iwrc rc = jql_create(&q, "c1", "/foo/[bar = :num] and /[name re :?] | /foo");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_from_json(&jbl, "{\"foo\":{\"bar\":2},\"name\":\"test\"}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int i = 0; i < 4; ++i) {
+    tasks[i].num = i;
+    tasks[i].jbl = jbl;
+    rc = jql_clone(q, &tasks[i].q);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = jql_set_i64(tasks[i].q, "num", 0, i);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = jql_set_regexp(tasks[i].q, 0, 0, "^te");
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+  // Parsed query is kept until the last clone is destroyed
+  jql_destroy(&q);
+
+  for (int i = 0; i < 4; ++i) {
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&threads[i], 0, _jql_test1_7_worker, &tasks[i]), 0);
+  }
+  for (int i = 0; i < 4; ++i) {
+    pthread_join(threads[i], 0);
+    CU_ASSERT_FALSE(tasks[i].fail);
+    jql_destroy(&tasks[i].q);
+  }
+  jbl_destroy(&jbl);
+}
+
 int main() {
   CU_pSuite pSuite = NULL;
   if (CUE_SUCCESS != CU_initialize_registry()) {
@@ -340,7 +403,8 @@ int main() {
      || (NULL == CU_add_test(pSuite, "jql_test1_3", jql_test1_3))
      || (NULL == CU_add_test(pSuite, "jql_test1_4", jql_test_1_4))
      || (NULL == CU_add_test(pSuite, "jql_test1_5", jql_test_1_5))
-     || (NULL == CU_add_test(pSuite, "jql_test1_6", jql_test_1_6))) {
+     || (NULL == CU_add_test(pSuite, "jql_test1_6", jql_test_1_6))
+     || (NULL == CU_add_test(pSuite, "jql_test1_7", jql_test_1_7))) {
     CU_cleanup_registry();
     return CU_get_error();
   }
@@ -1,5 +1,7 @@
 #include "ejdb_test.h"
 #include <CUnit/Basic.h>
+#include <pthread.h>
+#include <unistd.h>
 
 int init_suite() {
   int rc = ejdb_init();
@@ -1149,6 +1151,2441 @@ static void ejdb_test3_9(void) {
   CU_ASSERT_EQUAL_FATAL(rc, 0);
 }
 
+static iwrc ejdb_test3_10_visitor(struct ejdb_exec *ux, EJDB_DOC doc, int64_t *step) {
+  int64_t *prev = ux->opaque;
+  CU_ASSERT_TRUE(doc->id < *prev);
+  *prev = doc->id;
+  return 0;
+}
+
+static void ejdb_test3_10(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_10.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .parallel_threads = 4
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id, n, count = 0, prev = INT64_MAX;
+  EJDB_LIST list = 0;
+  const int num = 4 * JB_PARALLEL_SCAN_MIN_RNUM;
+  IWXSTR *log = iwxstr_new();
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int i = 0; i < num; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"g\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  // Parallel scan keeps the order of document ids
+  rc = ejdb_list3(db, "c1", "/[g = 3]", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[SCANNER] PARALLEL"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    CU_ASSERT_TRUE(doc->id < prev);
+    prev = doc->id;
+    ++count;
+  }
+  CU_ASSERT_EQUAL(count, num / 7);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_list3(db, "c1", "/[g = 3] | skip 10 limit 5", 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  count = 0;
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    rc = jbl_object_get_i64(doc->raw, "n", &n);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(n, num - 1 - (num - 1 - 3) % 7 - 7 * (10 + count));
+    ++count;
+  }
+  CU_ASSERT_EQUAL(count, 5);
+  ejdb_list_destroy(&list);
+
+  // Parallel sorting
+  prev = -1;
+  count = 0;
+  rc = ejdb_list3(db, "c1", "/[g != 3] | asc /n", 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    rc = jbl_object_get_i64(doc->raw, "n", &n);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_TRUE(n > prev);
+    prev = n;
+    ++count;
+  }
+  CU_ASSERT_EQUAL(count, num - num / 7);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_count2(db, "c1", "/[g = 3]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, num / 7);
+
+  // Paged queries fall back to serial scan resumed by page tokens
+  JQL q;
+  int pages = 0;
+  IWXSTR *token = iwxstr_new();
+  rc = jql_create(&q, "c1", "/[g = 3]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  prev = INT64_MAX;
+  count = 0;
+  do {
+    iwxstr_clear(log);
+    EJDB_EXEC ux = {
+      .db = db,
+      .q = q,
+      .visitor = ejdb_test3_10_visitor,
+      .opaque = &prev,
+      .log = log,
+      .limit = num / 7 / 3 + 1,
+      .page_token = iwxstr_ptr(token),
+      .next_page_token = token
+    };
+    rc = ejdb_exec(&ux);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_PTR_NULL(strstr(iwxstr_ptr(log), "[SCANNER] PARALLEL"));
+    count += ux.cnt;
+    CU_ASSERT_TRUE_FATAL(++pages <= 4);
+  } while (iwxstr_size(token));
+  CU_ASSERT_EQUAL(pages, 3);
+  CU_ASSERT_EQUAL(count, num / 7);
+  iwxstr_destroy(token);
+
+  // Cursor fetches documents by batches
+  EJDB_DOC doc;
+  EJDB_CURSOR cur;
+  prev = INT64_MAX;
+  count = 0;
+  rc = ejdb_cursor_open(db, q, 100, &cur);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  while (!(rc = ejdb_cursor_next(cur, &doc)) && doc) {
+    CU_ASSERT_TRUE(doc->id < prev);
+    prev = doc->id;
+    ++count;
+  }
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, num / 7);
+  ejdb_cursor_close(&cur);
+  jql_destroy(&q);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(log);
+}
+
+static void ejdb_test3_11(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_11.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .query_cache_size = 2
+  };
+  EJDB db;
+  JQL q, q2;
+  int64_t count = 0;
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 10; ++i) {
+    char buf[64];
+    JBL jbl;
+    int64_t id;
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"s\":\"v  %d\"}", i, i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  rc = ejdb_query_prepared(db, "c1", "/[n > :n]", 0, &q);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iwhmap_count(db->qcache), 1);
+  rc = ejdb_query_prepared(db, "c1", "  /[n   >  :n] ", 0, &q2);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iwhmap_count(db->qcache), 1);
+  CU_ASSERT_PTR_EQUAL(q->aux, q2->aux);
+  CU_ASSERT_PTR_NOT_EQUAL(q, q2);
+
+  // Every query object has its own placeholder bindings
+  rc = jql_set_i64(q, "n", 0, 6);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jql_set_i64(q2, "n", 0, 2);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count(db, q, &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 3);
+  rc = ejdb_count(db, q2, &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 7);
+  jql_destroy(&q2);
+
+  // Whitespaces in string literals are significant
+  rc = ejdb_count2(db, "c1", "/[s = \"v  3\"]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 1);
+  rc = ejdb_count2(db, "c1", "/[s = \"v 3\"]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 0);
+
+  // Evicted cached query is still valid for its clones
+  CU_ASSERT_EQUAL(iwhmap_count(db->qcache), 2);
+  rc = ejdb_count(db, q, &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 3);
+  jql_destroy(&q);
+
+  // Parse errors are not cached
+  rc = ejdb_query_prepared(db, "c1", "/[n > ", JQL_SILENT_ON_PARSE_ERROR | JQL_KEEP_QUERY_ON_PARSE_ERROR, &q);
+  CU_ASSERT_EQUAL(rc, JQL_ERROR_QUERY_PARSE);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(q);
+  CU_ASSERT_PTR_NOT_NULL(jql_error(q));
+  CU_ASSERT_EQUAL(iwhmap_count(db->qcache), 2);
+  jql_destroy(&q);
+
+  // Counting does not affect projection of cached query
+  EJDB_LIST list = 0;
+  rc = ejdb_count2(db, "c1", "/[n = 1] | /s", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 1);
+  rc = ejdb_list3(db, "c1", "/[n = 1] | /s", 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(list->first);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(list->first->node);
+  CU_ASSERT_STRING_EQUAL(list->first->node->child->key, "s");
+  CU_ASSERT_PTR_NULL(list->first->node->child->next);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_12(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_12.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JQL q;
+  int64_t count = 0;
+  IWXSTR *log = iwxstr_new();
+  const char *vals[] = { "abc", "abcd", "abx", "ab", "abcxyz", "zzz", "xabc", "abc1" };
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/s", EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < sizeof(vals) / sizeof(vals[0]); ++i) {
+    char buf[64];
+    JBL jbl;
+    int64_t id;
+    snprintf(buf, sizeof(buf), "{\"s\":\"%s\"}", vals[i]);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  rc = jql_create(&q, "c1", "/[s re \"^abc.*\"]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = { .db = db, .q = q, .log = log };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 4);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED STR"));
+  jql_destroy(&q);
+
+  // Regexp is matched as residual filter
+  rc = ejdb_count2(db, "c1", "/[s re \"^abc\\\\d\"]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 1);
+
+  // Optional last literal is not a part of the prefix
+  rc = ejdb_count2(db, "c1", "/[s re \"^abcd?\"]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 4);
+
+  // No common prefix for top level alternation
+  iwxstr_clear(log);
+  rc = jql_create(&q, "c1", "/[s re \"^abc|zz\"]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ux = (EJDB_EXEC) { .db = db, .q = q, .log = log };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 5);
+  CU_ASSERT_PTR_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED"));
+  jql_destroy(&q);
+
+  // Prefix is recomputed for new placeholder value
+  rc = jql_create(&q, "c1", "/[s re :?]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jql_set_str(q, 0, 0, "^ab");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count(db, q, &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 6);
+  rc = jql_set_str(q, 0, 0, "^abx");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count(db, q, &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 1);
+  jql_destroy(&q);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(log);
+}
+
+static void ejdb_test3_13(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_13.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  const char *status;
+  int64_t id, count = 0;
+  EJDB_LIST list = 0;
+  IWXSTR *log = iwxstr_new();
+  const char *statuses[] = { "done", "archived", "open", "new" };
+  const char *docs[] = {
+    "{\"tags\":[\"a\",\"b\"]}", "{\"tags\":[\"b\"]}", "{\"tags\":\"b\"}", "{\"tags\":[\"c\"]}",
+    "{\"tags\":null}", "{\"tags\":{\"b\":\"z\"}}", "{\"tags\":[\"z\"]}", "{\"tags\":[]}"
+  };
+  const char *queries[] = {
+    "/[tags != \"z\"]", "/[tags not in [\"z\", \"b\"]]", "/[tags != \"b\"]", "/[tags not in [\"z\"]]"
+  };
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/status", EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c2", "/tags", EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c3", "/tags", EJDB_IDX_UNIQUE | EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 40; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"status\":\"%s\"}", i, statuses[i % 4]);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+  for (int i = 0; i < sizeof(docs) / sizeof(docs[0]); ++i) {
+    rc = jbl_from_json(&jbl, docs[i]);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c2", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    if (i < 4) {
+      rc = ejdb_put_new(db, "c3", jbl, &id);
+      CU_ASSERT_EQUAL_FATAL(rc, 0);
+    }
+    jbl_destroy(&jbl);
+  }
+
+  // Negated expressions are matched by full scan
+  rc = ejdb_list3(db, "c1", "/[status != \"done\"]", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    rc = jbl_object_get_str(doc->raw, "status", &status);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_STRING_NOT_EQUAL(status, "done");
+  }
+  CU_ASSERT_EQUAL(count, 30);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_count2(db, "c1", "/[status not in [\"done\", \"archived\"]]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 20);
+
+  // Index is used by other expressions of query
+  iwxstr_clear(log);
+  rc = ejdb_list3(db, "c1", "/[status = \"open\"] and /[n != 2]", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED STR"));
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "EXPR1: 'status = open'"));
+  count = 0;
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    ++count;
+  }
+  CU_ASSERT_EQUAL(count, 9);
+  ejdb_list_destroy(&list);
+
+  const char *prev = "";
+  count = 0;
+  rc = ejdb_list3(db, "c1", "/[status != \"open\"] | asc /status", 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    rc = jbl_object_get_str(doc->raw, "status", &status);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_TRUE(strcmp(prev, status) <= 0);
+    CU_ASSERT_STRING_NOT_EQUAL(status, "open");
+    prev = status;
+  }
+  CU_ASSERT_EQUAL(count, 30);
+  ejdb_list_destroy(&list);
+
+  // Unique index
+  rc = ejdb_count2(db, "c1", "/[n != 5]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 39);
+  rc = ejdb_count2(db, "c1", "/[n not in [1, 2, 3]]", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 37);
+
+  // Array field contains value
+  iwxstr_clear(log);
+  EJDB_EXEC ux = { .db = db, .log = log };
+  rc = jql_create(&ux.q, "c2", "/[tags ni \"b\"]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 2);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED STR"));
+  jql_destroy(&ux.q);
+
+  // Unique index does not keep array elements
+  iwxstr_clear(log);
+  ux.cnt = 0;
+  rc = jql_create(&ux.q, "c3", "/[tags ni \"b\"]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 2);
+  CU_ASSERT_PTR_NULL(strstr(iwxstr_ptr(log), "[INDEX] SELECTED"));
+  jql_destroy(&ux.q);
+
+  // Negated expressions match documents without index keys of field:
+  // null, object, empty array and array of excluded values only
+  for (int i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+    int64_t icount = 0;
+    rc = ejdb_count2(db, "c2", queries[i], &icount, 0);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    snprintf(buf, sizeof(buf), "%s | noidx", queries[i]);
+    rc = ejdb_count2(db, "c2", buf, &count, 0);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(icount, count);
+  }
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(log);
+}
+
+// Test aggregate functions and group by
+static void ejdb_test3_14(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_14.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  JQL q;
+  double dv;
+  const char *status;
+  int64_t id, llv, count = 0;
+  EJDB_LIST list = 0;
+  IWXSTR *log = iwxstr_new();
+  const char *statuses[] = { "done", "archived", "open", "new" };
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/status", EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 40; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"status\":\"%s\",\"price\":%d.5}", i, statuses[i % 4], i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  // Groups are collected in index order
+  rc = ejdb_list3(db, "c1", "/* | group by /status sum /n avg /price min /n max /n", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[COLLECTOR] AGGREGATE ORDERED"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    rc = jbl_object_get_str(doc->raw, "/status", &status);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    int s = 0;
+    while (s < 4 && strcmp(statuses[s], status)) {
+      ++s;
+    }
+    CU_ASSERT_TRUE_FATAL(s < 4);
+    rc = jbl_object_get_i64(doc->raw, "count", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, 10);
+    rc = jbl_object_get_i64(doc->raw, "sum(/n)", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, 180 + 10 * s);
+    rc = jbl_object_get_f64(doc->raw, "avg(/price)", &dv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_DOUBLE_EQUAL(dv, 18.5 + s, 0.0001);
+    rc = jbl_object_get_i64(doc->raw, "min(/n)", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, s);
+    rc = jbl_object_get_i64(doc->raw, "max(/n)", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, 36 + s);
+  }
+  CU_ASSERT_EQUAL(count, 4);
+  ejdb_list_destroy(&list);
+
+  // Hash aggregation without index
+  count = 0;
+  iwxstr_clear(log);
+  rc = ejdb_list3(db, "c1", "/[n < 20] | distinct /status sum /n noidx", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[COLLECTOR] AGGREGATE\n"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    rc = jbl_object_get_i64(doc->raw, "count", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, 5);
+  }
+  CU_ASSERT_EQUAL(count, 4);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_count2(db, "c1", "/[status != \"done\"] | distinct /status", &count, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 3);
+
+  // Max value is taken from the first index entry
+  count = 0;
+  iwxstr_clear(log);
+  rc = ejdb_list3(db, "c1", "/* | max /n", 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[COLLECTOR] AGGREGATE ORDERED"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    rc = jbl_object_get_i64(doc->raw, "max(/n)", &llv);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(llv, 39);
+  }
+  CU_ASSERT_EQUAL(count, 1);
+  ejdb_list_destroy(&list);
+
+  // Aggregate functions over no matched documents
+  count = 0;
+  rc = ejdb_list3(db, "c1", "/[n > 100] | min /n sum /price", 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++count) {
+    CU_ASSERT_EQUAL(jbl_object_get_type(doc->raw, "min(/n)"), JBV_NULL);
+    CU_ASSERT_EQUAL(jbl_object_get_type(doc->raw, "sum(/price)"), JBV_NULL);
+  }
+  CU_ASSERT_EQUAL(count, 1);
+  ejdb_list_destroy(&list);
+
+  rc = jql_create(&q, "c1", "/* | del | sum /n");
+  CU_ASSERT_EQUAL(rc, JQL_ERROR_AGGREGATE_WITH_APPLY);
+  rc = jql_create(&q, "c1", "/* | group by /n desc /n");
+  CU_ASSERT_EQUAL(rc, JQL_ERROR_AGGREGATE_WITH_ORDERBY);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(log);
+}
+
+struct ejdb_test3_15_ctx {
+  int64_t ids[64];
+  int     num;
+};
+
+static iwrc ejdb_test3_15_visitor(struct ejdb_exec *ux, EJDB_DOC doc, int64_t *step) {
+  struct ejdb_test3_15_ctx *pc = ux->opaque;
+  if (pc->num < sizeof(pc->ids) / sizeof(pc->ids[0])) {
+    pc->ids[pc->num++] = doc->id;
+  }
+  return 0;
+}
+
+// Fetches all query results by pages then compares them with results of query without pagination
+static void ejdb_test3_15_check(EJDB db, const char *query, int64_t limit, int pages_expected) {
+  JQL q;
+  int pages = 0;
+  EJDB_LIST list = 0;
+  struct ejdb_test3_15_ctx pc = { 0 };
+  IWXSTR *token = iwxstr_new();
+  iwrc rc = jql_create(&q, "c1", query);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  do {
+    EJDB_EXEC ux = {
+      .db = db,
+      .q = q,
+      .visitor = ejdb_test3_15_visitor,
+      .opaque = &pc,
+      .limit = limit,
+      .page_token = iwxstr_ptr(token),
+      .next_page_token = token
+    };
+    rc = ejdb_exec(&ux);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_TRUE_FATAL(++pages <= pages_expected);
+  } while (iwxstr_size(token));
+  CU_ASSERT_EQUAL(pages, pages_expected);
+
+  rc = ejdb_list4(db, q, 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  int i = 0;
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++i) {
+    CU_ASSERT_TRUE_FATAL(i < pc.num);
+    CU_ASSERT_EQUAL(doc->id, pc.ids[i]);
+  }
+  CU_ASSERT_EQUAL(i, pc.num);
+  ejdb_list_destroy(&list);
+  jql_destroy(&q);
+  iwxstr_destroy(token);
+}
+
+// Test keyset pagination
+static void ejdb_test3_15(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_15.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  JQL q;
+  int64_t id;
+  const char *statuses[] = { "done", "archived", "open", "new" };
+  char buf[64];
+  struct ejdb_test3_15_ctx pc = { 0 };
+  IWXSTR *token = iwxstr_new();
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/status", EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 40; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"status\":\"%s\",\"price\":%d}", i, statuses[i % 4], i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  ejdb_test3_15_check(db, "/*", 7, 6);
+  ejdb_test3_15_check(db, "/* | inverse", 9, 5);
+  ejdb_test3_15_check(db, "/[n >= 10] | asc /n", 7, 5);
+  ejdb_test3_15_check(db, "/[n < 30] | desc /n", 7, 5);
+  ejdb_test3_15_check(db, "/[status = \"open\"]", 3, 4);
+  ejdb_test3_15_check(db, "/[status > \"done\"] and /[price > 2]", 4, 4);
+
+  // Last document of the page is removed before the next page
+  rc = jql_create(&q, "c1", "/[n >= 0] | asc /n");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_15_visitor,
+    .opaque = &pc,
+    .limit = 10,
+    .next_page_token = token
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL_FATAL(pc.num, 10);
+  CU_ASSERT_TRUE_FATAL(iwxstr_size(token) > 0);
+  rc = ejdb_del(db, "c1", pc.ids[9]);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ux.limit = 10;
+  ux.page_token = iwxstr_ptr(token);
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL_FATAL(pc.num, 20);
+  for (int i = 0; i < pc.num; ++i) {
+    CU_ASSERT_EQUAL(pc.ids[i], i + 1);
+  }
+
+  // Token of other query plan
+  ux.limit = 10;
+  rc = jql_create(&ux.q, "c1", "/*");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_INVALID_PAGE_TOKEN);
+  ux.page_token = "zz";
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_INVALID_PAGE_TOKEN);
+  jql_destroy(&ux.q);
+
+  // Sorting without index doesn't support pagination
+  ux.limit = 10;
+  ux.page_token = 0;
+  rc = jql_create(&ux.q, "c1", "/* | asc /price");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iwxstr_size(token), 0);
+  jql_destroy(&ux.q);
+
+  jql_destroy(&q);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(token);
+}
+
+// Pulls all query results by cursor then compares them with results of `ejdb_list4()`
+static void ejdb_test3_16_check(EJDB db, const char *query, int64_t batch) {
+  JQL q;
+  EJDB_DOC doc;
+  EJDB_CURSOR cur;
+  EJDB_LIST list = 0;
+  iwrc rc = jql_create(&q, "c1", query);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_list4(db, q, 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_cursor_open(db, q, batch, &cur);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  EJDB_DOC ldoc = list->first;
+  while (!(rc = ejdb_cursor_next(cur, &doc)) && doc) {
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ldoc);
+    CU_ASSERT_EQUAL(doc->id, ldoc->id);
+    ldoc = ldoc->next;
+  }
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_PTR_NULL(ldoc);
+  // Cursor stays at the end
+  rc = ejdb_cursor_next(cur, &doc);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_PTR_NULL(doc);
+
+  ejdb_cursor_close(&cur);
+  CU_ASSERT_PTR_NULL(cur);
+  ejdb_list_destroy(&list);
+  jql_destroy(&q);
+}
+
+// Test pull based query cursor
+static void ejdb_test3_16(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_16.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  EJDB_DOC doc;
+  EJDB_CURSOR cur;
+  int64_t id;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"price\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  ejdb_test3_16_check(db, "/*", 7);
+  ejdb_test3_16_check(db, "/*", 0);
+  ejdb_test3_16_check(db, "/* | inverse", 10);
+  ejdb_test3_16_check(db, "/[n >= 3] | asc /n skip 2 limit 13", 4);
+  ejdb_test3_16_check(db, "/[n < 20] | desc /n", 100);
+  // Sorting without index, cursor falls back to single batch
+  ejdb_test3_16_check(db, "/* | asc /price desc /n", 5);
+  ejdb_test3_16_check(db, "/[price = 3] | /n", 2);
+
+  // Documents added between batches are visited
+  rc = ejdb_cursor_open2(db, "c1", "/[n >= 0] | asc /n", 10, &cur);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 10; ++i) {
+    rc = ejdb_cursor_next(cur, &doc);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(doc);
+  }
+  rc = jbl_from_json(&jbl, "{\"n\":100}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put_new(db, "c1", jbl, &id);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  jbl_destroy(&jbl);
+  int cnt = 10;
+  while (!(rc = ejdb_cursor_next(cur, &doc)) && doc) {
+    ++cnt;
+  }
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(cnt, 31);
+  ejdb_cursor_close(&cur);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_17_check(
+  EJDB db, const char *query, const char *scanner, const char *collector,
+  int64_t fetched, int64_t matched, int64_t returned) {
+  JQL q;
+  JBL jbl, sjbl;
+  const char *sv;
+  int64_t iv;
+  IWXSTR *stats = iwxstr_new();
+  iwrc rc = jql_create(&q, "c1", query);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .stats = stats
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  rc = jbl_object_get_str(jbl, "scanner", &sv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_STRING_EQUAL(sv, scanner);
+  rc = jbl_object_get_str(jbl, "collector", &sv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_STRING_EQUAL(sv, collector);
+  rc = jbl_object_get_i64(jbl, "fetched", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, fetched);
+  rc = jbl_object_get_i64(jbl, "matched", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, matched);
+  rc = jbl_object_get_i64(jbl, "returned", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, returned);
+  rc = jbl_object_get_i64(jbl, "bytes", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_TRUE(iv > 0);
+  rc = jbl_at(jbl, "/index", &sjbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  if (strcmp(scanner, "full") == 0) {
+    CU_ASSERT_EQUAL(jbl_type(sjbl), JBV_NULL);
+  } else {
+    CU_ASSERT_STRING_EQUAL(jbl_get_str(sjbl), "/n");
+  }
+  jbl_destroy(&sjbl);
+
+  jbl_destroy(&jbl);
+  jql_destroy(&q);
+  iwxstr_destroy(stats);
+}
+
+// Test query execution statistics
+static void ejdb_test3_17(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_17.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"price\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  ejdb_test3_17_check(db, "/[price = 3]", "full", "PLAIN", 30, 4, 4);
+  ejdb_test3_17_check(db, "/[price = 3] | limit 2", "full", "PLAIN", 13, 2, 2);
+  ejdb_test3_17_check(db, "/[n >= 10]", "uniq", "PLAIN", 20, 20, 20);
+  ejdb_test3_17_check(db, "/* | asc /price limit 5", "full", "SORTER", 30, 30, 5);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_18_check(JBL jbl, const char *query, int64_t calls, int64_t returned, const char *index) {
+  JBL item = 0, sjbl = 0;
+  const char *sv;
+  int64_t iv, p50, p99, max;
+  char path[64];
+  iwrc rc = 0;
+
+  for (int i = 0; !rc; ++i) {
+    jbl_destroy(&item);
+    snprintf(path, sizeof(path), "/queries/%d", i);
+    rc = jbl_at(jbl, path, &item);
+    if (!rc) {
+      rc = jbl_object_get_str(item, "query", &sv);
+      CU_ASSERT_EQUAL_FATAL(rc, 0);
+      if (strcmp(sv, query) == 0) {
+        break;
+      }
+    }
+  }
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_str(item, "collection", &sv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_STRING_EQUAL(sv, "c1");
+  rc = jbl_object_get_i64(item, "calls", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, calls);
+  rc = jbl_object_get_i64(item, "returned", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, returned);
+  rc = jbl_object_get_i64(item, "p50_us", &p50);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(item, "p99_us", &p99);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(item, "max_us", &max);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_TRUE(p50 <= p99 && p99 <= max);
+  rc = jbl_at(item, "/histogram/0/1", &sjbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_TRUE(jbl_get_i64(sjbl) > 0);
+  jbl_destroy(&sjbl);
+  rc = jbl_object_get_str(item, "index", &sv);
+  if (index) {
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_STRING_EQUAL(sv, index);
+  } else {
+    CU_ASSERT_NOT_EQUAL(rc, 0);
+  }
+  jbl_destroy(&item);
+}
+
+// Test query profiler
+static void ejdb_test3_18(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_18.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .query_profiler = true
+  };
+  EJDB db;
+  JBL jbl, sjbl;
+  EJDB_LIST list;
+  int64_t id;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"price\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+  for (int i = 0; i < 3; ++i) {
+    rc = ejdb_list2(db, "c1", "/[price = 3]", 0, &list);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    ejdb_list_destroy(&list);
+  }
+  // Queries are profiled by normalized query text
+  rc = ejdb_list2(db, "c1", "/[n >= 10]", 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_list_destroy(&list);
+  rc = ejdb_list2(db, "c1", "/[n   >=   10]", 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_list_destroy(&list);
+
+  rc = ejdb_get_query_profile(db, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_18_check(jbl, "/[price = 3]", 3, 12, 0);
+  ejdb_test3_18_check(jbl, "/[n >= 10]", 2, 40, "/n");
+  rc = jbl_at(jbl, "/queries/2", &sjbl);
+  CU_ASSERT_EQUAL(rc, JBL_ERROR_PATH_NOTFOUND);
+  jbl_destroy(&jbl);
+
+  rc = ejdb_get_meta(db, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_18_check(jbl, "/[price = 3]", 3, 12, 0);
+  jbl_destroy(&jbl);
+
+  rc = ejdb_reset_query_profile(db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_get_query_profile(db, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_at(jbl, "/queries/0", &sjbl);
+  CU_ASSERT_EQUAL(rc, JBL_ERROR_PATH_NOTFOUND);
+  jbl_destroy(&jbl);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_19_check(EJDB db, int64_t hits, int64_t misses) {
+  JBL jbl, sjbl;
+  iwrc rc = ejdb_get_meta(db, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_at(jbl, "/result_cache/hits", &sjbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(jbl_get_i64(sjbl), hits);
+  jbl_destroy(&sjbl);
+  rc = jbl_at(jbl, "/result_cache/misses", &sjbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(jbl_get_i64(sjbl), misses);
+  jbl_destroy(&sjbl);
+  jbl_destroy(&jbl);
+}
+
+static int ejdb_test3_19_list(EJDB db, JQL q) {
+  int cnt = 0;
+  EJDB_LIST list;
+  iwrc rc = ejdb_list4(db, q, 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    ++cnt;
+  }
+  ejdb_list_destroy(&list);
+  return cnt;
+}
+
+// Test query results cache
+static void ejdb_test3_19(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_19.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .result_cache_size = 1024 * 1024
+  };
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  EJDB_LIST list;
+  int64_t id, cnt;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"price\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  rc = jql_create(&q, "c1", "/[price = :?]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jql_set_i64(q, 0, 0, 3);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ejdb_test3_19_list(db, q), 4);
+  CU_ASSERT_EQUAL(ejdb_test3_19_list(db, q), 4);
+  ejdb_test3_19_check(db, 1, 1);
+
+  // Placeholder values are the part of cache key
+  rc = jql_set_i64(q, 0, 0, 2);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ejdb_test3_19_list(db, q), 4);
+  ejdb_test3_19_check(db, 1, 2);
+
+  // Collection modification invalidates cached results
+  rc = jbl_from_json(&jbl, "{\"n\":100,\"price\":3}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put_new(db, "c1", jbl, &id);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  jbl_destroy(&jbl);
+  rc = jql_set_i64(q, 0, 0, 3);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ejdb_test3_19_list(db, q), 5);
+  ejdb_test3_19_check(db, 1, 3);
+  jql_destroy(&q);
+
+  // Projected documents are served from cache
+  for (int i = 0; i < 2; ++i) {
+    rc = ejdb_list2(db, "c1", "/[n = 5] | /n", 0, &list);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(list->first);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(list->first->node);
+    CU_ASSERT_PTR_NULL(list->first->next);
+    IWXSTR *xstr = iwxstr_new();
+    rc = jbn_as_json(list->first->node, jbl_xstr_json_printer, xstr, 0);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_STRING_EQUAL(iwxstr_ptr(xstr), "{\"n\":5}");
+    iwxstr_destroy(xstr);
+    ejdb_list_destroy(&list);
+  }
+  ejdb_test3_19_check(db, 2, 4);
+
+  for (int i = 0; i < 2; ++i) {
+    rc = ejdb_count2(db, "c1", "/[price = 3]", &cnt, 0);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(cnt, 5);
+  }
+  ejdb_test3_19_check(db, 3, 5);
+
+  rc = ejdb_del(db, "c1", id);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[price = 3]", &cnt, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(cnt, 4);
+  ejdb_test3_19_check(db, 3, 6);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static iwrc ejdb_test3_20_visitor(struct ejdb_exec *ctx, EJDB_DOC doc, int64_t *step) {
+  return 0;
+}
+
+// Test query timeouts, cancellation and resources budgets
+static void ejdb_test3_20(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_20.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  int64_t id;
+  char buf[64];
+  volatile bool cancel = false;
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"price\":%d}", i, i % 7);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  rc = jql_create(&q, "c1", "/[price > 0]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .max_scanned = 30
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 25);
+
+  ux = (EJDB_EXEC) {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .max_scanned = 10
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_QUERY_BUDGET_EXCEEDED);
+  CU_ASSERT_TRUE(ux.cnt < 25);
+
+  ux = (EJDB_EXEC) {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .max_output_bytes = 64
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_QUERY_BUDGET_EXCEEDED);
+  CU_ASSERT_TRUE(ux.cnt > 0 && ux.cnt < 25);
+
+  cancel = true;
+  ux = (EJDB_EXEC) {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .cancel = &cancel
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_QUERY_CANCELLED);
+  CU_ASSERT_EQUAL(ux.cnt, 0);
+  jql_destroy(&q);
+
+  // Documents collected by sorter are limited by `max_sort_bytes`
+  rc = jql_create(&q, "c1", "/* | asc /price");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ux = (EJDB_EXEC) {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .max_sort_bytes = 128
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_QUERY_BUDGET_EXCEEDED);
+  CU_ASSERT_EQUAL(ux.cnt, 0);
+
+  ux = (EJDB_EXEC) {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_20_visitor,
+    .timeout_ms = 60000,
+    .max_sort_bytes = 1024 * 1024
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 30);
+  jql_destroy(&q);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_21_check(EJDB db, const char *query, int64_t prefiltered, int64_t fetched, int64_t returned) {
+  JQL q;
+  JBL jbl;
+  int64_t iv;
+  IWXSTR *stats = iwxstr_new();
+  iwrc rc = jql_create(&q, "c1", query);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .stats = stats
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, returned);
+  rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(jbl, "prefiltered", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, prefiltered);
+  rc = jbl_object_get_i64(jbl, "fetched", &iv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, fetched);
+  jbl_destroy(&jbl);
+  jql_destroy(&q);
+  iwxstr_destroy(stats);
+}
+
+// Test rejection of index scanned entries by lookups of other indexes
+static void ejdb_test3_21(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_21.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id;
+  char buf[128];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/a", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/c", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/u", EJDB_IDX_UNIQUE | EJDB_IDX_STR);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 30; ++i) {
+    if (i < 20) { // Index `/c` has less records so it is selected for `=` queries
+      snprintf(buf, sizeof(buf), "{\"a\":%d,\"c\":%d,\"u\":\"u%d\"}", i % 3, i % 5, i);
+    } else {
+      snprintf(buf, sizeof(buf), "{\"a\":%d,\"u\":\"u%d\"}", i % 3, i);
+    }
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  // c = 1: 1, 6, 11, 16 with a = 1, 0, 2, 1
+  ejdb_test3_21_check(db, "/[c = 1] and /[a = 2]", 3, 1, 1);
+  ejdb_test3_21_check(db, "/[c = 1] and /[u = \"u16\"]", 3, 1, 1);
+  ejdb_test3_21_check(db, "/[c = 1] and /[u = \"u17\"]", 4, 0, 0);
+  ejdb_test3_21_check(db, "/[c = 1] and /[a = 1] and /[u = \"u16\"]", 3, 1, 1);
+  // Value of non native index type is checked on fetched documents
+  ejdb_test3_21_check(db, "/[c = 1] and /[a = \"2\"]", 0, 4, 1);
+  ejdb_test3_21_check(db, "/[c = 1] and /[a = 2] | noidx", 0, 30, 1);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+struct ejdb_test3_22_ctx {
+  EJDB db;
+  pthread_t     writer;
+  volatile bool written;
+  int after; // Number of documents visited after writer finished
+};
+
+static void* ejdb_test3_22_writer(void *op) {
+  JBL jbl;
+  int64_t id;
+  struct ejdb_test3_22_ctx *tc = op;
+  iwrc rc = jbl_from_json(&jbl, "{\"n\":-1}");
+  if (!rc) {
+    rc = ejdb_put_new(tc->db, "c1", jbl, &id);
+    jbl_destroy(&jbl);
+  }
+  tc->written = !rc;
+  return 0;
+}
+
+static iwrc ejdb_test3_22_visitor(struct ejdb_exec *ux, EJDB_DOC doc, int64_t *step) {
+  struct ejdb_test3_22_ctx *tc = ux->opaque;
+  if (ux->cnt == 0) {
+    if (pthread_create(&tc->writer, 0, ejdb_test3_22_writer, tc)) {
+      return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, errno);
+    }
+  } else if (tc->written) {
+    ++tc->after;
+  }
+  usleep(200);
+  return 0;
+}
+
+struct ejdb_test3_22_ictx {
+  EJDB      db;
+  pthread_t writer;
+  int64_t   id;        // Document moved by writer past the index scan cursor
+  iwrc      rc;
+  int       dups;      // Number of documents visited twice
+  bool      seen[301];
+};
+
+static void* ejdb_test3_22_iwriter(void *op) {
+  struct ejdb_test3_22_ictx *tc = op;
+  tc->rc = ejdb_patch(tc->db, "c1", "[{\"op\":\"replace\", \"path\":\"/n\", \"value\":1000}]", tc->id);
+  return 0;
+}
+
+static iwrc ejdb_test3_22_ivisitor(struct ejdb_exec *ux, EJDB_DOC doc, int64_t *step) {
+  struct ejdb_test3_22_ictx *tc = ux->opaque;
+  if (ux->cnt == 0) {
+    tc->id = doc->id;
+    if (pthread_create(&tc->writer, 0, ejdb_test3_22_iwriter, tc)) {
+      return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, errno);
+    }
+  }
+  if ((doc->id > 0) && (doc->id < sizeof(tc->seen) / sizeof(tc->seen[0]))) {
+    if (tc->seen[doc->id]) {
+      ++tc->dups;
+    }
+    tc->seen[doc->id] = true;
+  }
+  usleep(200);
+  return 0;
+}
+
+// Test release of collection lock by long read-only queries
+static void ejdb_test3_22(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_22.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .read_yield_ms = 60000 // Lock is released for waiting writer regardless of timeout
+  };
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  int64_t id;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 300; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d}", i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  struct ejdb_test3_22_ctx tc = { .db = db };
+  rc = jql_create(&q, "c1", "/*");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_22_visitor,
+    .opaque = &tc
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, 0);
+  pthread_join(tc.writer, 0);
+  CU_ASSERT_TRUE(tc.written);
+  // Writer is not blocked until the end of scan
+  CU_ASSERT_TRUE(tc.after > 0);
+  // Document added by writer has greater id so it is not visited by scan in descending id order
+  CU_ASSERT_EQUAL(ux.cnt, 300);
+  jql_destroy(&q);
+
+  // Index scan keeps collection lock: indexed value updated by writer
+  // may be moved past the scan cursor and the document would be visited twice
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  struct ejdb_test3_22_ictx itc = { .db = db };
+  rc = jql_create(&q, "c1", "/[n >= 0]");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC iux = {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_22_ivisitor,
+    .opaque = &itc
+  };
+  rc = ejdb_exec(&iux);
+  CU_ASSERT_EQUAL(rc, 0);
+  pthread_join(itc.writer, 0);
+  CU_ASSERT_EQUAL(itc.rc, 0);
+  CU_ASSERT_EQUAL(itc.dups, 0);
+  CU_ASSERT_EQUAL(iux.cnt, 300);
+  jql_destroy(&q);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+#define EJDB_TEST3_23_THREADS 4
+#define EJDB_TEST3_23_DOCS    250
+
+struct ejdb_test3_23_ctx {
+  EJDB      db;
+  pthread_t thread;
+  int       tid;
+  iwrc      rc;
+};
+
+static void* ejdb_test3_23_writer(void *op) {
+  JBL jbl;
+  char buf[64];
+  int64_t ids[EJDB_TEST3_23_DOCS];
+  struct ejdb_test3_23_ctx *tc = op;
+  iwrc rc = 0;
+  for (int i = 0; !rc && i < EJDB_TEST3_23_DOCS; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"g\":%d}", tc->tid * EJDB_TEST3_23_DOCS + i, i % 2);
+    rc = jbl_from_json(&jbl, buf);
+    if (!rc) {
+      rc = ejdb_put_new(tc->db, "c1", jbl, &ids[i]);
+      jbl_destroy(&jbl);
+    }
+  }
+  for (int i = 0; !rc && i < EJDB_TEST3_23_DOCS; i += 2) {
+    rc = ejdb_patch(tc->db, "c1", "[{\"op\":\"add\", \"path\":\"/p\", \"value\":1}]", ids[i + 1]);
+    if (!rc) {
+      rc = ejdb_del(tc->db, "c1", ids[i]);
+    }
+  }
+  tc->rc = rc;
+  return 0;
+}
+
+// Test parallel writers of distinct documents of the same collection
+static void ejdb_test3_23(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_23.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id, count;
+  struct ejdb_test3_23_ctx tc[EJDB_TEST3_23_THREADS] = { 0 };
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_UNIQUE | EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/g", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int i = 0; i < EJDB_TEST3_23_THREADS; ++i) {
+    tc[i].db = db;
+    tc[i].tid = i;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&tc[i].thread, 0, ejdb_test3_23_writer, &tc[i]), 0);
+  }
+  for (int i = 0; i < EJDB_TEST3_23_THREADS; ++i) {
+    pthread_join(tc[i].thread, 0);
+    CU_ASSERT_EQUAL(tc[i].rc, 0);
+  }
+
+  rc = ejdb_count2(db, "c1", "/*", &count, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, EJDB_TEST3_23_THREADS * EJDB_TEST3_23_DOCS / 2);
+  rc = ejdb_count2(db, "c1", "/[g = 1]", &count, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, EJDB_TEST3_23_THREADS * EJDB_TEST3_23_DOCS / 2);
+  rc = ejdb_count2(db, "c1", "/[g = 0]", &count, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 0);
+  rc = ejdb_count2(db, "c1", "/[p = 1]", &count, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, EJDB_TEST3_23_THREADS * EJDB_TEST3_23_DOCS / 2);
+
+  // Identifiers reserved by parallel writers are never reused
+  rc = jbl_from_json(&jbl, "{\"n\":-1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put_new(db, "c1", jbl, &id);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(id, EJDB_TEST3_23_THREADS * EJDB_TEST3_23_DOCS + 1);
+  jbl_destroy(&jbl);
+
+  // Records counters updated by parallel writers are consistent
+  JBL meta, at;
+  char path[64];
+  int64_t rnum = EJDB_TEST3_23_THREADS * EJDB_TEST3_23_DOCS / 2 + 1;
+  rc = ejdb_get_meta(db, &meta);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_at(meta, "/collections/0/rnum", &at);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(jbl_get_i64(at), rnum);
+  jbl_destroy(&at);
+  for (int i = 0; i < 2; ++i) {
+    snprintf(path, sizeof(path), "/collections/0/indexes/%d/ptr", i);
+    rc = jbl_at(meta, path, &at);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    // Document `{"n":-1}` is not indexed by `/g`
+    count = strcmp(jbl_get_str(at), "/n") == 0 ? rnum : rnum - 1;
+    jbl_destroy(&at);
+    snprintf(path, sizeof(path), "/collections/0/indexes/%d/rnum", i);
+    rc = jbl_at(meta, path, &at);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(jbl_get_i64(at), count);
+    jbl_destroy(&at);
+  }
+  jbl_destroy(&meta);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+struct ejdb_test3_24_ctx {
+  EJDB_COLL coll;
+  pthread_t thread;
+  int       tid;
+  iwrc      rc;
+};
+
+static void* ejdb_test3_24_worker(void *op) {
+  JBL jbl;
+  char buf[64];
+  struct ejdb_test3_24_ctx *tc = op;
+  iwrc rc = 0;
+  for (int i = 1; !rc && i <= 500; ++i) {
+    int64_t id = tc->tid * 1000 + i;
+    snprintf(buf, sizeof(buf), "{\"id\":%" PRId64 "}", id);
+    rc = jbl_from_json(&jbl, buf);
+    if (!rc) {
+      rc = ejdb_coll_put(tc->coll, jbl, id);
+      jbl_destroy(&jbl);
+    }
+    if (!rc) {
+      rc = ejdb_coll_get(tc->coll, id, &jbl);
+      if (!rc) {
+        jbl_destroy(&jbl);
+      }
+    }
+  }
+  tc->rc = rc;
+  return 0;
+}
+
+// Test collection handles and database lock shared by concurrent readers
+static void ejdb_test3_24(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_24.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  EJDB_COLL coll, coll2;
+  JBL jbl;
+  int64_t id, count;
+  struct ejdb_test3_24_ctx tc[4] = { 0 };
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_coll_open(db, "c1", &coll);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int i = 0; i < 4; ++i) {
+    tc[i].coll = coll;
+    tc[i].tid = i;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&tc[i].thread, 0, ejdb_test3_24_worker, &tc[i]), 0);
+  }
+  // Database write lock is acquired while handles are used by other threads
+  rc = ejdb_rename_collection(db, "c1", "c2");
+  CU_ASSERT_EQUAL(rc, 0);
+  for (int i = 0; i < 4; ++i) {
+    pthread_join(tc[i].thread, 0);
+    CU_ASSERT_EQUAL(tc[i].rc, 0);
+  }
+  rc = ejdb_count2(db, "c2", "/*", &count, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(count, 2000);
+
+  rc = jbl_from_json(&jbl, "{\"n\":1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_coll_put_new(coll, jbl, &id);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(id, 3501);
+  jbl_destroy(&jbl);
+  rc = ejdb_coll_del(coll, id);
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_coll_get(coll, id, &jbl);
+  CU_ASSERT_EQUAL(rc, IWKV_ERROR_NOTFOUND);
+
+  // Removed collection is released by the last handle
+  rc = ejdb_coll_open(db, "c2", &coll2);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(coll2);
+  rc = ejdb_remove_collection(db, "c2");
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_coll_get(coll, 1, &jbl);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_COLLECTION_NOT_FOUND);
+  rc = ejdb_coll_del(coll2, 1);
+  CU_ASSERT_EQUAL(rc, EJDB_ERROR_COLLECTION_NOT_FOUND);
+  rc = ejdb_coll_close(&coll);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_PTR_NULL(coll);
+  rc = ejdb_coll_close(&coll2);
+  CU_ASSERT_EQUAL(rc, 0);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+struct ejdb_test3_25_ctx {
+  EJDB db;
+  pthread_t     reader;
+  volatile bool done;
+  int after; // Number of documents updated after reader finished
+};
+
+static void* ejdb_test3_25_reader(void *op) {
+  int64_t count = 0;
+  struct ejdb_test3_25_ctx *tc = op;
+  iwrc rc = ejdb_count2(tc->db, "c1", "/*", &count, 0);
+  tc->done = !rc && count == 300;
+  return 0;
+}
+
+static iwrc ejdb_test3_25_visitor(struct ejdb_exec *ux, EJDB_DOC doc, int64_t *step) {
+  struct ejdb_test3_25_ctx *tc = ux->opaque;
+  if (ux->cnt == 0) {
+    if (pthread_create(&tc->reader, 0, ejdb_test3_25_reader, tc)) {
+      return iwrc_set_errno(IW_ERROR_THREADING_ERRNO, errno);
+    }
+  } else if (tc->done) {
+    ++tc->after;
+  }
+  usleep(200);
+  return 0;
+}
+
+// Test release of collection write lock by queries with apply
+static void ejdb_test3_25(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_25.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .apply_batch_size = 10
+  };
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  int64_t id, iv;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 300; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d}", i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  struct ejdb_test3_25_ctx tc = { .db = db };
+  IWXSTR *stats = iwxstr_new();
+  rc = jql_create(&q, "c1", "/* | apply {\"a\":1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .visitor = ejdb_test3_25_visitor,
+    .opaque = &tc,
+    .stats = stats
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL(rc, 0);
+  pthread_join(tc.reader, 0);
+  CU_ASSERT_EQUAL(ux.cnt, 300);
+  CU_ASSERT_TRUE(tc.done);
+  // Reader is not blocked until the end of update
+  CU_ASSERT_TRUE(tc.after > 0);
+  rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(jbl, "yields", &iv);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 30);
+  jbl_destroy(&jbl);
+  jql_destroy(&q);
+  iwxstr_destroy(stats);
+
+  rc = ejdb_count2(db, "c1", "/[a = 1]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 300);
+
+  // Documents removed by batches
+  rc = ejdb_update2(db, "c1", "/[n < 100] | del");
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/*", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 200);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static volatile int ejdb_test3_26_done;
+static volatile int ejdb_test3_26_failed;
+
+static void ejdb_test3_26_cb(EJDB_ASYNC *op, iwrc rc) {
+  if (rc) {
+    op->opaque = (void*) (uintptr_t) rc;
+    __sync_add_and_fetch(&ejdb_test3_26_failed, 1);
+  }
+  __sync_add_and_fetch(&ejdb_test3_26_done, 1);
+}
+
+static void ejdb_test3_26_wait(int num) {
+  while (__sync_fetch_and_add(&ejdb_test3_26_done, 0) < num) {
+    usleep(1000);
+  }
+}
+
+static void ejdb_test3_26(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_26.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .async_threads = 4
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t iv;
+  EJDB_ASYNC ops[300] = { 0 };
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_from_json(&jbl, "{\"a\":1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int i = 0; i < 200; ++i) {
+    ops[i] = (EJDB_ASYNC) {
+      .op = EJDB_ASYNC_PUT_NEW,
+      .coll = (i & 1) ? "c1" : "c2",
+      .jbl = jbl,
+      .cb = ejdb_test3_26_cb
+    };
+    rc = ejdb_submit(db, &ops[i]);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+  ejdb_test3_26_wait(200);
+  CU_ASSERT_EQUAL(ejdb_test3_26_failed, 0);
+  for (int i = 0; i < 200; ++i) {
+    CU_ASSERT_TRUE(ops[i].id > 0);
+  }
+  rc = ejdb_count2(db, "c1", "/*", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 100);
+  rc = ejdb_count2(db, "c2", "/*", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 100);
+
+  // Operations of collection are executed in submission order
+  int64_t id = ops[1].id;
+  ops[200] = (EJDB_ASYNC) { .op = EJDB_ASYNC_GET, .coll = "c1", .id = id, .cb = ejdb_test3_26_cb };
+  ops[201] = (EJDB_ASYNC) { .op = EJDB_ASYNC_DEL, .coll = "c1", .id = id, .cb = ejdb_test3_26_cb };
+  ops[202] = (EJDB_ASYNC) { .op = EJDB_ASYNC_GET, .coll = "c1", .id = id, .cb = ejdb_test3_26_cb };
+  for (int i = 200; i < 203; ++i) {
+    rc = ejdb_submit(db, &ops[i]);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+  ejdb_test3_26_wait(203);
+  CU_ASSERT_EQUAL(ejdb_test3_26_failed, 1);
+  CU_ASSERT_PTR_NOT_NULL(ops[200].jbl);
+  CU_ASSERT_EQUAL(ops[200].opaque, 0);
+  CU_ASSERT_EQUAL(ops[201].opaque, 0);
+  CU_ASSERT_PTR_NULL(ops[202].jbl);
+  CU_ASSERT_EQUAL((iwrc) (uintptr_t) ops[202].opaque, IWKV_ERROR_NOTFOUND);
+  jbl_destroy(&ops[200].jbl);
+
+  rc = ejdb_submit(db, &(EJDB_ASYNC) { .op = EJDB_ASYNC_GET, .coll = "c1", .cb = ejdb_test3_26_cb });
+  CU_ASSERT_EQUAL(rc, IW_ERROR_INVALID_ARGS);
+
+  // Pending operations are executed on close
+  for (int i = 203; i < 300; ++i) {
+    ops[i] = (EJDB_ASYNC) {
+      .op = EJDB_ASYNC_PATCH,
+      .coll = "c2",
+      .id = ops[i - 203].id,
+      .patch = "{\"b\":2}",
+      .cb = ejdb_test3_26_cb
+    };
+    if (i == 299) {
+      ops[i].op = EJDB_ASYNC_MERGE_OR_PUT;
+      ops[i].id = 1000;
+    }
+    rc = ejdb_submit(db, &ops[i]);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ejdb_test3_26_done, 300);
+  CU_ASSERT_EQUAL(ejdb_test3_26_failed, 1);
+  jbl_destroy(&jbl);
+}
+
+#define EJDB_TEST3_27_DOC \
+  "{\"name\":\"user%d\",\"email\":\"user%d@example.com\",\"role\":\"member\"," \
+  "\"tags\":[\"red\",\"green\",\"blue\"],\"addr\":{\"zip\":\"12345\",\"geo\":[{\"lat\":15}]},\"n\":%d}"
+
+static void ejdb_test3_27_check(EJDB db, const char *coll, int64_t id) {
+  JBL jbl;
+  char buf[256];
+  IWXSTR *xstr = iwxstr_new();
+  CU_ASSERT_PTR_NOT_NULL_FATAL(xstr);
+  snprintf(buf, sizeof(buf), EJDB_TEST3_27_DOC, (int) id - 1, (int) id - 1, (int) id - 1);
+  iwrc rc = ejdb_get(db, coll, id, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_as_json(jbl, jbl_xstr_json_printer, xstr, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_STRING_EQUAL(iwxstr_ptr(xstr), buf);
+  jbl_destroy(&jbl);
+  iwxstr_destroy(xstr);
+}
+
+static void ejdb_test3_27(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_27.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id, iv;
+  char buf[256];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 300; ++i) {
+    snprintf(buf, sizeof(buf), EJDB_TEST3_27_DOC, i, i, i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+  rc = ejdb_set_compression(db, "c1", (ejdb_compression_t) 10, 0);
+  CU_ASSERT_EQUAL(rc, IW_ERROR_INVALID_ARGS);
+
+  // Existing documents are packed using dictionary
+  rc = ejdb_set_compression(db, "c1", EJDB_COMPRESSION_LZ, 100);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c1", 6);
+
+  snprintf(buf, sizeof(buf), EJDB_TEST3_27_DOC, 300, 300, 300);
+  rc = jbl_from_json(&jbl, buf);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put_new(db, "c1", jbl, &id);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(id, 301);
+  jbl_destroy(&jbl);
+  ejdb_test3_27_check(db, "c1", 301);
+
+  // Index is built over packed documents
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[n > 250]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 50);
+  rc = ejdb_count2(db, "c1", "/[name = user7]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+
+  rc = ejdb_patch(db, "c1", "{\"n\":1000}", 1);
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[n = 1000]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+  rc = ejdb_del(db, "c1", 2);
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[n < 10]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 8);
+
+  // Compression settings are kept in collection meta
+  rc = ejdb_rename_collection(db, "c1", "c2");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  opts.kv.oflags = 0;
+  rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c2", 7);
+  rc = ejdb_update2(db, "c2", "/[n = 7] | apply {\"name\":\"user7\"}");
+  CU_ASSERT_EQUAL(rc, 0);
+  ejdb_test3_27_check(db, "c2", 8);
+
+  rc = ejdb_set_compression(db, "c2", EJDB_COMPRESSION_NONE, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c2", 9);
+  rc = ejdb_count2(db, "c2", "/*", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 300);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static void ejdb_test3_28(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_28.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id, iv;
+  char buf[256];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 100; ++i) {
+    snprintf(buf, sizeof(buf), EJDB_TEST3_27_DOC, i, i, i);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+  rc = ejdb_set_compression(db, "c1", EJDB_COMPRESSION_KEYS, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c1", 10);
+  rc = ejdb_count2(db, "c1", "/addr/geo/*/[lat = 15]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 100);
+
+  // Keys dictionary is combined with compression
+  rc = ejdb_set_compression(db, "c1", EJDB_COMPRESSION_KEYS | EJDB_COMPRESSION_LZ, 50);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c1", 11);
+  rc = ejdb_patch(db, "c1", "{\"extra\":{\"key\":1}}", 12);
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_ensure_index(db, "c1", "/extra/key", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/extra/[key = 1]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  // Keys dictionary is loaded from database meta
+  opts.kv.oflags = 0;
+  rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c1", 13);
+  rc = jbl_from_json(&jbl, "{\"other\":\"value\",\"name\":\"user1000\"}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put(db, "c1", jbl, 1000);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  jbl_destroy(&jbl);
+  rc = ejdb_count2(db, "c1", "/[other = value]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+  rc = ejdb_count2(db, "c1", "/extra/[key = 1]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+
+  // Keys longer than 256 bytes are interned
+  char lkey[301];
+  memset(lkey, 'k', sizeof(lkey) - 1);
+  lkey[sizeof(lkey) - 1] = '\0';
+  char *lbuf = malloc(sizeof(lkey) + 32);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(lbuf);
+  snprintf(lbuf, sizeof(lkey) + 32, "{\"%s\":1001}", lkey);
+  rc = jbl_from_json(&jbl, lbuf);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put(db, "c1", jbl, 1001);
+  CU_ASSERT_EQUAL(rc, 0);
+  jbl_destroy(&jbl);
+  rc = ejdb_get(db, "c1", 1001, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(jbl, lkey, &iv);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1001);
+  jbl_destroy(&jbl);
+  free(lbuf);
+
+  // Document which root is a binn map is stored as is
+  struct jbl mjbl;
+  int32_t mv = 0;
+  binn *map = binn_map();
+  CU_ASSERT_PTR_NOT_NULL_FATAL(map);
+  CU_ASSERT_TRUE(binn_map_set_int32(map, 7, 1002));
+  rc = jbl_from_buf_keep_onstack(&mjbl, binn_ptr(map), binn_size(map));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put(db, "c1", &mjbl, 1002);
+  CU_ASSERT_EQUAL(rc, 0);
+  binn_free(map);
+  rc = ejdb_get(db, "c1", 1002, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  void *mbuf;
+  size_t mbufsz;
+  rc = jbl_as_buf(jbl, &mbuf, &mbufsz);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(*(uint8_t*) mbuf, BINN_MAP);
+  CU_ASSERT_TRUE(binn_map_get_int32(mbuf, 7, &mv));
+  CU_ASSERT_EQUAL(mv, 1002);
+  jbl_destroy(&jbl);
+
+  rc = ejdb_set_compression(db, "c1", EJDB_COMPRESSION_NONE, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  ejdb_test3_27_check(db, "c1", 14);
+  rc = ejdb_count2(db, "c1", "/*", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 103);
+
+  rc = ejdb_remove_collection(db, "c1");
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static int64_t ejdb_test3_29_bytes(EJDB db, const char *query, int64_t *cnt) {
+  JQL q;
+  JBL jbl;
+  int64_t iv = -1;
+  IWXSTR *stats = iwxstr_new();
+  CU_ASSERT_PTR_NOT_NULL_FATAL(stats);
+  iwrc rc = jql_create(&q, "c1", query);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db = db,
+    .q = q,
+    .stats = stats
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  *cnt = ux.cnt;
+  rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_i64(jbl, "bytes", &iv);
+  CU_ASSERT_EQUAL(rc, 0);
+  jbl_destroy(&jbl);
+  jql_destroy(&q);
+  iwxstr_destroy(stats);
+  return iv;
+}
+
+// Test out of line storage of large documents
+static void ejdb_test3_29(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_29.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .large_document_sz = 1024
+  };
+  EJDB db;
+  JBL jbl, jbv;
+  int64_t id, iv;
+  char body[4001], buf[4200];
+
+  memset(body, 'x', sizeof(body) - 1);
+  body[sizeof(body) - 1] = '\0';
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 20; ++i) {
+    if (i % 2) {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"name\":\"small%d\"}", i, i);
+    } else {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"name\":\"large%d\",\"body\":\"B%d-%s\"}", i, i, i, body);
+    }
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  rc = ejdb_get(db, "c1", 5, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_at(jbl, "/body", &jbv);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(strlen(jbl_get_str(jbv)), strlen(body) + 3);
+  CU_ASSERT_EQUAL(strncmp(jbl_get_str(jbv), "B4-", 3), 0);
+  jbl_destroy(&jbv);
+  jbl_destroy(&jbl);
+
+  // Large documents rejected by summary are not fetched
+  iv = ejdb_test3_29_bytes(db, "/[n = 4]", &id);
+  CU_ASSERT_EQUAL(id, 1);
+  CU_ASSERT_TRUE(iv > 4000 && iv < 8000);
+  iv = ejdb_test3_29_bytes(db, "/[n > 100] or /[name = small3]", &id);
+  CU_ASSERT_EQUAL(id, 1);
+  CU_ASSERT_TRUE(iv < 4000);
+  // Large field is matched against document body
+  iv = ejdb_test3_29_bytes(db, "/[body ~ B6-]", &id);
+  CU_ASSERT_EQUAL(id, 1);
+  CU_ASSERT_TRUE(iv > 40000);
+
+  rc = ejdb_ensure_index(db, "c1", "/n", EJDB_IDX_I64);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[n >= 10] | /body", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 10);
+
+  // Large document is updated and then becomes small
+  rc = ejdb_patch(db, "c1", "{\"n\":100}", 1);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[n = 100] and /[body ~ B0-]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+  rc = ejdb_patch(db, "c1", "[{\"op\":\"remove\",\"path\":\"/body\"}]", 1);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_get(db, "c1", 1, &jbl);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_at(jbl, "/body", &jbv);
+  CU_ASSERT_EQUAL(rc, JBL_ERROR_PATH_NOTFOUND);
+  jbl_destroy(&jbl);
+  rc = ejdb_del(db, "c1", 3);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[body ~ B]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 8);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  // Large documents are readable without `large_document_sz` option
+  opts.kv.oflags = 0;
+  opts.large_document_sz = 0;
+  rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[body ~ B18-]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 1);
+  // Documents are moved back into collection
+  rc = ejdb_set_compression(db, "c1", EJDB_COMPRESSION_NONE, 0);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_count2(db, "c1", "/[body ~ B]", &iv, 0);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(iv, 8);
+  rc = ejdb_remove_collection(db, "c1");
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+static iwrc ejdb_test3_30_visitor(struct ejdb_exec *ux, struct ejdb_doc *doc, int64_t *step) {
+  return jbl_as_json(doc->raw, jbl_xstr_json_printer, ux->opaque, 0);
+}
+
+/**
+ * Executes query over collection columns if `columns` is set and then by full scan,
+ * checks both executions return the same result. Returns number of result documents.
+ */
+static int64_t ejdb_test3_30_cmp(EJDB db, const char *query, bool columns, int64_t *prefiltered) {
+  JQL q;
+  JBL jbl;
+  int64_t cnt = -1;
+  char buf[256];
+  IWXSTR *log = iwxstr_new();
+  IWXSTR *stats = iwxstr_new();
+  IWXSTR *out[2] = { iwxstr_new(), iwxstr_new() };
+  CU_ASSERT_PTR_NOT_NULL_FATAL(log && stats && out[0] && out[1]);
+
+  for (int i = 0; i < 2; ++i) {
+    snprintf(buf, sizeof(buf), i ? "%s noidx" : "%s", query);
+    iwrc rc = jql_create(&q, "c1", buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    EJDB_EXEC ux = {
+      .db      = db,
+      .q       = q,
+      .log     = log,
+      .stats   = stats,
+      .visitor = ejdb_test3_30_visitor,
+      .opaque  = out[i]
+    };
+    rc = ejdb_exec(&ux);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    if (i) {
+      CU_ASSERT_PTR_NULL(strstr(iwxstr_ptr(log), "[SCANNER] COLUMNS"));
+      CU_ASSERT_EQUAL(ux.cnt, cnt);
+      CU_ASSERT_STRING_EQUAL(iwxstr_ptr(out[0]), iwxstr_ptr(out[1]));
+    } else {
+      cnt = ux.cnt;
+      CU_ASSERT_EQUAL(strstr(iwxstr_ptr(log), "[SCANNER] COLUMNS") != 0, columns);
+      rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+      CU_ASSERT_EQUAL_FATAL(rc, 0);
+      rc = jbl_object_get_i64(jbl, "prefiltered", prefiltered);
+      CU_ASSERT_EQUAL(rc, 0);
+      jbl_destroy(&jbl);
+    }
+    iwxstr_clear(log);
+    jql_destroy(&q);
+  }
+  iwxstr_destroy(log);
+  iwxstr_destroy(stats);
+  iwxstr_destroy(out[0]);
+  iwxstr_destroy(out[1]);
+  return cnt;
+}
+
+// Test columnar store of collection fields
+static void ejdb_test3_30(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_30.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JBL jbl;
+  int64_t id, iv, pv;
+  const char *regions[] = { "eu", "us", "asia" };
+  char buf[256];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 1; i <= 1000; ++i) {
+    if (i == 13) {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"region\":\"eu\",\"amount\":\"12\"}", i);
+    } else if (i == 22) {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"region\":\"us\",\"amount\":{\"v\":1}}", i);
+    } else if (i % 7 == 0) {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"region\":\"%s\"}", i, regions[i % 3]);
+    } else if (i % 5 == 0) {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"region\":\"%s\",\"amount\":%d.5,\"note\":\"note%d\"}",
+               i, regions[i % 3], i, i);
+    } else {
+      snprintf(buf, sizeof(buf), "{\"n\":%d,\"region\":\"%s\",\"amount\":%d,\"note\":\"note%d\"}",
+               i, regions[i % 3], i, i);
+    }
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+  rc = ejdb_ensure_column(db, "c1", "/region/name");
+  CU_ASSERT_EQUAL(rc, IW_ERROR_INVALID_ARGS);
+  rc = ejdb_ensure_column(db, "c1", "/region");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_column(db, "c1", "/amount");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_ensure_column(db, "c1", "/amount");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  // Segments are skipped by zone maps
+  iv = ejdb_test3_30_cmp(db, "/[amount < 50] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 42);
+  CU_ASSERT_TRUE(pv > 900);
+  iv = ejdb_test3_30_cmp(db, "/[amount >= 100] and /[amount <= 200.5] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 87);
+  iv = ejdb_test3_30_cmp(db, "/[region = asia] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 333);
+  CU_ASSERT_EQUAL(pv, 667);
+  iv = ejdb_test3_30_cmp(db, "/* | sum /amount avg /amount min /amount max /amount", true, &pv);
+  CU_ASSERT_EQUAL(iv, 1);
+  iv = ejdb_test3_30_cmp(db, "/[region = eu] and /[amount > 500] | group by /region sum /amount", true, &pv);
+  CU_ASSERT_EQUAL(iv, 1);
+  iv = ejdb_test3_30_cmp(db, "/[amount > 900] or /[region = us] | group by /region max /amount", true, &pv);
+  CU_ASSERT_EQUAL(iv, 3);
+  iv = ejdb_test3_30_cmp(db, "/[amount > 990] | sum /n", false, &pv);
+  CU_ASSERT_EQUAL(iv, 1);
+  iv = ejdb_test3_30_cmp(db, "/[note = note10] | count", false, &pv);
+  CU_ASSERT_EQUAL(iv, 1);
+
+  // Columns are updated by document writes
+  rc = ejdb_patch(db, "c1", "{\"amount\":5}", 500);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_del(db, "c1", 13);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_update2(db, "c1", "/[n = 600] | apply {\"amount\":\"x\"}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_from_json(&jbl, "{\"n\":1001,\"region\":\"eu\",\"amount\":1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put_new(db, "c1", jbl, &id);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  jbl_destroy(&jbl);
+  iv = ejdb_test3_30_cmp(db, "/[amount < 50] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 43);
+  iv = ejdb_test3_30_cmp(db, "/[region = eu] | sum /amount max /amount", true, &pv);
+  CU_ASSERT_EQUAL(iv, 1);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  opts.kv.oflags = 0;
+  rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iv = ejdb_test3_30_cmp(db, "/[amount >= 999] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 3);
+  rc = ejdb_remove_column(db, "c1", "/amount");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iv = ejdb_test3_30_cmp(db, "/[amount >= 999] | count", false, &pv);
+  CU_ASSERT_EQUAL(iv, 3);
+  iv = ejdb_test3_30_cmp(db, "/[region = us] | count", true, &pv);
+  CU_ASSERT_EQUAL(iv, 333);
+  rc = ejdb_remove_column(db, "c1", "/region");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iv = ejdb_test3_30_cmp(db, "/[region = us] | count", false, &pv);
+  CU_ASSERT_EQUAL(iv, 333);
+  rc = ejdb_remove_collection(db, "c1");
+  CU_ASSERT_EQUAL(rc, 0);
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
+#define EJDB_TEST3_31_GROUPS (JB_AGGREGATE_SPILL_GROUPS + 1000)
+
+static iwrc ejdb_test3_31_visitor(struct ejdb_exec *ux, struct ejdb_doc *doc, int64_t *step) {
+  int64_t g = -1, cnt = 0, sum = 0;
+  uint8_t *seen = ux->opaque;
+  iwrc rc = jbl_object_get_i64(doc->raw, "/g", &g);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_FATAL(g >= 0 && g < EJDB_TEST3_31_GROUPS);
+  rc = jbl_object_get_i64(doc->raw, "count", &cnt);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(cnt, 2);
+  rc = jbl_object_get_i64(doc->raw, "sum(/n)", &sum);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_EQUAL(sum, 2 * g + EJDB_TEST3_31_GROUPS);
+  CU_ASSERT_EQUAL(seen[g], 0);
+  seen[g] = 1;
+  return 0;
+}
+
+// Test group by spilling groups into temp file
+static void ejdb_test3_31(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test3_31.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true
+  };
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  int64_t id;
+  bool spilled = false;
+  char buf[64];
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (int i = 0; i < 2 * EJDB_TEST3_31_GROUPS; ++i) {
+    snprintf(buf, sizeof(buf), "{\"n\":%d,\"g\":%d}", i, i % EJDB_TEST3_31_GROUPS);
+    rc = jbl_from_json(&jbl, buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    rc = ejdb_put_new(db, "c1", jbl, &id);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    jbl_destroy(&jbl);
+  }
+
+  uint8_t *seen = calloc(EJDB_TEST3_31_GROUPS, 1);
+  IWXSTR *stats = iwxstr_new();
+  CU_ASSERT_PTR_NOT_NULL_FATAL(seen && stats);
+  rc = jql_create(&q, "c1", "/* | group by /g sum /n");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  EJDB_EXEC ux = {
+    .db      = db,
+    .q       = q,
+    .visitor = ejdb_test3_31_visitor,
+    .opaque  = seen,
+    .stats   = stats
+  };
+  rc = ejdb_exec(&ux);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_EQUAL(ux.cnt, EJDB_TEST3_31_GROUPS);
+  rc = jbl_from_json(&jbl, iwxstr_ptr(stats));
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = jbl_object_get_bool(jbl, "spilled", &spilled);
+  CU_ASSERT_EQUAL(rc, 0);
+  CU_ASSERT_TRUE(spilled);
+  jbl_destroy(&jbl);
+  jql_destroy(&q);
+  iwxstr_destroy(stats);
+  free(seen);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+}
+
 int main() {
   CU_pSuite pSuite = NULL;
   if (CUE_SUCCESS != CU_initialize_registry()) {
@@ -1167,7 +3604,29 @@ int main() {
      || (NULL == CU_add_test(pSuite, "ejdb_test3_6", ejdb_test3_6))
      || (NULL == CU_add_test(pSuite, "ejdb_test3_7", ejdb_test3_7))
      || (NULL == CU_add_test(pSuite, "ejdb_test3_8", ejdb_test3_8))
-     || (NULL == CU_add_test(pSuite, "ejdb_test3_9", ejdb_test3_9))) {
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_9", ejdb_test3_9))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_10", ejdb_test3_10))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_11", ejdb_test3_11))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_12", ejdb_test3_12))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_13", ejdb_test3_13))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_14", ejdb_test3_14))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_15", ejdb_test3_15))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_16", ejdb_test3_16))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_17", ejdb_test3_17))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_18", ejdb_test3_18))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_19", ejdb_test3_19))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_20", ejdb_test3_20))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_21", ejdb_test3_21))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_22", ejdb_test3_22))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_23", ejdb_test3_23))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_24", ejdb_test3_24))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_25", ejdb_test3_25))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_26", ejdb_test3_26))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_27", ejdb_test3_27))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_28", ejdb_test3_28))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_29", ejdb_test3_29))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_30", ejdb_test3_30))
+     || (NULL == CU_add_test(pSuite, "ejdb_test3_31", ejdb_test3_31))) {
     CU_cleanup_registry();
     return CU_get_error();
   }
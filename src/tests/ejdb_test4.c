@@ -209,6 +209,92 @@ static void ejdb_test4_2(void) {
   CU_ASSERT_EQUAL_FATAL(rc, 0);
 }
 
+static void ejdb_test4_3(void) {
+  EJDB_OPTS opts = {
+    .kv = {
+      .path = "ejdb_test4_3.db",
+      .oflags = IWKV_TRUNC
+    },
+    .no_wal = true,
+    .join_cache_size = 4096
+  };
+
+  EJDB db;
+  JQL q;
+  JBL jbl;
+  JBL_NODE n;
+  int64_t id, ids[100];
+  char buf[64];
+  int i = 0;
+  EJDB_LIST list = 0;
+  IWXSTR *log = iwxstr_new();
+
+  iwrc rc = ejdb_open(&opts, &db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+
+  for (int k = 0; k < 100; ++k) {
+    snprintf(buf, sizeof(buf), "{'n':%d}", k);
+    rc = put_json2(db, "artists", buf, &ids[k]);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+  for (int k = 0; k < 300; ++k) {
+    snprintf(buf, sizeof(buf), "{'n':%d, 'artist_ref':%" PRId64 "}", k % 100, ids[k % 100]);
+    rc = put_json(db, "paintings", buf);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+  }
+
+  // Joined documents are fetched by windows of result documents
+  rc = jql_create(&q, "paintings", "/* | /{n, artist_ref<artists} | skip 3 limit 200");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_list4(db, q, 0, log, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  CU_ASSERT_PTR_NOT_NULL(strstr(iwxstr_ptr(log), "[COLLECTOR] WINDOW"));
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next, ++i) {
+    rc = jbn_at(doc->node, "/n", &n);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    id = n->vi64;
+    rc = jbn_at(doc->node, "/artist_ref/n", &n);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    CU_ASSERT_EQUAL(n->type, JBV_I64);
+    CU_ASSERT_EQUAL(n->vi64, id);
+  }
+  CU_ASSERT_EQUAL(i, 200);
+  ejdb_list_destroy(&list);
+
+  // Joined documents cache is bounded by memory size
+  CU_ASSERT_TRUE(iwhmap_count(db->jcache) > 0);
+  CU_ASSERT_TRUE(iwhmap_count(db->jcache) < 100);
+  CU_ASSERT_TRUE(db->jcache_size <= opts.join_cache_size);
+
+  // Updated joined document must not be served from join cache
+  rc = jbl_from_json(&jbl, "{\"n\":-1}");
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  rc = ejdb_put(db, "artists", jbl, ids[7]);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  jbl_destroy(&jbl);
+
+  i = 0;
+  rc = ejdb_list4(db, q, 0, 0, &list);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  for (EJDB_DOC doc = list->first; doc; doc = doc->next) {
+    rc = jbn_at(doc->node, "/n", &n);
+    CU_ASSERT_EQUAL_FATAL(rc, 0);
+    if (n->vi64 == 7) {
+      rc = jbn_at(doc->node, "/artist_ref/n", &n);
+      CU_ASSERT_EQUAL_FATAL(rc, 0);
+      CU_ASSERT_EQUAL(n->vi64, -1);
+      ++i;
+    }
+  }
+  CU_ASSERT_EQUAL(i, 2);
+  ejdb_list_destroy(&list);
+  jql_destroy(&q);
+
+  rc = ejdb_close(&db);
+  CU_ASSERT_EQUAL_FATAL(rc, 0);
+  iwxstr_destroy(log);
+}
+
 int main() {
   CU_pSuite pSuite = NULL;
   if (CUE_SUCCESS != CU_initialize_registry()) {
@@ -220,7 +306,8 @@ int main() {
     return CU_get_error();
   }
   if (  (NULL == CU_add_test(pSuite, "ejdb_test4_1", ejdb_test4_1))
-     || (NULL == CU_add_test(pSuite, "ejdb_test4_2", ejdb_test4_2))) {
+     || (NULL == CU_add_test(pSuite, "ejdb_test4_2", ejdb_test4_2))
+     || (NULL == CU_add_test(pSuite, "ejdb_test4_3", ejdb_test4_3))) {
     CU_cleanup_registry();
     return CU_get_error();
   }